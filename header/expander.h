@@ -128,10 +128,26 @@ enum UninitializeReason {
 
 
 // debugging and error handling
+#ifndef EXPANDER_LOGLEVEL
+#define EXPANDER_LOGLEVEL LOG_DEBUG                         // messages of lower levels are removed at compile time (warn() and error() are never removed)
+#endif
+
 #define dump(...)   _dump  (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define debug(...)  _debug (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define info(...)   _info  (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
-#define notice(...) _notice(__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#if EXPANDER_LOGLEVEL > LOG_DEBUG
+   #define debug(...)  _nolog(__VA_ARGS__)
+#else
+   #define debug(...)  _debug (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#endif
+#if EXPANDER_LOGLEVEL > LOG_INFO
+   #define info(...)   _nolog(__VA_ARGS__)
+#else
+   #define info(...)   _info  (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#endif
+#if EXPANDER_LOGLEVEL > LOG_NOTICE
+   #define notice(...) _nolog(__VA_ARGS__)
+#else
+   #define notice(...) _notice(__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
+#endif
 #define warn(...)   _warn  (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
 #define error(...)  _error (__FILE__, __FUNCTION__, __LINE__, __VA_ARGS__)
 
@@ -148,6 +164,9 @@ int __cdecl _error (const char* fileName, const char* funcName, uint line, int e
 
 int __cdecl debug_raw(const char* message, ...);
 
+int __cdecl _nolog(const char* message, ...);                // replacements of removed log statements
+int __cdecl _nolog(int error, const char* message, ...);
+
 
 // helper functions returning constant values
 int          __cdecl _EMPTY       (...);
@@ -0,0 +1,45 @@
+#pragma once
+#include "expander.h"
+#include "struct/mt4/HistoryBar401.h"
+#include "struct/mt4/Tick.h"
+
+#include <vector>
+
+
+#define AGGREGATOR_SKIP_WEEKEND   1                // ignore data of Saturdays and Sundays (session time)
+#define AGGREGATOR_MERGE_SUNDAY   2                // add data of Sundays to the D1 bar of the following Monday
+
+
+// a target timeframe of an aggregator
+struct AGGREGATOR_TARGET {
+   uint          timeframe;                        // timeframe in minutes (standard or custom)
+   uint          hWriter;                          // history writer receiving the bars or NULL
+   HistoryBar401 bar;                              // the forming bar
+   time32        closeTime;                        // open time of the next bar
+   BOOL          hasBar;                           // whether the forming bar holds data
+};
+
+
+// an aggregator building bars of multiple timeframes from ticks or M1 bars in one pass
+struct AGGREGATOR {
+   uint                           id;              // handle as returned by Aggregator_Create()
+   string                         symbol;          // symbol
+   uint                           digits;          // digits
+   DWORD                          flags;           // AGGREGATOR_* flags
+   int                            sessionOffset;   // offset of the session start from 00:00 in seconds
+   time32                         lastTime;        // time of the last processed tick or bar
+   std::vector<AGGREGATOR_TARGET> targets;         // target timeframes
+};
+
+
+uint   WINAPI Aggregator_Create      (const char* symbol, uint digits, DWORD flags = NULL, int sessionOffset = 0);
+BOOL   WINAPI Aggregator_AddTimeframe(uint hAggregator, uint timeframe, const char* hstFile = NULL);
+BOOL   WINAPI Aggregator_AddTick     (uint hAggregator, time32 time, double price);
+int    WINAPI Aggregator_AddTicks    (uint hAggregator, const TICK ticks[], int count);
+int    WINAPI Aggregator_AddBars     (uint hAggregator, const HistoryBar401 bars[], int count);
+const HistoryBar401* WINAPI Aggregator_CurrentBar(uint hAggregator, uint timeframe);
+BOOL   WINAPI Aggregator_Flush       (uint hAggregator);
+BOOL   WINAPI Aggregator_Release     (uint hAggregator);
+time32 WINAPI BarOpenTime            (time32 time, uint timeframe, int sessionOffset = 0, DWORD flags = NULL);
+
+void   WINAPI ReleaseAggregators();
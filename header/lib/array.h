@@ -1,7 +1,49 @@
 #pragma once
 #include "expander.h"
+#include "struct/ExecutionContext.h"
+#include "struct/mt4/MqlString.h"
+
+#include <vector>
+
+
+/**
+ * A fixed-size ring buffer for timeseries values with the oldest element at the logical start. Elements are accessed by
+ * bar offset (0 = youngest element) like an MQL timeseries array.
+ */
+template <typename T>
+struct RingBuffer {
+   std::vector<T> data;                            // elements
+   int            size;                            // number of elements
+   int            head;                            // physical index of the oldest element
+   T              emptyValue;                      // initialization value for elements interpreted as "empty"
+   uint           pid;                             // MQL program the buffer belongs to
+
+   T&       operator[](int bar)       { int i = head + size-1-bar; return data[i < size ? i : i-size]; }
+   const T& operator[](int bar) const { int i = head + size-1-bar; return data[i < size ? i : i-size]; }
+
+   void shift (int count);
+   void copyTo(T* dest) const;
+};
 
 
 // separated template definitions to prevent a bloated binary
 template <typename T> BOOL WINAPI InitializeArray(T values[], int size, T initValue, int from, int count = INT_MAX);
 template <typename T> BOOL WINAPI ShiftIndicatorBuffer(T buffer[], int size, int count, T emptyValue);
+template <typename T> void WINAPI FillArray(T* dest, int count, T value);
+
+int    WINAPI SearchIntArray         (const int array[], int size, int value, BOOL reverseIndexed = FALSE);
+int    WINAPI SearchSortedIntArray   (const int array[], int size, int value, BOOL reverseIndexed = FALSE);
+int    WINAPI SearchDoubleArray      (const double array[], int size, double value, BOOL reverseIndexed = FALSE);
+int    WINAPI SearchSortedDoubleArray(const double array[], int size, double value, BOOL reverseIndexed = FALSE);
+int    WINAPI SearchStringArrayA     (const MqlStringA array[], int size, const char* value, BOOL sorted = FALSE, BOOL reverseIndexed = FALSE);
+int    WINAPI SearchStringArrayW     (const MqlStringW array[], int size, const wchar* value, BOOL sorted = FALSE, BOOL reverseIndexed = FALSE);
+int    WINAPI SearchIntArrayKeys     (const int array[], int size, const int keys[], int keysSize, int results[], BOOL reverseIndexed = FALSE);
+
+uint   WINAPI RingBuffer_Create (const EXECUTION_CONTEXT* ec, int size, double emptyValue);
+BOOL   WINAPI RingBuffer_Shift  (uint hBuffer, int count);
+BOOL   WINAPI RingBuffer_Set    (uint hBuffer, int bar, double value);
+double WINAPI RingBuffer_Get    (uint hBuffer, int bar);
+BOOL   WINAPI RingBuffer_CopyTo (uint hBuffer, double buffer[], int size);
+BOOL   WINAPI RingBuffer_Release(uint hBuffer);
+void   WINAPI ReleaseRingBuffers(uint pid);
+void   WINAPI ReleaseRingBuffers();
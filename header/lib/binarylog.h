@@ -0,0 +1,16 @@
+#pragma once
+#include "expander.h"
+#include "struct/BinaryLog.h"
+
+#include <fstream>
+
+
+#define BINARY_LOG_EXTENSION        ".blog"        // logfiles with this extension are written in binary format
+
+
+BOOL WINAPI IsBinaryLogfileA(const char* filename);
+void WINAPI BinaryLog_ComposeMessage(string &buffer, const BLOG_MESSAGE &header, const char* level, const char* symbol, const char* period, const char* path, const char* errorDescr, const char* message);
+void WINAPI BinaryLog_Encode(std::ofstream* logger, const char* data, uint length, string &out);
+void WINAPI BinaryLog_Open(std::ofstream* logger);
+void WINAPI BinaryLog_Close(std::ofstream* logger);
+void WINAPI ReleaseBinaryLogs();
@@ -2,6 +2,14 @@
 #include "expander.h"
 
 
+// cache of the formatted minute of a timestamp, see cachedTimeFormat()
+struct TIME_FORMAT_CACHE {
+   time32 minute;                                  // start of the cached minute (0: empty)
+   BOOL   localTime;                               // whether the cached minute is formatted as local time
+   char   buffer[24];                              // "YYYY-MM-DD HH:MM:SS.mmm"
+};
+
+
 // current time
 time32     WINAPI GetGmtTime32();
 time64     WINAPI GetGmtTime64();
@@ -21,6 +29,8 @@ char*      WINAPI LocalTimeFormatA(time32 time, const char*  format);
 wchar*     WINAPI LocalTimeFormatW(time64 time, const wchar* format);
 string     WINAPI localTimeFormat (time32 time, const char*  format);
 
+const char* WINAPI cachedTimeFormat(TIME_FORMAT_CACHE &cache, time32 time, BOOL toLocalTime, int milliseconds = EMPTY);
+
 // type conversion
 SYSTEMTIME WINAPI FileTimeToSystemTime(const FILETIME &ft);
 time32     WINAPI FileTimeToUnixTime32(const FILETIME &ft);
@@ -1,7 +1,26 @@
 #pragma once
 #include "expander.h"
+#include "lib/datetime.h"
 #include "struct/ExecutionContext.h"
 
+#define THREAD_SEGMENT_SIZE  256                   // slots per segment of the thread registry
+#define MAX_THREAD_SEGMENTS   64                   // max. number of segments
+#define MAX_THREAD_SLOTS    (THREAD_SEGMENT_SIZE * MAX_THREAD_SEGMENTS)
+#define THREAD_SLOT_BUSY      -1                   // THREAD_SLOT.threadId while a slot is being (re-)assigned
+
+#define LIMBO_BUCKETS       1024                   // number of buckets of the index of unloaded indicators
+
+
+// a slot of the thread registry (segments are never freed, so slot pointers stay valid)
+struct THREAD_SLOT {
+   volatile LONG     threadId;                     // id of the owning thread, 0 if unused
+   HANDLE            hThread;                      // handle of the owning thread to detect its termination
+   uint              index;                        // index of the slot in the registry (the thread index)
+   BOOL              isUiThread;                   // whether the owning thread is the UI thread
+   volatile uint     pid;                          // last MQL program executed by the thread
+   TIME_FORMAT_CACHE timeFormat;                   // cached timestamp of the thread's last log entry
+};
+
 
 int                WINAPI MqlProgram_init  (EXECUTION_CONTEXT* ec, ProgramType type, const char* name, UninitializeReason reason, DWORD initFlags, DWORD deinitFlags, const char* symbol, uint timeframe, uint digits, double point, BOOL isTesting, BOOL isVisualMode, BOOL isOptimization, int recorder, EXECUTION_CONTEXT* sec, HWND hChart, int droppedOnChart, int droppedOnPosX, int droppedOnPosY, const char* accountServer, int accountNumber);
 int                WINAPI MqlProgram_start (EXECUTION_CONTEXT* ec, const void* rates, int bars, int changedBars, uint ticks, time32 tickTime, BOOL isVirtual, double bid, double ask);
@@ -17,6 +36,10 @@ HWND               WINAPI FindWindowHandle(const char* programName, ModuleType m
 UninitializeReason WINAPI FixUninitReason(EXECUTION_CONTEXT* ec, ModuleType moduleType, CoreFunction coreFunction, UninitializeReason uninitReason);
 
 uint               WINAPI GetCurrentThreadIndex();
+THREAD_SLOT*       WINAPI GetCurrentThreadSlot();
+uint               WINAPI GetThreadSlotsCount();
+const THREAD_SLOT* WINAPI GetThreadSlot(uint index);
+void               WINAPI ReleaseThreadSlots();
 uint               WINAPI GetLastThreadProgram();
 int                WINAPI SetLastThreadProgram(uint pid);
 
@@ -25,11 +48,16 @@ InitializeReason   WINAPI GetInitReason_indicator(EXECUTION_CONTEXT* ec, const E
 InitializeReason   WINAPI GetInitReason_expert   (EXECUTION_CONTEXT* ec,                                                        const char* programName, UninitializeReason uninitReason, const char* symbol, uint timeframe, BOOL testing,                                                   int droppedOnPosX, int droppedOnPosY);
 InitializeReason   WINAPI GetInitReason_script   (EXECUTION_CONTEXT* ec,                                                        const char* programName,                                                                                                                                      int droppedOnPosX, int droppedOnPosY);
 
+BOOL               WINAPI Program_IsFinished    (uint pid);
 BOOL               WINAPI Program_IsOptimization(const EXECUTION_CONTEXT* ec, BOOL isOptimization);
 BOOL               WINAPI Program_IsPartialTest (uint pid, const char* programName);
 BOOL               WINAPI Program_IsTesting     (const EXECUTION_CONTEXT* ec, BOOL isTesting);
 BOOL               WINAPI Program_IsVisualMode  (const EXECUTION_CONTEXT* ec, BOOL isVisualMode);
 
 uint               WINAPI PushProgram(ContextChain* chain);
+void               WINAPI RetireProgram(uint pid);
+void               WINAPI UnretireProgram(uint pid);
 BOOL               WINAPI AddToIndicatorList     (EXECUTION_CONTEXT* ec);
 BOOL               WINAPI RemoveFromIndicatorList(EXECUTION_CONTEXT* ec);
+void               WINAPI AddToLimboIndex        (uint pid);
+void               WINAPI RemoveFromLimboIndex   (uint pid);
@@ -0,0 +1,74 @@
+#pragma once
+#include "expander.h"
+#include "struct/mt4/FxtHeader.h"
+#include "struct/mt4/FxtTick.h"
+#include "struct/mt4/Symbol.h"
+
+
+#define FXT_VIEW_SIZE         (16 * 1024 * 1024)   // size of the mapped window of an FXT file (multiple of the allocation granularity)
+#define FXT_MAP_GRANULARITY   (64 * 1024)          // allocation granularity of Win32 file views
+#define FXT_WRITE_BUFFER      (64 * 1024)          // number of ticks buffered by the FXT generator before it writes (~3.5 MB)
+#define FXT_PROLOG_BARS       1000                 // number of prolog bars written by the terminal
+
+
+// an opened FXT file, only the window around the current read position is mapped
+struct FXT_FILE {
+   uint        id;                                 // handle as returned by FxtFile_Open()
+   string      filename;                           // full filename
+   HANDLE      hFile;                              // file handle
+   HANDLE      hMapping;                           // file mapping handle
+   uint64      fileSize;                           // file size at the time of opening
+   FXT_HEADER  header;                             // copy of the file header
+   uint        tickFormat;                         // 400 | 401
+   uint        tickSize;                           // sizeof(FxtTick400) | sizeof(FxtTick401)
+   uint        ticks;                              // number of complete tick records in the file
+   uint        prologBars;                         // number of bars of the prolog
+   uint        prologTicks;                        // number of tick records of the prolog (index of the first modeled tick)
+   const BYTE* view;                               // start of the currently mapped window or NULL
+   uint64      viewOffset;                         // file offset of the mapped window
+   uint        viewSize;                           // size of the mapped window
+};
+
+
+// a job of the FXT generator: input, test settings and results
+struct FXT_GENERATOR_JOB {
+   char       hstFile[MAX_PATH];                   // M1 history file to generate the ticks from
+   char       fxtFile[MAX_PATH];                   // FXT file to create (an existing file is overwritten)
+   SYMBOL     symbol;                              // symbol properties
+   char       serverName[128];                     // account server name
+   uint       period;                              // test timeframe (PERIOD_M1...PERIOD_D1)
+   uint       barModel;                            // MODE_EVERYTICK | MODE_CONTROLPOINTS | MODE_BAROPEN
+   time32     from;                                // test start time (inclusive)
+   time32     to;                                  // test end time (exclusive) or NULL for all available bars
+   uint       prologBars;                          // number of prolog bars (default: FXT_PROLOG_BARS)
+   uint       accountLeverage;                     // account leverage
+   double     commissionValue;                     // commission rate
+   uint       commissionType;                      // COMMISSION_PER_*
+   double     tickValue;                           // value of a tick per lot in account currency (0: contractSize * pointSize,
+                                                   // i.e. the value in quote currency, correct for accounts in quote currency)
+
+   BOOL       success;                             // out: whether the file was generated
+   uint       ticks;                               // out: number of written tick records (incl. prolog)
+   uint       modeledBars;                         // out: number of modeled bars
+   double     modelQuality;                        // out: model quality in percent
+   uint       modelErrors;                         // out: number of invalid M1 bars
+};
+
+
+uint              WINAPI FxtFile_Open            (const char* filename);
+BOOL              WINAPI FxtFile_Close           (uint hFile);
+const FXT_HEADER* WINAPI FxtFile_Header          (uint hFile);
+uint              WINAPI FxtFile_TickFormat      (uint hFile);
+int               WINAPI FxtFile_Ticks           (uint hFile);
+int               WINAPI FxtFile_PrologBars      (uint hFile);
+int               WINAPI FxtFile_PrologTicks     (uint hFile);
+int               WINAPI FxtFile_ModeledTicks    (uint hFile);
+int               WINAPI FxtFile_ReadTicks       (uint hFile, int from, FxtTick ticks[], int count);
+int               WINAPI FxtFile_ReadPrologTicks (uint hFile, int from, FxtTick ticks[], int count);
+int               WINAPI FxtFile_ReadModeledTicks(uint hFile, int from, FxtTick ticks[], int count);
+
+BOOL              WINAPI FxtFile_Generate        (FXT_GENERATOR_JOB* job);
+BOOL              WINAPI FxtFile_GenerateAll     (FXT_GENERATOR_JOB jobs[], int count);
+
+FXT_FILE*         WINAPI GetFxtFile(uint hFile);
+void              WINAPI ReleaseFxtFiles();
@@ -0,0 +1,74 @@
+#pragma once
+#include "expander.h"
+#include "struct/mt4/HistoryBar400.h"
+#include "struct/mt4/HistoryBar401.h"
+#include "struct/mt4/HistoryHeader.h"
+
+#include <vector>
+
+
+#define HISTORY_WRITE_BUFFER  8192                 // number of bars buffered by a history writer before it flushes (~480 KB)
+
+
+/**
+ * A typed read-only view of a bar range. Points directly into the mapped file, nothing is copied.
+ */
+template <typename T>
+struct BarSpan {
+   const T* bars;                                  // first (oldest) bar
+   uint     size;                                  // number of bars
+
+   const T& operator[](uint i) const { return bars[i]; }
+};
+
+
+// metadata of a memory-mapped history file
+struct HISTORY_FILE {
+   uint                  id;                       // handle as returned by HistoryFile_Open()
+   string                filename;                 // full filename
+   HANDLE                hFile;                    // file handle
+   HANDLE                hMapping;                 // file mapping handle
+   const BYTE*           view;                     // start of the mapped view
+   uint64                fileSize;                 // file size at the time of opening
+   const HISTORY_HEADER* header;                   // file header (start of the view)
+   uint                  barFormat;                // 400 | 401
+   uint                  barSize;                  // sizeof(HistoryBar400) | sizeof(HistoryBar401)
+   const void*           bars;                     // first bar (directly after the header)
+   uint                  barsCount;                // number of complete bars in the file
+};
+
+
+// an open history file writer
+struct HISTORY_WRITER {
+   uint                       id;                  // handle as returned by HistoryWriter_Open()
+   string                     filename;            // full filename
+   string                     symbol;              // symbol
+   uint                       timeframe;           // timeframe
+   HANDLE                     hFile;               // file handle
+   uint64                     writeOffset;         // file offset of the first buffered bar
+   std::vector<HistoryBar401> buffer;              // pending bars, the last bar is the still forming one
+   BOOL                       dirty;               // whether the buffer holds unflushed changes
+};
+
+
+uint                  WINAPI HistoryFile_Open     (const char* filename);
+BOOL                  WINAPI HistoryFile_Close    (uint hFile);
+const HISTORY_HEADER* WINAPI HistoryFile_Header   (uint hFile);
+uint                  WINAPI HistoryFile_BarFormat(uint hFile);
+int                   WINAPI HistoryFile_Bars     (uint hFile);
+const void*           WINAPI HistoryFile_Rates    (uint hFile);
+
+uint                  WINAPI HistoryWriter_Open     (const char* filename, const char* symbol, uint timeframe, uint digits);
+BOOL                  WINAPI HistoryWriter_AddBar   (uint hWriter, time32 time, double open, double high, double low, double close, double volume);
+BOOL                  WINAPI HistoryWriter_AddBars  (uint hWriter, const HistoryBar401 bars[], int count);
+BOOL                  WINAPI HistoryWriter_UpdateBar(uint hWriter, time32 time, double price, double volume);
+BOOL                  WINAPI HistoryWriter_Flush    (uint hWriter);
+BOOL                  WINAPI HistoryWriter_Close    (uint hWriter);
+
+const HISTORY_FILE*   WINAPI GetHistoryFile(uint hFile);
+HISTORY_WRITER*       WINAPI GetHistoryWriter(uint hWriter);
+void                  WINAPI ReleaseHistoryFiles();
+BOOL                  WINAPI ValidateHistoryHeader(const HISTORY_HEADER* hh, uint64 fileSize, const char* filename);
+
+// separated template definitions to prevent a bloated binary
+template <typename T> BOOL WINAPI GetHistoryBars(uint hFile, BarSpan<T> &span);
@@ -0,0 +1,41 @@
+#pragma once
+#include "expander.h"
+#include "struct/ExecutionContext.h"
+
+#include <vector>
+
+
+// indicator types of the incremental calculation engine
+enum IndicatorType {
+   IND_SMA    = 1,                                 // buffers: 0 = average
+   IND_EMA    = 2,                                 // buffers: 0 = average
+   IND_STDDEV = 3,                                 // buffers: 0 = standard deviation, 1 = moving average
+   IND_BANDS  = 4,                                 // buffers: 0 = moving average, 1 = upper band, 2 = lower band
+   IND_ATR    = 5,                                 // buffers: 0 = average true range, 1 = true range
+   IND_RSI    = 6                                  // buffers: 0 = RSI, 1 = smoothed gains, 2 = smoothed losses
+};
+#define INDICATOR_BUFFERS  3                       // max. number of buffers of an indicator
+
+
+// state of an incrementally calculated indicator, bound to an MQL program instance
+struct INDICATOR_STATE {
+   uint                id;                         // handle as returned by Indicator_Create()
+   uint                pid;                        // MQL program the indicator belongs to
+   IndicatorType       type;                       // indicator type
+   int                 period;                     // calculation period
+   double              param;                      // additional parameter (IND_BANDS: deviations)
+
+   int                 bars;                       // number of calculated bars (0: nothing calculated yet)
+   time32              firstBarTime;               // open time of the oldest bar at the last calculation
+   time32              lastBarTime;                // open time of the youngest bar at the last calculation (the checkpoint)
+   std::vector<double> high, low, close;           // input columns, indexed like the bars (0 = oldest bar)
+   std::vector<double> buffers[INDICATOR_BUFFERS]; // result buffers, indexed like the bars
+};
+
+
+uint          WINAPI Indicator_Create (const EXECUTION_CONTEXT* ec, IndicatorType type, int period, double param);
+int           WINAPI Indicator_Update (const EXECUTION_CONTEXT* ec, uint hIndicator);
+const double* WINAPI Indicator_Buffer (uint hIndicator, int buffer);
+double        WINAPI Indicator_Value  (uint hIndicator, int buffer, int bar);
+BOOL          WINAPI Indicator_Release(uint hIndicator);
+void          WINAPI ReleaseIndicators(uint pid);
@@ -0,0 +1,10 @@
+#pragma once
+#include "expander.h"
+
+
+// calculation kernels (values ordered ascending by time, results[0..from) must hold previously calculated values)
+void WINAPI CalculateSMA(const double values[], int from, int to, int period, double results[]);
+void WINAPI CalculateEMA(const double values[], int from, int to, int period, double results[]);
+
+BOOL WINAPI Indicator_SMA(const double values[], int size, int period, double results[]);
+BOOL WINAPI Indicator_EMA(const double values[], int size, int period, double results[]);
@@ -0,0 +1,8 @@
+#pragma once
+#include "expander.h"
+
+
+// calculation kernel (values ordered ascending by time, buffers[0..from) must hold previously calculated values)
+void WINAPI CalculateRSI(const double close[], int from, int to, int period, double pos[], double neg[], double results[]);
+
+BOOL WINAPI Indicator_RSI(const double close[], int size, int period, double results[]);
@@ -0,0 +1,12 @@
+#pragma once
+#include "expander.h"
+
+
+// calculation kernels (values ordered ascending by time, results[0..from) must hold previously calculated values)
+void WINAPI CalculateStdDev   (const double values[], int from, int to, int period, double ma[], double results[]);
+void WINAPI CalculateTrueRange(const double high[], const double low[], const double close[], int from, int to, double results[]);
+void WINAPI CalculateATR      (const double high[], const double low[], const double close[], int from, int to, int period, double tr[], double results[]);
+
+BOOL WINAPI Indicator_StdDev(const double values[], int size, int period, double results[]);
+BOOL WINAPI Indicator_Bands (const double values[], int size, int period, double deviations, double ma[], double upper[], double lower[]);
+BOOL WINAPI Indicator_ATR   (const double high[], const double low[], const double close[], int size, int period, double results[]);
@@ -3,5 +3,8 @@
 #include "struct/ExecutionContext.h"
 
 
-BOOL WINAPI AppendLogMessageA(EXECUTION_CONTEXT* ec, time32 serverTime, const char* message, int error, int level);
-BOOL WINAPI SetLogfileA      (EXECUTION_CONTEXT* ec, const char* filename);
+BOOL               WINAPI AppendLogMessageA      (EXECUTION_CONTEXT* ec, time32 serverTime, const char* message, int error, int level);
+EXECUTION_CONTEXT* WINAPI GetLogContext          (uint pid);
+BOOL               WINAPI IsDebugLoglevelActive  (uint pid, int level);
+BOOL               WINAPI IsLogfileLoglevelActive(const EXECUTION_CONTEXT* ec, int level);
+BOOL               WINAPI SetLogfileA            (EXECUTION_CONTEXT* ec, const char* filename);
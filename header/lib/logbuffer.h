@@ -0,0 +1,27 @@
+#pragma once
+#include "expander.h"
+
+#include <fstream>
+#include <vector>
+
+
+#define LOG_BUFFER_CHUNK_SIZE        65536         // size of a memory chunk of a log buffer
+#define LOG_BUFFER_MAX_MEMORY      1048576         // default max. memory of a log buffer, further entries are spilled to a temp file
+
+
+// buffered log entries of a program without a logfile (INIT_BUFFERED_LOG)
+struct LOG_BUFFER {
+   std::vector<char*> chunks;                      // memory chunks of LOG_BUFFER_CHUNK_SIZE holding entries with line breaks
+   uint               chunkUsed;                   // bytes used in the last chunk
+   uint               entries;                     // number of buffered entries
+   uint               size;                        // number of buffered bytes (memory and temp file)
+   HANDLE             hTempFile;                   // temp file holding entries beyond the memory limit or NULL (none)
+};
+
+
+LOG_BUFFER* WINAPI LogBuffer_Create();
+BOOL        WINAPI LogBuffer_Append(LOG_BUFFER* buffer, const char* text, uint length);
+BOOL        WINAPI LogBuffer_Configure(int maxMemory);
+BOOL        WINAPI LogBuffer_Drain(LOG_BUFFER* buffer, std::ofstream* logger, BOOL binary);
+uint        WINAPI LogBuffer_Size(const LOG_BUFFER* buffer);
+void        WINAPI LogBuffer_Release(LOG_BUFFER* buffer);
@@ -0,0 +1,30 @@
+#pragma once
+#include "expander.h"
+
+#include <fstream>
+
+
+#define LOG_RING_SIZE           4096               // capacity of the queue of pending log entries (must be a power of 2)
+#define LOG_ENTRY_SIZE           500               // max. length of a queued log entry, longer entries are written synchronously
+#define LOG_BATCH_SIZE         65536               // max. size of a single write to a logfile
+#define LOG_FLUSH_INTERVAL      1000               // default interval between flushes of the queue in msec
+#define LOG_FLUSH_SIZE           256               // default number of pending entries triggering an early flush
+#define LOG_STOP_TIMEOUT        2000               // max. time to wait for the writer thread to stop in msec
+
+
+// a pending log entry
+struct LOG_ENTRY {
+   volatile LONG  sequence;                        // ring buffer sequence number (slot state)
+   std::ofstream* logger;                          // target logfile
+   uint           length;                          // length of the text
+   BOOL           binary;                          // whether the text is a binary log message (see BinaryLog_ComposeMessage())
+   char           text[LOG_ENTRY_SIZE];            // log entry without line break
+};
+
+
+BOOL WINAPI LogWriter_Append(std::ofstream* logger, const char* text, uint length, BOOL binary = FALSE);
+BOOL WINAPI LogWriter_Configure(int flushInterval, int flushSize);
+void WINAPI LogWriter_Flush();
+void WINAPI LogWriter_Lock();
+void WINAPI LogWriter_Unlock();
+void WINAPI ReleaseLogWriter(BOOL isTerminating = FALSE);
@@ -0,0 +1,58 @@
+#pragma once
+#include "expander.h"
+#include "struct/mt4/Symbol.h"
+#include "struct/mt4/SymbolGroup.h"
+#include "struct/mt4/SymbolSelected.h"
+
+#include <map>
+#include <vector>
+
+#define MAX_SYMBOL_GROUPS   32                     // number of groups in "symgroups.raw"
+#define SYMBOLS_SEL_VERSION 400                    // format version in the header of a new "symbols.sel"
+
+
+// an in-memory copy of "symbols.raw" with hash indexes
+struct SYMBOL_TABLE {
+   uint                id;                         // handle as returned by SymbolTable_Open()
+   string              filename;                   // full filename
+   std::vector<SYMBOL> symbols;                    // copy of the file's symbols
+   uint                count;                      // number of symbols
+   uint                mask;                       // hash table size - 1 (the size is a power of 2)
+   std::vector<uint>   byName;                     // open addressing hash tables holding symbol index + 1 (0: empty slot)
+   std::vector<uint>   byAltName;                  //
+   std::vector<uint>   byId;                       //
+};
+
+
+// a transaction on the symbol files of a trade server directory ("symbols.raw", "symgroups.raw", "symbols.sel")
+struct SYMBOL_TRANSACTION {
+   uint                         id;                // handle as returned by SymbolTransaction_Begin()
+   string                       directory;         // trade server directory
+   std::vector<SYMBOL>          symbols;           // contents of "symbols.raw"
+   std::vector<SYMBOL_GROUP>    groups;            // contents of "symgroups.raw" (always MAX_SYMBOL_GROUPS entries)
+   std::vector<BYTE>            selectedHeader;    // header of "symbols.sel"
+   std::vector<SYMBOL_SELECTED> selected;          // records of "symbols.sel"
+   std::map<string, uint>       byName;            // symbol name => index in symbols
+   std::map<string, uint>       selectedByName;    // symbol name => index in selected
+   uint                         maxId;             // largest SYMBOL.id in use
+   BOOL                         modified;          // whether the transaction contains changes
+};
+
+
+uint          WINAPI SymbolTable_Open         (const char* filename);
+BOOL          WINAPI SymbolTable_Close        (uint hTable);
+int           WINAPI SymbolTable_Count        (uint hTable);
+const SYMBOL* WINAPI SymbolTable_Symbols      (uint hTable);
+const SYMBOL* WINAPI SymbolTable_FindByName   (uint hTable, const char* name);
+const SYMBOL* WINAPI SymbolTable_FindByAltName(uint hTable, const char* altName);
+const SYMBOL* WINAPI SymbolTable_FindById     (uint hTable, uint id);
+
+uint          WINAPI SymbolTransaction_Begin     (const char* directory);
+int           WINAPI SymbolTransaction_AddGroup  (uint hTx, const char* name, const char* description, uint color);
+int           WINAPI SymbolTransaction_AddSymbols(uint hTx, const SYMBOL symbols[], int count, BOOL select);
+BOOL          WINAPI SymbolTransaction_Commit    (uint hTx);
+BOOL          WINAPI SymbolTransaction_Rollback  (uint hTx);
+
+uint          WINAPI SymbolNameHash(const char* name);
+void          WINAPI ReleaseSymbolTables();
+void          WINAPI ReleaseSymbolTransactions();
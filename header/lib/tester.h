@@ -4,9 +4,27 @@
 #include "struct/mt4/FxtHeader.h"
 
 
-HWND   WINAPI FindTesterWindow();
-int    WINAPI Tester_GetBarModel();
-time32 WINAPI Tester_GetStartDate();
-time32 WINAPI Tester_GetEndDate();
-BOOL   WINAPI Tester_ReadFxtHeader(const char* symbol, uint timeframe, uint barModel, FXT_HEADER* fxtHeader);
-double WINAPI Test_GetCommission  (const EXECUTION_CONTEXT* ec);
+// a cached FXT header
+struct FXT_HEADER_CACHE {
+   string     symbol;                              // symbol
+   uint       timeframe;                           // timeframe
+   uint       barModel;                            // bar model
+   string     filename;                            // full filename
+   FILETIME   lastWriteTime;                       // modification time of the file when the header was read
+   uint64     fileSize;                            // size of the file when the header was read
+   BOOL       valid;                               // whether the header holds valid data
+   FXT_HEADER header;                              // the header
+};
+
+
+HWND              WINAPI FindTesterWindow();
+int               WINAPI Tester_GetBarModel();
+time32            WINAPI Tester_GetStartDate();
+time32            WINAPI Tester_GetEndDate();
+BOOL              WINAPI Tester_ReadFxtHeader(const char* symbol, uint timeframe, uint barModel, FXT_HEADER &fxtHeader);
+BOOL              WINAPI Tester_GetFxtHeader (const char* symbol, uint timeframe, uint barModel, FXT_HEADER* fxtHeader);
+
+int               WINAPI Test_GetBarModel  (const EXECUTION_CONTEXT* ec);
+BOOL              WINAPI Test_GetFxtHeader (const EXECUTION_CONTEXT* ec, FXT_HEADER* fxtHeader);
+double            WINAPI Test_GetCommission(const EXECUTION_CONTEXT* ec);
+void              WINAPI ReleaseTestSession(uint pid);
@@ -0,0 +1,48 @@
+#pragma once
+#include "expander.h"
+#include "struct/mt4/Symbol.h"
+#include "struct/mt4/Tick.h"
+
+#include <vector>
+
+
+#define TICK_QUEUE_SIZE       1024                 // capacity of a symbol's tick queue (must be a power of 2)
+#define TICK_READ_BUFFER      4096                 // number of ticks read from "ticks.raw" at once
+#define TICK_POLL_INTERVAL      50                 // interval between checks of "ticks.raw" for new ticks in msec
+
+
+// single-producer/single-consumer queue of the ticks of one symbol
+struct TICK_QUEUE {
+   char          symbol[MAX_SYMBOL_LENGTH+1];      // symbol
+   TICK          ticks[TICK_QUEUE_SIZE];           // ring buffer
+   volatile LONG head;                             // number of ticks ever written (by the reader thread)
+   volatile LONG tail;                             // number of ticks ever read (by the consumer)
+   volatile LONG overflows;                        // number of ticks dropped because the queue was full
+};
+
+
+// a reader following "ticks.raw"
+struct TICK_READER {
+   uint               id;                          // handle as returned by TickReader_Open()
+   string             filename;                    // full filename
+   HANDLE             hFile;                       // file handle
+   HANDLE             hThread;                     // reader thread
+   volatile LONG      stop;                        // whether the reader thread should stop
+   volatile LONG      stopped;                     // whether the reader thread has stopped
+   volatile LONG      refCount;                    // number of references: the registry and all running calls
+   uint64             readOffset;                  // file offset of the next tick to read
+   volatile LONG      lastCounter;                 // counter of the last processed tick
+   TICK_QUEUE*        queues[MAX_SYMBOLS];         // queues of all symbols seen so far
+   volatile LONG      queuesCount;                 // number of published queues
+   uint               lastQueue;                   // index of the last used queue (ticks come in bursts per symbol)
+   std::vector<TICK>  buffer;                      // read buffer
+};
+
+
+uint WINAPI TickReader_Open       (const char* filename, uint fromCounter = 0);
+BOOL WINAPI TickReader_Close      (uint hReader);
+int  WINAPI TickReader_GetTicks   (uint hReader, const char* symbol, TICK ticks[], int size);
+int  WINAPI TickReader_Overflows  (uint hReader, const char* symbol);
+uint WINAPI TickReader_LastCounter(uint hReader);
+
+void WINAPI ReleaseTickReaders();
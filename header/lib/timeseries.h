@@ -1,131 +1,41 @@
 #pragma once
 #include "expander.h"
+#include "struct/ExecutionContext.h"
 #include "struct/mt4/HistoryBar400.h"
 #include "struct/mt4/HistoryBar401.h"
 
 
 /**
- * Return the open price of a bar.
+ * A typed view of a bar timeseries with youngest prices at the end. Bars are accessed by chart offset (0 = youngest bar)
+ * without any range checks. The bar format is a template parameter, so accessors compile down to plain strided loads.
+ * Callers resolve the format once via GetBarFormat() and dispatch to the matching specialization:
  *
- * @param  void* rates - bar timeseries with youngest prices at the end
- * @param  uint  bars  - number of bars in the series
- * @param  uint  bar   - bar offset to return
- *
- * @return double
- */
-inline double iOpen(const void* rates, uint bars, uint bar) {
-   static uint build = GetTerminalBuild();               // TODO: defeats inlining
-   if (!build || bar < 0 || bar >= bars) return NULL;
-
-   uint shift = bars-1-bar;
-
-   double open;
-   if (build <= 509) open = ((HistoryBar400*) rates)[shift].open;
-   else              open = ((HistoryBar401*) rates)[shift].open;
-   return open;
-}
-
-
-/**
- * Return the high price of a bar.
- *
- * @param  void* rates - bar timeseries with youngest prices at the end
- * @param  uint  bars  - number of bars in the series
- * @param  uint  bar   - bar offset to return
- *
- * @return double
+ *   if (GetBarFormat() == 400) result = func(BarView<HistoryBar400>(ec));
+ *   else                       result = func(BarView<HistoryBar401>(ec));
  */
-inline double WINAPI iHigh(const void* rates, uint bars, uint bar) {
-   static uint build = GetTerminalBuild();               // TODO: defeats inlining
-   if (!build || bar < 0 || bar >= bars) return NULL;
+template <typename T>
+struct BarView {
+   const T* rates;                                 // bars ordered ascending by time
+   int      bars;                                  // number of bars
 
-   double high;
-   uint shift = bars-1-bar;
-   if (build <= 509) high = ((HistoryBar400*) rates)[shift].high;
-   else              high = ((HistoryBar401*) rates)[shift].high;
-   return high;
-}
+   BarView(const EXECUTION_CONTEXT* ec) : rates((const T*)ec->rates), bars(ec->bars) {}
+   BarView(const void* rates, int bars) : rates((const T*)rates),     bars(bars)     {}
 
+   const T& operator[](int bar) const { return rates[bars-1-bar];            }
 
-/**
- * Return the low price of a bar.
- *
- * @param  void* rates - bar timeseries with youngest prices at the end
- * @param  uint  bars  - number of bars in the series
- * @param  uint  bar   - bar offset to return
- *
- * @return double
- */
-inline double WINAPI iLow(const void* rates, uint bars, uint bar) {
-   static uint build = GetTerminalBuild();               // TODO: defeats inlining
-   if (!build || bar < 0 || bar >= bars) return NULL;
+   double   Open  (int bar)     const { return rates[bars-1-bar].open;       }
+   double   High  (int bar)     const { return rates[bars-1-bar].high;       }
+   double   Low   (int bar)     const { return rates[bars-1-bar].low;        }
+   double   Close (int bar)     const { return rates[bars-1-bar].close;      }
+   uint     Volume(int bar)     const { return (uint)rates[bars-1-bar].ticks; }
+   time32   Time  (int bar)     const { return rates[bars-1-bar].time;       }
+};
 
-   double low;
-   uint shift = bars-1-bar;
-   if (build <= 509) low = ((HistoryBar400*) rates)[shift].low;
-   else              low = ((HistoryBar401*) rates)[shift].low;
-   return low;
-}
 
+uint WINAPI GetBarFormat();
+int  WINAPI iBarShift (const EXECUTION_CONTEXT* ec, time32 time, BOOL exact = FALSE);
+BOOL WINAPI iBarShifts(const EXECUTION_CONTEXT* ec, const time32 times[], int size, int results[], BOOL exact = FALSE);
 
-/**
- * Return the close price of a bar.
- *
- * @param  void* rates - bar timeseries with youngest prices at the end
- * @param  uint  bars  - number of bars in the series
- * @param  uint  bar   - bar offset to return
- *
- * @return double
- */
-inline double WINAPI iClose(const void* rates, uint bars, uint bar) {
-   static uint build = GetTerminalBuild();               // TODO: defeats inlining
-   if (!build || bar < 0 || bar >= bars) return NULL;
-
-   double close;
-   uint shift = bars-1-bar;
-   if (build <= 509) close = ((HistoryBar400*) rates)[shift].close;
-   else              close = ((HistoryBar401*) rates)[shift].close;
-   return close;
-}
-
-
-/**
- * Return the tick volume of a bar.
- *
- * @param  void* rates - bar timeseries with youngest prices at the end
- * @param  uint  bars  - number of bars in the series
- * @param  uint  bar   - bar offset to return
- *
- * @return uint
- */
-inline uint WINAPI iVolume(const void* rates, uint bars, uint bar) {
-   static uint build = GetTerminalBuild();               // TODO: defeats inlining
-   if (!build || bar < 0 || bar >= bars) return NULL;
-
-   uint ticks;
-   uint shift = bars-1-bar;
-   if (build <= 509) ticks = (uint)((HistoryBar400*) rates)[shift].ticks;
-   else              ticks = (uint)((HistoryBar401*) rates)[shift].ticks;
-   return ticks;
-}
-
-
-/**
- * Return the open time of a bar.
- *
- * @param  void* rates - bar timeseries with youngest prices at the end
- * @param  uint  bars  - number of bars in the series
- * @param  uint  bar   - bar offset to return
- *
- * @return time32
- */
-inline time32 WINAPI iTime(const void* rates, int bars, int bar) {
-   static uint build = GetTerminalBuild();               // TODO: defeats inlining
-   if (!build || bar < 0 || bar >= bars) return NULL;
+BOOL WINAPI CopyRatesColumns (const EXECUTION_CONTEXT* ec, int from, time32 times[], double open[], double high[], double low[], double close[], double volume[]);
+int  WINAPI Rates_CopyColumns(const EXECUTION_CONTEXT* ec, int size, time32 times[], double open[], double high[], double low[], double close[], double volume[], BOOL incremental);
 
-   time32 time;
-   uint shift = bars-1-bar;
-   if (build <= 509) time = ((HistoryBar400*) rates)[shift].time;
-   else              time = ((HistoryBar401*) rates)[shift].time;
-   return time;
-}
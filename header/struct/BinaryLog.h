@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+ * File format of binary logfiles written by AppendLogMessageA() (extension ".blog"). This header has no dependencies and is
+ * shared with the offline decoder (see "tools/blogdump").
+ *
+ * A binary logfile is a sequence of records. Each record starts with a one byte record type. A file header starts a new
+ * section and resets the string table, so a logfile reopened in append mode stays decodable. Strings repeated in many log
+ * messages (loglevel, symbol, period, program path, error description) are written once per section as a BLOG_STRING record
+ * and then referenced by id. The log message itself is stored as is.
+ */
+#define BLOG_MAGIC              "MT4XBLOG"         // magic of a file header (without the terminating NUL)
+#define BLOG_VERSION                     1         // current file format version
+
+#define BLOG_RECORD_HEADER             'H'         // record types
+#define BLOG_RECORD_STRING             'S'
+#define BLOG_RECORD_MESSAGE            'M'
+#define BLOG_RECORD_TEXT               'T'
+
+#define BLOG_FLAG_TESTER              0x01         // time is the tester time (rendered with prefix "T" and without milliseconds)
+
+#define BLOG_MAX_STRINGS             65535         // max. number of interned strings per section
+
+
+#pragma pack(push, 1)
+/**
+ * File header, starts a new section.
+ */
+struct BLOG_HEADER {                               // -- offset ---- size --- description ----------------------------------------------------------------------------
+   char           type;                            //         0         1     BLOG_RECORD_HEADER
+   char           magic[8];                        //         1         8     BLOG_MAGIC
+   unsigned int   version;                         //         9         4     BLOG_VERSION
+};                                                 // ----------------------------------------------------------------------------------------------------------------
+                                                   //                = 13
+
+/**
+ * Definition of an interned string, followed by the string's characters (without terminating NUL).
+ */
+struct BLOG_STRING {                               // -- offset ---- size --- description ----------------------------------------------------------------------------
+   char           type;                            //         0         1     BLOG_RECORD_STRING
+   unsigned short id;                              //         1         2     string id (1 to BLOG_MAX_STRINGS)
+   unsigned short length;                          //         3         2     length of the string
+};                                                 // ----------------------------------------------------------------------------------------------------------------
+                                                   //                 = 5
+
+/**
+ * A log message, followed by the raw message characters (without terminating NUL).
+ */
+struct BLOG_MESSAGE {                              // -- offset ---- size --- description ----------------------------------------------------------------------------
+   char           type;                            //         0         1     BLOG_RECORD_MESSAGE
+   unsigned char  flags;                           //         1         1     BLOG_FLAG_*
+   unsigned short milliseconds;                    //         2         2     milliseconds of the time (online only)
+   int            time;                            //         4         4     tester time or local time as a Unix timestamp
+   int            level;                           //         8         4     loglevel of the message
+   unsigned int   pid;                             //        12         4     MQL program id
+   int            timeframe;                       //        16         4     chart timeframe
+   int            error;                           //        20         4     error linked to the message (if any)
+   unsigned short levelId;                         //        24         2     id of the loglevel description
+   unsigned short symbolId;                        //        26         2     id of the chart symbol
+   unsigned short periodId;                        //        28         2     id of the timeframe description
+   unsigned short pathId;                          //        30         2     id of the execution path, e.g. "MyExpert::MyLibrary::"
+   unsigned short errorId;                         //        32         2     id of the error description or 0 (no error)
+   unsigned int   length;                          //        34         4     length of the message
+};                                                 // ----------------------------------------------------------------------------------------------------------------
+                                                   //                = 38
+
+/**
+ * A preformatted log entry (e.g. from the log buffer), followed by the entry's characters (without line break).
+ */
+struct BLOG_TEXT {                                 // -- offset ---- size --- description ----------------------------------------------------------------------------
+   char           type;                            //         0         1     BLOG_RECORD_TEXT
+   unsigned int   length;                          //         1         4     length of the text
+};                                                 // ----------------------------------------------------------------------------------------------------------------
+#pragma pack(pop)                                  //                 = 5
@@ -1,7 +1,9 @@
 #pragma once
+#include <deque>
 #include <vector>
 
-typedef std::vector<string> LogBuffer;
+struct LOG_BUFFER;                                 // see lib/logbuffer.h
+typedef LOG_BUFFER LogBuffer;
 
 
 #pragma pack(push, 1)
@@ -175,4 +177,35 @@ char* WINAPI lpEXECUTION_CONTEXT_toStr(const EXECUTION_CONTEXT* ec);
 // type definitions
 typedef std::vector<EXECUTION_CONTEXT*> ContextChain;       // A ContextChain holds all EXECUTION_CONTEXTs of an MQL program (one per module).
 typedef std::vector<uint>               IndicatorList;      // List of indicators (pids) loaded in a chart window.
-typedef std::vector<ContextChain*>      MqlInstanceList;    // List of all MQL programs ever loaded (index = pid = instance id).
+
+
+#define MQL_INSTANCE_SEGMENT_SIZE 1024             // slots per segment of the program registry
+#define MAX_MQL_INSTANCE_SEGMENTS  256             // max. number of segments (max. 262144 concurrent program instances)
+#define MQL_INSTANCE_QUARANTINE    256             // number of newer retirements after which a retired pid is recycled
+
+
+/**
+ * Registry of all MQL program instances (index = pid = instance id). Storage is segmented and never relocates, so readers
+ * don't need a lock: a slot is written before the new size is published and slots below size() always hold a valid chain.
+ * Writers synchronize on g_expanderMutex (see PushProgram() and RetireProgram()). The pids of programs which are finally
+ * unloaded are recycled after a quarantine period, which keeps memory bounded over long optimization sessions.
+ */
+struct MQL_INSTANCE_LIST {
+   ContextChain** volatile segments[MAX_MQL_INSTANCE_SEGMENTS];
+   volatile LONG           count;                  // published number of slots (index 0 is not a valid pid and is always empty)
+   std::deque<uint>        retired;                // retired pids in order of retirement
+
+   MQL_INSTANCE_LIST() : count(1) {
+      memset((void*)segments, 0, sizeof(segments));
+      segments[0] = new ContextChain*[MQL_INSTANCE_SEGMENT_SIZE]();
+   }
+
+   uint size() const {
+      return (uint)count;
+   }
+
+   ContextChain* operator[] (uint pid) const {
+      return segments[pid / MQL_INSTANCE_SEGMENT_SIZE][pid % MQL_INSTANCE_SEGMENT_SIZE];
+   }
+};
+typedef MQL_INSTANCE_LIST MqlInstanceList;
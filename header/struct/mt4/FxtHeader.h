@@ -85,4 +85,56 @@ struct FXT_HEADER {                                // -- offset -- size -- descr
 #pragma pack(pop)                                  //            = 728     Warum bin ich nicht auf Ibiza?
 
 
+// getters
+uint        WINAPI fxt_Version                  (const FXT_HEADER* fxt);
+const char* WINAPI fxt_Description              (const FXT_HEADER* fxt);
+const char* WINAPI fxt_ServerName               (const FXT_HEADER* fxt);
+const char* WINAPI fxt_Symbol                   (const FXT_HEADER* fxt);
+uint        WINAPI fxt_Period                   (const FXT_HEADER* fxt);
+uint        WINAPI fxt_Timeframe                (const FXT_HEADER* fxt);
+uint        WINAPI fxt_ModelType                (const FXT_HEADER* fxt);
+uint        WINAPI fxt_ModeledBars              (const FXT_HEADER* fxt);
+time32      WINAPI fxt_FirstBarTime             (const FXT_HEADER* fxt);
+time32      WINAPI fxt_LastBarTime              (const FXT_HEADER* fxt);
+double      WINAPI fxt_ModelQuality             (const FXT_HEADER* fxt);
+const char* WINAPI fxt_BaseCurrency             (const FXT_HEADER* fxt);
+uint        WINAPI fxt_Spread                   (const FXT_HEADER* fxt);
+uint        WINAPI fxt_Digits                   (const FXT_HEADER* fxt);
+double      WINAPI fxt_PointSize                (const FXT_HEADER* fxt);
+uint        WINAPI fxt_MinLotsize               (const FXT_HEADER* fxt);
+uint        WINAPI fxt_MaxLotsize               (const FXT_HEADER* fxt);
+uint        WINAPI fxt_LotStepsize              (const FXT_HEADER* fxt);
+uint        WINAPI fxt_StopDistance             (const FXT_HEADER* fxt);
+BOOL        WINAPI fxt_PendingsGTC              (const FXT_HEADER* fxt);
+double      WINAPI fxt_ContractSize             (const FXT_HEADER* fxt);
+double      WINAPI fxt_TickValue                (const FXT_HEADER* fxt);
+double      WINAPI fxt_TickSize                 (const FXT_HEADER* fxt);
+uint        WINAPI fxt_ProfitCalculationMode    (const FXT_HEADER* fxt);
+BOOL        WINAPI fxt_SwapEnabled              (const FXT_HEADER* fxt);
+uint        WINAPI fxt_SwapType                 (const FXT_HEADER* fxt);
+double      WINAPI fxt_SwapLongValue            (const FXT_HEADER* fxt);
+double      WINAPI fxt_SwapShortValue           (const FXT_HEADER* fxt);
+uint        WINAPI fxt_SwapTripleRolloverDay    (const FXT_HEADER* fxt);
+uint        WINAPI fxt_AccountLeverage          (const FXT_HEADER* fxt);
+uint        WINAPI fxt_FreeMarginCalculationType(const FXT_HEADER* fxt);
+uint        WINAPI fxt_MarginCalculationMode    (const FXT_HEADER* fxt);
+uint        WINAPI fxt_MarginStopoutLevel       (const FXT_HEADER* fxt);
+uint        WINAPI fxt_MarginStopoutType        (const FXT_HEADER* fxt);
+double      WINAPI fxt_MarginInit               (const FXT_HEADER* fxt);
+double      WINAPI fxt_MarginMaintenance        (const FXT_HEADER* fxt);
+double      WINAPI fxt_MarginHedged             (const FXT_HEADER* fxt);
+double      WINAPI fxt_MarginDivider            (const FXT_HEADER* fxt);
+const char* WINAPI fxt_MarginCurrency           (const FXT_HEADER* fxt);
+double      WINAPI fxt_CommissionValue          (const FXT_HEADER* fxt);
+uint        WINAPI fxt_CommissionCalculationMode(const FXT_HEADER* fxt);
+uint        WINAPI fxt_CommissionType           (const FXT_HEADER* fxt);
+uint        WINAPI fxt_FirstBar                 (const FXT_HEADER* fxt);
+uint        WINAPI fxt_LastBar                  (const FXT_HEADER* fxt);
+time32      WINAPI fxt_TesterSettingFrom        (const FXT_HEADER* fxt);
+time32      WINAPI fxt_TesterSettingTo          (const FXT_HEADER* fxt);
+uint        WINAPI fxt_FreezeDistance           (const FXT_HEADER* fxt);
+uint        WINAPI fxt_ModelErrors              (const FXT_HEADER* fxt);
+uint        WINAPI fxt_StartPeriod              (const FXT_HEADER* fxt, int index);
+
+
 // Tickdata, letztes Feld: // expert flag 0-bar is modified, but expert is not run
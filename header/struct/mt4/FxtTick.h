@@ -0,0 +1,50 @@
+#pragma once
+#include "expander.h"
+
+
+#pragma pack(push, 1)
+/**
+ * MT4 struct FXT_TICK_400
+ *
+ * Tick format of FXT files generated by terminal builds <= 509. Each record holds the state of the bar after the tick.
+ */
+struct FXT_TICK_400 {                     // -- offset -- size -- description -----------
+   time32 barTime;                        //       0        4     opentime of the bar the tick belongs to
+   double open;                           //       4        8
+   double high;                           //      12        8
+   double low;                            //      20        8
+   double close;                          //      28        8     tick price
+   double volume;                         //      36        8     bar volume after the tick
+   time32 tickTime;                       //      44        4     tick time
+   int    flags;                          //      48        4     0: the expert is not run for the tick (bar update only)
+};                                        // ----------------------------------------------
+#pragma pack(pop)                         //             = 52
+
+
+#pragma pack(push, 1)
+/**
+ * MT4 struct FXT_TICK_401
+ *
+ * Tick format of FXT files generated by terminal builds > 509. Each record holds the state of the bar after the tick.
+ */
+struct FXT_TICK_401 {                     // -- offset -- size -- description -----------
+   union {                                //       0        8     opentime of the bar the tick belongs to
+      struct {                            //
+         time32 barTime;                  //       0        4     32-bit datetime value
+         DWORD  reserved1;                //       4        4     high 32 bits
+      };                                  //
+      time64 barTime_ex;                  //       0        8     64-bit datetime value
+   };                                     //
+   double open;                           //       8        8
+   double high;                           //      16        8
+   double low;                            //      24        8
+   double close;                          //      32        8     tick price
+   uint64 volume;                         //      40        8     bar volume after the tick
+   time32 tickTime;                       //      48        4     tick time
+   int    flags;                          //      52        4     0: the expert is not run for the tick (bar update only)
+};                                        // ----------------------------------------------
+#pragma pack(pop)                         //             = 56
+
+typedef FXT_TICK_400 FxtTick400;
+typedef FXT_TICK_401 FxtTick401;
+typedef FXT_TICK_401 FxtTick;             // format returned by the FXT reader
@@ -34,4 +34,4 @@ struct MqlStringW {
 };
 //typedef MqlStringW MqlString;     // MetaQuotes alias
 
-#pragma pack(pop,1)
+#pragma pack(pop)
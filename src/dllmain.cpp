@@ -1,15 +1,23 @@
 #include "expander.h"
 #include "dllmain.h"
+#include "lib/aggregator.h"
+#include "lib/array.h"
+#include "lib/binarylog.h"
+#include "lib/executioncontext.h"
+#include "lib/fxt.h"
 #include "lib/helper.h"
+#include "lib/history.h"
+#include "lib/logwriter.h"
 #include "lib/string.h"
+#include "lib/symbols.h"
 #include "lib/terminal.h"
+#include "lib/ticks.h"
 #include "lib/timer.h"
 #include "lib/ui/integration.h"
 #include "struct/ExecutionContext.h"
 
 extern MqlInstanceList               g_mqlInstances;        // all MQL program instances
-extern std::vector<DWORD>            g_threads;             // all known threads executing MQL programs
-extern std::vector<uint>             g_threadsPrograms;     // the last MQL program executed by a thread
+extern DWORD                         g_threadSlotTls;       // TLS index holding a thread's registry slot
 extern std::vector<TICK_TIMER_DATA*> g_tickTimers;          // all registered ticktimers
 extern CRITICAL_SECTION              g_expanderMutex;       // mutex for Expander-wide locking
 
@@ -45,10 +53,10 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD reason, LPVOID reserved) {
 static BOOL WINAPI onProcessAttach() {
    InitializeCriticalSection(&g_expanderMutex);
 
-   g_mqlInstances.   reserve(128);        // TODO: replace global state by getters/setters with local state
-   g_threads.        reserve(512);
-   g_threadsPrograms.reserve(512);
-   g_tickTimers.     reserve(32);
+   g_tickTimers.reserve(32);            // TODO: replace global state by getters/setters with local state
+
+   g_threadSlotTls = TlsAlloc();
+   if (g_threadSlotTls == TLS_OUT_OF_INDEXES) return !error(ERR_WIN32_ERROR + GetLastError(), "TlsAlloc()");
 
    // launch worker thread for custom initializations
    HMODULE hModule = NULL;                // increase ref-count so the DLL can't be unloaded before the thread finishes
@@ -74,10 +82,23 @@ static BOOL WINAPI onProcessAttach() {
  * @return BOOL - success status
  */
 static BOOL WINAPI onProcessDetach(BOOL isTerminating) {
-   if (!isTerminating) {
-      DeleteCriticalSection(&g_expanderMutex);
+   if (isTerminating) {
+      ReleaseLogWriter(TRUE);                      // all other threads are gone: only write pending log entries
+   }
+   else {
       ReleaseTickTimers();
+      ReleaseAggregators();
+      ReleaseRingBuffers();
+      ReleaseHistoryFiles();
+      ReleaseFxtFiles();
+      ReleaseTickReaders();
+      ReleaseSymbolTables();
+      ReleaseSymbolTransactions();
       ReleaseWindowProperties();
+      ReleaseLogWriter();
+      ReleaseBinaryLogs();
+      ReleaseThreadSlots();                        // last: the releases above may still log, which resolves thread slots
+      DeleteCriticalSection(&g_expanderMutex);     // the releases above lock the registries
    }
    return TRUE;
 }
@@ -1,10 +1,18 @@
 #include "expander.h"
 #include "lib/conversion.h"
 #include "lib/executioncontext.h"
+#include "lib/log.h"
 #include "lib/string.h"
 
 extern MqlInstanceList g_mqlInstances;       // all MQL program instances
 
+#define DEBUG_MSG_SIZE        2048           // size of the stack buffer for debug messages, longer messages use the heap
+#define DEBUG_MSG_PREFIX_SIZE  512           // max. size of the message prefix (application id and call location)
+
+#ifndef va_copy
+#define va_copy(dest, src) ((dest) = (src))  // VS2008 has no va_copy(), a va_list is a plain pointer
+#endif
+
 
 /**
  * Dump data from a buffer to the debugger output.
@@ -55,6 +63,85 @@ int __cdecl _dump(const char* fileName, const char* funcName, uint line, const v
 }
 
 
+/**
+ * Return the name of a source file without the directory part. The returned pointer points into the passed string, no
+ * memory is allocated.
+ *
+ * @param  char* fileName - file name as passed by the __FILE__ macro
+ *
+ * @return char* - file name without directory
+ */
+static const char* WINAPI DebugBaseName(const char* fileName) {
+   if (!fileName) return("");
+
+   const char* baseName = fileName;
+   for (const char* c=fileName; *c; c++) {
+      if (*c=='\\' || *c=='/') baseName = c+1;
+   }
+   return(baseName);
+}
+
+
+/**
+ * Format a message and pass it to the system debugger. Debug, info and notice messages not passing the loglevel
+ * configuration of the MQL program executed by the current thread are discarded before they are formatted. Warnings and
+ * errors are always passed on. The message is composed in a buffer on the stack of the calling thread. Only messages not
+ * fitting into that buffer are composed on the heap.
+ *
+ * @param  int     level    - loglevel of the message
+ * @param  char*   fileName - file name of the call or NULL (no call location)
+ * @param  char*   funcName - function name of the call or NULL (no call location)
+ * @param  uint    line     - line number of the call
+ * @param  int     error    - error code to append to the message (if any)
+ * @param  char*   format   - message with format codes for additional parameters
+ * @param  va_list args     - variable list of additional parameters (may be used only once, see va_copy())
+ */
+static void WINAPI OutputDebugMessage(int level, const char* fileName, const char* funcName, uint line, int error, const char* format, va_list args) {
+   if (level < LOG_WARN && !IsDebugLoglevelActive(GetLastThreadProgram(), level)) return;
+
+   if (!format) format = "(null)";
+   char buffer[DEBUG_MSG_SIZE];
+
+   // insert the application prefix for filtering in DebugView and the call location: {basename.ext(line)}
+   buffer[DEBUG_MSG_PREFIX_SIZE-1] = '\0';
+   const char* sLevel = (level==LOG_DEBUG ? "" : LoglevelDescriptionA(level));   // LOG_DEBUG is blanked out
+   if (funcName) _snprintf(buffer, DEBUG_MSG_PREFIX_SIZE-1, "MT4Expander %-6s %s::%s(%u)  ", sLevel, DebugBaseName(fileName), funcName, line);
+   else          _snprintf(buffer, DEBUG_MSG_PREFIX_SIZE-1, "MT4Expander %-6s ", sLevel);
+   uint prefixLen = strlen(buffer);
+
+   // the error code to add at the end (if any)
+   char suffix[64] = "";
+   if (error) _snprintf(suffix, sizeof(suffix)-1, "  [%s]", ErrorToStrA(error));
+   uint suffixLen = strlen(suffix);
+
+   // format the variable parameters
+   char* msg = buffer;
+   uint available = sizeof(buffer) - prefixLen - suffixLen;       // including the terminating NUL char
+   va_list copy;
+   va_copy(copy, args);
+   int len = _vsnprintf(buffer + prefixLen, available, format, copy);
+   va_end(copy);
+   if (len >= 0 && (uint)len < available) {
+      memcpy(buffer + prefixLen + len, suffix, suffixLen + 1);
+   }
+   else {                                                         // the message doesn't fit into the buffer
+      va_copy(copy, args);
+      uint msgLen = vscprintf(format, copy);
+      va_end(copy);
+      msg = (char*) malloc(prefixLen + msgLen + suffixLen + 1);
+      if (!msg) return;
+      memcpy(msg, buffer, prefixLen);
+      vsprintf_s(msg + prefixLen, msgLen + 1, format, args);
+      memcpy(msg + prefixLen + msgLen, suffix, suffixLen + 1);
+   }
+
+   // pass the message to the system debugger
+   OutputDebugStringA(msg);
+
+   if (msg != buffer) free(msg);
+}
+
+
 /**
  * Print a message without call-site identifiers to the system debugger.
  *
@@ -64,22 +151,10 @@ int __cdecl _dump(const char* fileName, const char* funcName, uint line, const v
  * @return int - 0 (NULL)
  */
 int __cdecl debug_raw(const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_DEBUG, NULL, NULL, 0, NO_ERROR, message, args);
    va_end(args);
-
-   // insert the application prefix for filtering in DebugView
-   char* fullMsg = asformat("MT4Expander        %s", formattedMsg);
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return NO_ERROR;
 }
 
@@ -96,25 +171,10 @@ int __cdecl debug_raw(const char* message, ...) {
  * @return int - 0 (NULL)
  */
 int __cdecl _debug(const char* fileName, const char* funcName, uint line, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_DEBUG, fileName, funcName, line, NO_ERROR, message, args);
    va_end(args);
-
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander        %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return NO_ERROR;
 }
 
@@ -132,32 +192,10 @@ int __cdecl _debug(const char* fileName, const char* funcName, uint line, const
  * @return int - the passed error code
  */
 int __cdecl _debug(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_DEBUG, fileName, funcName, line, error, message, args);
    va_end(args);
-
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander        %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // add the error code at the end (if any)
-   if (error) {
-      char* newMsg = asformat("%s  [%s]", fullMsg, ErrorToStrA(error));
-      free(fullMsg);
-      fullMsg = newMsg;
-   }
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return error;
 }
 
@@ -174,25 +212,10 @@ int __cdecl _debug(const char* fileName, const char* funcName, uint line, int er
  * @return int - the passed error code
  */
 int __cdecl _info(const char* fileName, const char* funcName, uint line, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_INFO, fileName, funcName, line, NO_ERROR, message, args);
    va_end(args);
-
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander INFO   %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return NO_ERROR;
 }
 
@@ -210,32 +233,10 @@ int __cdecl _info(const char* fileName, const char* funcName, uint line, const c
  * @return int - the passed error code
  */
 int __cdecl _info(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_INFO, fileName, funcName, line, error, message, args);
    va_end(args);
-
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander INFO   %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // add the error code at the end (if any)
-   if (error) {
-      char* newMsg = asformat("%s  [%s]", fullMsg, ErrorToStrA(error));
-      free(fullMsg);
-      fullMsg = newMsg;
-   }
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return error;
 }
 
@@ -252,25 +253,10 @@ int __cdecl _info(const char* fileName, const char* funcName, uint line, int err
  * @return int - the passed error code
  */
 int __cdecl _notice(const char* fileName, const char* funcName, uint line, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_NOTICE, fileName, funcName, line, NO_ERROR, message, args);
    va_end(args);
-
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander NOTICE %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return NO_ERROR;
 }
 
@@ -288,32 +274,10 @@ int __cdecl _notice(const char* fileName, const char* funcName, uint line, const
  * @return int - the passed error code
  */
 int __cdecl _notice(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_NOTICE, fileName, funcName, line, error, message, args);
    va_end(args);
-
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander NOTICE %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // add the error code at the end (if any)
-   if (error) {
-      char* newMsg = asformat("%s  [%s]", fullMsg, ErrorToStrA(error));
-      free(fullMsg);
-      fullMsg = newMsg;
-   }
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
-   free(formattedMsg, fullMsg);
    return error;
 }
 
@@ -330,24 +294,11 @@ int __cdecl _notice(const char* fileName, const char* funcName, uint line, int e
  * @return int - the passed error code
  */
 int __cdecl _warn(const char* fileName, const char* funcName, uint line, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_WARN, fileName, funcName, line, NO_ERROR, message, args);
    va_end(args);
 
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander WARN   %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
    // store the warning in the EXECUTION_CONTEXT of the currently executed MQL program
    if (uint pid = GetLastThreadProgram()) {
       ContextChain &chain = *g_mqlInstances[pid];
@@ -361,8 +312,6 @@ int __cdecl _warn(const char* fileName, const char* funcName, uint line, const c
          //ec_SetDllWarningMsg(ec, formattedMsg);
       }
    }
-
-   free(formattedMsg, fullMsg);
    return NO_ERROR;
 }
 
@@ -380,31 +329,11 @@ int __cdecl _warn(const char* fileName, const char* funcName, uint line, const c
  * @return int - the passed error code
  */
 int __cdecl _warn(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
-   const char* msg = message;
-   if (!msg) msg = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_WARN, fileName, funcName, line, error, message, args);
    va_end(args);
 
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander WARN   %s%s::%s(%u)  %s", baseName, ext, funcName, line, formattedMsg);
-
-   // add the error code at the end (if any)
-   if (error) {
-      char* newMsg = asformat("%s  [%s]", fullMsg, ErrorToStrA(error));
-      free(fullMsg);
-      fullMsg = newMsg;
-   }
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
    // store the warning in the EXECUTION_CONTEXT of the currently executed MQL program
    if (uint pid = GetLastThreadProgram()) {
       ContextChain &chain = *g_mqlInstances[pid];
@@ -418,8 +347,6 @@ int __cdecl _warn(const char* fileName, const char* funcName, uint line, int err
          //ec_SetDllWarningMsg(ec, formattedMsg);
       }
    }
-
-   free(formattedMsg, fullMsg);
    return error;
 }
 
@@ -439,24 +366,11 @@ int __cdecl _warn(const char* fileName, const char* funcName, uint line, int err
 int __cdecl _error(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
    if (!error) return NO_ERROR;
 
-   const char* msg = message;
-   if (!msg) message = "(null)";
-
-   // format the variable parameters
    va_list args;
    va_start(args, message);
-   char* formattedMsg = _asformat(msg, args);
+   OutputDebugMessage(LOG_ERROR, fileName, funcName, line, error, message, args);
    va_end(args);
 
-   // insert the call location at the beginning: {basename.ext(line)}
-   char baseName[MAX_FNAME] = {}, ext[MAX_EXT] = {};
-   if (!fileName) baseName[0] = ext[0] = '\0';
-   else           _splitpath_s(fileName, NULL, 0, NULL, 0, baseName, MAX_FNAME, ext, MAX_EXT);
-   char* fullMsg = asformat("MT4Expander ERROR  %s%s::%s(%u)  %s  [%s]", baseName, ext, funcName, line, formattedMsg, ErrorToStrA(error));
-
-   // pass the message to the system debugger
-   OutputDebugStringA(fullMsg);
-
    // store the error in the EXECUTION_CONTEXT of the currently executed MQL program
    if (uint pid = GetLastThreadProgram()) {
       ContextChain &chain = *g_mqlInstances[pid];
@@ -470,8 +384,33 @@ int __cdecl _error(const char* fileName, const char* funcName, uint line, int er
          //ec_SetDllErrorMsg(ec, formattedMsg);
       }
    }
+   return error;
+}
+
+
+/**
+ * Replacement of a log statement removed at compile time (see EXPANDER_LOGLEVEL). Nothing is formatted.
+ *
+ * @param  char* message - ignored
+ * @param        ...     - ignored
+ *
+ * @return int - 0 (NULL)
+ */
+int __cdecl _nolog(const char* message, ...) {
+   return NO_ERROR;
+}
 
-   free(formattedMsg, fullMsg);
+
+/**
+ * Replacement of a log statement with error code removed at compile time (see EXPANDER_LOGLEVEL). Nothing is formatted.
+ *
+ * @param  int   error   - error code of the message
+ * @param  char* message - ignored
+ * @param        ...     - ignored
+ *
+ * @return int - the passed error code
+ */
+int __cdecl _nolog(int error, const char* message, ...) {
    return error;
 }
 
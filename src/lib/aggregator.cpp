@@ -0,0 +1,431 @@
+#include "expander.h"
+#include "lib/aggregator.h"
+#include "lib/datetime.h"
+#include "lib/history.h"
+#include "lib/math.h"
+
+#include <vector>
+
+
+extern CRITICAL_SECTION  g_expanderMutex;                // mutex for Expander-wide locking
+std::vector<AGGREGATOR*> g_aggregators;                  // all created aggregators (index = handle-1)
+
+
+/**
+ * Return the open time of the bar a point in time belongs to. Intraday bars start at the session start of each day, so
+ * custom timeframes not dividing a day (e.g. M7) never span a session boundary. Weekly bars start on Sundays, monthly and
+ * quarterly bars on the first day of the month/quarter.
+ *
+ * @param  time32 time                    - point in time (server time)
+ * @param  uint   timeframe               - timeframe in minutes (standard or custom)
+ * @param  int    sessionOffset [optional] - offset of the session start from 00:00 in seconds (default: 0)
+ * @param  DWORD  flags         [optional] - AGGREGATOR_MERGE_SUNDAY: Sundays belong to the D1 bar of the following Monday
+ *
+ * @return time32 - bar open time or NULL in case of errors
+ */
+time32 WINAPI BarOpenTime(time32 time, uint timeframe, int sessionOffset/*=0*/, DWORD flags/*=NULL*/) {
+   if ((int)timeframe <= 0) return(!error(ERR_INVALID_PARAMETER, "invalid parameter timeframe: %d", timeframe));
+
+   time32 t = time - sessionOffset;                            // session time
+   time32 dayStart = t - t % DAY;
+   time32 open;
+
+   if (timeframe <= PERIOD_D1) {
+      uint secs = timeframe * MINUTES;
+      open = dayStart + (t - dayStart) / secs * secs;
+      if (timeframe==PERIOD_D1 && (flags & AGGREGATOR_MERGE_SUNDAY) && (dayStart/DAY + THURSDAY) % 7 == SUNDAY)
+         open += DAY;
+   }
+   else if (timeframe == PERIOD_W1) {
+      open = dayStart - ((dayStart/DAY + THURSDAY) % 7) * DAY;  // 1970-01-01 was a Thursday
+   }
+   else if (timeframe==PERIOD_MN1 || timeframe==PERIOD_Q1) {
+      TM tm = UnixTimeToTm(dayStart);
+      tm.tm_mday = 1;
+      if (timeframe == PERIOD_Q1) tm.tm_mon -= tm.tm_mon % 3;
+      open = TmToUnixTime32(tm);
+   }
+   else {
+      uint secs = timeframe * MINUTES;                         // custom multiple of days
+      open = t - t % secs;
+   }
+   return(open + sessionOffset);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the open time of the bar following the bar with the specified open time.
+ *
+ * @param  time32 openTime
+ * @param  uint   timeframe
+ * @param  int    sessionOffset
+ *
+ * @return time32
+ */
+static time32 WINAPI BarCloseTime(time32 openTime, uint timeframe, int sessionOffset) {
+   time32 t = openTime - sessionOffset;
+
+   if (timeframe <= PERIOD_D1) {
+      time32 dayEnd = t - t % DAY + DAY;                       // intraday bars end at the session end
+      return(min(t + (time32)(timeframe * MINUTES), dayEnd) + sessionOffset);
+   }
+   if (timeframe == PERIOD_W1) return(openTime + WEEK);
+
+   if (timeframe==PERIOD_MN1 || timeframe==PERIOD_Q1) {
+      TM tm = UnixTimeToTm(t);
+      tm.tm_mon += (timeframe==PERIOD_Q1) ? 3 : 1;
+      if (tm.tm_mon > 11) {
+         tm.tm_mon -= 12;
+         tm.tm_year++;
+      }
+      return(TmToUnixTime32(tm) + sessionOffset);
+   }
+   return(openTime + timeframe * MINUTES);
+}
+
+
+/**
+ * Add a price event to all target timeframes of an aggregator. A completed bar is passed to the target's history writer.
+ *
+ * @param  AGGREGATOR* agg
+ * @param  time32      time   - time of the tick or open time of the M1 bar
+ * @param  double      open
+ * @param  double      high
+ * @param  double      low
+ * @param  double      close
+ * @param  uint64      volume
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI Aggregator_Update(AGGREGATOR* agg, time32 time, double open, double high, double low, double close, uint64 volume) {
+   if (time < agg->lastTime) return(TRUE);                     // out of order: ignore
+   agg->lastTime = time;
+
+   if (agg->flags & AGGREGATOR_SKIP_WEEKEND) {
+      int dow = ((time - agg->sessionOffset) / DAY + THURSDAY) % 7;
+      if (dow==SATURDAY || dow==SUNDAY) return(TRUE);
+   }
+
+   uint size = agg->targets.size();
+   for (uint i=0; i < size; i++) {
+      AGGREGATOR_TARGET &target = agg->targets[i];
+      HistoryBar401 &bar = target.bar;
+
+      if (target.hasBar && time >= bar.time && time < target.closeTime) {
+         bar.high        = max(bar.high, high);                // the common case: the forming bar continues
+         bar.low         = min(bar.low, low);
+         bar.close       = close;
+         bar.tickVolume += volume;
+         continue;
+      }
+
+      time32 barTime = BarOpenTime(time, target.timeframe, agg->sessionOffset, agg->flags);
+      if (target.hasBar && barTime == bar.time) {              // e.g. a merged Sunday
+         bar.high        = max(bar.high, high);
+         bar.low         = min(bar.low, low);
+         bar.close       = close;
+         bar.tickVolume += volume;
+         continue;
+      }
+      if (target.hasBar && target.hWriter && !HistoryWriter_AddBars(target.hWriter, &bar, 1)) return(FALSE);
+
+      memset(&bar, 0, sizeof(bar));
+      bar.time       = barTime;
+      bar.open       = open;
+      bar.high       = high;
+      bar.low        = low;
+      bar.close      = close;
+      bar.tickVolume = volume;
+      target.closeTime = BarCloseTime(barTime, target.timeframe, agg->sessionOffset);
+      target.hasBar    = TRUE;
+   }
+   return(TRUE);
+}
+
+
+/**
+ * Create an aggregator building bars of multiple timeframes from ticks or M1 bars in a single pass.
+ *
+ * @param  char* symbol                   - symbol
+ * @param  uint  digits                   - digits of the symbol
+ * @param  DWORD flags         [optional] - AGGREGATOR_SKIP_WEEKEND | AGGREGATOR_MERGE_SUNDAY (default: none)
+ * @param  int   sessionOffset [optional] - offset of the session start from 00:00 in seconds, e.g. -7*HOURS for sessions
+ *                                          starting at 17:00 of the previous day (default: 0)
+ *
+ * @return uint - aggregator handle or NULL in case of errors
+ */
+uint WINAPI Aggregator_Create(const char* symbol, uint digits, DWORD flags/*=NULL*/, int sessionOffset/*=0*/) {
+   if ((uint)symbol < MIN_VALID_POINTER)               return(!error(ERR_INVALID_PARAMETER, "invalid parameter symbol: 0x%p (not a valid pointer)", symbol));
+   if (!*symbol || strlen(symbol) > MAX_SYMBOL_LENGTH) return(!error(ERR_INVALID_PARAMETER, "invalid parameter symbol: \"%s\"", symbol));
+   if ((int)digits < 0)                                return(!error(ERR_INVALID_PARAMETER, "invalid parameter digits: %d", digits));
+   if (sessionOffset <= -DAY || sessionOffset >= DAY)  return(!error(ERR_INVALID_PARAMETER, "invalid parameter sessionOffset: %d (must be within one day)", sessionOffset));
+
+   AGGREGATOR* agg = new AGGREGATOR();
+   agg->symbol        = symbol;
+   agg->digits        = digits;
+   agg->flags         = flags;
+   agg->sessionOffset = sessionOffset;
+   agg->lastTime      = 0;
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_aggregators.push_back(agg);                               // may re-allocate, thus needs to be synchronized
+   agg->id = g_aggregators.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(agg->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve an aggregator handle.
+ *
+ * @param  uint hAggregator - aggregator handle
+ *
+ * @return AGGREGATOR* - the aggregator or NULL in case of errors
+ */
+static AGGREGATOR* WINAPI GetAggregator(uint hAggregator) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_aggregators.size();                           // the vector may be re-allocated by another thread
+   AGGREGATOR* agg = ((int)hAggregator > 0 && hAggregator <= size) ? g_aggregators[hAggregator-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hAggregator <= 0 || hAggregator > size) return((AGGREGATOR*)!error(ERR_INVALID_PARAMETER, "invalid parameter hAggregator: %d (unknown handle)", hAggregator));
+   if (!agg)                                        return((AGGREGATOR*)!error(ERR_ILLEGAL_STATE, "aggregator already released: hAggregator=%d", hAggregator));
+   return(agg);
+}
+
+
+/**
+ * Add a target timeframe to an aggregator. If a history file is specified completed bars are appended to it.
+ *
+ * @param  uint  hAggregator        - aggregator handle
+ * @param  uint  timeframe          - timeframe in minutes (standard or custom)
+ * @param  char* hstFile [optional] - full name of the history file to write (default: none)
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Aggregator_AddTimeframe(uint hAggregator, uint timeframe, const char* hstFile/*=NULL*/) {
+   AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg)                                        return(FALSE);
+   if ((int)timeframe <= 0)                         return(!error(ERR_INVALID_PARAMETER, "invalid parameter timeframe: %d", timeframe));
+   if (timeframe > PERIOD_D1 && timeframe % PERIOD_D1 && timeframe!=PERIOD_W1 && timeframe!=PERIOD_MN1 && timeframe!=PERIOD_Q1)
+                                                    return(!error(ERR_INVALID_PARAMETER, "invalid parameter timeframe: %d (not a multiple of D1)", timeframe));
+   if (hstFile && (uint)hstFile < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter hstFile: 0x%p (not a valid pointer)", hstFile));
+   if (agg->lastTime)                               return(!error(ERR_ILLEGAL_STATE, "cannot add a timeframe after data was added"));
+
+   uint size = agg->targets.size();
+   for (uint i=0; i < size; i++) {
+      if (agg->targets[i].timeframe == timeframe) return(!error(ERR_INVALID_PARAMETER, "duplicate timeframe: %d", timeframe));
+   }
+
+   AGGREGATOR_TARGET target = {};
+   target.timeframe = timeframe;
+   if (hstFile) {
+      target.hWriter = HistoryWriter_Open(hstFile, agg->symbol.c_str(), timeframe, agg->digits);
+      if (!target.hWriter) return(FALSE);
+   }
+   agg->targets.push_back(target);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Add a single tick to an aggregator.
+ *
+ * @param  uint   hAggregator - aggregator handle
+ * @param  time32 time        - tick time
+ * @param  double price       - tick price (Bid)
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Aggregator_AddTick(uint hAggregator, time32 time, double price) {
+   AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg) return(FALSE);
+   return(Aggregator_Update(agg, time, price, price, price, price, 1));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Add ticks to an aggregator. Ticks of other symbols are skipped, so the records of "ticks.raw" can be passed as they are.
+ *
+ * @param  uint hAggregator - aggregator handle
+ * @param  TICK ticks[]     - ticks in ascending order
+ * @param  int  count       - number of ticks
+ *
+ * @return int - number of processed ticks or EMPTY (-1) in case of errors
+ */
+int WINAPI Aggregator_AddTicks(uint hAggregator, const TICK ticks[], int count) {
+   AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg)                            return(EMPTY);
+   if ((uint)ticks < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ticks: 0x%p (not a valid pointer)", ticks)));
+   if (count < 0)                       return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter count: %d (must be >= 0)", count)));
+
+   const char* symbol = agg->symbol.c_str();
+   int processed = 0;
+
+   for (int i=0; i < count; i++) {
+      const TICK &tick = ticks[i];
+      if (strncmp(tick.symbol, symbol, MAX_SYMBOL_LENGTH)) continue;
+      if (!Aggregator_Update(agg, tick.time, tick.bid, tick.bid, tick.bid, tick.bid, 1)) return(EMPTY);
+      processed++;
+   }
+   return(processed);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Add M1 bars to an aggregator.
+ *
+ * @param  uint          hAggregator - aggregator handle
+ * @param  HistoryBar401 bars[]      - M1 bars in ascending order
+ * @param  int           count       - number of bars
+ *
+ * @return int - number of processed bars or EMPTY (-1) in case of errors
+ */
+int WINAPI Aggregator_AddBars(uint hAggregator, const HistoryBar401 bars[], int count) {
+   AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg)                           return(EMPTY);
+   if ((uint)bars < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter bars: 0x%p (not a valid pointer)", bars)));
+   if (count < 0)                      return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter count: %d (must be >= 0)", count)));
+
+   for (int i=0; i < count; i++) {
+      const HistoryBar401 &bar = bars[i];
+      if (!Aggregator_Update(agg, bar.time, bar.open, bar.high, bar.low, bar.close, bar.tickVolume)) return(EMPTY);
+   }
+   return(count);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the forming bar of a target timeframe of an aggregator.
+ *
+ * @param  uint hAggregator - aggregator handle
+ * @param  uint timeframe   - target timeframe
+ *
+ * @return HistoryBar401* - the forming bar or NULL if the timeframe holds no data yet or in case of errors
+ */
+const HistoryBar401* WINAPI Aggregator_CurrentBar(uint hAggregator, uint timeframe) {
+   const AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg) return(NULL);
+
+   uint size = agg->targets.size();
+   for (uint i=0; i < size; i++) {
+      const AGGREGATOR_TARGET &target = agg->targets[i];
+      if (target.timeframe == timeframe) return(target.hasBar ? &target.bar : NULL);
+   }
+   return((HistoryBar401*)!error(ERR_INVALID_PARAMETER, "unknown timeframe: %d", timeframe));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Pass the forming bars of an aggregator to the history writers and flush them to disk.
+ *
+ * @param  AGGREGATOR* agg
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI Aggregator_FlushTargets(AGGREGATOR* agg) {
+   BOOL success = TRUE;
+   uint size = agg->targets.size();
+   for (uint i=0; i < size; i++) {
+      AGGREGATOR_TARGET &target = agg->targets[i];
+      if (!target.hWriter) continue;
+      if (target.hasBar && !HistoryWriter_AddBars(target.hWriter, &target.bar, 1)) success = FALSE;
+      else if (!HistoryWriter_Flush(target.hWriter))                                success = FALSE;
+   }
+   return(success);
+}
+
+
+/**
+ * Pass the forming bars of an aggregator to the history writers and flush them to disk.
+ *
+ * @param  uint hAggregator - aggregator handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Aggregator_Flush(uint hAggregator) {
+   AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg) return(FALSE);
+   return(Aggregator_FlushTargets(agg));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Flush the forming bars of an aggregator, close its history writers and delete it. The aggregator must already be
+ * removed from the registry.
+ *
+ * @param  AGGREGATOR* agg
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI Aggregator_Destroy(AGGREGATOR* agg) {
+   BOOL success = Aggregator_FlushTargets(agg);
+
+   uint size = agg->targets.size();
+   for (uint i=0; i < size; i++) {
+      if (agg->targets[i].hWriter && !HistoryWriter_Close(agg->targets[i].hWriter)) success = FALSE;
+   }
+   delete agg;
+   return(success);
+}
+
+
+/**
+ * Release an aggregator. Forming bars are flushed and the history writers are closed.
+ *
+ * @param  uint hAggregator - aggregator handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Aggregator_Release(uint hAggregator) {
+   AGGREGATOR* agg = GetAggregator(hAggregator);
+   if (!agg) return(FALSE);
+
+   // The slot is reset only if it still holds the resolved aggregator. Of concurrent releases of the same handle only one
+   // succeeds.
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL released = (hAggregator <= g_aggregators.size() && g_aggregators[hAggregator-1] == agg);    // ReleaseAggregators() swaps the vector
+   if (released) g_aggregators[hAggregator-1] = NULL;          // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+   if (!released) return(!error(ERR_ILLEGAL_STATE, "aggregator already released: hAggregator=%d", hAggregator));
+
+   return(Aggregator_Destroy(agg));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Release all aggregators still existing. Called on DLL_PROCESS_DETACH before the history writers are released.
+ */
+void WINAPI ReleaseAggregators() {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::vector<AGGREGATOR*> aggregators;
+   aggregators.swap(g_aggregators);
+   LeaveCriticalSection(&g_expanderMutex);
+
+   uint size = aggregators.size();
+   for (uint i=0; i < size; i++) {
+      if (aggregators[i]) Aggregator_Destroy(aggregators[i]);
+   }
+}
@@ -1,6 +1,65 @@
 #include "expander.h"
 #include "lib/array.h"
 
+#include <algorithm>
+#include <emmintrin.h>
+
+
+extern CRITICAL_SECTION           g_expanderMutex;       // mutex for Expander-wide locking
+std::vector<RingBuffer<double>*> g_ringBuffers;          // all created indicator ring buffers (index = handle-1)
+
+
+/**
+ * Fill a memory range with a value. The aligned middle part is written with SSE2 16-byte stores, large ranges (which would
+ * only evict the cache) with non-temporal stores.
+ *
+ * @param  T*  dest  - start of the range (must be aligned to sizeof(T) for the SSE2 path)
+ * @param  int count - number of elements
+ * @param  T   value - fill value
+ */
+template <typename T>
+void WINAPI FillArray(T* dest, int count, T value) {
+   if (count < 32 || (uint)dest % sizeof(T)) {
+      std::fill_n(dest, count, value);
+      return;
+   }
+
+   // fill the head until the destination is 16-byte aligned
+   int head = ((16 - (uint)dest % 16) % 16) / sizeof(T);
+   std::fill_n(dest, head, value);
+   dest  += head;
+   count -= head;
+
+   // build a 16-byte pattern of the value
+   T pattern[16/sizeof(T)];
+   std::fill_n(pattern, 16/sizeof(T), value);
+   __m128i v = _mm_loadu_si128((const __m128i*)pattern);
+
+   int blocks = count * sizeof(T) / 16;
+   __m128i* p = (__m128i*)dest;
+   if (blocks * 16 >= 1024*1024) {
+      for (int i=0; i < blocks; i++) _mm_stream_si128(p+i, v);
+      _mm_sfence();
+   }
+   else {
+      for (int i=0; i < blocks; i++) _mm_store_si128(p+i, v);
+   }
+
+   // fill the tail
+   int done = blocks * 16 / sizeof(T);
+   std::fill_n(dest + done, count - done, value);
+}
+
+
+// explicit template instantiation to make definitions accessible to the linker
+template void FillArray<bool>  (bool*,   int, bool  );
+template void FillArray<char>  (char*,   int, char  );
+template void FillArray<short> (short*,  int, short );
+template void FillArray<int>   (int*,    int, int   );
+template void FillArray<int64> (int64*,  int, int64 );
+template void FillArray<float> (float*,  int, float );
+template void FillArray<double>(double*, int, double);
+
 
 /**
  * Initialize a range of array elements with a custom value.
@@ -30,7 +89,7 @@ BOOL WINAPI InitializeArray(T array[], int size, T initValue, int from, int coun
       if (from+count > size)    return(!error(ERR_INVALID_PARAMETER, "invalid parameter count: %d (out of range)", count));
    }
 
-   std::fill_n(&array[from], count, initValue);
+   FillArray(&array[from], count, initValue);
    return(TRUE);
 }
 
@@ -181,6 +240,103 @@ BOOL WINAPI InitializeDoubleArray(double array[], int size, double initValue, in
 }
 
 
+/**
+ * Scan an unsorted <int> array for a value using SSE2, 4 elements per comparison.
+ *
+ * @param  int  array[] - array to search
+ * @param  int  size    - number of elements in the array
+ * @param  int  value   - value to search
+ * @param  BOOL fromEnd - whether to return the last instead of the first match
+ *
+ * @return int - memory index of the match or EMPTY (-1) if the value was not found
+ */
+static int WINAPI ScanIntArray(const int array[], int size, int value, BOOL fromEnd) {
+   __m128i v = _mm_set1_epi32(value);
+   int blocks = size/4;
+
+   if (!fromEnd) {
+      for (int b=0; b < blocks; b++) {
+         int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(array + b*4)), v)));
+         if (mask) {
+            for (int i=0; i < 4; i++) if (mask & (1 << i)) return(b*4 + i);
+         }
+      }
+      for (int i=blocks*4; i < size; i++) {
+         if (array[i] == value) return(i);
+      }
+   }
+   else {
+      for (int i=size-1; i >= blocks*4; i--) {
+         if (array[i] == value) return(i);
+      }
+      for (int b=blocks-1; b >= 0; b--) {
+         int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(array + b*4)), v)));
+         if (mask) {
+            for (int i=3; i >= 0; i--) if (mask & (1 << i)) return(b*4 + i);
+         }
+      }
+   }
+   return(EMPTY);
+}
+
+
+/**
+ * Scan an unsorted <double> array for a value using SSE2, 2 elements per comparison. Values are compared exactly, NaN never
+ * matches.
+ *
+ * @param  double array[] - array to search
+ * @param  int    size    - number of elements in the array
+ * @param  double value   - value to search
+ * @param  BOOL   fromEnd - whether to return the last instead of the first match
+ *
+ * @return int - memory index of the match or EMPTY (-1) if the value was not found
+ */
+static int WINAPI ScanDoubleArray(const double array[], int size, double value, BOOL fromEnd) {
+   __m128d v = _mm_set1_pd(value);
+   int blocks = size/2;
+
+   if (!fromEnd) {
+      for (int b=0; b < blocks; b++) {
+         int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(array + b*2), v));
+         if (mask) return(b*2 + ((mask & 1) ? 0 : 1));
+      }
+      if (size % 2 && array[size-1] == value) return(size-1);
+   }
+   else {
+      if (size % 2 && array[size-1] == value) return(size-1);
+      for (int b=blocks-1; b >= 0; b--) {
+         int mask = _mm_movemask_pd(_mm_cmpeq_pd(_mm_loadu_pd(array + b*2), v));
+         if (mask) return(b*2 + ((mask & 2) ? 1 : 0));
+      }
+   }
+   return(EMPTY);
+}
+
+
+/**
+ * Binary search of a value in an array sorted ascending.
+ *
+ * @param  T    array[] - array to search
+ * @param  int  size    - number of elements in the array
+ * @param  T    value   - value to search
+ * @param  BOOL fromEnd - whether to return the last instead of the first match
+ *
+ * @return int - memory index of the match or EMPTY (-1) if the value was not found
+ */
+template <typename T>
+static int WINAPI BinarySearch(const T array[], int size, T value, BOOL fromEnd) {
+   if (!fromEnd) {
+      const T* pos = std::lower_bound(array, array+size, value);
+      if (pos != array+size && *pos == value) return(pos - array);
+   }
+   else {
+      const T* pos = std::upper_bound(array, array+size, value);
+      if (pos != array && *(pos-1) == value) return(pos-1 - array);
+   }
+   return(EMPTY);
+}
+
+
 /**
  * Search an <int> array for a value and return its index.
  *
@@ -192,9 +348,220 @@ BOOL WINAPI InitializeDoubleArray(double array[], int size, double initValue, in
  * @return int - index of the first match or EMPTY (-1) if the value was not found;
  *               -2 in case of errors
  */
-int WINAPI SearchIntArray(const int array[], int size, int value, BOOL reverseIndexed = FALSE) {
-   return(EMPTY);
-   //#pragma EXPANDER_EXPORT
+int WINAPI SearchIntArray(const int array[], int size, int value, BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+
+   int i = ScanIntArray(array, size, value, reverseIndexed);
+   if (i == EMPTY || !reverseIndexed) return(i);
+   return(size-1-i);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Search an <int> array sorted ascending for a value and return its index. Uses a binary search.
+ *
+ * @param  int  array[]                   - array to search (sorted ascending in memory)
+ * @param  int  size                      - number of elements in the array
+ * @param  int  value                     - value to search
+ * @param  BOOL reverseIndexed [optional] - whether the array should be reverse indexed like an MQL timeseries array (default: no)
+ *
+ * @return int - index of the first match or EMPTY (-1) if the value was not found;
+ *               -2 in case of errors
+ */
+int WINAPI SearchSortedIntArray(const int array[], int size, int value, BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+
+   int i = BinarySearch(array, size, value, reverseIndexed);
+   if (i == EMPTY || !reverseIndexed) return(i);
+   return(size-1-i);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Search a <double> array for a value and return its index. Values are compared exactly.
+ *
+ * @param  double array[]                   - array to search
+ * @param  int    size                      - number of elements in the array
+ * @param  double value                     - value to search
+ * @param  BOOL   reverseIndexed [optional] - whether the array should be reverse indexed like an MQL timeseries array (default: no)
+ *
+ * @return int - index of the first match or EMPTY (-1) if the value was not found;
+ *               -2 in case of errors
+ */
+int WINAPI SearchDoubleArray(const double array[], int size, double value, BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+
+   int i = ScanDoubleArray(array, size, value, reverseIndexed);
+   if (i == EMPTY || !reverseIndexed) return(i);
+   return(size-1-i);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Search a <double> array sorted ascending for a value and return its index. Uses a binary search, values are compared
+ * exactly.
+ *
+ * @param  double array[]                   - array to search (sorted ascending in memory)
+ * @param  int    size                      - number of elements in the array
+ * @param  double value                     - value to search
+ * @param  BOOL   reverseIndexed [optional] - whether the array should be reverse indexed like an MQL timeseries array (default: no)
+ *
+ * @return int - index of the first match or EMPTY (-1) if the value was not found;
+ *               -2 in case of errors
+ */
+int WINAPI SearchSortedDoubleArray(const double array[], int size, double value, BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+
+   int i = BinarySearch(array, size, value, reverseIndexed);
+   if (i == EMPTY || !reverseIndexed) return(i);
+   return(size-1-i);
+   #pragma EXPANDER_EXPORT
+}
+
+
+// string comparison in the same order as used by SortMqlStringsA/W()
+static int WINAPI StrCmp(const char*  s1, const char*  s2) { return(strcmp(s1, s2)); }
+static int WINAPI StrCmp(const wchar* s1, const wchar* s2) { return(wcscmp(s1, s2)); }
+
+
+/**
+ * Search a string array for a value. Array elements holding a NULL pointer never match.
+ *
+ * @param  S    array[]  - MqlStringA or MqlStringW array
+ * @param  int  size     - number of elements in the array
+ * @param  C*   value    - value to search
+ * @param  BOOL fromEnd  - whether to return the last instead of the first match
+ * @param  BOOL sorted   - whether the array is sorted ascending by SortMqlStrings*()
+ *
+ * @return int - memory index of the match or EMPTY (-1) if the value was not found
+ */
+template <typename S, typename C>
+static int WINAPI SearchStrings(const S array[], int size, const C* value, BOOL fromEnd, BOOL sorted) {
+   if (!sorted) {
+      if (!fromEnd) {
+         for (int i=0; i < size; i++) {
+            if (array[i].value && !StrCmp(array[i].value, value)) return(i);
+         }
+      }
+      else {
+         for (int i=size-1; i >= 0; i--) {
+            if (array[i].value && !StrCmp(array[i].value, value)) return(i);
+         }
+      }
+      return(EMPTY);
+   }
+
+   int lo = 0, hi = size;                                      // first element not less than the value, NULL elements
+   while (lo < hi) {                                           // are considered less than any string
+      int mid = lo + (hi-lo)/2;
+      if (!array[mid].value || StrCmp(array[mid].value, value) < 0) lo = mid + 1;
+      else                                                          hi = mid;
+   }
+   if (lo == size || !array[lo].value || StrCmp(array[lo].value, value)) return(EMPTY);
+   if (fromEnd) {
+      while (lo+1 < size && array[lo+1].value && !StrCmp(array[lo+1].value, value)) lo++;
+   }
+   return(lo);
+}
+
+
+/**
+ * Search an MQL4.0 string array for a value and return its index.
+ *
+ * @param  MqlStringA array[]                   - array to search
+ * @param  int        size                      - number of elements in the array
+ * @param  char*      value                     - value to search
+ * @param  BOOL       sorted         [optional] - whether the array is sorted by SortMqlStringsA(), enables a binary search (default: no)
+ * @param  BOOL       reverseIndexed [optional] - whether the array should be reverse indexed like an MQL timeseries array (default: no)
+ *
+ * @return int - index of the first match or EMPTY (-1) if the value was not found;
+ *               -2 in case of errors
+ */
+int WINAPI SearchStringArrayA(const MqlStringA array[], int size, const char* value, BOOL sorted/*=FALSE*/, BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+   if ((uint)value < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter value: 0x%p (not a valid pointer)", value)));
+
+   int i = SearchStrings(array, size, value, reverseIndexed, sorted);
+   if (i == EMPTY || !reverseIndexed) return(i);
+   return(size-1-i);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Search an MQL4.5 string array for a value and return its index.
+ *
+ * @param  MqlStringW array[]                   - array to search
+ * @param  int        size                      - number of elements in the array
+ * @param  wchar*     value                     - value to search
+ * @param  BOOL       sorted         [optional] - whether the array is sorted by SortMqlStringsW(), enables a binary search (default: no)
+ * @param  BOOL       reverseIndexed [optional] - whether the array should be reverse indexed like an MQL timeseries array (default: no)
+ *
+ * @return int - index of the first match or EMPTY (-1) if the value was not found;
+ *               -2 in case of errors
+ */
+int WINAPI SearchStringArrayW(const MqlStringW array[], int size, const wchar* value, BOOL sorted/*=FALSE*/, BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+   if ((uint)value < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter value: 0x%p (not a valid pointer)", value)));
+
+   int i = SearchStrings(array, size, value, reverseIndexed, sorted);
+   if (i == EMPTY || !reverseIndexed) return(i);
+   return(size-1-i);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Search an <int> array for multiple values at once, e.g. to reconcile a list of tickets with the open positions. The keys
+ * are sorted once and the array is scanned a single time, so the cost is O(n*log(k)) instead of O(n*k) for k separate
+ * searches.
+ *
+ * @param  int  array[]                   - array to search
+ * @param  int  size                      - number of elements in the array
+ * @param  int  keys[]                    - values to search
+ * @param  int  keysSize                  - number of values to search
+ * @param  int  results[]                 - array receiving for each key the index of its first match or EMPTY (-1)
+ * @param  BOOL reverseIndexed [optional] - whether the array should be reverse indexed like an MQL timeseries array (default: no)
+ *
+ * @return int - number of keys found or -2 in case of errors
+ */
+int WINAPI SearchIntArrayKeys(const int array[], int size, const int keys[], int keysSize, int results[], BOOL reverseIndexed/*=FALSE*/) {
+   if ((uint)array < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter array: 0x%p (not a valid pointer)", array)));
+   if (size < 0)                        return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+   if ((uint)keys < MIN_VALID_POINTER)    return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter keys: 0x%p (not a valid pointer)", keys)));
+   if ((uint)results < MIN_VALID_POINTER) return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results)));
+   if (keysSize < 0)                      return(_int(-2, error(ERR_INVALID_PARAMETER, "invalid parameter keysSize: %d (must be >= 0)", keysSize)));
+
+   std::vector<std::pair<int, int> > sortedKeys(keysSize);     // key and its position
+   for (int k=0; k < keysSize; k++) {
+      sortedKeys[k] = std::make_pair(keys[k], k);
+      results[k] = EMPTY;
+   }
+   std::sort(sortedKeys.begin(), sortedKeys.end());
+
+   int found = 0;
+   for (int n=0; n < size && found < keysSize; n++) {
+      int i = reverseIndexed ? size-1-n : n;                   // scan in index order
+      std::vector<std::pair<int, int> >::iterator it = std::lower_bound(sortedKeys.begin(), sortedKeys.end(), std::make_pair(array[i], INT_MIN));
+
+      for (; it != sortedKeys.end() && it->first == array[i]; ++it) {
+         if (results[it->second] == EMPTY) {
+            results[it->second] = n;
+            found++;
+         }
+      }
+   }
+   return(found);
+   #pragma EXPANDER_EXPORT
 }
 
 
@@ -220,7 +587,7 @@ BOOL WINAPI ShiftIndicatorBuffer(T buffer[], int size, int count, T emptyValue)
    if (count < size) {
       MoveMemory((void*)&buffer[0], &buffer[count], (size-count)*sizeof(buffer[0]));
    }
-   std::fill_n(&buffer[size-count], count, emptyValue);
+   FillArray(&buffer[size-count], count, emptyValue);
    return(TRUE);
 }
 
@@ -369,3 +736,247 @@ BOOL WINAPI ShiftDoubleIndicatorBuffer(double buffer[], int size, int count, dou
    return(ShiftIndicatorBuffer(buffer, size, count, emptyValue));
    #pragma EXPANDER_EXPORT
 }
+
+
+/**
+ * Shift a ring buffer by the specified number of elements. Discards the oldest elements and initializes the same number of
+ * youngest elements with the empty value. Only the head index moves, so the cost is O(count) instead of O(size).
+ *
+ * @param  int count - number of elements to shift
+ */
+template <typename T>
+void RingBuffer<T>::shift(int count) {
+   if (count >= size) {
+      head = 0;
+      FillArray(&data[0], size, emptyValue);
+      return;
+   }
+   int first = head;                                           // the oldest slots become the youngest ones
+   head = (head + count) % size;
+
+   int n = min(count, size-first);
+   FillArray(&data[first], n, emptyValue);
+   if (n < count) FillArray(&data[0], count-n, emptyValue);
+}
+
+
+/**
+ * Copy a ring buffer into a flat array with the oldest element first, i.e. in the memory layout of an MQL timeseries array.
+ *
+ * @param  T* dest - destination array holding at least 'size' elements
+ */
+template <typename T>
+void RingBuffer<T>::copyTo(T* dest) const {
+   int n = size - head;
+   CopyMemory(dest,   &data[head], n    * sizeof(T));
+   CopyMemory(dest+n, &data[0],    head * sizeof(T));
+}
+
+
+// explicit template instantiation to make definitions accessible to the linker
+template struct RingBuffer<double>;
+
+
+/**
+ * Create a ring buffer for indicator values. Shifting the buffer on a new bar only advances its head index instead of
+ * moving all elements as ShiftIndicatorBuffer() does. The buffer is materialized into an MQL indicator buffer only when
+ * requested by RingBuffer_CopyTo(). The buffer is bound to the calling MQL program and released on the program's final
+ * deinitialization if the program doesn't release it by itself.
+ *
+ * @param  EXECUTION_CONTEXT* ec         - execution context of the program
+ * @param  int                size       - number of elements
+ * @param  double             emptyValue - initialization value for elements interpreted as "empty"
+ *
+ * @return uint - ring buffer handle or NULL in case of errors
+ */
+uint WINAPI RingBuffer_Create(const EXECUTION_CONTEXT* ec, int size, double emptyValue) {
+   if ((uint)ec < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec));
+   if (!ec->pid)                     return(!error(ERR_INVALID_PARAMETER, "invalid execution context (ec.pid=0)"));
+   if (size <= 0)                    return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be > 0)", size));
+
+   RingBuffer<double>* rb = new RingBuffer<double>();
+   rb->data.resize(size);
+   rb->size       = size;
+   rb->head       = 0;
+   rb->emptyValue = emptyValue;
+   rb->pid        = ec->pid;
+   FillArray(&rb->data[0], size, emptyValue);
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_ringBuffers.push_back(rb);                                // may re-allocate, thus needs to be synchronized
+   uint id = g_ringBuffers.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve a ring buffer handle.
+ *
+ * @param  uint hBuffer - ring buffer handle
+ *
+ * @return RingBuffer<double>* - the ring buffer or NULL in case of errors
+ */
+static RingBuffer<double>* WINAPI GetRingBuffer(uint hBuffer) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_ringBuffers.size();                           // the vector may be re-allocated by RingBuffer_Create()
+   RingBuffer<double>* rb = ((int)hBuffer > 0 && hBuffer <= size) ? g_ringBuffers[hBuffer-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hBuffer <= 0 || hBuffer > size) return((RingBuffer<double>*)!error(ERR_INVALID_PARAMETER, "invalid parameter hBuffer: %d (unknown handle)", hBuffer));
+   if (!rb)                                 return((RingBuffer<double>*)!error(ERR_ILLEGAL_STATE, "ring buffer already released: hBuffer=%d", hBuffer));
+   return(rb);
+}
+
+
+/**
+ * Shift a ring buffer by the specified number of elements. Discards the oldest elements.
+ *
+ * @param  uint hBuffer - ring buffer handle
+ * @param  int  count   - number of elements to shift
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI RingBuffer_Shift(uint hBuffer, int count) {
+   RingBuffer<double>* rb = GetRingBuffer(hBuffer);
+   if (!rb) return(FALSE);
+   if (count < 0) return(!error(ERR_INVALID_PARAMETER, "invalid parameter count: %d (must be >= 0)", count));
+
+   if (count) rb->shift(count);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Set an element of a ring buffer.
+ *
+ * @param  uint   hBuffer - ring buffer handle
+ * @param  int    bar     - bar offset (0 = youngest element)
+ * @param  double value
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI RingBuffer_Set(uint hBuffer, int bar, double value) {
+   RingBuffer<double>* rb = GetRingBuffer(hBuffer);
+   if (!rb) return(FALSE);
+   if (bar < 0 || bar >= rb->size) return(!error(ERR_INVALID_PARAMETER, "invalid parameter bar: %d (out of range)", bar));
+
+   (*rb)[bar] = value;
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Get an element of a ring buffer.
+ *
+ * @param  uint hBuffer - ring buffer handle
+ * @param  int  bar     - bar offset (0 = youngest element)
+ *
+ * @return double - value or EMPTY_VALUE in case of errors
+ */
+double WINAPI RingBuffer_Get(uint hBuffer, int bar) {
+   RingBuffer<double>* rb = GetRingBuffer(hBuffer);
+   if (!rb) return(EMPTY_VALUE);
+   if (bar < 0 || bar >= rb->size) return(_EMPTY_VALUE(error(ERR_INVALID_PARAMETER, "invalid parameter bar: %d (out of range)", bar)));
+
+   return((*rb)[bar]);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Materialize a ring buffer into an MQL indicator buffer.
+ *
+ * @param  uint   hBuffer  - ring buffer handle
+ * @param  double buffer[] - MQL indicator buffer
+ * @param  int    size     - number of elements of the indicator buffer (must match the ring buffer)
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI RingBuffer_CopyTo(uint hBuffer, double buffer[], int size) {
+   RingBuffer<double>* rb = GetRingBuffer(hBuffer);
+   if (!rb) return(FALSE);
+   if ((uint)buffer < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter buffer: 0x%p (not a valid pointer)", buffer));
+   if (size != rb->size)                 return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (ring buffer size: %d)", size, rb->size));
+
+   rb->copyTo(buffer);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Release a ring buffer.
+ *
+ * @param  uint hBuffer - ring buffer handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI RingBuffer_Release(uint hBuffer) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_ringBuffers.size();
+   RingBuffer<double>* rb = ((int)hBuffer > 0 && hBuffer <= size) ? g_ringBuffers[hBuffer-1] : NULL;
+   if (rb) g_ringBuffers[hBuffer-1] = NULL;                    // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hBuffer <= 0 || hBuffer > size) return(!error(ERR_INVALID_PARAMETER, "invalid parameter hBuffer: %d (unknown handle)", hBuffer));
+   if (!rb)                                 return(!error(ERR_ILLEGAL_STATE, "ring buffer already released: hBuffer=%d", hBuffer));
+
+   delete rb;
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Release all ring buffers of an MQL program. Called on final deinitialization of the program.
+ *
+ * @param  uint pid - MQL program id
+ */
+void WINAPI ReleaseRingBuffers(uint pid) {
+   std::vector<RingBuffer<double>*> released;
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_ringBuffers.size();
+   for (uint i=0; i < size; i++) {
+      RingBuffer<double>* rb = g_ringBuffers[i];
+      if (rb && rb->pid==pid) {
+         g_ringBuffers[i] = NULL;
+         released.push_back(rb);
+      }
+   }
+   LeaveCriticalSection(&g_expanderMutex);
+
+   for (uint i=0; i < released.size(); i++) {
+      delete released[i];
+   }
+}
+
+
+/**
+ * Release all ring buffers of all programs. Called on DLL unloading.
+ */
+void WINAPI ReleaseRingBuffers() {
+   uint size = g_ringBuffers.size();
+   for (uint i=0; i < size; i++) {
+      delete g_ringBuffers[i];
+      g_ringBuffers[i] = NULL;
+   }
+   g_ringBuffers.clear();
+}
@@ -0,0 +1,178 @@
+#include "expander.h"
+#include "lib/binarylog.h"
+#include "lib/string.h"
+
+#include <map>
+
+
+/**
+ * Binary logfile appender. AppendLogMessageA() queues a log message as a BLOG_MESSAGE header followed by the NUL terminated
+ * strings to intern and the raw message (see BinaryLog_ComposeMessage()). The log writer converts the queued message to the
+ * file format (see "struct/BinaryLog.h") when it writes the message. As the log writer serializes all access to loggers, the
+ * string tables need no separate lock.
+ */
+typedef std::map<string, WORD> StringTable;                  // interned strings and their ids
+
+std::map<std::ofstream*, StringTable*> g_binaryLogs;     // string tables of the binary logfiles (accessed by the log writer only)
+
+
+/**
+ * Whether a logfile is written in binary format.
+ *
+ * @param  char* filename
+ *
+ * @return BOOL
+ */
+BOOL WINAPI IsBinaryLogfileA(const char* filename) {
+   return(filename && StrEndsWithI(filename, BINARY_LOG_EXTENSION));
+}
+
+
+/**
+ * Compose a log message for queuing. The string ids in the header are resolved when the message is written.
+ *
+ * @param  string       &buffer     - buffer receiving the composed message
+ * @param  BLOG_MESSAGE &header     - message header (the string ids are ignored)
+ * @param  char*        level       - loglevel description
+ * @param  char*        symbol      - chart symbol
+ * @param  char*        period      - timeframe description
+ * @param  char*        path        - execution path
+ * @param  char*        errorDescr  - error description or an empty string (no error)
+ * @param  char*        message     - raw log message
+ */
+void WINAPI BinaryLog_ComposeMessage(string &buffer, const BLOG_MESSAGE &header, const char* level, const char* symbol, const char* period, const char* path, const char* errorDescr, const char* message) {
+   BLOG_MESSAGE msg = header;
+   msg.type   = BLOG_RECORD_MESSAGE;
+   msg.length = strlen(message);
+
+   buffer.assign((char*)&msg, sizeof(msg));
+   buffer.append(level).append(1, '\0');
+   buffer.append(symbol).append(1, '\0');
+   buffer.append(period).append(1, '\0');
+   buffer.append(path).append(1, '\0');
+   buffer.append(errorDescr).append(1, '\0');
+   buffer.append(message, msg.length);
+}
+
+
+/**
+ * Append a file header to an output buffer.
+ *
+ * @param  string &out
+ */
+static void WINAPI BinaryLog_AppendHeader(string &out) {
+   BLOG_HEADER header = {};
+   header.type = BLOG_RECORD_HEADER;
+   memcpy(header.magic, BLOG_MAGIC, sizeof(header.magic));
+   header.version = BLOG_VERSION;
+   out.append((char*)&header, sizeof(header));
+}
+
+
+/**
+ * Resolve the id of an interned string. A string seen for the first time is added to the string table and its definition
+ * is appended to the output buffer.
+ *
+ * @param  StringTable &table
+ * @param  char*       &str   - NUL terminated string, on return the pointer is positioned after the string
+ * @param  string      &out   - output buffer
+ *
+ * @return WORD - string id
+ */
+static WORD WINAPI BinaryLog_Intern(StringTable &table, const char* &str, string &out) {
+   uint len = strlen(str);
+   string value(str, len);
+   str += len + 1;
+
+   StringTable::iterator it = table.find(value);
+   if (it != table.end()) return(it->second);
+
+   BLOG_STRING def = {};
+   def.type   = BLOG_RECORD_STRING;
+   def.id     = (WORD)(table.size() + 1);
+   def.length = (WORD)min(len, (uint)USHRT_MAX);
+   out.append((char*)&def, sizeof(def)).append(value, 0, def.length);
+
+   table[value] = def.id;
+   return(def.id);
+}
+
+
+/**
+ * Convert a message composed by BinaryLog_ComposeMessage() to the file format and append it to an output buffer. Must be
+ * called by the log writer only.
+ *
+ * @param  std::ofstream* logger - target logfile
+ * @param  char*          data   - composed message
+ * @param  uint           length - length of the composed message
+ * @param  string         &out   - output buffer
+ */
+void WINAPI BinaryLog_Encode(std::ofstream* logger, const char* data, uint length, string &out) {
+   if (length < sizeof(BLOG_MESSAGE)) return;
+
+   StringTable* &table = g_binaryLogs[logger];
+   if (!table) {                                                  // the logfile was not opened by BinaryLog_Open()
+      table = new StringTable();
+      BinaryLog_AppendHeader(out);
+   }
+   else if (table->size() > BLOG_MAX_STRINGS-5) {                 // the string table is full: start a new section
+      table->clear();
+      BinaryLog_AppendHeader(out);
+   }
+
+   BLOG_MESSAGE msg = *(BLOG_MESSAGE*)data;
+   const char* str = data + sizeof(BLOG_MESSAGE);
+   msg.levelId  = BinaryLog_Intern(*table, str, out);
+   msg.symbolId = BinaryLog_Intern(*table, str, out);
+   msg.periodId = BinaryLog_Intern(*table, str, out);
+   msg.pathId   = BinaryLog_Intern(*table, str, out);
+   if (*str) msg.errorId = BinaryLog_Intern(*table, str, out);
+   else    { msg.errorId = 0; str++; }                             // no error
+
+   out.append((char*)&msg, sizeof(msg)).append(str, msg.length);
+}
+
+
+/**
+ * Start a new section in a binary logfile which was just opened. Resets the logfile's string table and writes a file header.
+ * Must be called with exclusive access to the logger (see LogWriter_Lock()).
+ *
+ * @param  std::ofstream* logger
+ */
+void WINAPI BinaryLog_Open(std::ofstream* logger) {
+   StringTable* &table = g_binaryLogs[logger];
+   if (!table) table = new StringTable();
+   else        table->clear();
+
+   string header;
+   BinaryLog_AppendHeader(header);
+   logger->write(header.data(), header.size());
+}
+
+
+/**
+ * Release the string table of a logfile which was closed or is about to be deleted. If the logfile is reopened or a new
+ * logger gets the same address, the next write starts a new section. Must be called with exclusive access to the logger
+ * (see LogWriter_Lock()).
+ *
+ * @param  std::ofstream* logger
+ */
+void WINAPI BinaryLog_Close(std::ofstream* logger) {
+   std::map<std::ofstream*, StringTable*>::iterator it = g_binaryLogs.find(logger);
+   if (it != g_binaryLogs.end()) {
+      delete it->second;
+      g_binaryLogs.erase(it);
+   }
+}
+
+
+/**
+ * Release the string tables of all binary logfiles. Called on DLL_PROCESS_DETACH after the log writer was stopped.
+ */
+void WINAPI ReleaseBinaryLogs() {
+   std::map<std::ofstream*, StringTable*>::iterator it;
+   for (it=g_binaryLogs.begin(); it != g_binaryLogs.end(); ++it) {
+      delete it->second;
+   }
+   g_binaryLogs.clear();
+}
@@ -1255,6 +1255,45 @@ wchar* WINAPI LocalTimeFormatW(time64 time, const wchar* format) {
 }
 
 
+/**
+ * Format a timestamp as "YYYY-MM-DD HH:MM:SS[.mmm]" using a cache. The date, hour and minute part is rendered only when the
+ * minute changes, otherwise only the seconds and milliseconds digits are updated. Meant for log entries with a high
+ * frequency of mostly increasing timestamps.
+ *
+ * @param  TIME_FORMAT_CACHE &cache                  - cache (one per thread, not synchronized)
+ * @param  time32             time                   - Unix timestamp (seconds since 01.01.1970 00:00 GMT)
+ * @param  BOOL               toLocalTime            - whether to format as local or as GMT time
+ * @param  int                milliseconds [optional] - milliseconds to append (default: none)
+ *
+ * @return char* - pointer to the formatted time in the cache (valid until the next call)
+ */
+const char* WINAPI cachedTimeFormat(TIME_FORMAT_CACHE &cache, time32 time, BOOL toLocalTime, int milliseconds/*=EMPTY*/) {
+   time32 minute = time - (time % 60);
+
+   if (minute != cache.minute || toLocalTime != cache.localTime || !cache.minute) {
+      TM tm = UnixTimeToTm(minute, toLocalTime);
+      sprintf(cache.buffer, "%04d-%02d-%02d %02d:%02d:", tm.tm_year+1900, tm.tm_mon+1, tm.tm_mday, tm.tm_hour, tm.tm_min);
+      cache.minute    = minute;
+      cache.localTime = toLocalTime;
+   }
+   uint seconds = time - minute;                            // the prefix has a fixed length of 17 chars
+   cache.buffer[17] = (char)('0' + seconds/10);
+   cache.buffer[18] = (char)('0' + seconds%10);
+
+   if (milliseconds < 0) {
+      cache.buffer[19] = '\0';
+   }
+   else {
+      cache.buffer[19] = '.';
+      cache.buffer[20] = (char)('0' + milliseconds/100 % 10);
+      cache.buffer[21] = (char)('0' + milliseconds/10 % 10);
+      cache.buffer[22] = (char)('0' + milliseconds % 10);
+      cache.buffer[23] = '\0';
+   }
+   return(cache.buffer);
+}
+
+
 /**
  * Convert a FILETIME to a SYSTEMTIME.
  *
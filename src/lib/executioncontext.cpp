@@ -1,22 +1,31 @@
 #include "expander.h"
+#include "lib/array.h"
+#include "lib/binarylog.h"
 #include "lib/conversion.h"
 #include "lib/datetime.h"
 #include "lib/executioncontext.h"
 #include "lib/helper.h"
+#include "lib/logbuffer.h"
+#include "lib/logwriter.h"
+#include "lib/indicators/incremental.h"
 #include "lib/math.h"
 #include "lib/string.h"
 #include "lib/terminal.h"
+#include "lib/tester.h"
 #include "lib/win32.h"
 #include "struct/ExecutionContext.h"
 
+#include <algorithm>
 #include <fstream>
 
 
-MqlInstanceList    g_mqlInstances(1);              // all MQL program instances: index 0 is not a valid pid and is always empty
-std::vector<DWORD> g_threads;                      // all known threads executing MQL programs
-std::vector<uint>  g_threadsPrograms;              // pid of the last MQL program executed by a thread
+MqlInstanceList    g_mqlInstances;                 // all MQL program instances: index 0 is not a valid pid and is always empty
+DWORD              g_threadSlotTls = TLS_OUT_OF_INDEXES;   // TLS index holding a thread's THREAD_SLOT*
+THREAD_SLOT*       g_threadSegments[MAX_THREAD_SEGMENTS];  // registry of all known threads executing MQL programs
+volatile LONG      g_threadSlotsCount;                     // number of slots handed out by the registry
 uint               g_lastUiThreadProgram;          // pid of the last MQL program executed by the UI thread
 CRITICAL_SECTION   g_expanderMutex;                // mutex for Expander-wide locking
+std::vector<uint>  g_limboIndex[LIMBO_BUCKETS];    // unloaded indicators waiting for reload, bucket = hash of the program name
 
 struct RECOMPILED_MODULE {                         // A struct holding the last MQL module with UninitReason UR_RECOMPILE.
    uint       pid;                                 // Only one module is tracked (the last one) and the variable is accessed
@@ -394,6 +403,7 @@ int WINAPI MqlProgram_init(EXECUTION_CONTEXT* ec, ProgramType programType, const
       master = (*g_mqlInstances[currentPid])[0];
       (*g_mqlInstances[currentPid])[1] = ec;                               // store main context at old (possibly empty) position
    }
+   UnretireProgram(currentPid);                                            // the program may have been retired before reloading
 
    // update main and master context
    ec_SetProgramType         (ec, programType );
@@ -599,6 +609,16 @@ int WINAPI MqlProgram_deinit(EXECUTION_CONTEXT* ec, UninitializeReason uninitRea
       else warn(ERR_ILLEGAL_STATE, "no module context found at chain[%d]: %p  main=%s", i, chain[i], EXECUTION_CONTEXT_toStr(ec));
    }
 
+   // release resources bound to the program instance
+   if (uninitReason==UR_REMOVE || uninitReason==UR_CHARTCLOSE || uninitReason==UR_CLOSE) {
+      ReleaseIndicators(ec->pid);
+      ReleaseRingBuffers(ec->pid);
+   }
+   if (ec->programType==PT_EXPERT && ec->testing) {
+      ReleaseTestSession(ec->pid);
+   }
+   LogWriter_Flush();                                                // write pending log entries
+
    if (debugOptions & OPTION_DEBUG_EXECUTION_CONTEXT) debug("o:%p  %-17s  %-14s  ec=%s", ec, ec->programName, UninitReasonToStr(uninitReason), EXECUTION_CONTEXT_toStr(ec));
    return(NO_ERROR);
    #pragma EXPANDER_EXPORT
@@ -660,6 +680,7 @@ int WINAPI MqlLibrary_init(EXECUTION_CONTEXT* ec, UninitializeReason uninitReaso
             if (!pid) error(ERR_RUNTIME_ERROR, "UR_RECOMPILE - no %s library found in g_recompiledModule (pid=%d, type=%s, name=%s):  thread=%d %s  isTesting=%s", moduleName, g_recompiledModule.pid, ModuleTypeToStr(g_recompiledModule.type), g_recompiledModule.name, GetCurrentThreadId(), IsUiThread() ? "(UI)":"(non-UI)", BoolToStr(isTesting));
             else {
                SetLastThreadProgram(pid);                            // asap
+               UnretireProgram(pid);
                g_recompiledModule = RECOMPILED_MODULE();             // reset recompilation tracker
 
                *ec = *(*g_mqlInstances[pid])[0];                     // initialize empty library context with master context
@@ -702,7 +723,7 @@ int WINAPI MqlLibrary_init(EXECUTION_CONTEXT* ec, UninitializeReason uninitReaso
                chain->push_back(master);                             // add master to a new chain
                chain->push_back(NULL);                               // add empty entry for the yet to come main context
                currentPid = PushProgram(chain);                      // store the chain
-               uint threadIndex = SetLastThreadProgram(currentPid);
+               SetLastThreadProgram(currentPid);
 
                master->pid         = currentPid;                     // update master context with the known values
                master->programType = PT_EXPERT;
@@ -714,7 +735,7 @@ int WINAPI MqlLibrary_init(EXECUTION_CONTEXT* ec, UninitializeReason uninitReaso
                master->point        = point;
 
                master->superContext = FALSE;
-               master->threadId     = g_threads[threadIndex];
+               master->threadId     = GetCurrentThreadId();
 
                master->testing      = TRUE;                          // TODO: so wrong, we can be online and not in tester
                master->optimization = isOptimization;
@@ -761,6 +782,7 @@ int WINAPI MqlLibrary_init(EXECUTION_CONTEXT* ec, UninitializeReason uninitReaso
       // (2.1) ec.pid is set: indicator in init cycle or in IR_PROGRAM_AFTERTEST (both UI thread)
       //       ec.pid points to the original indicator (still in limbo), Library::init() is called before Indicator::init()
       SetLastThreadProgram(ec->pid);                                 // set the thread's currently executed program asap (error handling)
+      UnretireProgram(ec->pid);
 
       EXECUTION_CONTEXT* master = (*g_mqlInstances[ec->pid])[0];
       if (isTesting) {                                               // indicator in IR_PROGRAM_AFTERTEST
@@ -846,7 +868,7 @@ int WINAPI MqlLibrary_init(EXECUTION_CONTEXT* ec, UninitializeReason uninitReaso
          chain->push_back(master);                                   // add master to a new chain
          chain->push_back(NULL);                                     // add empty entry for the yet to come main context
          currentPid = PushProgram(chain);                            // store the chain and get a new pid
-         uint threadIndex = SetLastThreadProgram(currentPid);
+         SetLastThreadProgram(currentPid);
 
          master->pid              = currentPid;                      // update master context with the known values
          master->previousPid      = ec->pid;
@@ -864,7 +886,7 @@ int WINAPI MqlLibrary_init(EXECUTION_CONTEXT* ec, UninitializeReason uninitReaso
          master->pip       = round(1./pow((double)10., (int)master->pipDigits), master->pipDigits);
          master->point     = point;
 
-         master->threadId     = g_threads[threadIndex];
+         master->threadId     = GetCurrentThreadId();
          master->testing      = TRUE;
          master->optimization = isOptimization;
          master->debugOptions = debugOptions;
@@ -978,6 +1000,7 @@ int WINAPI LeaveMqlModule(EXECUTION_CONTEXT* ec) {
             else warn(ERR_ILLEGAL_STATE, "no module context found at chain[%d]: (null)  main=%s", i, EXECUTION_CONTEXT_toStr(ec));
          }
          chain[1] = NULL;                                                  // unset the main execution context but keep the slot in the chain
+         if (ec->moduleType == MT_INDICATOR) AddToLimboIndex(ec->pid);    // the indicator may get reloaded
          break;
 
       // --- library module --------------------------------------------------------------------------------------------------
@@ -1010,7 +1033,15 @@ int WINAPI LeaveMqlModule(EXECUTION_CONTEXT* ec) {
    // close an open logfile
    EXECUTION_CONTEXT* master = chain[0];
    if (master && master->logger && master->logger->is_open()) {
+      LogWriter_Lock();
       master->logger->close();                                             // re-opened automatically on next use
+      BinaryLog_Close(master->logger);
+      LogWriter_Unlock();
+   }
+
+   // retire the program if it was unloaded for good
+   if (Program_IsFinished(ec->pid)) {
+      RetireProgram(ec->pid);
    }
    return(NO_ERROR);
    #pragma EXPANDER_EXPORT
@@ -1018,7 +1049,63 @@ int WINAPI LeaveMqlModule(EXECUTION_CONTEXT* ec) {
 
 
 /**
- * Find the first unloaded indicator or library suitable for reloading matching the specified arguments.
+ * Return the bucket of the limbo index for an indicator name.
+ *
+ * @param  char* name - program name
+ *
+ * @return uint - bucket index
+ */
+static uint WINAPI LimboBucket(const char* name) {
+   uint hash = 2166136261U;                                       // FNV-1a
+   for (; *name; name++) {
+      hash ^= (BYTE)*name;
+      hash *= 16777619U;
+   }
+   return hash & (LIMBO_BUCKETS-1);
+}
+
+
+/**
+ * Add an unloaded indicator to the limbo index. Entries are removed lazily by FindModuleInLimbo() when they don't refer to
+ * an unloaded indicator anymore, and by PushProgram() when the pid is recycled. A retired indicator stays in the index until
+ * then, FindModuleInLimbo() matches it only by its uninit reason and chart.
+ *
+ * @param  uint pid - program id
+ */
+void WINAPI AddToLimboIndex(uint pid) {
+   const EXECUTION_CONTEXT* master = (*g_mqlInstances[pid])[0];
+   if (!master) return;
+   std::vector<uint> &bucket = g_limboIndex[LimboBucket(master->programName)];
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   if (std::find(bucket.begin(), bucket.end(), pid) == bucket.end()) {
+      bucket.push_back(pid);
+   }
+   LeaveCriticalSection(&g_expanderMutex);
+}
+
+
+/**
+ * Remove a program from the limbo index. Must be called with g_expanderMutex held.
+ *
+ * @param  uint pid - program id
+ */
+void WINAPI RemoveFromLimboIndex(uint pid) {
+   const EXECUTION_CONTEXT* master = (*g_mqlInstances[pid])[0];
+   if (!master) return;
+   std::vector<uint> &bucket = g_limboIndex[LimboBucket(master->programName)];
+
+   std::vector<uint>::iterator it = std::find(bucket.begin(), bucket.end(), pid);
+   if (it != bucket.end()) bucket.erase(it);
+}
+
+
+/**
+ * Find the first unloaded indicator or library suitable for reloading matching the specified arguments. Indicators are
+ * looked-up in the limbo index, so the cost doesn't depend on the number of program instances.
  *
  * @param  ModuleType         moduleType - MT_INDICATOR | MT_LIBRARY
  * @param  const char*        name
@@ -1034,64 +1121,49 @@ uint WINAPI FindModuleInLimbo(ModuleType moduleType, const char* name, Uninitial
          // If the indicator was not used in a test (testing=FALSE) master.threadId must be the UI thread.
          // If the indicator was used in a test (testing=TRUE) master.threadId depends on whether one of the indicator's
          // libraries has been reloaded before.
-         uint chainsSize = g_mqlInstances.size();
-         EXECUTION_CONTEXT* master;
-
-         // TODO: In a test the hChart window is ignored - atm.
-         if (testing) {
-            for (uint i=1; i < chainsSize; ++i) {                                   // index[0] is always empty
-               ContextChain &chain = *g_mqlInstances[i];
-               uint size = chain.size();
-               if (size) {
-                  if (master = chain[0]) {
-                     if (master->programType == MT_INDICATOR) {
-                        if (!master->programCoreFunction) {                         // main module is unloaded
-                           if (master->programUninitReason == uninitReason) {
-                              if (StrCompare(master->programName, name)) {          // name check at the end
-                                 if (size > 2) {                                    // with libraries master->threadId must be the UI thread
-                                    if (IsUiThread(master->threadId)) {
-                                       return(i);
-                                    }
-                                 }
-                                 else if (!IsUiThread(master->threadId)) {          // without libraries master->threadId must not be the UI thread
-                                    return(i);
-                                 }
-                              }
-                           }
-                        }
-                     }
-                  } else warn(ERR_ILLEGAL_STATE, "illegal master context found in g_mqlPrograms[%d]:  master=NULL", i);
-               } else warn(ERR_ILLEGAL_STATE, "illegal ContextChain found at g_mqlPrograms[%d]:  size=%d", i, size);
-            }
-         }
-
          // If not in a test a chart must exist. Possible use cases:
          // - a regular init cycle in the UI thread
          // - a recompilation (again in the UI thread)
-         else {
-            if (hChart) {
-               for (uint i=1; i < chainsSize; ++i) {                                // index[0] is always empty
-                  ContextChain &chain = *g_mqlInstances[i];
-                  if (chain.size()) {
-                     if (master = chain[0]) {
-                        if (master->programType == MT_INDICATOR) {
-                           if (!master->programCoreFunction) {                      // main module is unloaded
-                              if (master->programUninitReason == uninitReason) {
-                                 if (master->chart == hChart) {                     // we are still in the same chart
-                                    if (IsUiThread(master->threadId)) {             // master->threadId must be the UI thread
-                                       if (StrCompare(master->programName, name)) { // name check last
-                                          return(i);
-                                       }
-                                    }
-                                 }
-                              }
-                           }
-                        }
-                     } else warn(ERR_ILLEGAL_STATE, "illegal master context found in g_mqlPrograms[%d]:  master=NULL", i);
-                  } else warn(ERR_ILLEGAL_STATE, "illegal ContextChain found at g_mqlPrograms[%d]:  size=%d", i, chain.size());
+         if (!testing && !hChart) break;
+         uint result = NULL;
+
+         if (!TryEnterCriticalSection(&g_expanderMutex)) {
+            debug("waiting for lock on g_expanderMutex...");
+            EnterCriticalSection(&g_expanderMutex);
+         }
+         std::vector<uint> &bucket = g_limboIndex[LimboBucket(name)];
+
+         for (uint i=0; i < bucket.size(); ) {
+            uint pid = bucket[i];
+            ContextChain &chain = *g_mqlInstances[pid];
+            uint size = chain.size();
+            EXECUTION_CONTEXT* master = size ? chain[0] : NULL;
+
+            if (!master || master->programType!=MT_INDICATOR || master->programCoreFunction) {
+               bucket.erase(bucket.begin() + i);                                    // not unloaded anymore
+               continue;
+            }
+            i++;
+            if (result && pid > result)                       continue;             // return the first match (lowest pid)
+            if (master->programUninitReason != uninitReason)  continue;
+            if (!StrCompare(master->programName, name))       continue;
+
+            // TODO: In a test the hChart window is ignored - atm.
+            if (testing) {
+               if (size > 2) {                                                      // with libraries master->threadId must be the UI thread
+                  if (IsUiThread(master->threadId)) result = pid;
                }
+               else if (!IsUiThread(master->threadId)) {                            // without libraries master->threadId must not be the UI thread
+                  result = pid;
+               }
+            }
+            else if (master->chart == hChart) {                                     // we are still in the same chart
+               if (IsUiThread(master->threadId)) result = pid;                      // master->threadId must be the UI thread
             }
          }
+         LeaveCriticalSection(&g_expanderMutex);
+
+         if (result) return(result);
          break;
       }
 
@@ -1294,48 +1366,129 @@ UninitializeReason WINAPI FixUninitReason(EXECUTION_CONTEXT* ec, ModuleType modu
 
 
 /**
- * Find the index of the current thread in the list of known threads. If the current thread is not found it is added to
- * the list.
+ * Register the current thread in the thread registry. A slot of a terminated thread is re-used, otherwise a new slot is
+ * appended. Runs once per thread, all further look-ups of the slot go through thread-local storage.
  *
- * @return uint - thread index
+ * @return THREAD_SLOT* - the thread's registry slot or NULL in case of errors
  */
-uint WINAPI GetCurrentThreadIndex() {
-   DWORD currentThread = GetCurrentThreadId();
-
-   // look-up the current thread
-   uint size = g_threads.size();
-   for (uint i=0; i < size; i++) {
-      if (g_threads[i] == currentThread) return i;                // thread found
+static THREAD_SLOT* WINAPI RegisterCurrentThread() {
+   LONG   threadId = GetCurrentThreadId();
+   HANDLE hThread  = OpenThread(SYNCHRONIZE, FALSE, threadId);
+   if (!hThread) return((THREAD_SLOT*)!error(ERR_WIN32_ERROR + GetLastError(), "OpenThread(%d)", threadId));
+   THREAD_SLOT* slot = NULL;
+
+   // re-use the slot of a terminated thread
+   uint size = min((uint)g_threadSlotsCount, (uint)MAX_THREAD_SLOTS);
+   for (uint i=0; i < size && !slot; i++) {
+      THREAD_SLOT* segment = g_threadSegments[i / THREAD_SEGMENT_SIZE];
+      if (!segment) continue;                                     // another thread is about to publish the segment
+      THREAD_SLOT* candidate = &segment[i % THREAD_SEGMENT_SIZE];
+
+      LONG owner = candidate->threadId;
+      if (owner == THREAD_SLOT_BUSY) continue;
+      if (owner && WaitForSingleObject(candidate->hThread, 0) != WAIT_OBJECT_0) continue;
+      if (InterlockedCompareExchange(&candidate->threadId, THREAD_SLOT_BUSY, owner) != owner) continue;
+      if (candidate->hThread) CloseHandle(candidate->hThread);
+      slot = candidate;
    }
 
-   // thread not found
-   if (!TryEnterCriticalSection(&g_expanderMutex)) {
-      debug("waiting for lock on: g_expanderMutex...");
-      EnterCriticalSection(&g_expanderMutex);
+   // append a new slot
+   while (!slot) {
+      uint index = InterlockedIncrement(&g_threadSlotsCount) - 1;
+      if (index >= MAX_THREAD_SLOTS) {
+         CloseHandle(hThread);
+         return((THREAD_SLOT*)!error(ERR_RUNTIME_ERROR, "thread registry full (%d threads)", MAX_THREAD_SLOTS));
+      }
+      uint n = index / THREAD_SEGMENT_SIZE;
+      if (!g_threadSegments[n]) {
+         THREAD_SLOT* segment = new THREAD_SLOT[THREAD_SEGMENT_SIZE]();
+         for (uint i=0; i < THREAD_SEGMENT_SIZE; i++) {
+            segment[i].index = n*THREAD_SEGMENT_SIZE + i;
+         }
+         if (InterlockedCompareExchangePointer((void* volatile*)&g_threadSegments[n], segment, NULL) != NULL)
+            delete[] segment;                                     // another thread published the segment first
+      }
+      THREAD_SLOT* candidate = &g_threadSegments[n][index % THREAD_SEGMENT_SIZE];
+      if (InterlockedCompareExchange(&candidate->threadId, THREAD_SLOT_BUSY, 0) == 0)
+         slot = candidate;                                        // otherwise a re-using thread was faster, try the next one
    }
-   g_threads.push_back(currentThread);                            // add current thread to the list
-   g_threadsPrograms.push_back(0);                                // add empty program index of 0 (zero) to the list
-   uint index = g_threads.size() - 1;
-   LeaveCriticalSection(&g_expanderMutex);
 
-   if (index > 768 && !(index % 100)) {
-      debug("added thread %d to thread list (size=%d)", currentThread, index+1);
+   slot->hThread    = hThread;
+   slot->isUiThread = IsUiThread();
+   slot->pid        = 0;
+   slot->timeFormat.minute = 0;
+   InterlockedExchange(&slot->threadId, threadId);                // publish the slot
+   TlsSetValue(g_threadSlotTls, slot);
+
+   if (slot->index > 768 && !(slot->index % 100)) {
+      debug("registered thread %d in thread slot %d", threadId, slot->index);
    }
-   return index;
+   return(slot);
+}
+
+
+/**
+ * Return the registry slot of the current thread. If the current thread is not yet registered it is added to the registry.
+ *
+ * @return THREAD_SLOT* - slot or NULL in case of errors
+ */
+THREAD_SLOT* WINAPI GetCurrentThreadSlot() {
+   THREAD_SLOT* slot = (THREAD_SLOT*)TlsGetValue(g_threadSlotTls);
+   if (slot) return slot;
+   return RegisterCurrentThread();
+}
+
+
+/**
+ * Find the index of the current thread in the thread registry. If the current thread is not found it is added to the
+ * registry. The index is stable for the lifetime of the thread, after the thread terminated it may be re-used.
+ *
+ * @return uint - thread index or EMPTY (-1) in case of errors
+ */
+uint WINAPI GetCurrentThreadIndex() {
+   THREAD_SLOT* slot = GetCurrentThreadSlot();
+   if (!slot) return EMPTY;
+   return slot->index;
 }
 
 
 /**
- * Get the id of the last MQL program executed by the current thread.
+ * Return the number of slots of the thread registry. Used for enumeration, slots below this number may still be in the
+ * process of being published.
+ *
+ * @return uint
+ */
+uint WINAPI GetThreadSlotsCount() {
+   return min((uint)g_threadSlotsCount, (uint)MAX_THREAD_SLOTS);
+}
+
+
+/**
+ * Return the thread registry slot at the specified index. Does not lock, the returned slot may belong to a terminated thread
+ * or be re-used at any time.
+ *
+ * @param  uint index
+ *
+ * @return THREAD_SLOT* - slot or NULL if the slot doesn't exist (yet)
+ */
+const THREAD_SLOT* WINAPI GetThreadSlot(uint index) {
+   if (index >= GetThreadSlotsCount()) return NULL;
+   const THREAD_SLOT* segment = g_threadSegments[index / THREAD_SEGMENT_SIZE];
+   if (!segment) return NULL;
+   return &segment[index % THREAD_SEGMENT_SIZE];
+}
+
+
+/**
+ * Get the id of the last MQL program executed by the current thread. A thread not yet registered didn't execute an MQL program
+ * and is not registered by this function (it's called by the error handlers).
  *
  * @return uint - program id or NULL (0) if the current thread didn't yet execute a MQL program
  */
 uint WINAPI GetLastThreadProgram() {
-   uint index = GetCurrentThreadIndex();
-   if (g_threadsPrograms.size() > index) {
-      return g_threadsPrograms[index];
-   }
-   return NULL;
+   THREAD_SLOT* slot = (THREAD_SLOT*)TlsGetValue(g_threadSlotTls);
+   if (!slot) return NULL;
+   return slot->pid;
 }
 
 
@@ -1344,18 +1497,38 @@ uint WINAPI GetLastThreadProgram() {
  *
  * @param  uint pid - MQL program id
  *
- * @return int - index of the current thread in the list of known threads or EMPTY (-1) in case of errors
+ * @return int - index of the current thread in the thread registry or EMPTY (-1) in case of errors
  */
 int WINAPI SetLastThreadProgram(uint pid) {
    if ((int)pid < 1) return _EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter pid: %d", pid));
 
-   uint index = GetCurrentThreadIndex();
-   g_threadsPrograms[index] = pid;                       // update the thread's last executed program
+   THREAD_SLOT* slot = GetCurrentThreadSlot();
+   if (!slot) return EMPTY;
+   slot->pid = pid;                                      // update the thread's last executed program
 
-   if (IsUiThread()) {
+   if (slot->isUiThread) {
       g_lastUiThreadProgram = pid;                       // update lastUiThreadProgram if the thread is the UI thread
    }
-   return index;
+   return slot->index;
+}
+
+
+/**
+ * Release the thread registry. Called on DLL_PROCESS_DETACH.
+ */
+void WINAPI ReleaseThreadSlots() {
+   for (uint n=0; n < MAX_THREAD_SEGMENTS; n++) {
+      THREAD_SLOT* segment = g_threadSegments[n];
+      if (!segment) continue;
+      for (uint i=0; i < THREAD_SEGMENT_SIZE; i++) {
+         if (segment[i].hThread) CloseHandle(segment[i].hThread);
+      }
+      g_threadSegments[n] = NULL;
+      delete[] segment;
+   }
+   g_threadSlotsCount = 0;
+   if (g_threadSlotTls != TLS_OUT_OF_INDEXES) TlsFree(g_threadSlotTls);
+   g_threadSlotTls = TLS_OUT_OF_INDEXES;
 }
 
 
@@ -1767,26 +1940,134 @@ BOOL WINAPI Program_IsVisualMode(const EXECUTION_CONTEXT* ec, BOOL isVisualMode)
 
 
 /**
- * Push the specififed ContextChain (an MQL program) onto the end of the program list.
+ * Store the specififed ContextChain (an MQL program) in the program registry. If the quarantine of retired programs is full
+ * the oldest retired pid is recycled, otherwise the chain is appended to the registry.
  *
  * @param  ContextChain* chain
  *
- * @return uint - index where the program is stored
+ * @return uint - index where the program is stored (the program id) or NULL (0) in case of errors
  */
 uint WINAPI PushProgram(ContextChain* chain) {
    if (!TryEnterCriticalSection(&g_expanderMutex)) {
       debug("waiting for lock on g_expanderMutex...");
       EnterCriticalSection(&g_expanderMutex);
    }
-   g_mqlInstances.push_back(chain);
-   uint index = g_mqlInstances.size()-1;
+   uint index;
+   ContextChain* recycled = NULL;
+
+   if (g_mqlInstances.retired.size() > MQL_INSTANCE_QUARANTINE) {
+      index = g_mqlInstances.retired.front();                     // recycle the oldest retired pid
+      g_mqlInstances.retired.pop_front();
+      RemoveFromLimboIndex(index);                                // the limbo entry still refers to the old program
+      ContextChain** slot = &g_mqlInstances.segments[index / MQL_INSTANCE_SEGMENT_SIZE][index % MQL_INSTANCE_SEGMENT_SIZE];
+      recycled = (ContextChain*)InterlockedExchangePointer((void**)slot, chain);
+   }
+   else {
+      index = g_mqlInstances.size();                              // append a new slot
+      uint n = index / MQL_INSTANCE_SEGMENT_SIZE;
+      if (n >= MAX_MQL_INSTANCE_SEGMENTS) {
+         LeaveCriticalSection(&g_expanderMutex);
+         return _int(NULL, error(ERR_RUNTIME_ERROR, "program registry full (%d instances)", MAX_MQL_INSTANCE_SEGMENTS * MQL_INSTANCE_SEGMENT_SIZE));
+      }
+      if (!g_mqlInstances.segments[n]) {
+         g_mqlInstances.segments[n] = new ContextChain*[MQL_INSTANCE_SEGMENT_SIZE]();
+      }
+      g_mqlInstances.segments[n][index % MQL_INSTANCE_SEGMENT_SIZE] = chain;
+      InterlockedIncrement(&g_mqlInstances.count);                // publish the slot (full barrier)
+   }
    LeaveCriticalSection(&g_expanderMutex);
 
+   if (recycled) {                                                // release the recycled program's state
+      ReleaseIndicators(index);
+      ReleaseRingBuffers(index);
+      ReleaseTestSession(index);
+
+      EXECUTION_CONTEXT* master = recycled->size() ? (*recycled)[0] : NULL;
+      if (master) {
+         if (master->logger) {
+            LogWriter_Lock();
+            if (master->logger->is_open()) master->logger->close();
+            BinaryLog_Close(master->logger);
+            delete master->logger;
+            LogWriter_Unlock();
+         }
+         LogBuffer_Release(master->logBuffer);
+         delete master;
+      }
+      delete recycled;
+   }
    //if (index > 31) debug("registered programs: %d", index);   // index[0] is always empty
    return index;
 }
 
 
+/**
+ * Retire a program which has been finally unloaded. The pid is quarantined and recycled by PushProgram() only after
+ * MQL_INSTANCE_QUARANTINE newer retirements, so late readers of the pid don't see a different program. A pid is retired
+ * only once.
+ *
+ * @param  uint pid - program id
+ */
+void WINAPI RetireProgram(uint pid) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::deque<uint> &retired = g_mqlInstances.retired;
+   if (std::find(retired.begin(), retired.end(), pid) == retired.end()) {
+      retired.push_back(pid);
+   }
+   LeaveCriticalSection(&g_expanderMutex);
+}
+
+
+/**
+ * Take back the retirement of a program which is loaded again, so its pid is not recycled while in use.
+ *
+ * @param  uint pid - program id
+ */
+void WINAPI UnretireProgram(uint pid) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::deque<uint> &retired = g_mqlInstances.retired;
+   std::deque<uint>::iterator it = std::find(retired.begin(), retired.end(), pid);
+   if (it != retired.end()) retired.erase(it);
+   LeaveCriticalSection(&g_expanderMutex);
+}
+
+
+/**
+ * Whether an unloaded program will never be loaded again and its pid can be retired. This is the case if the main module
+ * and all libraries have been unloaded for good. An indicator in the tester unloaded with UR_REMOVE or UR_CHARTCLOSE is
+ * not final: after the test it's reloaded with IR_PROGRAM_AFTERTEST under the same pid.
+ *
+ * @param  uint pid - program id
+ *
+ * @return BOOL
+ */
+BOOL WINAPI Program_IsFinished(uint pid) {
+   if (!pid || pid >= g_mqlInstances.size()) return FALSE;
+
+   const ContextChain &chain = *g_mqlInstances[pid];
+   if (chain.size() != 2 || chain[1]) return FALSE;             // the main module or a library is still loaded or in limbo
+   const EXECUTION_CONTEXT* master = chain[0];
+   if (!master || master->programCoreFunction) return FALSE;
+
+   switch (master->programUninitReason) {
+      case UR_CLOSE:
+         return TRUE;
+      case UR_REMOVE:
+      case UR_CHARTCLOSE:
+         return !(master->programType==PT_INDICATOR && master->testing);
+      case UR_UNDEFINED:                                          // a finished test
+         return (master->programType==PT_EXPERT && master->testing);
+   }
+   return FALSE;
+}
+
+
 /**
  * Add an indicator to the indicator list of the given chart.
  *
@@ -0,0 +1,908 @@
+#include "expander.h"
+#include "lib/datetime.h"
+#include "lib/fxt.h"
+#include "lib/history.h"
+#include "lib/math.h"
+
+#include <algorithm>
+#include <vector>
+
+
+extern CRITICAL_SECTION g_expanderMutex;                 // mutex for Expander-wide locking
+std::vector<FXT_FILE*>  g_fxtFiles;                      // all opened FXT files (index = handle-1)
+
+
+/**
+ * Map the window of an FXT file containing the specified byte range. The previously mapped window is released, so at any
+ * time at most FXT_VIEW_SIZE bytes of a file are mapped.
+ *
+ * @param  FXT_FILE* fxt    - FXT file
+ * @param  uint64    offset - file offset of the range
+ * @param  uint      size   - size of the range (must not exceed FXT_VIEW_SIZE - FXT_MAP_GRANULARITY)
+ *
+ * @return BYTE* - pointer to the start of the range or NULL in case of errors
+ */
+static const BYTE* WINAPI FxtFile_Map(FXT_FILE* fxt, uint64 offset, uint size) {
+   if (fxt->view && offset >= fxt->viewOffset && offset+size <= fxt->viewOffset+fxt->viewSize)
+      return(fxt->view + (uint)(offset - fxt->viewOffset));
+
+   if (offset+size > fxt->fileSize) return((BYTE*)!error(ERR_INVALID_PARAMETER, "range %I64u+%d exceeds the size of \"%s\" (%I64u bytes)", offset, size, fxt->filename.c_str(), fxt->fileSize));
+
+   if (fxt->view) {
+      if (!UnmapViewOfFile(fxt->view)) return((BYTE*)!error(ERR_WIN32_ERROR + GetLastError(), "UnmapViewOfFile(\"%s\")", fxt->filename.c_str()));
+      fxt->view = NULL;
+   }
+   uint64 start = offset & ~(uint64)(FXT_MAP_GRANULARITY-1);
+   uint   len   = (uint)min((uint64)FXT_VIEW_SIZE, fxt->fileSize - start);
+
+   const BYTE* view = (const BYTE*)MapViewOfFile(fxt->hMapping, FILE_MAP_READ, (DWORD)(start >> 32), (DWORD)start, len);
+   if (!view) return((BYTE*)!error(ERR_WIN32_ERROR + GetLastError(), "MapViewOfFile(\"%s\", offset=%I64u, size=%d)", fxt->filename.c_str(), start, len));
+
+   fxt->view       = view;
+   fxt->viewOffset = start;
+   fxt->viewSize   = len;
+   return(view + (uint)(offset - start));
+}
+
+
+/**
+ * Detect the tick format of an FXT file by checking the plausibility of the first tick record. Both formats share the same
+ * header version (405), they differ only in the size and layout of the tick records.
+ *
+ * @param  FXT_FILE* fxt
+ *
+ * @return uint - tick format (400 | 401) or NULL if the format can't be detected
+ */
+static uint WINAPI FxtFile_DetectTickFormat(FXT_FILE* fxt) {
+   uint64 dataSize = fxt->fileSize - sizeof(FXT_HEADER);
+   if (!dataSize) return(401);                                    // no ticks: assume the format of current terminals
+
+   for (int strict=1; strict >= 0; strict--) {                    // prefer a format matching the data size (no partial record)
+      if (dataSize >= sizeof(FXT_TICK_401) && (!strict || !(dataSize % sizeof(FXT_TICK_401)))) {
+         const FXT_TICK_401* tick = (const FXT_TICK_401*)FxtFile_Map(fxt, sizeof(FXT_HEADER), sizeof(FXT_TICK_401));
+         if (!tick) return(NULL);
+         if (!tick->reserved1 && tick->barTime > 0 && tick->tickTime >= tick->barTime) return(401);
+      }
+      if (dataSize >= sizeof(FXT_TICK_400) && (!strict || !(dataSize % sizeof(FXT_TICK_400)))) {
+         const FXT_TICK_400* tick = (const FXT_TICK_400*)FxtFile_Map(fxt, sizeof(FXT_HEADER), sizeof(FXT_TICK_400));
+         if (!tick) return(NULL);
+         if (tick->barTime > 0 && tick->tickTime >= tick->barTime) return(400);
+      }
+   }
+   return(NULL);
+}
+
+
+/**
+ * Find the end of the prolog of an FXT file. The prolog consists of the first "firstBar" bars (fallback: "startPeriod[0]"),
+ * the first modeled tick is the first tick of the following bar. Only the prolog is scanned.
+ *
+ * @param  FXT_FILE* fxt
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI FxtFile_FindProlog(FXT_FILE* fxt) {
+   const FXT_HEADER& fh = fxt->header;
+   fxt->prologBars  = fh.firstBar ? fh.firstBar : fh.startPeriod[0];
+   fxt->prologTicks = 0;
+   if (!fxt->prologBars) return(TRUE);
+
+   uint bars = 0;
+   time32 lastBarTime = 0;
+
+   for (uint i=0; i < fxt->ticks; i++) {
+      const BYTE* record = FxtFile_Map(fxt, sizeof(FXT_HEADER) + (uint64)i * fxt->tickSize, fxt->tickSize);
+      if (!record) return(FALSE);
+      time32 barTime = ((const FXT_TICK_400*)record)->barTime;      // both formats start with the 32-bit bar time
+
+      if (barTime != lastBarTime) {
+         if (bars == fxt->prologBars) {
+            fxt->prologTicks = i;
+            if (fh.firstBarTime && barTime != fh.firstBarTime) {
+               warn(ERR_INVALID_FILE_FORMAT, "prolog of \"%s\" ends at bar %s but header.firstBarTime is %s", fxt->filename.c_str(), gmtTimeFormat(barTime, "%Y.%m.%d %H:%M").c_str(), gmtTimeFormat(fh.firstBarTime, "%Y.%m.%d %H:%M").c_str());
+            }
+            return(TRUE);
+         }
+         lastBarTime = barTime;
+         bars++;
+      }
+   }
+   fxt->prologBars  = bars;                                       // the file holds no modeled ticks
+   fxt->prologTicks = fxt->ticks;
+   return(TRUE);
+}
+
+
+/**
+ * Open an FXT file for streaming. In contrast to history files the file is never mapped as a whole, only a window of
+ * FXT_VIEW_SIZE bytes around the current read position. Memory usage is constant regardless of the file size. A trailing
+ * partial tick record is ignored.
+ *
+ * A handle owns the mapped window and must not be used by multiple threads at the same time.
+ *
+ * @param  char* filename - full filename
+ *
+ * @return uint - handle of the opened FXT file or NULL in case of errors
+ */
+uint WINAPI FxtFile_Open(const char* filename) {
+   if ((uint)filename < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter filename: 0x%p (not a valid pointer)", filename));
+
+   HANDLE hFile = CreateFileA(filename,                              // file name
+                              GENERIC_READ,                          // desired access
+                              FILE_SHARE_READ|FILE_SHARE_WRITE,      // share mode
+                              NULL,                                  // default security
+                              OPEN_EXISTING,                         // open only if existing
+                              FILE_FLAG_SEQUENTIAL_SCAN,             // hint for the cache manager
+                              NULL);                                 // no attribute template
+   if (hFile == INVALID_HANDLE_VALUE) return(!error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot open \"%s\"", filename));
+
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(hFile, &size)) {
+      error(ERR_WIN32_ERROR + GetLastError(), "GetFileSizeEx(\"%s\")", filename);
+      return(!CloseHandle(hFile));
+   }
+   uint64 fileSize = size.QuadPart;
+   if (fileSize < sizeof(FXT_HEADER)) {
+      error(ERR_INVALID_FILE_FORMAT, "illegal size of FXT file \"%s\": %I64u (too small for the header)", filename, fileSize);
+      return(!CloseHandle(hFile));
+   }
+
+   HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+   if (!hMapping) {
+      error(ERR_WIN32_ERROR + GetLastError(), "CreateFileMappingA(\"%s\")", filename);
+      return(!CloseHandle(hFile));
+   }
+
+   FXT_FILE* fxt = new FXT_FILE();
+   fxt->filename = filename;
+   fxt->hFile    = hFile;
+   fxt->hMapping = hMapping;
+   fxt->fileSize = fileSize;
+
+   const FXT_HEADER* fh = (const FXT_HEADER*)FxtFile_Map(fxt, 0, sizeof(FXT_HEADER));
+   BOOL success = (fh != NULL);
+   if (success) {
+      fxt->header = *fh;
+      if (fh->version != 405) success = !error(ERR_INVALID_FILE_FORMAT, "unsupported version of FXT file \"%s\": %d", filename, fh->version);
+   }
+   if (success) {
+      fxt->tickFormat = FxtFile_DetectTickFormat(fxt);
+      if (!fxt->tickFormat) success = !error(ERR_INVALID_FILE_FORMAT, "cannot detect the tick format of FXT file \"%s\"", filename);
+   }
+   if (success) {
+      fxt->tickSize = (fxt->tickFormat==400) ? sizeof(FXT_TICK_400) : sizeof(FXT_TICK_401);
+      uint64 ticks = (fileSize - sizeof(FXT_HEADER)) / fxt->tickSize;
+      if (ticks > INT_MAX) success = !error(ERR_INVALID_FILE_FORMAT, "too many ticks in FXT file \"%s\": %I64u", filename, ticks);
+      else fxt->ticks = (uint)ticks;
+   }
+   if (success) success = FxtFile_FindProlog(fxt);
+
+   if (!success) {
+      if (fxt->view) UnmapViewOfFile(fxt->view);
+      CloseHandle(hMapping);
+      CloseHandle(hFile);
+      delete fxt;
+      return(NULL);
+   }
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_fxtFiles.push_back(fxt);                                  // may re-allocate, thus needs to be synchronized
+   fxt->id = g_fxtFiles.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(fxt->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Close an FXT file opened by FxtFile_Open().
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI FxtFile_Close(uint hFile) {
+   // The file is released and its slot is reset. The vector holding all FXT files is not modified.
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_fxtFiles.size();                              // the vector may be re-allocated by another thread
+   FXT_FILE* fxt = ((int)hFile > 0 && hFile <= size) ? g_fxtFiles[hFile-1] : NULL;
+   if (fxt) g_fxtFiles[hFile-1] = NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hFile <= 0 || hFile > size) return(!error(ERR_INVALID_PARAMETER, "invalid parameter hFile: %d (unknown handle)", hFile));
+   if (!fxt)                            return(!warn(ERR_ILLEGAL_STATE, "FXT file has already been closed: hFile=%d", hFile));
+
+   BOOL success = TRUE;
+   if (fxt->view && !UnmapViewOfFile(fxt->view)) success = !error(ERR_WIN32_ERROR + GetLastError(), "UnmapViewOfFile(\"%s\")", fxt->filename.c_str());
+   if (!CloseHandle(fxt->hMapping))              success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(hMapping of \"%s\")", fxt->filename.c_str());
+   if (!CloseHandle(fxt->hFile))                 success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(hFile of \"%s\")", fxt->filename.c_str());
+   delete fxt;
+   return(success);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve an FXT file handle.
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return FXT_FILE* - the FXT file or NULL in case of errors
+ */
+FXT_FILE* WINAPI GetFxtFile(uint hFile) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_fxtFiles.size();                              // the vector may be re-allocated by another thread
+   FXT_FILE* fxt = ((int)hFile > 0 && hFile <= size) ? g_fxtFiles[hFile-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hFile <= 0 || hFile > size) return((FXT_FILE*)!error(ERR_INVALID_PARAMETER, "invalid parameter hFile: %d (unknown handle)", hFile));
+   if (!fxt)                            return((FXT_FILE*)!error(ERR_ILLEGAL_STATE, "FXT file already closed: hFile=%d", hFile));
+   return(fxt);
+}
+
+
+/**
+ * Return the header of an opened FXT file.
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return FXT_HEADER* - header or NULL in case of errors
+ */
+const FXT_HEADER* WINAPI FxtFile_Header(uint hFile) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt) return(NULL);
+   return(&fxt->header);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the tick format of an opened FXT file.
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return uint - tick format (400 | 401) or NULL in case of errors
+ */
+uint WINAPI FxtFile_TickFormat(uint hFile) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt) return(NULL);
+   return(fxt->tickFormat);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the total number of tick records of an opened FXT file (prolog and modeled ticks).
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return int - number of tick records or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_Ticks(uint hFile) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt) return(EMPTY);
+   return(fxt->ticks);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of prolog bars of an opened FXT file.
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return int - number of prolog bars or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_PrologBars(uint hFile) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt) return(EMPTY);
+   return(fxt->prologBars);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of prolog tick records of an opened FXT file. This is also the index of the first modeled tick.
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return int - number of prolog ticks or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_PrologTicks(uint hFile) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt) return(EMPTY);
+   return(fxt->prologTicks);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of modeled tick records of an opened FXT file (without the prolog).
+ *
+ * @param  uint hFile - FXT file handle
+ *
+ * @return int - number of modeled ticks or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_ModeledTicks(uint hFile) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt) return(EMPTY);
+   return(fxt->ticks - fxt->prologTicks);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Copy a range of tick records of an FXT file to a buffer. Records of format 400 are converted to format 401. Sequential
+ * reads in blocks of a few thousand ticks are the fastest way to process a file.
+ *
+ * @param  uint    hFile   - FXT file handle
+ * @param  int     from    - index of the first tick to read (0 = first record of the file)
+ * @param  FxtTick ticks[] - buffer receiving the ticks
+ * @param  int     count   - max. number of ticks to read
+ *
+ * @return int - number of ticks read (0 at the end of the file) or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_ReadTicks(uint hFile, int from, FxtTick ticks[], int count) {
+   FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt)                            return(EMPTY);
+   if (from < 0)                        return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter from: %d (must be >= 0)", from)));
+   if ((uint)ticks < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ticks: 0x%p (not a valid pointer)", ticks)));
+   if (count < 0)                       return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter count: %d (must be >= 0)", count)));
+   if ((uint)from >= fxt->ticks)        return(0);
+
+   count = min(count, (int)(fxt->ticks - from));
+   int read = 0;
+
+   while (read < count) {
+      uint64 offset = sizeof(FXT_HEADER) + (uint64)(from+read) * fxt->tickSize;
+      const BYTE* record = FxtFile_Map(fxt, offset, fxt->tickSize);
+      if (!record) return(EMPTY);
+
+      uint available = (uint)(fxt->viewOffset + fxt->viewSize - offset) / fxt->tickSize;
+      int  batch     = min(count-read, (int)available);
+
+      if (fxt->tickFormat == 401) {
+         memcpy(&ticks[read], record, batch * sizeof(FXT_TICK_401));
+      }
+      else {
+         const FXT_TICK_400* src = (const FXT_TICK_400*)record;
+         for (int i=0; i < batch; i++) {
+            FXT_TICK_401& dest = ticks[read+i];
+            dest.barTime_ex = src[i].barTime;
+            dest.open       = src[i].open;
+            dest.high       = src[i].high;
+            dest.low        = src[i].low;
+            dest.close      = src[i].close;
+            dest.volume     = (uint64)src[i].volume;
+            dest.tickTime   = src[i].tickTime;
+            dest.flags      = src[i].flags;
+         }
+      }
+      read += batch;
+   }
+   return(read);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Copy a range of prolog tick records of an FXT file to a buffer.
+ *
+ * @param  uint    hFile   - FXT file handle
+ * @param  int     from    - index of the first tick to read (0 = first tick of the prolog)
+ * @param  FxtTick ticks[] - buffer receiving the ticks
+ * @param  int     count   - max. number of ticks to read
+ *
+ * @return int - number of ticks read (0 at the end of the prolog) or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_ReadPrologTicks(uint hFile, int from, FxtTick ticks[], int count) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt)                           return(EMPTY);
+   if (from < 0)                       return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter from: %d (must be >= 0)", from)));
+   if ((uint)from >= fxt->prologTicks) return(0);
+
+   return(FxtFile_ReadTicks(hFile, from, ticks, min(count, (int)(fxt->prologTicks - from))));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Copy a range of modeled tick records of an FXT file to a buffer.
+ *
+ * @param  uint    hFile   - FXT file handle
+ * @param  int     from    - index of the first tick to read (0 = first modeled tick after the prolog)
+ * @param  FxtTick ticks[] - buffer receiving the ticks
+ * @param  int     count   - max. number of ticks to read
+ *
+ * @return int - number of ticks read (0 at the end of the file) or EMPTY (-1) in case of errors
+ */
+int WINAPI FxtFile_ReadModeledTicks(uint hFile, int from, FxtTick ticks[], int count) {
+   const FXT_FILE* fxt = GetFxtFile(hFile);
+   if (!fxt)     return(EMPTY);
+   if (from < 0) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter from: %d (must be >= 0)", from)));
+
+   return(FxtFile_ReadTicks(hFile, fxt->prologTicks + from, ticks, count));
+   #pragma EXPANDER_EXPORT
+}
+
+
+// an M1 bar independent of the history file format
+struct FXT_M1_BAR {
+   time32 time;
+   double open;
+   double high;
+   double low;
+   double close;
+   uint   volume;
+};
+
+
+// state of the FXT generator while writing a file
+struct FXT_WRITER {
+   FXT_GENERATOR_JOB*        job;                        // the job
+   HANDLE                    hFile;                      // handle of the created file
+   std::vector<FXT_TICK_401> buffer;                     // pending ticks
+   FXT_TICK_401              bar;                        // current state of the modeled bar
+   std::vector<double>       prices;                     // scratch buffer for the prices of an M1 bar
+};
+
+
+/**
+ * Convert history bars of any format to an FXT_M1_BAR.
+ */
+static void WINAPI ToM1Bar(const HistoryBar400& src, FXT_M1_BAR& dest) {
+   dest.time   = src.time;
+   dest.open   = src.open;
+   dest.high   = src.high;
+   dest.low    = src.low;
+   dest.close  = src.close;
+   dest.volume = (uint)src.ticks;
+}
+static void WINAPI ToM1Bar(const HistoryBar401& src, FXT_M1_BAR& dest) {
+   dest.time   = src.time;
+   dest.open   = src.open;
+   dest.high   = src.high;
+   dest.low    = src.low;
+   dest.close  = src.close;
+   dest.volume = src.ticks;
+}
+
+
+/**
+ * Write the buffered ticks of the FXT generator to the file.
+ *
+ * @param  FXT_WRITER& w
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI FxtWriter_Flush(FXT_WRITER& w) {
+   if (w.buffer.empty()) return(TRUE);
+
+   DWORD size = w.buffer.size() * sizeof(FXT_TICK_401), written;
+   if (!WriteFile(w.hFile, &w.buffer[0], size, &written, NULL) || written != size)
+      return(!error(ERR_WIN32_ERROR + GetLastError(), "WriteFile(\"%s\", %d bytes)", w.job->fxtFile, size));
+
+   w.job->ticks += w.buffer.size();
+   w.buffer.clear();
+   return(TRUE);
+}
+
+
+/**
+ * Add a record with the current bar state to the FXT generator's write buffer.
+ *
+ * @param  FXT_WRITER& w
+ * @param  time32      tickTime
+ * @param  int         flags    - 0: bar update only, the expert is not run
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI FxtWriter_AddRecord(FXT_WRITER& w, time32 tickTime, int flags) {
+   w.bar.tickTime = tickTime;
+   w.bar.flags    = flags;
+   w.buffer.push_back(w.bar);
+   if (w.buffer.size() >= FXT_WRITE_BUFFER) return(FxtWriter_Flush(w));
+   return(TRUE);
+}
+
+
+/**
+ * Add a tick to the currently modeled bar.
+ *
+ * @param  FXT_WRITER& w
+ * @param  time32      tickTime
+ * @param  double      price
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI FxtWriter_AddTick(FXT_WRITER& w, time32 tickTime, double price) {
+   w.bar.high  = max(w.bar.high, price);
+   w.bar.low   = min(w.bar.low, price);
+   w.bar.close = price;
+   w.bar.volume++;
+   return(FxtWriter_AddRecord(w, tickTime, 1));
+}
+
+
+/**
+ * Start a new bar of the test timeframe.
+ *
+ * @param  FXT_WRITER& w
+ * @param  time32      barTime
+ * @param  double      open
+ */
+static void WINAPI FxtWriter_BeginBar(FXT_WRITER& w, time32 barTime, double open) {
+   w.bar.barTime_ex = barTime;
+   w.bar.open       = w.bar.high = w.bar.low = w.bar.close = open;
+   w.bar.volume     = 0;
+}
+
+
+/**
+ * Model the price path of an M1 bar. The path runs through the control points open, low, high, close for bullish bars and
+ * open, high, low, close for bearish bars. In MODE_EVERYTICK the legs between the control points are filled with
+ * intermediate prices proportional to their length, the total number of ticks is limited by the bar's tick volume.
+ *
+ * @param  FXT_M1_BAR          bar
+ * @param  uint                barModel - MODE_EVERYTICK | MODE_CONTROLPOINTS
+ * @param  uint                digits   - digits of the symbol
+ * @param  std::vector<double> prices   - vector receiving the modeled prices
+ */
+static void WINAPI ModelM1Bar(const FXT_M1_BAR& bar, uint barModel, uint digits, std::vector<double>& prices) {
+   double point = 1 / pow(10., (int)digits);
+   BOOL   bullish = (bar.close >= bar.open);
+   double points[4] = { bar.open, bullish ? bar.low : bar.high, bullish ? bar.high : bar.low, bar.close };
+
+   double cp[4];                                               // control points without consecutive duplicates
+   int    legLen[3], cps = 0, total = 0;
+   for (int i=0; i < 4; i++) {
+      double price = round(points[i], digits);
+      if (cps) {
+         int len = (int)round(fabs(price - cp[cps-1]) / point, 0);
+         if (!len) continue;
+         legLen[cps-1] = len;
+         total += len;
+      }
+      cp[cps++] = price;
+   }
+
+   prices.clear();
+   int extra = 0;
+   if (barModel == MODE_EVERYTICK && total) {
+      extra = (int)min((uint)total+1, max(bar.volume, (uint)cps)) - cps;
+   }
+
+   int legTicks[3] = {0, 0, 0}, assigned = 0;
+   for (int i=0; i < cps-1; i++) {
+      legTicks[i] = min((int)((int64)extra * legLen[i] / total), legLen[i]-1);
+      assigned += legTicks[i];
+   }
+   for (int i=0; i < cps-1 && assigned < extra; i++) {         // distribute the rounding remainder
+      if (legTicks[i] < legLen[i]-1) {
+         legTicks[i]++;
+         assigned++;
+      }
+   }
+
+   for (int i=0; i < cps; i++) {
+      prices.push_back(cp[i]);
+      if (i == cps-1) break;
+      double step = (cp[i+1] - cp[i]) / (legTicks[i] + 1);
+      for (int n=1; n <= legTicks[i]; n++) {
+         prices.push_back(round(cp[i] + n*step, digits));
+      }
+   }
+}
+
+
+/**
+ * Generate the prolog and the modeled ticks of an FXT file from M1 bars.
+ *
+ * @param  FXT_WRITER& w
+ * @param  BarSpan<T>  bars   - M1 bars
+ * @param  FXT_HEADER& header - header receiving the model statistics
+ *
+ * @return BOOL - success status
+ */
+template <typename T>
+static BOOL WINAPI FxtWriter_Generate(FXT_WRITER& w, const BarSpan<T>& bars, FXT_HEADER& header) {
+   FXT_GENERATOR_JOB& job = *w.job;
+   uint   periodSecs = job.period * MINUTES;
+   time32 from = job.from - job.from % periodSecs;
+   uint   digits = job.symbol.digits;
+
+   uint first = 0, last = bars.size;                           // first M1 bar to model (binary search)
+   while (first < last) {
+      uint mid = first + (last-first)/2;
+      if (bars[mid].time < from) first = mid + 1;
+      else                       last  = mid;
+   }
+
+   uint start = first, prologBars = 0;                         // first M1 bar of the prolog
+   time32 barTime = 0;
+   while (start > 0) {
+      time32 time = bars[start-1].time - bars[start-1].time % periodSecs;
+      if (time != barTime) {
+         if (prologBars == job.prologBars) break;
+         prologBars++;
+         barTime = time;
+      }
+      start--;
+   }
+
+   // prolog: one record per completed bar
+   FXT_M1_BAR m1 = {};
+   barTime = 0;
+   for (uint i=start; i < first; i++) {
+      ToM1Bar(bars[i], m1);
+      time32 time = m1.time - m1.time % periodSecs;
+      if (time != barTime) {
+         if (barTime && !FxtWriter_AddRecord(w, w.bar.tickTime, 0)) return(FALSE);
+         FxtWriter_BeginBar(w, time, m1.open);
+         barTime = time;
+      }
+      w.bar.high      = max(w.bar.high, m1.high);
+      w.bar.low       = min(w.bar.low, m1.low);
+      w.bar.close     = m1.close;
+      w.bar.volume   += m1.volume;
+      w.bar.tickTime  = m1.time + MINUTE - 1;
+   }
+   if (barTime && !FxtWriter_AddRecord(w, w.bar.tickTime, 0)) return(FALSE);
+
+   // modeled ticks
+   uint m1Bars = 0;
+   time32 lastM1Time = 0;
+   barTime = 0;
+   for (uint i=first; i < bars.size; i++) {
+      ToM1Bar(bars[i], m1);
+      if (job.to && m1.time >= job.to) break;
+
+      if (m1.time <= lastM1Time) {                             // out of order: skip the bar
+         job.modelErrors++;
+         continue;
+      }
+      lastM1Time = m1.time;
+      m1Bars++;
+
+      if (m1.high < max(m1.open, m1.close) || m1.low > min(m1.open, m1.close)) {
+         job.modelErrors++;                                    // inconsistent: repair the bar
+         m1.high = max(m1.high, max(m1.open, m1.close));
+         m1.low  = min(m1.low,  min(m1.open, m1.close));
+      }
+
+      time32 time = m1.time - m1.time % periodSecs;
+      BOOL isNewBar = (time != barTime);
+      if (isNewBar) {
+         FxtWriter_BeginBar(w, time, round(m1.open, digits));
+         if (!barTime) header.firstBarTime = time;
+         header.lastBarTime = barTime = time;
+         job.modeledBars++;
+      }
+
+      if (job.barModel == MODE_BAROPEN) {
+         if (isNewBar && !FxtWriter_AddTick(w, m1.time, w.bar.open)) return(FALSE);
+         w.bar.high  = max(w.bar.high, round(m1.high, digits));  // complete the bar without running the expert
+         w.bar.low   = min(w.bar.low,  round(m1.low,  digits));
+         w.bar.close = round(m1.close, digits);
+         if (!FxtWriter_AddRecord(w, m1.time + MINUTE - 1, 0)) return(FALSE);
+         continue;
+      }
+
+      ModelM1Bar(m1, job.barModel, digits, w.prices);
+      uint ticks = w.prices.size();
+      for (uint n=0; n < ticks; n++) {
+         if (!FxtWriter_AddTick(w, m1.time + n*MINUTE/ticks, w.prices[n])) return(FALSE);
+      }
+   }
+   if (!FxtWriter_Flush(w)) return(FALSE);
+
+   // model quality as reported by the terminal: 90% for M1 based "every tick" modeling, n/a (0) otherwise
+   if (job.barModel==MODE_EVERYTICK && m1Bars) {
+      job.modelQuality = round(90. * (m1Bars - min(m1Bars, job.modelErrors)) / m1Bars, 1);
+   }
+   header.modeledBars  = job.modeledBars;
+   header.modelQuality = job.modelQuality;
+   header.modelErrors  = job.modelErrors;
+   header.firstBar     = header.startPeriod[0] = prologBars;
+   return(TRUE);
+}
+
+
+/**
+ * Initialize an FXT header from the settings of a generator job.
+ *
+ * @param  FXT_GENERATOR_JOB* job
+ * @param  FXT_HEADER&        header
+ */
+static void WINAPI FxtWriter_InitHeader(const FXT_GENERATOR_JOB* job, FXT_HEADER& header) {
+   const SYMBOL& symbol = job->symbol;
+   memset(&header, 0, sizeof(header));
+
+   header.version   = 405;
+   strcpy(header.description, "Generated by the MT4Expander");
+   strncpy(header.serverName, job->serverName, sizeof(header.serverName)-1);
+   strcpy(header.symbol, symbol.name);
+   header.period    = job->period;
+   header.modelType = job->barModel;
+
+   strcpy(header.baseCurrency, symbol.baseCurrency);
+   header.spread       = symbol.spread;
+   header.digits       = symbol.digits;
+   header.pointSize    = symbol.pointSize;
+   header.minLotsize   = 1;                                   // SYMBOL holds no lot limits: 0.01...10'000 lot in steps of 0.01
+   header.maxLotsize   = 1000000;
+   header.lotStepsize  = 1;
+   header.stopDistance = symbol.stopDistance;
+
+   header.contractSize          = symbol.contractSize;
+   header.tickValue             = job->tickValue ? job->tickValue : symbol.contractSize * symbol.pointSize;
+   header.tickSize              = symbol.pointSize;
+   header.profitCalculationMode = 0;                          // Forex
+
+   header.swapEnabled           = symbol.swapEnabled;
+   header.swapType              = symbol.swapType;
+   header.swapLongValue         = symbol.swapLongValue;
+   header.swapShortValue        = symbol.swapShortValue;
+   header.swapTripleRolloverDay = symbol.swapTripleRolloverDay;
+
+   header.accountLeverage   = job->accountLeverage;
+   header.marginInit        = symbol.marginInit;
+   header.marginMaintenance = symbol.marginMaintenance;
+   header.marginHedged      = symbol.marginHedged;
+   header.marginDivider     = symbol.marginDivider;
+   strcpy(header.marginCurrency, symbol.marginCurrency);
+
+   header.commissionValue           = job->commissionValue;
+   header.commissionCalculationMode = COMM_TYPE_MONEY;
+   header.commissionType            = job->commissionType;
+
+   header.testerSettingFrom = job->from;
+   header.testerSettingTo   = job->to;
+}
+
+
+/**
+ * Generate an FXT file from M1 history. Tick records are written in format 401. The file is written sequentially in blocks
+ * of FXT_WRITE_BUFFER ticks, the header is rewritten at the end. The results are stored in the job.
+ *
+ * @param  FXT_GENERATOR_JOB* job
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI FxtFile_Generate(FXT_GENERATOR_JOB* job) {
+   if ((uint)job < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter job: 0x%p (not a valid pointer)", job));
+   job->success = FALSE;
+   job->ticks = job->modeledBars = job->modelErrors = 0;
+   job->modelQuality = 0;
+
+   if (!job->period || job->period > PERIOD_D1) return(!error(ERR_INVALID_PARAMETER, "invalid parameter job.period: %d (not between M1 and D1)", job->period));
+   if (job->barModel > MODE_BAROPEN)            return(!error(ERR_INVALID_PARAMETER, "invalid parameter job.barModel: %d", job->barModel));
+   if (job->to && job->to <= job->from)         return(!error(ERR_INVALID_PARAMETER, "invalid parameters job.from/to: %d/%d", job->from, job->to));
+   if (!job->prologBars) job->prologBars = FXT_PROLOG_BARS;
+
+   uint hHst = HistoryFile_Open(job->hstFile);
+   if (!hHst) return(FALSE);
+   const HISTORY_FILE* hf = GetHistoryFile(hHst);
+   if (hf->header->period != PERIOD_M1) {
+      error(ERR_INVALID_PARAMETER, "not an M1 history file: \"%s\" (period %d)", job->hstFile, hf->header->period);
+      return(!HistoryFile_Close(hHst));
+   }
+
+   HANDLE hFile = CreateFileA(job->fxtFile, GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+   if (hFile == INVALID_HANDLE_VALUE) {
+      error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot create \"%s\"", job->fxtFile);
+      return(!HistoryFile_Close(hHst));
+   }
+
+   FXT_HEADER header;
+   FxtWriter_InitHeader(job, header);
+   DWORD written;
+   BOOL success = WriteFile(hFile, &header, sizeof(header), &written, NULL);      // placeholder, rewritten at the end
+   if (!success) error(ERR_WIN32_ERROR + GetLastError(), "WriteFile(\"%s\", header)", job->fxtFile);
+
+   if (success) {
+      FXT_WRITER w = {};
+      w.job   = job;
+      w.hFile = hFile;
+      w.buffer.reserve(FXT_WRITE_BUFFER);
+
+      if (hf->barFormat == 400) {
+         BarSpan<HistoryBar400> bars;
+         success = GetHistoryBars(hHst, bars) && FxtWriter_Generate(w, bars, header);
+      }
+      else {
+         BarSpan<HistoryBar401> bars;
+         success = GetHistoryBars(hHst, bars) && FxtWriter_Generate(w, bars, header);
+      }
+   }
+   if (success) {
+      LARGE_INTEGER zero = {};
+      success = SetFilePointerEx(hFile, zero, NULL, FILE_BEGIN) && WriteFile(hFile, &header, sizeof(header), &written, NULL);
+      if (!success) error(ERR_WIN32_ERROR + GetLastError(), "cannot rewrite the header of \"%s\"", job->fxtFile);
+   }
+
+   if (!CloseHandle(hFile)) success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(\"%s\")", job->fxtFile);
+   HistoryFile_Close(hHst);
+   if (!success) DeleteFileA(job->fxtFile);
+
+   job->success = success;
+   return(success);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Thread procedure of an FXT generator worker.
+ */
+static DWORD WINAPI FxtGeneratorThread(LPVOID job) {
+   return(FxtFile_Generate((FXT_GENERATOR_JOB*)job));
+}
+
+
+/**
+ * Generate multiple FXT files in parallel, one worker thread per job (e.g. per symbol). Returns after all jobs have
+ * finished. The results of each job are stored in the job. The workers share only the Expander's file registries, which
+ * are accessed under g_expanderMutex.
+ *
+ * @param  FXT_GENERATOR_JOB jobs[]
+ * @param  int               count - number of jobs
+ *
+ * @return BOOL - whether all jobs succeeded
+ */
+BOOL WINAPI FxtFile_GenerateAll(FXT_GENERATOR_JOB jobs[], int count) {
+   if ((uint)jobs < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter jobs: 0x%p (not a valid pointer)", jobs));
+   if (count <= 0)                     return(!error(ERR_INVALID_PARAMETER, "invalid parameter count: %d (must be positive)", count));
+
+   BOOL success = TRUE;
+
+   for (int offset=0; offset < count; offset += MAXIMUM_WAIT_OBJECTS) {
+      int batch = min(count-offset, MAXIMUM_WAIT_OBJECTS);
+      std::vector<HANDLE> threads;
+
+      for (int i=0; i < batch; i++) {
+         FXT_GENERATOR_JOB* job = &jobs[offset+i];
+         HANDLE hThread = CreateThread(NULL, 0, FxtGeneratorThread, job, 0, NULL);
+         if (hThread) {
+            threads.push_back(hThread);
+         }
+         else {
+            warn(ERR_WIN32_ERROR + GetLastError(), "CreateThread(\"FxtGenerator\") failed, generating \"%s\" in the current thread", job->fxtFile);
+            FxtFile_Generate(job);
+         }
+      }
+      if (!threads.empty() && WaitForMultipleObjects(threads.size(), &threads[0], TRUE, INFINITE) == WAIT_FAILED) {
+         success = !error(ERR_WIN32_ERROR + GetLastError(), "WaitForMultipleObjects()");
+         for (uint i=0; i < threads.size(); i++) {              // the workers still use the jobs: join them one by one
+            if (WaitForSingleObject(threads[i], INFINITE) == WAIT_FAILED) error(ERR_WIN32_ERROR + GetLastError(), "WaitForSingleObject()");
+         }
+      }
+      for (uint i=0; i < threads.size(); i++) CloseHandle(threads[i]);
+   }
+
+   for (int i=0; i < count; i++) {
+      success = success && jobs[i].success;
+   }
+   return(success);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Close all FXT files still open. Called on DLL_PROCESS_DETACH.
+ */
+void WINAPI ReleaseFxtFiles() {
+   uint size = g_fxtFiles.size();
+   for (uint i=0; i < size; i++) {
+      if (g_fxtFiles[i]) FxtFile_Close(i+1);
+   }
+}
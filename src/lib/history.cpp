@@ -0,0 +1,640 @@
+#include "expander.h"
+#include "lib/history.h"
+#include "lib/string.h"
+
+#include <vector>
+
+
+extern CRITICAL_SECTION      g_expanderMutex;            // mutex for Expander-wide locking
+std::vector<HISTORY_FILE*>   g_historyFiles;             // all opened history files (index = handle-1)
+std::vector<HISTORY_WRITER*> g_historyWriters;           // all opened history writers (index = handle-1)
+
+
+/**
+ * Validate the header of a history file.
+ *
+ * @param  HISTORY_HEADER* hh       - header to validate
+ * @param  uint64          fileSize - size of the file
+ * @param  char*           filename - filename used for error messages
+ *
+ * @return BOOL - whether the header is valid
+ */
+BOOL WINAPI ValidateHistoryHeader(const HISTORY_HEADER* hh, uint64 fileSize, const char* filename) {
+   if ((uint)hh < MIN_VALID_POINTER)         return(!error(ERR_INVALID_PARAMETER, "invalid parameter hh: 0x%p (not a valid pointer)", hh));
+   if (fileSize < sizeof(HISTORY_HEADER))    return(!error(ERR_INVALID_FILE_FORMAT, "illegal size of history file \"%s\": %I64u (too small for the header)", filename, fileSize));
+   if (hh->barFormat!=400 && hh->barFormat!=401)
+                                             return(!error(ERR_INVALID_FILE_FORMAT, "unsupported bar format of history file \"%s\": %d", filename, hh->barFormat));
+   if (!hh->symbol[0] || strnlen(hh->symbol, sizeof(hh->symbol)) == sizeof(hh->symbol))
+                                             return(!error(ERR_INVALID_FILE_FORMAT, "illegal symbol in history file \"%s\" (empty or not terminated)", filename));
+   if ((int)hh->period <= 0)                 return(!error(ERR_INVALID_FILE_FORMAT, "illegal timeframe in history file \"%s\": %d", filename, hh->period));
+   if ((int)hh->digits < 0)                  return(!error(ERR_INVALID_FILE_FORMAT, "illegal digits in history file \"%s\": %d", filename, hh->digits));
+   return(TRUE);
+}
+
+
+/**
+ * Open a history file and map it read-only into memory. The file is not locked and may continue to be written to by the
+ * terminal. Bars appended after opening are not visible, to see them the file must be re-opened. A trailing partial bar
+ * (e.g. from an interrupted write) is ignored.
+ *
+ * @param  char* filename - full filename
+ *
+ * @return uint - handle of the opened history file or NULL in case of errors
+ */
+uint WINAPI HistoryFile_Open(const char* filename) {
+   if ((uint)filename < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter filename: 0x%p (not a valid pointer)", filename));
+
+   HANDLE hFile = CreateFileA(filename,                              // file name
+                              GENERIC_READ,                          // desired access
+                              FILE_SHARE_READ|FILE_SHARE_WRITE,      // share mode: the terminal may keep the file open for writing
+                              NULL,                                  // default security
+                              OPEN_EXISTING,                         // open only if existing
+                              FILE_ATTRIBUTE_NORMAL,                 // normal file
+                              NULL);                                 // no attribute template
+   if (hFile == INVALID_HANDLE_VALUE) return(!error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot open \"%s\"", filename));
+
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(hFile, &size)) {
+      error(ERR_WIN32_ERROR + GetLastError(), "GetFileSizeEx(\"%s\")", filename);
+      return(!CloseHandle(hFile));
+   }
+   uint64 fileSize = size.QuadPart;
+   if (fileSize < sizeof(HISTORY_HEADER)) {
+      error(ERR_INVALID_FILE_FORMAT, "illegal size of history file \"%s\": %I64u (too small for the header)", filename, fileSize);
+      return(!CloseHandle(hFile));
+   }
+   if (fileSize > INT_MAX) {                                         // a 32-bit process can't map it in one view
+      error(ERR_INVALID_FILE_FORMAT, "history file too large to be mapped: \"%s\" (%I64u bytes)", filename, fileSize);
+      return(!CloseHandle(hFile));
+   }
+
+   HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+   if (!hMapping) {
+      error(ERR_WIN32_ERROR + GetLastError(), "CreateFileMappingA(\"%s\")", filename);
+      return(!CloseHandle(hFile));
+   }
+   const BYTE* view = (const BYTE*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+   if (!view) {
+      error(ERR_WIN32_ERROR + GetLastError(), "MapViewOfFile(\"%s\")", filename);
+      CloseHandle(hMapping);
+      return(!CloseHandle(hFile));
+   }
+
+   const HISTORY_HEADER* hh = (const HISTORY_HEADER*)view;
+   if (!ValidateHistoryHeader(hh, fileSize, filename)) {
+      UnmapViewOfFile(view);
+      CloseHandle(hMapping);
+      return(!CloseHandle(hFile));
+   }
+
+   HISTORY_FILE* hf = new HISTORY_FILE();
+   hf->filename  = filename;
+   hf->hFile     = hFile;
+   hf->hMapping  = hMapping;
+   hf->view      = view;
+   hf->fileSize  = fileSize;
+   hf->header    = hh;
+   hf->barFormat = hh->barFormat;
+   hf->barSize   = (hh->barFormat==400) ? sizeof(HistoryBar400) : sizeof(HistoryBar401);
+   hf->bars      = view + sizeof(HISTORY_HEADER);
+   hf->barsCount = (uint)((fileSize - sizeof(HISTORY_HEADER)) / hf->barSize);
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_historyFiles.push_back(hf);                               // may re-allocate, thus needs to be synchronized
+   hf->id = g_historyFiles.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(hf->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Unmap and release a history file whose slot has been reset.
+ *
+ * @param  HISTORY_FILE* hf
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI HistoryFile_Release(HISTORY_FILE* hf) {
+   BOOL success = TRUE;
+   if (!UnmapViewOfFile(hf->view)) success = !error(ERR_WIN32_ERROR + GetLastError(), "UnmapViewOfFile(\"%s\")", hf->filename.c_str());
+   if (!CloseHandle(hf->hMapping)) success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(hMapping of \"%s\")", hf->filename.c_str());
+   if (!CloseHandle(hf->hFile))    success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(hFile of \"%s\")", hf->filename.c_str());
+   delete hf;
+   return(success);
+}
+
+
+/**
+ * Close a history file opened by HistoryFile_Open(). Pointers into the file become invalid.
+ *
+ * @param  uint hFile - history file handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI HistoryFile_Close(uint hFile) {
+   // The file is released and its slot is reset. The vector holding all history files is not modified.
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   if ((int)hFile <= 0 || hFile > g_historyFiles.size()) {
+      LeaveCriticalSection(&g_expanderMutex);
+      return(!error(ERR_INVALID_PARAMETER, "invalid parameter hFile: %d (unknown handle)", hFile));
+   }
+   HISTORY_FILE* hf = g_historyFiles[hFile-1];
+   g_historyFiles[hFile-1] = NULL;                             // a concurrent close sees the reset slot
+   LeaveCriticalSection(&g_expanderMutex);
+   if (!hf) return(!warn(ERR_ILLEGAL_STATE, "history file has already been closed: hFile=%d", hFile));
+
+   return(HistoryFile_Release(hf));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve a history file handle.
+ *
+ * @param  uint hFile - history file handle
+ *
+ * @return HISTORY_FILE* - metadata of the history file or NULL in case of errors
+ */
+const HISTORY_FILE* WINAPI GetHistoryFile(uint hFile) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_historyFiles.size();                          // the vector may be re-allocated by another thread
+   HISTORY_FILE* hf = ((int)hFile > 0 && hFile <= size) ? g_historyFiles[hFile-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hFile <= 0 || hFile > size) return((HISTORY_FILE*)!error(ERR_INVALID_PARAMETER, "invalid parameter hFile: %d (unknown handle)", hFile));
+   if (!hf)                             return((HISTORY_FILE*)!error(ERR_ILLEGAL_STATE, "history file already closed: hFile=%d", hFile));
+   return(hf);
+}
+
+
+/**
+ * Return the header of an opened history file.
+ *
+ * @param  uint hFile - history file handle
+ *
+ * @return HISTORY_HEADER* - pointer into the mapped file or NULL in case of errors
+ */
+const HISTORY_HEADER* WINAPI HistoryFile_Header(uint hFile) {
+   const HISTORY_FILE* hf = GetHistoryFile(hFile);
+   if (!hf) return(NULL);
+   return(hf->header);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the bar format of an opened history file.
+ *
+ * @param  uint hFile - history file handle
+ *
+ * @return uint - bar format (400 | 401) or NULL in case of errors
+ */
+uint WINAPI HistoryFile_BarFormat(uint hFile) {
+   const HISTORY_FILE* hf = GetHistoryFile(hFile);
+   if (!hf) return(NULL);
+   return(hf->barFormat);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of bars of an opened history file.
+ *
+ * @param  uint hFile - history file handle
+ *
+ * @return int - number of complete bars or EMPTY (-1) in case of errors
+ */
+int WINAPI HistoryFile_Bars(uint hFile) {
+   const HISTORY_FILE* hf = GetHistoryFile(hFile);
+   if (!hf) return(EMPTY);
+   return(hf->barsCount);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return a pointer to the first (oldest) bar of an opened history file. Bars are stored in the file's bar format and
+ * ordered ascending by time.
+ *
+ * @param  uint hFile - history file handle
+ *
+ * @return void* - pointer into the mapped file or NULL in case of errors
+ */
+const void* WINAPI HistoryFile_Rates(uint hFile) {
+   const HISTORY_FILE* hf = GetHistoryFile(hFile);
+   if (!hf) return(NULL);
+   return(hf->bars);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return a typed view of all bars of an opened history file. The view type must match the file's bar format.
+ *
+ * @param  uint        hFile - history file handle
+ * @param  BarSpan<T>& span  - span receiving the bars
+ *
+ * @return BOOL - success status
+ */
+template <typename T>
+BOOL WINAPI GetHistoryBars(uint hFile, BarSpan<T> &span) {
+   const HISTORY_FILE* hf = GetHistoryFile(hFile);
+   if (!hf) return(FALSE);
+   if (hf->barSize != sizeof(T)) return(!error(ERR_INVALID_PARAMETER, "bar format mismatch: history file \"%s\" has bar format %d", hf->filename.c_str(), hf->barFormat));
+
+   span.bars = (const T*)hf->bars;
+   span.size = hf->barsCount;
+   return(TRUE);
+}
+
+
+// explicit template instantiation to make definitions accessible to the linker
+template BOOL WINAPI GetHistoryBars<HistoryBar400>(uint, BarSpan<HistoryBar400>&);
+template BOOL WINAPI GetHistoryBars<HistoryBar401>(uint, BarSpan<HistoryBar401>&);
+
+
+/**
+ * Write a block of data at the specified file offset.
+ *
+ * @param  HISTORY_WRITER* hw     - history writer
+ * @param  uint64          offset - file offset
+ * @param  void*           data   - data to write
+ * @param  uint            size   - size of the data in bytes
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI HistoryWriter_WriteAt(HISTORY_WRITER* hw, uint64 offset, const void* data, uint size) {
+   LARGE_INTEGER pos; pos.QuadPart = offset;
+   if (!SetFilePointerEx(hw->hFile, pos, NULL, FILE_BEGIN))   return(!error(ERR_WIN32_ERROR + GetLastError(), "SetFilePointerEx(\"%s\", %I64u)", hw->filename.c_str(), offset));
+
+   DWORD written;
+   if (!WriteFile(hw->hFile, data, size, &written, NULL))     return(!error(ERR_WIN32_ERROR + GetLastError(), "WriteFile(\"%s\", %d bytes)", hw->filename.c_str(), size));
+   if (written != size)                                       return(!error(ERR_RUNTIME_ERROR, "WriteFile(\"%s\"): %d of %d bytes written", hw->filename.c_str(), written, size));
+   return(TRUE);
+}
+
+
+/**
+ * Open a history file for appending bars. A non-existing file is created. An existing file must be in bar format 401 and
+ * must match symbol and timeframe. Opening a file which already has an open writer returns the existing writer.
+ *
+ * New bars are collected in a write buffer and flushed to disk in large sequential chunks. The last bar stays in the buffer
+ * after each flush and is rewritten on the next one, so it can be updated in place while it's still forming.
+ *
+ * @param  char* filename  - full filename
+ * @param  char* symbol    - symbol
+ * @param  uint  timeframe - timeframe
+ * @param  uint  digits    - digits (used for new files only)
+ *
+ * @return uint - handle of the history writer or NULL in case of errors
+ */
+uint WINAPI HistoryWriter_Open(const char* filename, const char* symbol, uint timeframe, uint digits) {
+   if ((uint)filename < MIN_VALID_POINTER)      return(!error(ERR_INVALID_PARAMETER, "invalid parameter filename: 0x%p (not a valid pointer)", filename));
+   if ((uint)symbol < MIN_VALID_POINTER)        return(!error(ERR_INVALID_PARAMETER, "invalid parameter symbol: 0x%p (not a valid pointer)", symbol));
+   if (!*symbol || strlen(symbol) > MAX_SYMBOL_LENGTH)
+                                                return(!error(ERR_INVALID_PARAMETER, "invalid parameter symbol: \"%s\"", symbol));
+   if ((int)timeframe <= 0)                     return(!error(ERR_INVALID_PARAMETER, "invalid parameter timeframe: %d", timeframe));
+   if ((int)digits < 0)                         return(!error(ERR_INVALID_PARAMETER, "invalid parameter digits: %d", digits));
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_historyWriters.size();
+   for (uint i=0; i < size; i++) {                             // return an already open writer
+      HISTORY_WRITER* hw = g_historyWriters[i];
+      if (hw && !_stricmp(hw->filename.c_str(), filename)) {
+         LeaveCriticalSection(&g_expanderMutex);
+         if (_stricmp(hw->symbol.c_str(), symbol) || hw->timeframe != timeframe) return(!error(ERR_ILLEGAL_STATE, "history file \"%s\" already open for %s,%d", filename, hw->symbol.c_str(), hw->timeframe));
+         return(hw->id);
+      }
+   }
+   LeaveCriticalSection(&g_expanderMutex);
+
+   HANDLE hFile = CreateFileA(filename,                              // file name
+                              GENERIC_READ|GENERIC_WRITE,            // desired access
+                              FILE_SHARE_READ,                       // share mode: others may read (e.g. offline charts)
+                              NULL,                                  // default security
+                              OPEN_ALWAYS,                           // open existing or create new file
+                              FILE_ATTRIBUTE_NORMAL,                 // normal file
+                              NULL);                                 // no attribute template
+   if (hFile == INVALID_HANDLE_VALUE) return(!error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot open \"%s\"", filename));
+
+   HISTORY_WRITER* hw = new HISTORY_WRITER();
+   hw->filename  = filename;
+   hw->symbol    = symbol;
+   hw->timeframe = timeframe;
+   hw->hFile     = hFile;
+   hw->dirty     = FALSE;
+   hw->buffer.reserve(HISTORY_WRITE_BUFFER);
+
+   LARGE_INTEGER fileSize;
+   BOOL success = GetFileSizeEx(hFile, &fileSize);
+   if (!success) error(ERR_WIN32_ERROR + GetLastError(), "GetFileSizeEx(\"%s\")", filename);
+
+   if (success && !fileSize.QuadPart) {
+      // new file: write the header
+      HISTORY_HEADER hh = {};
+      hh.barFormat = 401;
+      strcpy(hh.symbol, symbol);
+      hh.period = timeframe;
+      hh.digits = digits;
+      success = HistoryWriter_WriteAt(hw, 0, &hh, sizeof(hh));
+      hw->writeOffset = sizeof(hh);
+   }
+   else if (success) {
+      // existing file: validate the header and continue at the last bar
+      HISTORY_HEADER hh;
+      DWORD bytesRead = 0;
+      success = ReadFile(hFile, &hh, sizeof(hh), &bytesRead, NULL);
+      if (!success)                                  error(ERR_WIN32_ERROR + GetLastError(), "ReadFile(\"%s\")", filename);
+      else if (bytesRead < sizeof(hh))               success = !error(ERR_INVALID_FILE_FORMAT, "illegal size of history file \"%s\": %I64d (too small for the header)", filename, fileSize.QuadPart);
+      else if (!ValidateHistoryHeader(&hh, fileSize.QuadPart, filename)) success = FALSE;
+      else if (hh.barFormat != 401)                  success = !error(ERR_NOT_IMPLEMENTED, "cannot append to history file \"%s\" in bar format %d", filename, hh.barFormat);
+      else if (_stricmp(hh.symbol, symbol) || hh.period != timeframe)
+                                                     success = !error(ERR_INVALID_PARAMETER, "history file \"%s\" mismatch: found %s,%d instead of %s,%d", filename, hh.symbol, hh.period, symbol, timeframe);
+      if (success) {
+         uint64 bars = (fileSize.QuadPart - sizeof(HISTORY_HEADER)) / sizeof(HistoryBar401);
+         hw->writeOffset = sizeof(HISTORY_HEADER) + bars * sizeof(HistoryBar401);
+
+         if (hw->writeOffset != fileSize.QuadPart) {                 // cut-off a trailing partial bar
+            LARGE_INTEGER pos; pos.QuadPart = hw->writeOffset;
+            success = SetFilePointerEx(hFile, pos, NULL, FILE_BEGIN) && SetEndOfFile(hFile);
+            if (!success) error(ERR_WIN32_ERROR + GetLastError(), "SetEndOfFile(\"%s\")", filename);
+         }
+         if (success && bars) {                                      // load the last bar as the forming one
+            HistoryBar401 bar;
+            hw->writeOffset -= sizeof(HistoryBar401);
+            LARGE_INTEGER pos; pos.QuadPart = hw->writeOffset;
+            success = SetFilePointerEx(hFile, pos, NULL, FILE_BEGIN) && ReadFile(hFile, &bar, sizeof(bar), &bytesRead, NULL) && bytesRead==sizeof(bar);
+            if (success) hw->buffer.push_back(bar);
+            else         error(ERR_WIN32_ERROR + GetLastError(), "cannot read last bar of \"%s\"", filename);
+         }
+      }
+   }
+   if (!success) {
+      CloseHandle(hFile);
+      delete hw;
+      return(NULL);
+   }
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_historyWriters.push_back(hw);                             // may re-allocate, thus needs to be synchronized
+   hw->id = g_historyWriters.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(hw->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve a history writer handle.
+ *
+ * @param  uint hWriter - history writer handle
+ *
+ * @return HISTORY_WRITER* - the history writer or NULL in case of errors
+ */
+HISTORY_WRITER* WINAPI GetHistoryWriter(uint hWriter) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_historyWriters.size();                        // the vector may be re-allocated by another thread
+   HISTORY_WRITER* hw = ((int)hWriter > 0 && hWriter <= size) ? g_historyWriters[hWriter-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hWriter <= 0 || hWriter > size) return((HISTORY_WRITER*)!error(ERR_INVALID_PARAMETER, "invalid parameter hWriter: %d (unknown handle)", hWriter));
+   if (!hw)                                 return((HISTORY_WRITER*)!error(ERR_ILLEGAL_STATE, "history writer already closed: hWriter=%d", hWriter));
+   return(hw);
+}
+
+
+/**
+ * Add a bar to a history file. A bar with the same open time as the last bar replaces it, a newer bar is appended. Bars
+ * must be added in ascending order.
+ *
+ * @param  HISTORY_WRITER* hw  - history writer
+ * @param  HistoryBar401&  bar - bar to add
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI HistoryWriter_Append(HISTORY_WRITER* hw, const HistoryBar401 &bar) {
+   if (!hw->buffer.empty()) {
+      HistoryBar401 &last = hw->buffer.back();
+      if (bar.time_ex < last.time_ex) return(!error(ERR_INVALID_PARAMETER, "bar out of order: %s,%d time=%d < last bar time=%d", hw->symbol.c_str(), hw->timeframe, bar.time, last.time));
+      if (bar.time_ex == last.time_ex) {
+         last = bar;                                           // update the forming bar in place
+         hw->dirty = TRUE;
+         return(TRUE);
+      }
+      if (hw->buffer.size() >= HISTORY_WRITE_BUFFER) {
+         if (!HistoryWriter_Flush(hw->id)) return(FALSE);
+      }
+   }
+   hw->buffer.push_back(bar);
+   hw->dirty = TRUE;
+   return(TRUE);
+}
+
+
+/**
+ * Add a single bar to a history file. A bar with the same open time as the last bar replaces it, a newer bar is appended.
+ *
+ * @param  uint   hWriter - history writer handle
+ * @param  time32 time    - bar open time
+ * @param  double open
+ * @param  double high
+ * @param  double low
+ * @param  double close
+ * @param  double volume  - tick volume
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI HistoryWriter_AddBar(uint hWriter, time32 time, double open, double high, double low, double close, double volume) {
+   HISTORY_WRITER* hw = GetHistoryWriter(hWriter);
+   if (!hw) return(FALSE);
+   if (time <= 0) return(!error(ERR_INVALID_PARAMETER, "invalid parameter time: %d", time));
+
+   HistoryBar401 bar = {};
+   bar.time       = time;
+   bar.open       = open;
+   bar.high       = high;
+   bar.low        = low;
+   bar.close      = close;
+   bar.tickVolume = (uint64)volume;
+   return(HistoryWriter_Append(hw, bar));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Add multiple bars to a history file. Bars must be ordered ascending by time.
+ *
+ * @param  uint          hWriter - history writer handle
+ * @param  HistoryBar401 bars[]  - bars to add
+ * @param  int           count   - number of bars
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI HistoryWriter_AddBars(uint hWriter, const HistoryBar401 bars[], int count) {
+   HISTORY_WRITER* hw = GetHistoryWriter(hWriter);
+   if (!hw) return(FALSE);
+   if ((uint)bars < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter bars: 0x%p (not a valid pointer)", bars));
+   if (count < 0)                      return(!error(ERR_INVALID_PARAMETER, "invalid parameter count: %d", count));
+
+   for (int i=0; i < count; i++) {
+      if (!HistoryWriter_Append(hw, bars[i])) return(FALSE);
+   }
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Update a history file with a new price. If the time belongs to the last bar the bar is updated in place, otherwise a new
+ * bar is started.
+ *
+ * @param  uint   hWriter - history writer handle
+ * @param  time32 time    - open time of the bar the price belongs to
+ * @param  double price   - new price
+ * @param  double volume  - volume to add to the bar
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI HistoryWriter_UpdateBar(uint hWriter, time32 time, double price, double volume) {
+   HISTORY_WRITER* hw = GetHistoryWriter(hWriter);
+   if (!hw) return(FALSE);
+   if (time <= 0) return(!error(ERR_INVALID_PARAMETER, "invalid parameter time: %d", time));
+
+   if (!hw->buffer.empty() && hw->buffer.back().time_ex == time) {
+      HistoryBar401 &bar = hw->buffer.back();
+      bar.high        = max(bar.high, price);
+      bar.low         = min(bar.low,  price);
+      bar.close       = price;
+      bar.tickVolume += (uint64)volume;
+      hw->dirty = TRUE;
+      return(TRUE);
+   }
+   return(HistoryWriter_AddBar(hWriter, time, price, price, price, price, volume));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Write all buffered bars of a history writer to disk. The last bar is kept in the buffer and rewritten on the next flush.
+ *
+ * @param  HISTORY_WRITER* hw
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI HistoryWriter_FlushBuffer(HISTORY_WRITER* hw) {
+   if (!hw->dirty) return(TRUE);
+
+   uint bars = hw->buffer.size();
+   if (!HistoryWriter_WriteAt(hw, hw->writeOffset, &hw->buffer[0], bars * sizeof(HistoryBar401))) return(FALSE);
+
+   hw->writeOffset += (bars-1) * sizeof(HistoryBar401);
+   hw->buffer.erase(hw->buffer.begin(), hw->buffer.end()-1);
+   hw->dirty = FALSE;
+   return(TRUE);
+}
+
+
+/**
+ * Write all buffered bars to disk. The last bar is kept in the buffer and rewritten on the next flush.
+ *
+ * @param  uint hWriter - history writer handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI HistoryWriter_Flush(uint hWriter) {
+   HISTORY_WRITER* hw = GetHistoryWriter(hWriter);
+   if (!hw) return(FALSE);
+   return(HistoryWriter_FlushBuffer(hw));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Flush and release a history writer whose slot has been reset.
+ *
+ * @param  HISTORY_WRITER* hw
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI HistoryWriter_Release(HISTORY_WRITER* hw) {
+   BOOL success = HistoryWriter_FlushBuffer(hw);
+   if (!CloseHandle(hw->hFile)) success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(\"%s\")", hw->filename.c_str());
+   delete hw;
+   return(success);
+}
+
+
+/**
+ * Flush and close a history writer.
+ *
+ * @param  uint hWriter - history writer handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI HistoryWriter_Close(uint hWriter) {
+   HISTORY_WRITER* hw = GetHistoryWriter(hWriter);
+   if (!hw) return(FALSE);
+
+   // The slot is reset only if it still holds the resolved writer. Of concurrent closes of the same handle only one succeeds.
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL closed = (g_historyWriters[hWriter-1] == hw);
+   g_historyWriters[hWriter-1] = NULL;                         // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+   if (!closed) return(!error(ERR_ILLEGAL_STATE, "history writer already closed: hWriter=%d", hWriter));
+
+   return(HistoryWriter_Release(hw));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Clean-up and release all open history files and writers. Called only in DLL::onProcessDetach().
+ */
+void WINAPI ReleaseHistoryFiles() {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::vector<HISTORY_WRITER*> writers;
+   std::vector<HISTORY_FILE*> files;
+   writers.swap(g_historyWriters);
+   files.swap(g_historyFiles);
+   LeaveCriticalSection(&g_expanderMutex);
+
+   uint size = writers.size();
+   for (uint i=0; i < size; i++) {
+      if (writers[i]) {
+         warn("closing unclosed history writer: \"%s\"", writers[i]->filename.c_str());
+         HistoryWriter_Release(writers[i]);
+      }
+   }
+
+   size = files.size();
+   for (uint i=0; i < size; i++) {
+      if (files[i]) HistoryFile_Release(files[i]);
+   }
+}
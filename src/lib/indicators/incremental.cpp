@@ -0,0 +1,287 @@
+#include "expander.h"
+#include "lib/indicators/incremental.h"
+#include "lib/indicators/ma.h"
+#include "lib/indicators/rsi.h"
+#include "lib/indicators/volatility.h"
+#include "lib/timeseries.h"
+
+
+extern CRITICAL_SECTION       g_expanderMutex;           // mutex for Expander-wide locking
+std::vector<INDICATOR_STATE*> g_indicators;              // all incrementally calculated indicators (index = handle-1)
+
+
+/**
+ * Return the open time of a bar of the current price series of an MQL program.
+ *
+ * @param  EXECUTION_CONTEXT* ec  - execution context of the program
+ * @param  int                bar - bar index (0 = oldest bar)
+ *
+ * @return time32
+ */
+static time32 WINAPI RatesTime(const EXECUTION_CONTEXT* ec, int bar) {
+   if (GetBarFormat() == 400) return(BarView<HistoryBar400>(ec).rates[bar].time);
+   else                       return(BarView<HistoryBar401>(ec).rates[bar].time);
+}
+
+
+/**
+ * Create an incrementally calculated indicator for an MQL program. The indicator keeps its input columns, results and
+ * intermediate values (running averages, true ranges, Wilder accumulators) between ticks, so that each call of
+ * Indicator_Update() only calculates the changed tail of the timeseries. If the program already has an indicator with the
+ * same parameters (e.g. after re-initialization) the existing one is reset and returned.
+ *
+ * @param  EXECUTION_CONTEXT* ec     - execution context of the program
+ * @param  IndicatorType      type   - indicator type
+ * @param  int                period - calculation period
+ * @param  double             param  - additional parameter (IND_BANDS: deviations, ignored for all other types)
+ *
+ * @return uint - indicator handle or NULL in case of errors
+ */
+uint WINAPI Indicator_Create(const EXECUTION_CONTEXT* ec, IndicatorType type, int period, double param) {
+   if ((uint)ec < MIN_VALID_POINTER)     return(!error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec));
+   if (!ec->pid)                         return(!error(ERR_INVALID_PARAMETER, "invalid execution context (ec.pid=0)"));
+   if (type < IND_SMA || type > IND_RSI) return(!error(ERR_INVALID_PARAMETER, "invalid parameter type: %d", type));
+   if (period <= 0)                      return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+   if (type != IND_BANDS) param = 0;
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_indicators.size();
+   for (uint i=0; i < size; i++) {                             // re-use an existing indicator
+      INDICATOR_STATE* state = g_indicators[i];
+      if (state && state->pid==ec->pid && state->type==type && state->period==period && state->param==param) {
+         state->bars = 0;                                      // symbol or timeframe may have changed
+         LeaveCriticalSection(&g_expanderMutex);
+         return(state->id);
+      }
+   }
+   INDICATOR_STATE* state = new INDICATOR_STATE();
+   state->pid          = ec->pid;
+   state->type         = type;
+   state->period       = period;
+   state->param        = param;
+   state->bars         = 0;
+   state->firstBarTime = 0;
+   state->lastBarTime  = 0;
+   g_indicators.push_back(state);                              // may re-allocate, thus needs to be synchronized
+   state->id = g_indicators.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(state->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve an indicator handle.
+ *
+ * @param  uint hIndicator - indicator handle
+ *
+ * @return INDICATOR_STATE* - the indicator or NULL in case of errors
+ */
+static INDICATOR_STATE* WINAPI GetIndicator(uint hIndicator) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_indicators.size();                            // the vector may be re-allocated by another thread
+   INDICATOR_STATE* state = ((int)hIndicator > 0 && hIndicator <= size) ? g_indicators[hIndicator-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hIndicator <= 0 || hIndicator > size) return((INDICATOR_STATE*)!error(ERR_INVALID_PARAMETER, "invalid parameter hIndicator: %d (unknown handle)", hIndicator));
+   if (!state)                                    return((INDICATOR_STATE*)!error(ERR_ILLEGAL_STATE, "indicator already released: hIndicator=%d", hIndicator));
+   return(state);
+}
+
+
+/**
+ * Update an indicator with the current price series of its MQL program. Only the changed tail of the series is calculated:
+ * the recalculation starts at the youngest bar of the previous calculation (the checkpoint, it may have been still forming)
+ * or at the first changed bar, whichever is older. Everything is recalculated if the terminal reports all bars as changed
+ * (changedBars = -1), or if the history was re-synchronized, which is detected by a changed open time of the oldest bar or
+ * of the checkpoint bar. All values before the start bar remain valid, so a recalculation rolls back correctly.
+ *
+ * @param  EXECUTION_CONTEXT* ec         - execution context of the program
+ * @param  uint               hIndicator - indicator handle
+ *
+ * @return int - index of the first recalculated bar (0 = oldest bar) or EMPTY (-1) in case of errors
+ */
+int WINAPI Indicator_Update(const EXECUTION_CONTEXT* ec, uint hIndicator) {
+   if ((uint)ec < MIN_VALID_POINTER)        return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec)));
+   INDICATOR_STATE* state = GetIndicator(hIndicator);
+   if (!state) return(EMPTY);
+   if (state->pid != ec->pid)               return(_EMPTY(error(ERR_ILLEGAL_STATE, "indicator %d belongs to program %d (not to ec.pid=%d)", hIndicator, state->pid, ec->pid)));
+   if ((uint)ec->rates < MIN_VALID_POINTER) return(_EMPTY(error(ERR_ILLEGAL_STATE, "invalid ec.rates: 0x%p (not a valid pointer)", ec->rates)));
+   if (!GetBarFormat()) return(EMPTY);
+
+   int bars = ec->bars;
+   if (bars <= 0) {
+      state->bars = 0;
+      return(0);
+   }
+
+   // determine the first bar to recalculate
+   int from = 0;
+   if (state->bars && ec->changedBars >= 0 && bars >= state->bars) {
+      if (RatesTime(ec, 0) == state->firstBarTime && RatesTime(ec, state->bars-1) == state->lastBarTime) {
+         from = min(state->bars-1, max(0, bars - ec->changedBars));
+      }
+   }
+
+   BOOL needsHL = (state->type == IND_ATR);
+   if (needsHL) {
+      state->high.resize(bars);
+      state->low .resize(bars);
+   }
+   state->close.resize(bars);
+   for (int i=0; i < INDICATOR_BUFFERS; i++) {
+      state->buffers[i].resize(bars);
+   }
+   double* high  = needsHL ? &state->high[0] : NULL;
+   double* low   = needsHL ? &state->low [0] : NULL;
+   double* close = &state->close[0];
+   double* buf0  = &state->buffers[0][0];
+   double* buf1  = &state->buffers[1][0];
+   double* buf2  = &state->buffers[2][0];
+   if (!CopyRatesColumns(ec, from, NULL, NULL, high, low, close, NULL)) return(EMPTY);
+
+   int period = state->period;
+   switch (state->type) {
+      case IND_SMA:
+         CalculateSMA(close, from, bars, period, buf0);
+         break;
+
+      case IND_EMA:
+         CalculateEMA(close, from, bars, period, buf0);
+         break;
+
+      case IND_STDDEV:
+         CalculateStdDev(close, from, bars, period, buf1, buf0);
+         break;
+
+      case IND_BANDS:
+         CalculateStdDev(close, from, bars, period, buf0, buf2);  // use the lower band as temporary buffer
+         for (int i=from; i < bars; i++) {
+            if (i < period-1) {
+               buf1[i] = EMPTY_VALUE;
+            }
+            else {
+               double width = state->param * buf2[i];
+               buf1[i] = buf0[i] + width;
+               buf2[i] = buf0[i] - width;
+            }
+         }
+         break;
+
+      case IND_ATR:
+         CalculateATR(high, low, close, from, bars, period, buf1, buf0);
+         break;
+
+      case IND_RSI:
+         CalculateRSI(close, from, bars, period, buf1, buf2, buf0);
+         break;
+   }
+
+   state->bars         = bars;
+   state->firstBarTime = RatesTime(ec, 0);
+   state->lastBarTime  = RatesTime(ec, bars-1);
+   return(from);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return a result buffer of an indicator. The buffer is indexed like the bars (index 0 = oldest bar) and holds as many
+ * values as bars were calculated by the last call of Indicator_Update(). It's invalidated by the next update.
+ *
+ * @param  uint hIndicator - indicator handle
+ * @param  int  buffer     - buffer index
+ *
+ * @return double* - buffer or NULL in case of errors or if nothing was calculated yet
+ */
+const double* WINAPI Indicator_Buffer(uint hIndicator, int buffer) {
+   INDICATOR_STATE* state = GetIndicator(hIndicator);
+   if (!state) return(NULL);
+   if (buffer < 0 || buffer >= INDICATOR_BUFFERS) return((double*)!error(ERR_INVALID_PARAMETER, "invalid parameter buffer: %d", buffer));
+   if (!state->bars) return(NULL);
+   return(&state->buffers[buffer][0]);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return a single value of an indicator.
+ *
+ * @param  uint hIndicator - indicator handle
+ * @param  int  buffer     - buffer index
+ * @param  int  bar        - bar offset (0 = youngest bar)
+ *
+ * @return double - value or EMPTY_VALUE if the bar was not calculated or in case of errors
+ */
+double WINAPI Indicator_Value(uint hIndicator, int buffer, int bar) {
+   INDICATOR_STATE* state = GetIndicator(hIndicator);
+   if (!state) return(EMPTY_VALUE);
+   if (buffer < 0 || buffer >= INDICATOR_BUFFERS) return(_EMPTY_VALUE(error(ERR_INVALID_PARAMETER, "invalid parameter buffer: %d", buffer)));
+   if (bar < 0 || bar >= state->bars) return(EMPTY_VALUE);
+   return(state->buffers[buffer][state->bars-1-bar]);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Release an indicator and its state.
+ *
+ * @param  uint hIndicator - indicator handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_Release(uint hIndicator) {
+   INDICATOR_STATE* state = GetIndicator(hIndicator);
+   if (!state) return(FALSE);
+
+   // The slot is reset only if it still holds the resolved indicator. Of concurrent releases of the same handle (or of a
+   // release and ReleaseIndicators()) only one succeeds.
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL released = (g_indicators[hIndicator-1] == state);
+   g_indicators[hIndicator-1] = NULL;                          // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+   if (!released) return(!error(ERR_ILLEGAL_STATE, "indicator already released: hIndicator=%d", hIndicator));
+
+   delete state;
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Release all indicators of an MQL program. Called on final deinitialization of the program.
+ *
+ * @param  uint pid - MQL program id
+ */
+void WINAPI ReleaseIndicators(uint pid) {
+   std::vector<INDICATOR_STATE*> released;
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_indicators.size();
+   for (uint i=0; i < size; i++) {
+      INDICATOR_STATE* state = g_indicators[i];
+      if (state && state->pid==pid) {
+         g_indicators[i] = NULL;                               // the vector itself is not modified
+         released.push_back(state);
+      }
+   }
+   LeaveCriticalSection(&g_expanderMutex);
+
+   size = released.size();
+   for (uint i=0; i < size; i++) {
+      delete released[i];
+   }
+}
@@ -0,0 +1,116 @@
+#include "expander.h"
+#include "lib/indicators/ma.h"
+
+#include <emmintrin.h>
+
+
+/**
+ * Calculate a Simple Moving Average. Follows the MQL reference implementation "Moving Averages.mq4" operation by
+ * operation and produces bit-identical results (see test Indicator_SMA_MatchesReference). The per-bar deltas are
+ * calculated with SSE2, the running average is a dependency chain and stays scalar.
+ *
+ * @param  double values[]  - input values ordered ascending by time
+ * @param  int    from      - first bar to calculate (results[0..from) must hold the previous results)
+ * @param  int    to        - last bar to calculate + 1
+ * @param  int    period    - averaging period
+ * @param  double results[] - buffer receiving the averages, bars without a full period are set to EMPTY_VALUE
+ */
+void WINAPI CalculateSMA(const double values[], int from, int to, int period, double results[]) {
+   int first = period-1, i;                                    // first bar with a full period
+
+   if (from <= first) {
+      for (i=from; i < first && i < to; i++) {
+         results[i] = EMPTY_VALUE;
+      }
+      if (to <= first) return;
+
+      double sum = 0;
+      for (i=0; i < period; i++) {
+         sum += values[i];
+      }
+      results[first] = sum/period;
+      from = first + 1;
+   }
+   if (from >= to) return;
+
+   __m128d vPeriod = _mm_set1_pd(period);
+   for (i=from; i+1 < to; i += 2) {
+      __m128d delta = _mm_sub_pd(_mm_loadu_pd(values+i), _mm_loadu_pd(values+i-period));
+      _mm_storeu_pd(results+i, _mm_div_pd(delta, vPeriod));
+   }
+   if (i < to) {
+      results[i] = (values[i]-values[i-period])/period;
+   }
+   for (i=from; i < to; i++) {
+      results[i] += results[i-1];
+   }
+}
+
+
+/**
+ * Calculate an Exponential Moving Average. Follows the MQL reference implementation "Moving Averages.mq4" and produces
+ * bit-identical results (see test Indicator_EMA_MatchesReference). The first value is seeded with the first input
+ * value.
+ *
+ * @param  double values[]  - input values ordered ascending by time
+ * @param  int    from      - first bar to calculate (results[0..from) must hold the previous results)
+ * @param  int    to        - last bar to calculate + 1
+ * @param  int    period    - averaging period
+ * @param  double results[] - buffer receiving the averages
+ */
+void WINAPI CalculateEMA(const double values[], int from, int to, int period, double results[]) {
+   double k = 2.0/(1.0+period);
+
+   if (from == 0 && to > 0) {
+      results[0] = values[0];
+      from = 1;
+   }
+   for (int i=from; i < to; i++) {
+      results[i] = values[i]*k + results[i-1]*(1.0-k);
+   }
+}
+
+
+/**
+ * Calculate a Simple Moving Average over a full timeseries.
+ *
+ * @param  double values[]  - input values ordered ascending by time
+ * @param  int    size      - number of input values
+ * @param  int    period    - averaging period
+ * @param  double results[] - buffer receiving the averages (same size as the input), bars without a full period are set to
+ *                            EMPTY_VALUE
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_SMA(const double values[], int size, int period, double results[]) {
+   if ((uint)values < MIN_VALID_POINTER)  return(!error(ERR_INVALID_PARAMETER, "invalid parameter values: 0x%p (not a valid pointer)", values));
+   if ((uint)results < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results));
+   if (size < 0)                          return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   if (period <= 0)                       return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+
+   CalculateSMA(values, 0, size, period, results);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Calculate an Exponential Moving Average over a full timeseries.
+ *
+ * @param  double values[]  - input values ordered ascending by time
+ * @param  int    size      - number of input values
+ * @param  int    period    - averaging period
+ * @param  double results[] - buffer receiving the averages (same size as the input)
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_EMA(const double values[], int size, int period, double results[]) {
+   if ((uint)values < MIN_VALID_POINTER)  return(!error(ERR_INVALID_PARAMETER, "invalid parameter values: 0x%p (not a valid pointer)", values));
+   if ((uint)results < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results));
+   if (size < 0)                          return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   if (period <= 0)                       return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+
+   CalculateEMA(values, 0, size, period, results);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
@@ -0,0 +1,75 @@
+#include "expander.h"
+#include "lib/indicators/rsi.h"
+
+#include <vector>
+
+
+/**
+ * Calculate the Relative Strength Index. Follows the MQL reference implementation "RSI.mq4" operation by operation and
+ * produces bit-identical results (see test Indicator_RSI_MatchesReference). The first value at bar 'period' is based on
+ * the simple averages of gains and losses of bars 1..period, following values use Wilder's smoothing. Each bar depends
+ * on the previous one, so the kernel is a tight scalar recurrence.
+ *
+ * @param  double close[]   - close prices ordered ascending by time
+ * @param  int    from      - first bar to calculate (buffers[0..from) must hold the previous results)
+ * @param  int    to        - last bar to calculate + 1
+ * @param  int    period    - averaging period
+ * @param  double pos[]     - buffer receiving the smoothed gains
+ * @param  double neg[]     - buffer receiving the smoothed losses
+ * @param  double results[] - buffer receiving the RSI values, bars without a full period are set to EMPTY_VALUE
+ */
+void WINAPI CalculateRSI(const double close[], int from, int to, int period, double pos[], double neg[], double results[]) {
+   if (from <= period) {
+      int i = from;
+      for (; i < period && i < to; i++) {
+         pos[i] = neg[i] = 0;
+         results[i] = EMPTY_VALUE;
+      }
+      if (to <= period) return;
+
+      double sumPos = 0, sumNeg = 0;
+      for (i=1; i <= period; i++) {
+         double diff = close[i] - close[i-1];
+         if (diff > 0) sumPos += diff;
+         else          sumNeg -= diff;
+      }
+      pos[period] = sumPos/period;
+      neg[period] = sumNeg/period;
+      from = period;
+   }
+
+   for (int i=from; i < to; i++) {
+      if (i > period) {
+         double diff = close[i] - close[i-1];
+         pos[i] = (pos[i-1]*(period-1) + (diff > 0 ?  diff : 0))/period;
+         neg[i] = (neg[i-1]*(period-1) + (diff < 0 ? -diff : 0))/period;
+      }
+      if      (neg[i]) results[i] = 100 - 100/(1 + pos[i]/neg[i]);
+      else if (pos[i]) results[i] = 100;
+      else             results[i] = 50;
+   }
+}
+
+
+/**
+ * Calculate the Relative Strength Index of a full timeseries.
+ *
+ * @param  double close[]   - close prices ordered ascending by time
+ * @param  int    size      - number of bars
+ * @param  int    period    - averaging period
+ * @param  double results[] - buffer receiving the RSI values (same size as the input), bars without a full period are set
+ *                            to EMPTY_VALUE
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_RSI(const double close[], int size, int period, double results[]) {
+   if ((uint)close < MIN_VALID_POINTER)   return(!error(ERR_INVALID_PARAMETER, "invalid parameter close: 0x%p (not a valid pointer)", close));
+   if ((uint)results < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results));
+   if (size < 0)                          return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   if (period <= 0)                       return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+
+   std::vector<double> pos(size), neg(size);
+   if (size) CalculateRSI(close, 0, size, period, &pos[0], &neg[0], results);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
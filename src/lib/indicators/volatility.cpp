@@ -0,0 +1,206 @@
+#include "expander.h"
+#include "lib/indicators/volatility.h"
+
+#include <cmath>
+#include <vector>
+#include <emmintrin.h>
+
+
+/**
+ * Calculate the population standard deviation of a moving window around its simple moving average. Follows the MQL
+ * reference implementations "StdDev.mq4" and "Bands.mq4": the average of each window is summed in full like SimpleMA()
+ * of "MovingAverages.mqh" and is bit-identical, it is not the running average of CalculateSMA(). The squared deviations
+ * are summed with SSE2, two values at a time. Due to the different summation order a deviation may differ from the
+ * reference by a few ULPs, the relative error stays below period * 1e-16 (see test Indicator_StdDev_WithinErrorBound).
+ *
+ * @param  double values[]  - input values ordered ascending by time
+ * @param  int    from      - first bar to calculate
+ * @param  int    to        - last bar to calculate + 1
+ * @param  int    period    - window size
+ * @param  double ma[]      - buffer receiving the moving average, bars without a full period are set to EMPTY_VALUE
+ * @param  double results[] - buffer receiving the deviations, bars without a full period are set to EMPTY_VALUE
+ */
+void WINAPI CalculateStdDev(const double values[], int from, int to, int period, double ma[], double results[]) {
+   int i = from;
+   for (; i < period-1 && i < to; i++) {
+      ma[i] = results[i] = EMPTY_VALUE;
+   }
+
+   for (; i < to; i++) {
+      double sum = 0;
+      for (int n=0; n < period; n++) {                         // same order as SimpleMA(): youngest value first
+         sum += values[i-n];
+      }
+      ma[i] = sum/period;
+
+      const double* window = values + i - period + 1;
+      __m128d vMa = _mm_set1_pd(ma[i]);
+      __m128d acc = _mm_setzero_pd();
+      int n = 0;
+      for (; n+1 < period; n += 2) {
+         __m128d diff = _mm_sub_pd(_mm_loadu_pd(window+n), vMa);
+         acc = _mm_add_pd(acc, _mm_mul_pd(diff, diff));
+      }
+      sum = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+      if (n < period) {
+         double diff = window[n] - ma[i];
+         sum += diff*diff;
+      }
+      results[i] = sqrt(sum/period);
+   }
+}
+
+
+/**
+ * Calculate the True Range of bars. Two bars at a time are calculated with SSE2. The first bar has no previous close
+ * and its range is high-low.
+ *
+ * @param  double high[]    - high prices ordered ascending by time
+ * @param  double low[]     - low prices ordered ascending by time
+ * @param  double close[]   - close prices ordered ascending by time
+ * @param  int    from      - first bar to calculate
+ * @param  int    to        - last bar to calculate + 1
+ * @param  double results[] - buffer receiving the true ranges
+ */
+void WINAPI CalculateTrueRange(const double high[], const double low[], const double close[], int from, int to, double results[]) {
+   if (from == 0 && to > 0) {
+      results[0] = high[0] - low[0];
+      from = 1;
+   }
+   int i = from;
+   for (; i+1 < to; i += 2) {
+      __m128d prevClose = _mm_loadu_pd(close+i-1);
+      __m128d tr = _mm_sub_pd(_mm_max_pd(_mm_loadu_pd(high+i), prevClose), _mm_min_pd(_mm_loadu_pd(low+i), prevClose));
+      _mm_storeu_pd(results+i, tr);
+   }
+   if (i < to) {
+      results[i] = max(high[i], close[i-1]) - min(low[i], close[i-1]);
+   }
+}
+
+
+/**
+ * Calculate the Average True Range. Follows the MQL reference implementation "ATR.mq4" and produces bit-identical
+ * results (see test Indicator_ATR_MatchesReference). The first value at bar 'period' is the average of the true ranges
+ * of bars 1..period, following values are updated as a running average.
+ *
+ * @param  double high[]    - high prices ordered ascending by time
+ * @param  double low[]     - low prices ordered ascending by time
+ * @param  double close[]   - close prices ordered ascending by time
+ * @param  int    from      - first bar to calculate (tr[0..from) and results[0..from) must hold the previous results)
+ * @param  int    to        - last bar to calculate + 1
+ * @param  int    period    - averaging period
+ * @param  double tr[]      - buffer receiving the true ranges
+ * @param  double results[] - buffer receiving the average true ranges, bars without a full period are set to EMPTY_VALUE
+ */
+void WINAPI CalculateATR(const double high[], const double low[], const double close[], int from, int to, int period, double tr[], double results[]) {
+   CalculateTrueRange(high, low, close, from, to, tr);
+
+   if (from <= period) {
+      int i = from;
+      for (; i < period && i < to; i++) {
+         results[i] = EMPTY_VALUE;
+      }
+      if (to <= period) return;
+
+      double sum = 0;
+      for (i=1; i <= period; i++) {
+         sum += tr[i];
+      }
+      results[period] = sum/period;
+      from = period + 1;
+   }
+   for (int i=from; i < to; i++) {
+      results[i] = results[i-1] + (tr[i]-tr[i-period])/period;
+   }
+}
+
+
+/**
+ * Calculate the standard deviation of a full timeseries.
+ *
+ * @param  double values[]  - input values ordered ascending by time
+ * @param  int    size      - number of input values
+ * @param  int    period    - window size
+ * @param  double results[] - buffer receiving the deviations (same size as the input), bars without a full period are set
+ *                            to EMPTY_VALUE
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_StdDev(const double values[], int size, int period, double results[]) {
+   if ((uint)values < MIN_VALID_POINTER)  return(!error(ERR_INVALID_PARAMETER, "invalid parameter values: 0x%p (not a valid pointer)", values));
+   if ((uint)results < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results));
+   if (size < 0)                          return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   if (period <= 0)                       return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+
+   std::vector<double> ma(size);
+   if (size) CalculateStdDev(values, 0, size, period, &ma[0], results);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Calculate Bollinger Bands of a full timeseries.
+ *
+ * @param  double values[]   - input values ordered ascending by time
+ * @param  int    size       - number of input values
+ * @param  int    period     - averaging period
+ * @param  double deviations - band width in standard deviations
+ * @param  double ma[]       - buffer receiving the moving average
+ * @param  double upper[]    - buffer receiving the upper band
+ * @param  double lower[]    - buffer receiving the lower band
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_Bands(const double values[], int size, int period, double deviations, double ma[], double upper[], double lower[]) {
+   if ((uint)values < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter values: 0x%p (not a valid pointer)", values));
+   if ((uint)ma < MIN_VALID_POINTER)     return(!error(ERR_INVALID_PARAMETER, "invalid parameter ma: 0x%p (not a valid pointer)", ma));
+   if ((uint)upper < MIN_VALID_POINTER)  return(!error(ERR_INVALID_PARAMETER, "invalid parameter upper: 0x%p (not a valid pointer)", upper));
+   if ((uint)lower < MIN_VALID_POINTER)  return(!error(ERR_INVALID_PARAMETER, "invalid parameter lower: 0x%p (not a valid pointer)", lower));
+   if (size < 0)                         return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   if (period <= 0)                      return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+
+   CalculateStdDev(values, 0, size, period, ma, upper);        // use the upper band as temporary buffer
+
+   for (int i=0; i < size; i++) {
+      if (i < period-1) {
+         lower[i] = EMPTY_VALUE;
+      }
+      else {
+         double width = deviations * upper[i];
+         upper[i] = ma[i] + width;
+         lower[i] = ma[i] - width;
+      }
+   }
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Calculate the Average True Range of a full timeseries.
+ *
+ * @param  double high[]    - high prices ordered ascending by time
+ * @param  double low[]     - low prices ordered ascending by time
+ * @param  double close[]   - close prices ordered ascending by time
+ * @param  int    size      - number of bars
+ * @param  int    period    - averaging period
+ * @param  double results[] - buffer receiving the average true ranges (same size as the input), bars without a full period
+ *                            are set to EMPTY_VALUE
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Indicator_ATR(const double high[], const double low[], const double close[], int size, int period, double results[]) {
+   if ((uint)high < MIN_VALID_POINTER)    return(!error(ERR_INVALID_PARAMETER, "invalid parameter high: 0x%p (not a valid pointer)", high));
+   if ((uint)low < MIN_VALID_POINTER)     return(!error(ERR_INVALID_PARAMETER, "invalid parameter low: 0x%p (not a valid pointer)", low));
+   if ((uint)close < MIN_VALID_POINTER)   return(!error(ERR_INVALID_PARAMETER, "invalid parameter close: 0x%p (not a valid pointer)", close));
+   if ((uint)results < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results));
+   if (size < 0)                          return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   if (period <= 0)                       return(!error(ERR_INVALID_PARAMETER, "invalid parameter period: %d (must be > 0)", period));
+
+   std::vector<double> tr(size);
+   if (size) CalculateATR(high, low, close, 0, size, period, &tr[0], results);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
@@ -1,7 +1,11 @@
 #include "expander.h"
+#include "lib/binarylog.h"
 #include "lib/datetime.h"
 #include "lib/file.h"
 #include "lib/conversion.h"
+#include "lib/executioncontext.h"
+#include "lib/logbuffer.h"
+#include "lib/logwriter.h"
 #include "lib/string.h"
 #include "struct/ExecutionContext.h"
 
@@ -12,7 +16,86 @@ extern MqlInstanceList g_mqlInstances;             // all MQL program instances
 
 
 /**
- * Append a log message to a program's logfile. The caller is responsible for filtering messages by loglevel.
+ * Start a logfile which was just opened and append existing logbuffer entries. Must be called with exclusive access to the
+ * logger (see LogWriter_Lock()).
+ *
+ * @param  EXECUTION_CONTEXT* master - master context of the program
+ */
+static void WINAPI WriteLogBuffer(EXECUTION_CONTEXT* master) {
+   BOOL binary = IsBinaryLogfileA(master->logFilename);
+   if (binary) BinaryLog_Open(master->logger);
+
+   if (master->logBuffer) LogBuffer_Drain(master->logBuffer, master->logger, binary);
+   master->logger->flush();
+}
+
+
+/**
+ * Resolve the master context holding the logger and the log configuration of a program. A program loaded by iCustom() uses
+ * the master context of its host program.
+ *
+ * @param  uint pid - program id
+ *
+ * @return EXECUTION_CONTEXT* - master context or NULL if the program is unknown
+ */
+EXECUTION_CONTEXT* WINAPI GetLogContext(uint pid) {
+   if (!pid || g_mqlInstances.size() <= pid) return(NULL);
+
+   ContextChain &chain = *g_mqlInstances[pid];
+   EXECUTION_CONTEXT* master = chain.size() ? chain[0] : NULL;
+   if (master && master->superContext) {
+      uint superPid = master->superContext->pid;
+      if (superPid && g_mqlInstances.size() > superPid) {
+         ContextChain &superChain = *g_mqlInstances[superPid];
+         if (superChain.size() && superChain[0]) master = superChain[0];
+      }
+   }
+   return(master);
+}
+
+
+/**
+ * Whether a log message of the specified level passes a program's configuration of the debug output appender. Messages of
+ * threads not executing an MQL program always pass.
+ *
+ * @param  uint pid   - program id or 0 (no program)
+ * @param  int  level - loglevel of the message
+ *
+ * @return BOOL
+ */
+BOOL WINAPI IsDebugLoglevelActive(uint pid, int level) {
+   EXECUTION_CONTEXT* master = GetLogContext(pid);
+   if (!master) return(TRUE);
+   return(level!=LOG_OFF && level >= master->loglevel && level >= master->loglevelDebug);
+}
+
+
+/**
+ * Whether a log message of the specified level would be written to a program's logfile or logbuffer. Allows MQL to skip
+ * composing and passing messages which AppendLogMessageA() would discard.
+ *
+ * @param  EXECUTION_CONTEXT* ec    - execution context of the program
+ * @param  int                level - loglevel of the message
+ *
+ * @return BOOL
+ */
+BOOL WINAPI IsLogfileLoglevelActive(const EXECUTION_CONTEXT* ec, int level) {
+   if ((uint)ec < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec));
+
+   EXECUTION_CONTEXT* master = GetLogContext(ec->pid);
+   if (!master || level==LOG_OFF)                                   return(FALSE);
+   if (level < master->loglevel || level < master->loglevelFile)   return(FALSE);
+
+   BOOL useLogger    = (master->logger && master->logFilename && *master->logFilename);
+   BOOL useLogBuffer = (!useLogger && master->programInitFlags & INIT_BUFFERED_LOG);
+   return(useLogger || useLogBuffer);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Append a log message to a program's logfile. Messages not passing the program's loglevel configuration of the logfile
+ * appender are discarded before anything is composed (see IsLogfileLoglevelActive()).
  *
  * @param  EXECUTION_CONTEXT* ec         - execution context of the program
  * @param  time32             serverTime - server time as a Unix timestamp (used in tests only, modelled)
@@ -30,8 +113,9 @@ BOOL WINAPI AppendLogMessageA(EXECUTION_CONTEXT* ec, time32 serverTime, const ch
    if (level == LOG_OFF)                  return FALSE;
 
    // for safety reasons we access only the logger/logBuffer in master (all other contexts can be manipulated in MQL)
-   EXECUTION_CONTEXT* master = (*g_mqlInstances[ec->pid])[0];
-   if (master->superContext) master = (*g_mqlInstances[master->superContext->pid])[0];    // use a super context (if any)
+   EXECUTION_CONTEXT* master = GetLogContext(ec->pid);                                    // use a super context (if any)
+   if (!master) return FALSE;
+   if (level < master->loglevel || level < master->loglevelFile) return FALSE;            // filtered by loglevel
 
    // check whether to use an existing logger or a logbuffer
    BOOL useLogger    = (master->logger && master->logFilename && strlen(master->logFilename));
@@ -46,44 +130,73 @@ BOOL WINAPI AppendLogMessageA(EXECUTION_CONTEXT* ec, time32 serverTime, const ch
          string path = string(drive).append(dir);
          if (CreateDirectoryA(path.c_str(), MODE_SYSTEM|MODE_MKPARENT)) return FALSE;     // make sure the directory exists
       }
+      LogWriter_Lock();
       master->logger->open(master->logFilename, std::ios::binary|std::ios::app);          // open the logfile
-      if (!master->logger->is_open()) return !error(ERR_WIN32_ERROR + GetLastError(), "opening of \"%s\" failed (%s)", master->logFilename, strerror(errno));
-      if (master->logBuffer && master->logBuffer->size()) {
-         uint size = master->logBuffer->size();
-         for (uint i=0; i < size; ++i) {
-            string entry = (*master->logBuffer)[i];
-            *master->logger << entry << NL;                                               // append existing logbuffer entries
-         }
-         master->logger->flush();
-         master->logBuffer->clear();
+      if (!master->logger->is_open()) {
+         LogWriter_Unlock();
+         return !error(ERR_WIN32_ERROR + GetLastError(), "opening of \"%s\" failed (%s)", master->logFilename, strerror(errno));
       }
+      WriteLogBuffer(master);                                                             // append existing logbuffer entries
+      LogWriter_Unlock();
    }
    else if (useLogBuffer && !master->logBuffer) {
-      master->logBuffer = ec->logBuffer = new LogBuffer();
-      master->logBuffer->reserve(16);
+      master->logBuffer = ec->logBuffer = LogBuffer_Create();
    }
 
    // compose the log entry
-   std::ostringstream ss;
    string sLoglevel(level==LOG_DEBUG ? "": LoglevelDescriptionA(level));                  // loglevel (LOG_DEBUG is blanked out)
    string sExecPath(master->programName); sExecPath.append("::");                         // execution path
    if (ec->moduleType == MT_LIBRARY) sExecPath.append(ec->moduleName).append("::");       //
+
+   if (useLogger && IsBinaryLogfileA(master->logFilename)) {                              // binary logfile: queue the raw fields
+      BLOG_MESSAGE header = {};
+      if (master->testing) {
+         header.flags = BLOG_FLAG_TESTER;
+         header.time  = serverTime;
+      }
+      else {
+         SYSTEMTIME st = getLocalTime();
+         header.time         = SystemTimeToUnixTime32(st);
+         header.milliseconds = st.wMilliseconds;
+      }
+      header.level     = level;
+      header.pid       = ec->pid;
+      header.timeframe = ec->timeframe;
+      header.error     = error;
+
+      string entry;
+      BinaryLog_ComposeMessage(entry, header, sLoglevel.c_str(), ec->symbol, PeriodDescriptionA(ec->timeframe), sExecPath.c_str(), error ? ErrorToStrA(error) : "", message);
+      LogWriter_Append(master->logger, entry.data(), entry.size(), TRUE);
+      return TRUE;
+   }
+
+   std::ostringstream ss;
    string sMessage(message); strReplace(strReplace(sMessage, "\r\n", " "), "\n", " ");    // replace linebreaks with spaces
    string sError; if (error) sError.append("  [").append(ErrorToStrA(error)).append("]"); // append error description
 
+   TIME_FORMAT_CACHE localCache = {};                                                     // timestamps are formatted using the thread's cache
+   THREAD_SLOT* thread = GetCurrentThreadSlot();
+   TIME_FORMAT_CACHE &timeCache = thread ? thread->timeFormat : localCache;
+
    if (master->testing) {                                                                 // tester:
-      ss << "T " << gmtTimeFormat(serverTime, "%Y-%m-%d %H:%M:%S");                       // prepend prefix "T" followed by the passed tester time (seconds only)
+      ss << "T " << cachedTimeFormat(timeCache, serverTime, FALSE);                       // prepend prefix "T" followed by the passed tester time (seconds only)
    }
    else {
       SYSTEMTIME st = getSystemTime();                                                    // online:
       time32 gmtTime = SystemTimeToUnixTime32(st);                                        // prepend current time with milliseconds
-      ss << localTimeFormat(gmtTime, "%Y-%m-%d %H:%M:%S") << "." << std::setw(3) << std::setfill('0') << st.wMilliseconds;
+      ss << cachedTimeFormat(timeCache, gmtTime, TRUE, st.wMilliseconds);
    }
    ss << "  " << std::setfill(' ') << std::setw(6) << std::left << sLoglevel << "  " << ec->symbol << "," << std::setw(3) << std::left << PeriodDescriptionA(ec->timeframe) << "  " << sExecPath << sMessage << sError;
 
-   // write the log entry to logfile or logbuffer
-   if (useLogger) *master->logger << ss.str() << std::endl;
-   else            master->logBuffer->push_back(ss.str());
+   // queue the log entry for the logfile or write it to the logbuffer
+   if (useLogger) {
+      string entry = ss.str();
+      LogWriter_Append(master->logger, entry.data(), entry.size());
+   }
+   else {
+      string entry = ss.str();
+      if (!LogBuffer_Append(master->logBuffer, entry.data(), entry.size())) return FALSE;
+   }
 
    return TRUE;
    #pragma EXPANDER_EXPORT
@@ -116,7 +229,11 @@ BOOL WINAPI SetLogfileA(EXECUTION_CONTEXT* ec, const char* filename) {
 
       // close a previous logfile with a different name
       if (!StrCompare(filename, master->logFilename)) {
-         if (log->is_open()) log->close();
+         if (log->is_open()) {
+            LogWriter_Lock();
+            log->close();
+            LogWriter_Unlock();
+         }
       }
       ec_SetLogFilename(ec, filename);
 
@@ -129,25 +246,25 @@ BOOL WINAPI SetLogfileA(EXECUTION_CONTEXT* ec, const char* filename) {
                string path = string(drive).append(dir);                          // make sure the directory exists
                if (CreateDirectoryA(path.c_str(), MODE_SYSTEM|MODE_MKPARENT)) return FALSE;
             }
+            LogWriter_Lock();
             log->open(filename, std::ios::binary|std::ios::app);                 // open the logfile
-            if (!log->is_open()) return !error(ERR_WIN32_ERROR + GetLastError(), "opening of \"%s\" failed (%s)", filename, strerror(errno));
-
-            if (master->logBuffer && master->logBuffer->size()) {
-               uint size = master->logBuffer->size();
-               for (uint i=0; i < size; ++i) {
-                  string entry = (*master->logBuffer)[i];
-                  *master->logger << entry << NL;                                // append existing logbuffer entries
-               }
-               master->logger->flush();
-               master->logBuffer->clear();
+            if (!log->is_open()) {
+               LogWriter_Unlock();
+               return !error(ERR_WIN32_ERROR + GetLastError(), "opening of \"%s\" failed (%s)", filename, strerror(errno));
             }
+
+            WriteLogBuffer(master);                                              // append existing logbuffer entries
+            LogWriter_Unlock();
          }
       }
    }
    else {
       // close the logfile but keep an existing instance (we may be in an init cycle)
       if (master->logger && master->logger->is_open()) {
+         LogWriter_Lock();
          master->logger->close();
+         BinaryLog_Close(master->logger);
+         LogWriter_Unlock();
       }
       ec_SetLogFilename(ec, filename);
    }
@@ -0,0 +1,267 @@
+#include "expander.h"
+#include "lib/logbuffer.h"
+#include "struct/BinaryLog.h"
+
+
+/**
+ * Log buffer of a program which logs before its logfile is configured. Entries are stored back-to-back including their line
+ * breaks in fixed size memory chunks. When the buffer exceeds the configured memory limit further entries are spilled to a
+ * temp file. Draining the buffer writes the chunks and the temp file content as is, no entry is copied.
+ */
+volatile LONG g_logBufferMaxMemory = LOG_BUFFER_MAX_MEMORY;    // memory limit of a single log buffer
+
+
+/**
+ * Create a new and empty log buffer.
+ *
+ * @return LOG_BUFFER* - log buffer, must be released with LogBuffer_Release()
+ */
+LOG_BUFFER* WINAPI LogBuffer_Create() {
+   LOG_BUFFER* buffer = new LOG_BUFFER();
+   buffer->chunkUsed = LOG_BUFFER_CHUNK_SIZE;                  // no chunk yet
+   buffer->entries   = 0;
+   buffer->size      = 0;
+   buffer->hTempFile = NULL;
+   return(buffer);
+}
+
+
+/**
+ * Create the temp file of a log buffer. The file is deleted automatically when it's closed.
+ *
+ * @param  LOG_BUFFER* buffer
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI LogBuffer_CreateTempFile(LOG_BUFFER* buffer) {
+   char path[MAX_PATH], filename[MAX_PATH];
+   if (!GetTempPathA(MAX_PATH, path))                return(!error(ERR_WIN32_ERROR + GetLastError(), "GetTempPathA()"));
+   if (!GetTempFileNameA(path, "log", 0, filename)) return(!error(ERR_WIN32_ERROR + GetLastError(), "GetTempFileNameA(%s)", path));
+
+   HANDLE hFile = CreateFileA(filename,                                          // file name
+                              GENERIC_READ|GENERIC_WRITE, 0,                     // exclusive read/write access
+                              NULL,                                              // default security
+                              CREATE_ALWAYS,                                     // overwrite the file created by GetTempFileNameA()
+                              FILE_ATTRIBUTE_TEMPORARY|FILE_FLAG_DELETE_ON_CLOSE,
+                              NULL);                                             // no attribute template
+   if (hFile == INVALID_HANDLE_VALUE) return(!error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot create \"%s\"", filename));
+
+   buffer->hTempFile = hFile;
+   return(TRUE);
+}
+
+
+/**
+ * Copy data to the memory chunks of a log buffer. New chunks are allocated as needed.
+ *
+ * @param  LOG_BUFFER* buffer
+ * @param  char*       data
+ * @param  uint        length
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI LogBuffer_Copy(LOG_BUFFER* buffer, const char* data, uint length) {
+   while (length) {
+      if (buffer->chunkUsed == LOG_BUFFER_CHUNK_SIZE) {
+         char* chunk = (char*) malloc(LOG_BUFFER_CHUNK_SIZE);
+         if (!chunk) return(!error(ERR_OUT_OF_MEMORY, "cannot allocate log buffer chunk"));
+         buffer->chunks.push_back(chunk);
+         buffer->chunkUsed = 0;
+      }
+      uint n = min(length, (uint)LOG_BUFFER_CHUNK_SIZE - buffer->chunkUsed);
+      memcpy(buffer->chunks.back() + buffer->chunkUsed, data, n);
+      buffer->chunkUsed += n;
+      data   += n;
+      length -= n;
+   }
+   return(TRUE);
+}
+
+
+/**
+ * Append an entry to a log buffer.
+ *
+ * @param  LOG_BUFFER* buffer
+ * @param  char*       text   - log entry without line break
+ * @param  uint        length - length of the entry
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI LogBuffer_Append(LOG_BUFFER* buffer, const char* text, uint length) {
+   if ((uint)buffer < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter buffer: 0x%p (not a valid pointer)", buffer));
+   if (buffer->size + length + 1 < buffer->size) return(!error(ERR_RUNTIME_ERROR, "log buffer full (%u bytes)", buffer->size));
+
+   if (!buffer->hTempFile && buffer->size + length + 1 > (uint)g_logBufferMaxMemory) {
+      if (!LogBuffer_CreateTempFile(buffer)) return(FALSE);
+   }
+
+   if (buffer->hTempFile) {                                    // spill to the temp file
+      DWORD written;
+      if (!WriteFile(buffer->hTempFile, text, length, &written, NULL) || !WriteFile(buffer->hTempFile, NL, 1, &written, NULL)) {
+         return(!error(ERR_WIN32_ERROR + GetLastError(), "WriteFile() failed to write to the log buffer's temp file"));
+      }
+   }
+   else {                                                      // copy to the memory chunks
+      if (!LogBuffer_Copy(buffer, text, length) || !LogBuffer_Copy(buffer, NL, 1)) return(FALSE);
+   }
+
+   buffer->entries++;
+   buffer->size += length + 1;
+   return(TRUE);
+}
+
+
+/**
+ * Configure the memory limit of log buffers. Entries exceeding the limit are spilled to a temp file.
+ *
+ * @param  int maxMemory - max. memory of a single log buffer in bytes
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI LogBuffer_Configure(int maxMemory) {
+   if (maxMemory < 0) return(!error(ERR_INVALID_PARAMETER, "invalid parameter maxMemory: %d", maxMemory));
+
+   InterlockedExchange(&g_logBufferMaxMemory, maxMemory);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Write a block of buffered log data to a logfile. For a binary logfile each entry is written as a separate BLOG_TEXT record
+ * without its line break. The start of an entry continued in the next block is collected in "pending".
+ *
+ * @param  std::ofstream* logger
+ * @param  BOOL           binary   - whether the logfile is a binary logfile
+ * @param  char*          data
+ * @param  uint           length
+ * @param  string         &pending - start of an incomplete entry of a previous block
+ */
+static void WINAPI LogBuffer_WriteBlock(std::ofstream* logger, BOOL binary, const char* data, uint length, string &pending) {
+   if (!binary) {
+      logger->write(data, length);
+      return;
+   }
+   const char* end = data + length;
+
+   while (data < end) {
+      const char* nl = (const char*) memchr(data, '\n', end - data);
+      if (!nl) {
+         pending.append(data, end - data);
+         break;
+      }
+      const char* text = data;
+      uint textLen = nl - data;
+      if (!pending.empty()) {
+         pending.append(data, textLen);
+         text    = pending.data();
+         textLen = pending.size();
+      }
+      BLOG_TEXT record = {};
+      record.type   = BLOG_RECORD_TEXT;
+      record.length = textLen;
+      logger->write((char*)&record, sizeof(record)).write(text, textLen);
+      pending.clear();
+      data = nl + 1;
+   }
+}
+
+
+/**
+ * Write all entries of a log buffer to a logfile and empty the buffer. The memory chunks are written as is, the temp file
+ * content is copied in chunks of the same size. For a binary logfile each entry is written as a BLOG_TEXT record, a record
+ * is written only after the whole entry was read. Must be called with exclusive access to the logger (see LogWriter_Lock()).
+ *
+ * @param  LOG_BUFFER*    buffer
+ * @param  std::ofstream* logger - logfile opened for writing
+ * @param  BOOL           binary - whether the logfile is a binary logfile
+ *
+ * @return BOOL - success status; if the logfile is not open the buffer is not modified
+ */
+BOOL WINAPI LogBuffer_Drain(LOG_BUFFER* buffer, std::ofstream* logger, BOOL binary) {
+   if ((uint)buffer < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter buffer: 0x%p (not a valid pointer)", buffer));
+   if ((uint)logger < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter logger: 0x%p (not a valid pointer)", logger));
+   if (!logger->is_open())               return(!error(ERR_ILLEGAL_STATE, "logfile not open (keeping %u buffered entries)", buffer->entries));
+   if (!buffer->size) return(TRUE);
+
+   BOOL success = TRUE;
+   uint remaining = buffer->size;
+   string pending;
+
+   uint chunks = buffer->chunks.size();
+   for (uint i=0; i < chunks && remaining; i++) {
+      uint n = min(remaining, i==chunks-1 ? buffer->chunkUsed : (uint)LOG_BUFFER_CHUNK_SIZE);
+      LogBuffer_WriteBlock(logger, binary, buffer->chunks[i], n, pending);
+      remaining -= n;
+   }
+
+   if (buffer->hTempFile) {
+      LARGE_INTEGER zero = {};
+      char* block = chunks ? buffer->chunks[0] : (char*) malloc(LOG_BUFFER_CHUNK_SIZE);    // re-use a written chunk
+      if (!block) {
+         success = !error(ERR_OUT_OF_MEMORY, "cannot allocate log buffer chunk");
+      }
+      else if (!SetFilePointerEx(buffer->hTempFile, zero, NULL, FILE_BEGIN)) {
+         success = !error(ERR_WIN32_ERROR + GetLastError(), "SetFilePointerEx() failed on the log buffer's temp file");
+      }
+      while (success && remaining) {
+         DWORD read;
+         if (!ReadFile(buffer->hTempFile, block, LOG_BUFFER_CHUNK_SIZE, &read, NULL)) {
+            success = !error(ERR_WIN32_ERROR + GetLastError(), "ReadFile() failed on the log buffer's temp file");
+         }
+         else if (!read) {
+            success = !error(ERR_RUNTIME_ERROR, "unexpected end of the log buffer's temp file (%u bytes missing)", remaining);
+         }
+         else {
+            uint n = min(remaining, (uint)read);
+            LogBuffer_WriteBlock(logger, binary, block, n, pending);
+            remaining -= n;
+         }
+      }
+      if (!chunks) free(block);
+   }
+   if (success && logger->fail()) success = !error(ERR_WIN32_ERROR + GetLastError(), "writing the log buffer to the logfile failed");
+
+   // empty the buffer (an incomplete entry in "pending" is dropped)
+   for (uint i=0; i < chunks; i++) {
+      free(buffer->chunks[i]);
+   }
+   buffer->chunks.clear();
+   buffer->chunkUsed = LOG_BUFFER_CHUNK_SIZE;
+   buffer->entries   = 0;
+   buffer->size      = 0;
+   if (buffer->hTempFile) {
+      CloseHandle(buffer->hTempFile);
+      buffer->hTempFile = NULL;
+   }
+   return(success);
+}
+
+
+/**
+ * Return the number of entries of a log buffer.
+ *
+ * @param  LOG_BUFFER* buffer
+ *
+ * @return uint
+ */
+uint WINAPI LogBuffer_Size(const LOG_BUFFER* buffer) {
+   if (!buffer) return(0);
+   return(buffer->entries);
+}
+
+
+/**
+ * Release a log buffer and all buffered entries.
+ *
+ * @param  LOG_BUFFER* buffer
+ */
+void WINAPI LogBuffer_Release(LOG_BUFFER* buffer) {
+   if (!buffer) return;
+
+   for (uint i=0; i < buffer->chunks.size(); i++) {
+      free(buffer->chunks[i]);
+   }
+   if (buffer->hTempFile) CloseHandle(buffer->hTempFile);
+   delete buffer;
+}
@@ -0,0 +1,288 @@
+#include "expander.h"
+#include "lib/binarylog.h"
+#include "lib/logwriter.h"
+
+
+/**
+ * Asynchronous log writer. MQL threads queue finished log entries in a bounded multi-producer/single-consumer ring buffer
+ * without taking a lock. A background thread writes the entries in batches per logfile and flushes the files once per batch
+ * instead of once per message. The consumer side is serialized by g_logWriterLock: whoever holds the lock drains the queue,
+ * this is the writer thread or a caller which needs to access a logger directly (see LogWriter_Lock()).
+ */
+LOG_ENTRY        g_logRing[LOG_RING_SIZE];                // pending log entries
+volatile LONG    g_logEnqueuePos;                         // position of the next entry to write (producers)
+volatile LONG    g_logDequeuePos;                         // position of the next entry to read (consumer)
+volatile LONG    g_logWriterState;                        // 0: not initialized, 1: initializing, 2: running, 3: stopped
+CRITICAL_SECTION g_logWriterLock;                         // serializes the consumer side and direct access to loggers
+HANDLE           g_logWriterEvent;                        // signals the writer thread to flush early or to stop
+HANDLE           g_logWriterThread;                       // the writer thread
+HANDLE           g_logWriterStopped;                      // signaled by the writer thread when it stopped (manual-reset event)
+volatile LONG    g_logWriterStop;                         // whether the writer thread should stop
+volatile LONG    g_logFlushInterval = LOG_FLUSH_INTERVAL; // interval between flushes in msec (0: write synchronously)
+volatile LONG    g_logFlushSize     = LOG_FLUSH_SIZE;     // number of pending entries triggering an early flush
+
+
+/**
+ * Write a batch of log entries to a logfile.
+ *
+ * @param  std::ofstream* logger
+ * @param  string         &batch
+ */
+static void WINAPI LogWriter_WriteBatch(std::ofstream* logger, string &batch) {
+   if (logger && logger->is_open() && !batch.empty()) {
+      logger->write(batch.data(), batch.size());
+   }
+   batch.clear();
+}
+
+
+/**
+ * Write all pending log entries. Consecutive entries of the same logfile are combined to a single write, each touched
+ * logfile is flushed once. Must be called with g_logWriterLock held.
+ */
+static void WINAPI LogWriter_Drain() {
+   std::ofstream* current = NULL;
+   std::ofstream* touched[16];
+   uint touchedCount = 0;
+   string batch;
+   batch.reserve(LOG_BATCH_SIZE);
+
+   for (uint pos=g_logDequeuePos; ; pos++) {
+      LOG_ENTRY &entry = g_logRing[pos & (LOG_RING_SIZE-1)];
+      if (entry.sequence != (LONG)(pos+1)) {                      // no more published entries
+         g_logDequeuePos = pos;
+         break;
+      }
+      if (entry.logger != current || batch.size() + entry.length + 1 > LOG_BATCH_SIZE) {
+         LogWriter_WriteBatch(current, batch);
+         current = entry.logger;
+
+         uint i = 0;
+         while (i < touchedCount && touched[i] != current) i++;
+         if (i == touchedCount) {
+            if (touchedCount == sizeof(touched)/sizeof(touched[0])) {
+               for (i=0; i < touchedCount; i++) {
+                  if (touched[i]->is_open()) touched[i]->flush();
+               }
+               touchedCount = 0;
+            }
+            touched[touchedCount++] = current;
+         }
+      }
+      if (entry.binary) BinaryLog_Encode(entry.logger, entry.text, entry.length, batch);
+      else              batch.append(entry.text, entry.length).append(NL);
+      InterlockedExchange(&entry.sequence, pos + LOG_RING_SIZE);  // release the slot for the next round
+   }
+   LogWriter_WriteBatch(current, batch);
+
+   for (uint i=0; i < touchedCount; i++) {
+      if (touched[i]->is_open()) touched[i]->flush();
+   }
+}
+
+
+/**
+ * Thread procedure of the log writer. Drains the queue every flush interval or when signaled. With synchronous writing
+ * nothing is queued and the thread sleeps until it's signaled.
+ */
+static DWORD WINAPI LogWriterThread(LPVOID) {
+   while (!g_logWriterStop) {
+      LONG interval = g_logFlushInterval;
+      WaitForSingleObject(g_logWriterEvent, interval > 0 ? interval : INFINITE);
+      EnterCriticalSection(&g_logWriterLock);
+      LogWriter_Drain();
+      LeaveCriticalSection(&g_logWriterLock);
+   }
+   SetEvent(g_logWriterStopped);                               // from here on no global state is accessed anymore
+   return(0);
+}
+
+
+/**
+ * Initialize the log writer on first use. The writer thread can't be started from DllMain() (loader lock).
+ *
+ * @return BOOL - whether the log writer is running
+ */
+static BOOL WINAPI LogWriter_Init() {
+   if (g_logWriterState == 2) return(TRUE);
+
+   if (InterlockedCompareExchange(&g_logWriterState, 1, 0) == 0) {
+      for (uint i=0; i < LOG_RING_SIZE; i++) {
+         g_logRing[i].sequence = i;
+      }
+      InitializeCriticalSection(&g_logWriterLock);
+      g_logWriterEvent   = CreateEventA(NULL, FALSE, FALSE, NULL);
+      g_logWriterStopped = CreateEventA(NULL, TRUE, FALSE, NULL);
+      g_logWriterThread  = g_logWriterEvent && g_logWriterStopped ? CreateThread(NULL, 0, LogWriterThread, NULL, 0, NULL) : NULL;
+      if (!g_logWriterThread) {
+         InterlockedExchange(&g_logWriterState, 3);
+         return(!error(ERR_WIN32_ERROR + GetLastError(), "cannot start the log writer thread"));
+      }
+      InterlockedExchange(&g_logWriterState, 2);
+      return(TRUE);
+   }
+   while (g_logWriterState == 1) Sleep(0);                     // another thread is initializing
+   return(g_logWriterState == 2);
+}
+
+
+/**
+ * Write a single log entry directly to a logfile.
+ *
+ * @param  std::ofstream* logger
+ * @param  char*          text
+ * @param  uint           length
+ * @param  BOOL           binary
+ */
+static void WINAPI LogWriter_WriteEntry(std::ofstream* logger, const char* text, uint length, BOOL binary) {
+   if (!logger->is_open()) return;
+
+   if (binary) {
+      string out;
+      BinaryLog_Encode(logger, text, length, out);
+      logger->write(out.data(), out.size());
+      logger->flush();
+   }
+   else {
+      logger->write(text, length);
+      *logger << std::endl;
+   }
+}
+
+
+/**
+ * Queue a log entry for writing to a logfile. If the entry is too long, if the queue is full or if asynchronous writing is
+ * disabled the entry is written synchronously, after all pending entries.
+ *
+ * @param  std::ofstream* logger            - target logfile
+ * @param  char*          text              - log entry without line break
+ * @param  uint           length            - length of the entry
+ * @param  BOOL           binary [optional] - whether the entry is a binary log message (default: no)
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI LogWriter_Append(std::ofstream* logger, const char* text, uint length, BOOL binary/*=FALSE*/) {
+   if (!LogWriter_Init()) {
+      LogWriter_WriteEntry(logger, text, length, binary);      // the writer is not available
+      return(TRUE);
+   }
+
+   if (length <= LOG_ENTRY_SIZE && g_logFlushInterval > 0) {
+      uint pos = g_logEnqueuePos;
+      while (true) {
+         LOG_ENTRY &entry = g_logRing[pos & (LOG_RING_SIZE-1)];
+         int diff = entry.sequence - (LONG)pos;
+         if (!diff) {
+            if ((uint)InterlockedCompareExchange(&g_logEnqueuePos, pos+1, pos) == pos) {
+               entry.logger = logger;
+               entry.length = length;
+               entry.binary = binary;
+               memcpy(entry.text, text, length);
+               InterlockedExchange(&entry.sequence, pos+1);       // publish the entry (full barrier)
+
+               if (pos+1 - (uint)g_logDequeuePos >= (uint)g_logFlushSize) SetEvent(g_logWriterEvent);
+               return(TRUE);
+            }
+            pos = g_logEnqueuePos;                                // another producer was faster
+         }
+         else if (diff < 0) break;                                // the queue is full
+         else pos = g_logEnqueuePos;
+      }
+   }
+
+   // write synchronously
+   LogWriter_Lock();
+   LogWriter_WriteEntry(logger, text, length, binary);
+   LogWriter_Unlock();
+   return(TRUE);
+}
+
+
+/**
+ * Configure the asynchronous log writer.
+ *
+ * @param  int flushInterval - max. interval between flushes of pending log entries in msec (0: write synchronously)
+ * @param  int flushSize     - number of pending log entries triggering an early flush
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI LogWriter_Configure(int flushInterval, int flushSize) {
+   if (flushInterval < 0)                          return(!error(ERR_INVALID_PARAMETER, "invalid parameter flushInterval: %d", flushInterval));
+   if (flushSize < 1 || flushSize > LOG_RING_SIZE) return(!error(ERR_INVALID_PARAMETER, "invalid parameter flushSize: %d (must be 1 to %d)", flushSize, LOG_RING_SIZE));
+
+   InterlockedExchange(&g_logFlushInterval, flushInterval);
+   InterlockedExchange(&g_logFlushSize, flushSize);
+   if (!flushInterval) LogWriter_Flush();
+   else if (g_logWriterState == 2) SetEvent(g_logWriterEvent);    // the writer thread may sleep without a timeout
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Write all pending log entries. Returns after the entries have been written and the logfiles have been flushed.
+ */
+void WINAPI LogWriter_Flush() {
+   LogWriter_Lock();
+   LogWriter_Unlock();
+}
+
+
+/**
+ * Acquire exclusive access to all loggers. Pending log entries are written first. Must be called before a logger is opened,
+ * closed, deleted or written to directly, and must be followed by LogWriter_Unlock().
+ */
+void WINAPI LogWriter_Lock() {
+   if (g_logWriterState != 2) return;
+   EnterCriticalSection(&g_logWriterLock);
+   LogWriter_Drain();
+}
+
+
+/**
+ * Release the exclusive access to the loggers acquired by LogWriter_Lock().
+ */
+void WINAPI LogWriter_Unlock() {
+   if (g_logWriterState != 2) return;
+   LeaveCriticalSection(&g_logWriterLock);
+}
+
+
+/**
+ * Write all pending log entries and stop the writer thread. Called on DLL_PROCESS_DETACH.
+ *
+ * On process termination all other threads are already gone, possibly the writer thread in the middle of a batch. The
+ * pending entries are then written only if the writer thread didn't hold g_logWriterLock, otherwise they are lost. Entries
+ * of a producer which was terminated before it published them are lost too.
+ *
+ * @param  BOOL isTerminating [optional] - whether the process is terminating (default: no)
+ */
+void WINAPI ReleaseLogWriter(BOOL isTerminating/*=FALSE*/) {
+   if (g_logWriterState != 2) return;
+
+   if (isTerminating) {
+      if (TryEnterCriticalSection(&g_logWriterLock)) {         // fails if the lock is owned by the terminated writer thread
+         LogWriter_Drain();
+         LeaveCriticalSection(&g_logWriterLock);
+      }
+      return;
+   }
+
+   // Under the loader lock the writer thread can't terminate and its handle is not signaled. It signals g_logWriterStopped
+   // as its last action instead. The handle is checked too, in case the thread was terminated otherwise.
+   LogWriter_Flush();
+   InterlockedExchange(&g_logWriterStop, TRUE);
+   SetEvent(g_logWriterEvent);
+   BOOL stopped = WaitForSingleObject(g_logWriterStopped, LOG_STOP_TIMEOUT)==WAIT_OBJECT_0 || WaitForSingleObject(g_logWriterThread, 0)==WAIT_OBJECT_0;
+   if (!stopped) {
+      warn(ERR_ILLEGAL_STATE, "log writer thread didn't stop within %d msec, leaking the log writer", LOG_STOP_TIMEOUT);
+      return;                                                  // the thread may still use the lock and the event
+   }
+
+   InterlockedExchange(&g_logWriterState, 3);
+   LogWriter_Drain();                                          // entries queued meanwhile
+   CloseHandle(g_logWriterThread);
+   CloseHandle(g_logWriterStopped);
+   CloseHandle(g_logWriterEvent);
+   DeleteCriticalSection(&g_logWriterLock);
+}
@@ -0,0 +1,700 @@
+#include "expander.h"
+#include "lib/symbols.h"
+
+#include <set>
+#include <vector>
+
+
+extern CRITICAL_SECTION          g_expanderMutex;        // mutex for Expander-wide locking
+std::vector<SYMBOL_TABLE*>       g_symbolTables;         // all opened symbol tables (index = handle-1)
+std::vector<SYMBOL_TRANSACTION*> g_symbolTransactions;   // all symbol transactions (index = handle-1)
+
+
+/**
+ * Calculate the FNV-1a hash of a symbol name. At most MAX_SYMBOL_LENGTH characters are considered, so names don't need to
+ * be terminated.
+ *
+ * @param  char* name
+ *
+ * @return uint - hash value
+ */
+uint WINAPI SymbolNameHash(const char* name) {
+   uint hash = 2166136261U;
+   for (int i=0; i < MAX_SYMBOL_LENGTH && name[i]; i++) {
+      hash ^= (BYTE)name[i];
+      hash *= 16777619U;
+   }
+   return(hash);
+}
+
+
+/**
+ * Mix the bits of a symbol id to a hash value.
+ *
+ * @param  uint id
+ *
+ * @return uint - hash value
+ */
+static uint WINAPI SymbolIdHash(uint id) {
+   id ^= id >> 16;
+   id *= 0x7feb352dU;
+   id ^= id >> 15;
+   return(id);
+}
+
+
+/**
+ * Insert a symbol into a hash table. Collisions are resolved by linear probing.
+ *
+ * @param  std::vector<uint> &table
+ * @param  uint               mask  - table size - 1
+ * @param  uint               hash  - hash of the key
+ * @param  uint               index - symbol index
+ */
+static void WINAPI HashTable_Insert(std::vector<uint> &table, uint mask, uint hash, uint index) {
+   uint slot = hash & mask;
+   while (table[slot]) slot = (slot+1) & mask;
+   table[slot] = index + 1;
+}
+
+
+/**
+ * Build the hash indexes of a symbol table. The load factor is kept at 50% or below, so lookups need ~1 probe.
+ *
+ * @param  SYMBOL_TABLE* table
+ */
+static void WINAPI SymbolTable_BuildIndex(SYMBOL_TABLE* table) {
+   uint size = 16;
+   while (size < table->count*2) size <<= 1;
+   table->mask = size - 1;
+   table->byName   .assign(size, 0);
+   table->byAltName.assign(size, 0);
+   table->byId     .assign(size, 0);
+
+   for (uint i=0; i < table->count; i++) {
+      const SYMBOL &symbol = table->symbols[i];
+      HashTable_Insert(table->byName, table->mask, SymbolNameHash(symbol.name), i);
+      if (symbol.altName[0]) HashTable_Insert(table->byAltName, table->mask, SymbolNameHash(symbol.altName), i);
+      HashTable_Insert(table->byId, table->mask, SymbolIdHash(symbol.id), i);
+   }
+}
+
+
+/**
+ * Read a file completely into memory.
+ *
+ * @param  string             &filename
+ * @param  std::vector<BYTE>  &data     - buffer receiving the file content
+ * @param  BOOL               &exists   - variable receiving whether the file exists
+ *
+ * @return BOOL - success status (a non-existing file is not an error)
+ */
+static BOOL WINAPI ReadWholeFile(const string &filename, std::vector<BYTE> &data, BOOL &exists) {
+   data.clear();
+   exists = FALSE;
+
+   HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+   if (hFile == INVALID_HANDLE_VALUE) {
+      DWORD lastError = GetLastError();
+      if (lastError==ERROR_FILE_NOT_FOUND || lastError==ERROR_PATH_NOT_FOUND) return(TRUE);
+      return(!error(ERR_WIN32_ERROR + lastError, "CreateFileA() cannot open \"%s\"", filename.c_str()));
+   }
+   exists = TRUE;
+
+   DWORD size = GetFileSize(hFile, NULL), read = 0;
+   if (size == INVALID_FILE_SIZE) {
+      error(ERR_WIN32_ERROR + GetLastError(), "GetFileSize(\"%s\")", filename.c_str());
+      return(!CloseHandle(hFile));
+   }
+   data.resize(size);
+   if (size && (!ReadFile(hFile, &data[0], size, &read, NULL) || read != size)) {
+      error(ERR_WIN32_ERROR + GetLastError(), "ReadFile(\"%s\", %d bytes)", filename.c_str(), size);
+      return(!CloseHandle(hFile));
+   }
+   CloseHandle(hFile);
+   return(TRUE);
+}
+
+
+/**
+ * Open a "symbols.raw" file and read it into memory. Hash indexes on SYMBOL.name, SYMBOL.altName and SYMBOL.id are built
+ * once, after that lookups run in O(1). The file is closed before the function returns, so it can be replaced while the
+ * table is in use (e.g. by SymbolTransaction_Commit()). Changes of the file after opening are not visible, to see them the
+ * file must be re-opened.
+ *
+ * @param  char* filename - full filename
+ *
+ * @return uint - handle of the symbol table or NULL in case of errors
+ */
+uint WINAPI SymbolTable_Open(const char* filename) {
+   if ((uint)filename < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter filename: 0x%p (not a valid pointer)", filename));
+
+   std::vector<BYTE> data;
+   BOOL exists;
+   if (!ReadWholeFile(filename, data, exists)) return(NULL);
+   if (!exists)                                return(!error(ERR_FILE_NOT_FOUND, "file not found: \"%s\"", filename));
+
+   uint fileSize = data.size();
+   if (fileSize % sizeof(SYMBOL) || fileSize > MAX_SYMBOLS * sizeof(SYMBOL)) return(!error(ERR_INVALID_FILE_FORMAT, "illegal size of \"%s\": %d (not a multiple of %d or more than %d symbols)", filename, fileSize, sizeof(SYMBOL), MAX_SYMBOLS));
+
+   SYMBOL_TABLE* table = new SYMBOL_TABLE();
+   table->filename = filename;
+   table->count    = fileSize / sizeof(SYMBOL);
+   table->symbols.resize(table->count);
+   if (fileSize) memcpy(&table->symbols[0], &data[0], fileSize);
+   SymbolTable_BuildIndex(table);
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_symbolTables.push_back(table);                            // may re-allocate, thus needs to be synchronized
+   table->id = g_symbolTables.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(table->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve a symbol table handle.
+ *
+ * @param  uint hTable - symbol table handle
+ *
+ * @return SYMBOL_TABLE* - the symbol table or NULL in case of errors
+ */
+static SYMBOL_TABLE* WINAPI GetSymbolTable(uint hTable) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_symbolTables.size();                          // the vector may be re-allocated by SymbolTable_Open()
+   SYMBOL_TABLE* table = ((int)hTable > 0 && hTable <= size) ? g_symbolTables[hTable-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hTable <= 0 || hTable > size) return((SYMBOL_TABLE*)!error(ERR_INVALID_PARAMETER, "invalid parameter hTable: %d (unknown handle)", hTable));
+   if (!table)                            return((SYMBOL_TABLE*)!error(ERR_ILLEGAL_STATE, "symbol table already closed: hTable=%d", hTable));
+   return(table);
+}
+
+
+/**
+ * Close a symbol table opened by SymbolTable_Open(). Pointers to its symbols become invalid.
+ *
+ * @param  uint hTable - symbol table handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI SymbolTable_Close(uint hTable) {
+   SYMBOL_TABLE* table = GetSymbolTable(hTable);
+   if (!table) return(FALSE);
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL closed = (hTable <= g_symbolTables.size() && g_symbolTables[hTable-1] == table);
+   if (closed) g_symbolTables[hTable-1] = NULL;                // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+   if (!closed) return(!error(ERR_ILLEGAL_STATE, "symbol table already closed: hTable=%d", hTable));
+
+   delete table;
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of symbols of a symbol table.
+ *
+ * @param  uint hTable - symbol table handle
+ *
+ * @return int - number of symbols or EMPTY (-1) in case of errors
+ */
+int WINAPI SymbolTable_Count(uint hTable) {
+   const SYMBOL_TABLE* table = GetSymbolTable(hTable);
+   if (!table) return(EMPTY);
+   return(table->count);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the symbols of a symbol table.
+ *
+ * @param  uint hTable - symbol table handle
+ *
+ * @return SYMBOL* - pointer into the table or NULL in case of errors or if the table is empty
+ */
+const SYMBOL* WINAPI SymbolTable_Symbols(uint hTable) {
+   const SYMBOL_TABLE* table = GetSymbolTable(hTable);
+   if (!table) return(NULL);
+   return(table->count ? &table->symbols[0] : NULL);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Find a symbol by name.
+ *
+ * @param  uint  hTable - symbol table handle
+ * @param  char* name   - symbol name (case-sensitive)
+ *
+ * @return SYMBOL* - pointer into the table or NULL if the symbol was not found or in case of errors
+ */
+const SYMBOL* WINAPI SymbolTable_FindByName(uint hTable, const char* name) {
+   const SYMBOL_TABLE* table = GetSymbolTable(hTable);
+   if (!table)                         return(NULL);
+   if ((uint)name < MIN_VALID_POINTER) return((SYMBOL*)!error(ERR_INVALID_PARAMETER, "invalid parameter name: 0x%p (not a valid pointer)", name));
+
+   for (uint slot=SymbolNameHash(name) & table->mask; table->byName[slot]; slot=(slot+1) & table->mask) {
+      const SYMBOL* symbol = &table->symbols[table->byName[slot]-1];
+      if (!strncmp(symbol->name, name, sizeof(symbol->name))) return(symbol);
+   }
+   return(NULL);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Find a symbol by its alternative (standard) name.
+ *
+ * @param  uint  hTable  - symbol table handle
+ * @param  char* altName - alternative symbol name (case-sensitive)
+ *
+ * @return SYMBOL* - pointer into the table or NULL if the symbol was not found or in case of errors
+ */
+const SYMBOL* WINAPI SymbolTable_FindByAltName(uint hTable, const char* altName) {
+   const SYMBOL_TABLE* table = GetSymbolTable(hTable);
+   if (!table)                            return(NULL);
+   if ((uint)altName < MIN_VALID_POINTER) return((SYMBOL*)!error(ERR_INVALID_PARAMETER, "invalid parameter altName: 0x%p (not a valid pointer)", altName));
+   if (!*altName)                         return(NULL);
+
+   for (uint slot=SymbolNameHash(altName) & table->mask; table->byAltName[slot]; slot=(slot+1) & table->mask) {
+      const SYMBOL* symbol = &table->symbols[table->byAltName[slot]-1];
+      if (!strncmp(symbol->altName, altName, sizeof(symbol->altName))) return(symbol);
+   }
+   return(NULL);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Find a symbol by id.
+ *
+ * @param  uint hTable - symbol table handle
+ * @param  uint id     - symbol id
+ *
+ * @return SYMBOL* - pointer into the table or NULL if the symbol was not found or in case of errors
+ */
+const SYMBOL* WINAPI SymbolTable_FindById(uint hTable, uint id) {
+   const SYMBOL_TABLE* table = GetSymbolTable(hTable);
+   if (!table) return(NULL);
+
+   for (uint slot=SymbolIdHash(id) & table->mask; table->byId[slot]; slot=(slot+1) & table->mask) {
+      const SYMBOL* symbol = &table->symbols[table->byId[slot]-1];
+      if (symbol->id == id) return(symbol);
+   }
+   return(NULL);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Write data to a temporary file next to the target file. The data is flushed to disk before the function returns.
+ *
+ * @param  string &tmpFile - temporary filename
+ * @param  void*  data
+ * @param  uint   size
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI WriteTempFile(const string &tmpFile, const void* data, uint size) {
+   HANDLE hFile = CreateFileA(tmpFile.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (hFile == INVALID_HANDLE_VALUE) return(!error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot create \"%s\"", tmpFile.c_str()));
+
+   DWORD written = 0;
+   BOOL success = TRUE;
+   if (size && (!WriteFile(hFile, data, size, &written, NULL) || written != size)) success = !error(ERR_WIN32_ERROR + GetLastError(), "WriteFile(\"%s\", %d bytes)", tmpFile.c_str(), size);
+   else if (!FlushFileBuffers(hFile))                                                success = !error(ERR_WIN32_ERROR + GetLastError(), "FlushFileBuffers(\"%s\")", tmpFile.c_str());
+   CloseHandle(hFile);
+
+   if (!success) DeleteFileA(tmpFile.c_str());
+   return(success);
+}
+
+
+/**
+ * Start a transaction on the symbol files of a trade server directory. The files "symbols.raw", "symgroups.raw" and
+ * "symbols.sel" are read once, all following changes are made in memory and written by SymbolTransaction_Commit().
+ * Missing files are treated as empty.
+ *
+ * @param  char* directory - full path of the trade server directory ("<data-directory>/history/<trade-server>")
+ *
+ * @return uint - transaction handle or NULL in case of errors
+ */
+uint WINAPI SymbolTransaction_Begin(const char* directory) {
+   if ((uint)directory < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter directory: 0x%p (not a valid pointer)", directory));
+   if (!*directory)                         return(!error(ERR_INVALID_PARAMETER, "invalid parameter directory: \"\" (empty)"));
+
+   string dir(directory);
+   if (dir[dir.size()-1] != '\\' && dir[dir.size()-1] != '/') dir.append("\\");
+
+   std::vector<BYTE> data;
+   BOOL exists;
+
+   // symbols.raw
+   string filename = dir + "symbols.raw";
+   if (!ReadWholeFile(filename, data, exists)) return(NULL);
+   if (data.size() % sizeof(SYMBOL) || data.size() > MAX_SYMBOLS * sizeof(SYMBOL))
+      return(!error(ERR_INVALID_FILE_FORMAT, "illegal size of \"%s\": %d (not a multiple of %d or more than %d symbols)", filename.c_str(), data.size(), sizeof(SYMBOL), MAX_SYMBOLS));
+
+   SYMBOL_TRANSACTION* tx = new SYMBOL_TRANSACTION();
+   tx->directory = dir;
+   tx->maxId     = 0;
+   tx->modified  = FALSE;
+   if (!data.empty()) {
+      const SYMBOL* symbols = (const SYMBOL*)&data[0];
+      tx->symbols.assign(symbols, symbols + data.size()/sizeof(SYMBOL));
+   }
+   for (uint i=0; i < tx->symbols.size(); i++) {
+      tx->byName[string(tx->symbols[i].name, strnlen(tx->symbols[i].name, sizeof(tx->symbols[i].name)))] = i;
+      tx->maxId = max(tx->maxId, tx->symbols[i].id);
+   }
+
+   // symgroups.raw
+   filename = dir + "symgroups.raw";
+   BOOL success = ReadWholeFile(filename, data, exists);
+   if (success && exists && data.size() != MAX_SYMBOL_GROUPS * sizeof(SYMBOL_GROUP))
+      success = !error(ERR_INVALID_FILE_FORMAT, "illegal size of \"%s\": %d (not %d)", filename.c_str(), data.size(), MAX_SYMBOL_GROUPS * sizeof(SYMBOL_GROUP));
+   if (!success) {
+      delete tx;
+      return(NULL);
+   }
+   tx->groups.resize(MAX_SYMBOL_GROUPS);
+   if (exists) memcpy(&tx->groups[0], &data[0], data.size());
+
+   // symbols.sel: a header followed by SYMBOL_SELECTED records
+   filename = dir + "symbols.sel";
+   if (!ReadWholeFile(filename, data, exists)) {
+      delete tx;
+      return(NULL);
+   }
+   if (exists) {
+      uint headerSize = data.size() % sizeof(SYMBOL_SELECTED);
+      tx->selectedHeader.assign(data.begin(), data.begin() + headerSize);
+      if (data.size() > headerSize) {
+         const SYMBOL_SELECTED* selected = (const SYMBOL_SELECTED*)&data[headerSize];
+         tx->selected.assign(selected, selected + (data.size()-headerSize)/sizeof(SYMBOL_SELECTED));
+      }
+      for (uint i=0; i < tx->selected.size(); i++) {
+         tx->selectedByName[string(tx->selected[i].symbol, strnlen(tx->selected[i].symbol, sizeof(tx->selected[i].symbol)))] = i;
+      }
+   }
+   else {
+      int version = SYMBOLS_SEL_VERSION;
+      tx->selectedHeader.assign((BYTE*)&version, (BYTE*)&version + sizeof(version));
+   }
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_symbolTransactions.push_back(tx);                         // may re-allocate, thus needs to be synchronized
+   tx->id = g_symbolTransactions.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(tx->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve a symbol transaction handle.
+ *
+ * @param  uint hTx - transaction handle
+ *
+ * @return SYMBOL_TRANSACTION* - the transaction or NULL in case of errors
+ */
+static SYMBOL_TRANSACTION* WINAPI GetSymbolTransaction(uint hTx) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_symbolTransactions.size();                    // the vector may be re-allocated by SymbolTransaction_Begin()
+   SYMBOL_TRANSACTION* tx = ((int)hTx > 0 && hTx <= size) ? g_symbolTransactions[hTx-1] : NULL;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hTx <= 0 || hTx > size) return((SYMBOL_TRANSACTION*)!error(ERR_INVALID_PARAMETER, "invalid parameter hTx: %d (unknown handle)", hTx));
+   if (!tx)                         return((SYMBOL_TRANSACTION*)!error(ERR_ILLEGAL_STATE, "symbol transaction already finished: hTx=%d", hTx));
+   return(tx);
+}
+
+
+/**
+ * Add a symbol group to a transaction. If a group of the same name exists its description and color are updated, otherwise
+ * the group is stored in the first unused slot.
+ *
+ * @param  uint  hTx         - transaction handle
+ * @param  char* name        - group name
+ * @param  char* description - group description
+ * @param  uint  color       - group color in the "Market Watch" window
+ *
+ * @return int - index of the group or EMPTY (-1) in case of errors
+ */
+int WINAPI SymbolTransaction_AddGroup(uint hTx, const char* name, const char* description, uint color) {
+   SYMBOL_TRANSACTION* tx = GetSymbolTransaction(hTx);
+   if (!tx) return(EMPTY);
+   if ((uint)name < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter name: 0x%p (not a valid pointer)", name)));
+
+   int index = EMPTY;
+   for (int i=0; i < MAX_SYMBOL_GROUPS; i++) {
+      if (!strncmp(tx->groups[i].name, name, sizeof(tx->groups[i].name))) { index = i; break; }
+      if (index == EMPTY && !tx->groups[i].name[0]) index = i;
+   }
+   if (index == EMPTY) return(_EMPTY(error(ERR_RUNTIME_ERROR, "cannot add symbol group \"%s\": all %d groups in use", name, MAX_SYMBOL_GROUPS)));
+
+   SYMBOL_GROUP group = tx->groups[index];
+   if (!sg_SetName(&group, name))               return(EMPTY);
+   if (!sg_SetDescription(&group, description)) return(EMPTY);
+   sg_SetBackgroundColor(&group, color);
+
+   tx->groups[index] = group;
+   tx->modified = TRUE;
+   return(index);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Insert or update symbols in a transaction. A symbol with the name of an existing symbol replaces the existing record but
+ * keeps its SYMBOL.id (ids are constant). A new symbol keeps its SYMBOL.id if it's unused, otherwise it gets a new id.
+ * SYMBOL.index is re-assigned on commit. The batch is validated as a whole before it's applied: in case of errors the
+ * transaction is not changed.
+ *
+ * @param  uint   hTx       - transaction handle
+ * @param  SYMBOL symbols[] - symbols to insert or update
+ * @param  int    count     - number of symbols
+ * @param  BOOL   select    - whether to add the symbols to "symbols.sel" (the "Market Watch" window)
+ *
+ * @return int - number of inserted or updated symbols or EMPTY (-1) in case of errors
+ */
+int WINAPI SymbolTransaction_AddSymbols(uint hTx, const SYMBOL symbols[], int count, BOOL select) {
+   SYMBOL_TRANSACTION* tx = GetSymbolTransaction(hTx);
+   if (!tx) return(EMPTY);
+   if ((uint)symbols < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter symbols: 0x%p (not a valid pointer)", symbols)));
+   if (count < 0)                         return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter count: %d", count)));
+
+   // validate the batch
+   std::vector<string> names(count);
+   std::set<string> inserts;
+   for (int i=0; i < count; i++) {
+      const SYMBOL &symbol = symbols[i];
+      string &name = names[i];
+      name.assign(symbol.name, strnlen(symbol.name, sizeof(symbol.name)));
+      if (name.empty())                      return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid symbol at index %d: empty name", i)));
+      if (name.size() > MAX_SYMBOL_LENGTH)   return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid symbol at index %d: name not terminated", i)));
+      if (symbol.group >= MAX_SYMBOL_GROUPS) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid symbol \"%s\": group %d (must be 0 to %d)", name.c_str(), symbol.group, MAX_SYMBOL_GROUPS-1)));
+      if (!tx->groups[symbol.group].name[0]) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid symbol \"%s\": group %d is unused", name.c_str(), symbol.group)));
+      if (!tx->byName.count(name)) inserts.insert(name);
+   }
+   if (tx->symbols.size() + inserts.size() > MAX_SYMBOLS) return(_EMPTY(error(ERR_RUNTIME_ERROR, "cannot add %d symbols: limit of %d symbols reached", inserts.size(), MAX_SYMBOLS)));
+
+   // apply it
+   std::set<uint> ids;
+   for (uint i=0; i < tx->symbols.size(); i++) {
+      ids.insert(tx->symbols[i].id);
+   }
+   for (int i=0; i < count; i++) {
+      SYMBOL symbol = symbols[i];
+      const string &name = names[i];
+
+      std::map<string, uint>::iterator it = tx->byName.find(name);
+      if (it != tx->byName.end()) {
+         symbol.id = tx->symbols[it->second].id;                     // update: keep the id
+         tx->symbols[it->second] = symbol;
+      }
+      else {
+         if (ids.count(symbol.id)) symbol.id = tx->maxId + 1;        // insert: the id must be unique
+         tx->maxId = max(tx->maxId, symbol.id);
+         ids.insert(symbol.id);
+         tx->byName[name] = tx->symbols.size();
+         tx->symbols.push_back(symbol);
+      }
+
+      if (select && !tx->selectedByName.count(name)) {
+         SYMBOL_SELECTED ss = {};
+         strcpy(ss.symbol, name.c_str());
+         ss.unknown_1 = 0x0001;
+         ss.tickType  = 2;                                           // n/a
+         ss.unknown_4 = 0x0100;
+         tx->selectedByName[name] = tx->selected.size();
+         tx->selected.push_back(ss);
+      }
+   }
+   if (count) tx->modified = TRUE;
+   return(count);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Commit a transaction and release it. Symbols are sorted by name and re-indexed, the "symbols.sel" records of existing
+ * symbols are synchronized. Each file is written once to a temporary file and flushed. Only after all files have been
+ * written successfully they replace the original files, so an interrupted commit never leaves a partially written file.
+ *
+ * The files are replaced one after another, the originals are kept as "<name>.bak" until all files have been replaced. If
+ * a replacement fails the already replaced files are restored from their backups. Should the restore fail too, or the
+ * process die during the replacement, the directory may hold files of both generations. In that case the error names the
+ * files which could not be restored, the backups of the previous generation are left in place.
+ *
+ * @param  uint hTx - transaction handle
+ *
+ * @return BOOL - success status (on error the transaction stays open and may be committed again or rolled back)
+ */
+BOOL WINAPI SymbolTransaction_Commit(uint hTx) {
+   SYMBOL_TRANSACTION* tx = GetSymbolTransaction(hTx);
+   if (!tx) return(FALSE);
+   if (!tx->modified) return(SymbolTransaction_Rollback(hTx));
+
+   // sort and re-index the symbols
+   if (!tx->symbols.empty() && !SortSymbols(&tx->symbols[0], tx->symbols.size())) return(FALSE);
+   tx->byName.clear();
+   for (uint i=0; i < tx->symbols.size(); i++) {
+      tx->byName[string(tx->symbols[i].name, strnlen(tx->symbols[i].name, sizeof(tx->symbols[i].name)))] = i;
+   }
+
+   // synchronize the selected symbols
+   for (uint i=0; i < tx->selected.size(); i++) {
+      SYMBOL_SELECTED &ss = tx->selected[i];
+      std::map<string, uint>::iterator it = tx->byName.find(string(ss.symbol, strnlen(ss.symbol, sizeof(ss.symbol))));
+      if (it == tx->byName.end()) continue;                          // leave unknown records untouched
+      const SYMBOL &symbol = tx->symbols[it->second];
+      ss.symbolIndex = symbol.index;
+      ss.digits      = symbol.digits;
+      ss.group       = symbol.group;
+      ss.pointSize   = symbol.pointSize;
+      ss.spread      = symbol.spread;
+   }
+
+   std::vector<BYTE> sel(tx->selectedHeader);
+   if (!tx->selected.empty()) sel.insert(sel.end(), (BYTE*)&tx->selected[0], (BYTE*)(&tx->selected[0] + tx->selected.size()));
+
+   // write all temporary files
+   const char* names[] = { "symgroups.raw", "symbols.raw", "symbols.sel" };
+   const void* data [] = { &tx->groups[0], tx->symbols.empty() ? NULL : &tx->symbols[0], sel.empty() ? NULL : &sel[0] };
+   uint        sizes[] = { tx->groups.size() * sizeof(SYMBOL_GROUP), tx->symbols.size() * sizeof(SYMBOL), sel.size() };
+   const int   files   = sizeof(names)/sizeof(names[0]);
+
+   for (int i=0; i < files; i++) {
+      if (!WriteTempFile(tx->directory + names[i] + ".tmp", data[i], sizes[i])) {
+         while (--i >= 0) DeleteFileA((tx->directory + names[i] + ".tmp").c_str());
+         return(FALSE);
+      }
+   }
+
+   // replace the originals, keeping backups until all files are replaced
+   const DWORD flags = MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH;
+   BOOL backedUp[files] = {}, replaced[files] = {};
+   int i;
+   for (i=0; i < files; i++) {
+      string target = tx->directory + names[i], tmpFile = target + ".tmp", bakFile = target + ".bak";
+      if (GetFileAttributesA(target.c_str()) != INVALID_FILE_ATTRIBUTES) {
+         if (!MoveFileExA(target.c_str(), bakFile.c_str(), flags)) {
+            error(ERR_WIN32_ERROR + GetLastError(), "MoveFileExA(\"%s\", \"%s\")", target.c_str(), bakFile.c_str());
+            break;
+         }
+         backedUp[i] = TRUE;
+      }
+      if (!MoveFileExA(tmpFile.c_str(), target.c_str(), flags)) {
+         error(ERR_WIN32_ERROR + GetLastError(), "MoveFileExA(\"%s\", \"%s\")", tmpFile.c_str(), target.c_str());
+         break;
+      }
+      replaced[i] = TRUE;
+   }
+   BOOL success = (i == files);
+
+   if (!success) {
+      // restore the originals
+      string mixed;
+      for (int n=0; n < files; n++) {
+         string target = tx->directory + names[n], bakFile = target + ".bak";
+         DeleteFileA((target + ".tmp").c_str());
+         BOOL restored = TRUE;
+         if (replaced[n]) restored = backedUp[n] ? MoveFileExA(bakFile.c_str(), target.c_str(), flags) : DeleteFileA(target.c_str());
+         else if (backedUp[n]) restored = MoveFileExA(bakFile.c_str(), target.c_str(), flags);
+         if (!restored) mixed += (mixed.empty() ? "":", ") + string(names[n]);
+      }
+      if (!mixed.empty()) error(ERR_RUNTIME_ERROR, "cannot restore the previous generation of the symbol files in \"%s\": %s (backups: *.bak)", tx->directory.c_str(), mixed.c_str());
+      return(FALSE);
+   }
+   for (i=0; i < files; i++) {
+      if (backedUp[i]) DeleteFileA((tx->directory + names[i] + ".bak").c_str());
+   }
+
+   return(SymbolTransaction_Rollback(hTx));                          // release the transaction
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Discard all changes of a transaction and release it.
+ *
+ * @param  uint hTx - transaction handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI SymbolTransaction_Rollback(uint hTx) {
+   SYMBOL_TRANSACTION* tx = GetSymbolTransaction(hTx);
+   if (!tx) return(FALSE);
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL released = (hTx <= g_symbolTransactions.size() && g_symbolTransactions[hTx-1] == tx);
+   if (released) g_symbolTransactions[hTx-1] = NULL;                 // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+   if (!released) return(!error(ERR_ILLEGAL_STATE, "symbol transaction already finished: hTx=%d", hTx));
+
+   delete tx;
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Close all symbol tables still open. Called on DLL_PROCESS_DETACH.
+ */
+void WINAPI ReleaseSymbolTables() {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::vector<SYMBOL_TABLE*> tables;
+   tables.swap(g_symbolTables);
+   LeaveCriticalSection(&g_expanderMutex);
+
+   for (uint i=0; i < tables.size(); i++) {
+      delete tables[i];
+   }
+}
+
+
+/**
+ * Discard all symbol transactions still open. Called on DLL_PROCESS_DETACH.
+ */
+void WINAPI ReleaseSymbolTransactions() {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::vector<SYMBOL_TRANSACTION*> transactions;
+   transactions.swap(g_symbolTransactions);
+   LeaveCriticalSection(&g_expanderMutex);
+
+   for (uint i=0; i < transactions.size(); i++) {
+      delete transactions[i];
+   }
+}
@@ -10,9 +10,15 @@
 #include "lib/win32.h"
 
 #include <fstream>
+#include <vector>
 #include <windowsx.h>
 
 
+extern CRITICAL_SECTION          g_expanderMutex;        // mutex for Expander-wide locking
+std::vector<FXT_HEADER_CACHE*>   g_fxtHeaders;           // cached headers of test history files
+std::vector<int>                 g_testBarModels;        // bar models of tested experts (index = pid), EMPTY_VALUE: unknown
+
+
 /**
  * Find the window handle of the Stratetgy Tester's main window. The function returns NULL if the window doesn't yet exist
  * (i.e. before the window was openend the first time).
@@ -201,22 +207,172 @@ BOOL WINAPI Tester_ReadFxtHeader(const char* symbol, uint timeframe, uint barMod
 
 
 /**
- * Get the commission value for a test.
+ * Get the bar model of a running test. The bar model can't change while a test is running, so it is read from the tester
+ * window only once per test (i.e. per program id).
  *
  * @param  EXECUTION_CONTEXT* ec - execution context of the expert under test
  *
- * @return double - commission value or EMPTY (-1) in case of errors
+ * @return int - bar model id or EMPTY (-1) in case of errors
  */
-double WINAPI Test_GetCommission(const EXECUTION_CONTEXT* ec) {
+int WINAPI Test_GetBarModel(const EXECUTION_CONTEXT* ec) {
    if ((uint)ec < MIN_VALID_POINTER)               return _EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec));
    if (ec->programType!=PT_EXPERT || !ec->testing) return _EMPTY(error(ERR_FUNC_NOT_ALLOWED, "function allowed only in experts under test"));
 
-   int barModel = Tester_GetBarModel();
-   FXT_HEADER fxtHeader = {};
+   uint pid = ec->pid;
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   int barModel = (pid < g_testBarModels.size()) ? g_testBarModels[pid] : EMPTY_VALUE;    // the vector may be re-allocated by another thread
+   LeaveCriticalSection(&g_expanderMutex);
+   if (barModel != EMPTY_VALUE) return barModel;
+
+   barModel = Tester_GetBarModel();
+   if (barModel == EMPTY) return EMPTY;
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   if (pid >= g_testBarModels.size()) g_testBarModels.resize(pid+1, EMPTY_VALUE);
+   g_testBarModels[pid] = barModel;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return barModel;
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Reset the cached test metadata of a program. Called when a tested expert is unloaded.
+ *
+ * @param  uint pid - program id
+ */
+void WINAPI ReleaseTestSession(uint pid) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   if (pid < g_testBarModels.size()) g_testBarModels[pid] = EMPTY_VALUE;
+   LeaveCriticalSection(&g_expanderMutex);
+}
+
+
+/**
+ * Get the header of the test history file for the specified symbol, timeframe and bar model. Headers are cached and re-read
+ * only if the modification time or the size of the file changed. A call costs a query of the file attributes but no file
+ * I/O. The file is accessed without holding the lock, a re-read header is published and copied while the cache is locked.
+ *
+ * @param  _In_  char*       symbol    - tested symbol
+ * @param  _In_  uint        timeframe - test timeframe
+ * @param  _In_  uint        barModel  - test bar model: MODE_EVERYTICK | MODE_CONTROLPOINTS | MODE_BAROPEN
+ * @param  _Out_ FXT_HEADER* fxtHeader - struct FXT_HEADER receiving the data
+ *
+ * @return BOOL - success status (e.g. FALSE if the file does not exist)
+ */
+BOOL WINAPI Tester_GetFxtHeader(const char* symbol, uint timeframe, uint barModel, FXT_HEADER* fxtHeader) {
+   if ((uint)symbol    < MIN_VALID_POINTER) return !error(ERR_INVALID_PARAMETER, "invalid parameter symbol: 0x%p (not a valid pointer)", symbol);
+   if ((uint)fxtHeader < MIN_VALID_POINTER) return !error(ERR_INVALID_PARAMETER, "invalid parameter fxtHeader: 0x%p (not a valid pointer)", fxtHeader);
+
+   string filename = string(GetTerminalDataPathA()).append("\\tester\\history\\")     // e.g. "GBPJPY15_2.fxt"
+                                                   .append(symbol)
+                                                   .append(to_string(timeframe))
+                                                   .append("_")
+                                                   .append(to_string(barModel))
+                                                   .append(".fxt");
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   FXT_HEADER_CACHE* entry = NULL;
+   uint size = g_fxtHeaders.size();
+   for (uint i=0; i < size; i++) {
+      FXT_HEADER_CACHE* cached = g_fxtHeaders[i];
+      if (cached->timeframe==timeframe && cached->barModel==barModel && StrCompare(cached->symbol.c_str(), symbol)) {
+         entry = cached;
+         break;
+      }
+   }
+   if (!entry) {
+      entry = new FXT_HEADER_CACHE();
+      entry->symbol    = symbol;
+      entry->timeframe = timeframe;
+      entry->barModel  = barModel;
+      entry->filename  = filename;
+      g_fxtHeaders.push_back(entry);                           // entries are never removed, the pointer stays valid
+   }
+   LeaveCriticalSection(&g_expanderMutex);
+
+   WIN32_FILE_ATTRIBUTE_DATA fad;
+   if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &fad)) {
+      warn(ERR_WIN32_ERROR + GetLastError(), "cannot access file \"%s\"", filename.c_str());
+      if (!TryEnterCriticalSection(&g_expanderMutex)) {
+         debug("waiting for lock on g_expanderMutex...");
+         EnterCriticalSection(&g_expanderMutex);
+      }
+      entry->valid = FALSE;
+      LeaveCriticalSection(&g_expanderMutex);
+      return FALSE;
+   }
+   uint64 fileSize = (uint64)fad.nFileSizeHigh << 32 | fad.nFileSizeLow;
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL current = entry->valid && fileSize==entry->fileSize && !CompareFileTime(&fad.ftLastWriteTime, &entry->lastWriteTime);
+   if (current) *fxtHeader = entry->header;
+   LeaveCriticalSection(&g_expanderMutex);
+   if (current) return TRUE;
+
+   FXT_HEADER header;                                          // read outside of the lock and publish the result
+   BOOL valid = Tester_ReadFxtHeader(symbol, timeframe, barModel, header);
 
-   if (!Tester_ReadFxtHeader(ec->symbol, ec->timeframe, barModel, fxtHeader)) {
-      return _EMPTY(error(ERR_RUNTIME_ERROR, "cannot read FXT header for %s,%s (bar model: %s)", ec->symbol, PeriodDescriptionA(ec->timeframe), BarModelDescription(barModel)));
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
    }
+   entry->valid         = valid;
+   entry->lastWriteTime = fad.ftLastWriteTime;
+   entry->fileSize      = fileSize;
+   if (valid) entry->header = header;
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if (valid) *fxtHeader = header;
+   return valid;
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Get the header of the test history file of a running test. See Tester_GetFxtHeader().
+ *
+ * @param  _In_  EXECUTION_CONTEXT* ec        - execution context of the expert under test
+ * @param  _Out_ FXT_HEADER*        fxtHeader - struct FXT_HEADER receiving the data
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI Test_GetFxtHeader(const EXECUTION_CONTEXT* ec, FXT_HEADER* fxtHeader) {
+   int barModel = Test_GetBarModel(ec);
+   if (barModel == EMPTY) return FALSE;
+
+   if (!Tester_GetFxtHeader(ec->symbol, ec->timeframe, barModel, fxtHeader))
+      return !error(ERR_RUNTIME_ERROR, "cannot read FXT header for %s,%s (bar model: %s)", ec->symbol, PeriodDescriptionA(ec->timeframe), BarModelDescription(barModel));
+   return TRUE;
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Get the commission value for a test.
+ *
+ * @param  EXECUTION_CONTEXT* ec - execution context of the expert under test
+ *
+ * @return double - commission value or EMPTY (-1) in case of errors
+ */
+double WINAPI Test_GetCommission(const EXECUTION_CONTEXT* ec) {
+   FXT_HEADER fxtHeader;
+   if (!Test_GetFxtHeader(ec, &fxtHeader)) return EMPTY;
    return fxtHeader.commissionValue;
    #pragma EXPANDER_EXPORT
 }
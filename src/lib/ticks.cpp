@@ -0,0 +1,426 @@
+#include "expander.h"
+#include "lib/string.h"
+#include "lib/ticks.h"
+
+#include <vector>
+
+
+extern CRITICAL_SECTION   g_expanderMutex;               // mutex for Expander-wide locking
+std::vector<TICK_READER*> g_tickReaders;                 // all opened tick readers (index = handle-1)
+
+
+/**
+ * Read the tick at the specified record index of a tick file.
+ *
+ * @param  HANDLE hFile
+ * @param  uint64 index - record index
+ * @param  TICK&  tick  - struct receiving the tick
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI ReadTickAt(HANDLE hFile, uint64 index, TICK &tick) {
+   LARGE_INTEGER offset;
+   offset.QuadPart = index * sizeof(TICK);
+   DWORD read;
+   return(SetFilePointerEx(hFile, offset, NULL, FILE_BEGIN) && ReadFile(hFile, &tick, sizeof(TICK), &read, NULL) && read==sizeof(TICK));
+}
+
+
+/**
+ * Find the file offset of the first tick with a counter greater than the specified value. Counters are consecutive, so a
+ * binary search reads only a few records.
+ *
+ * @param  TICK_READER* reader
+ * @param  uint64       fileSize
+ * @param  uint         counter
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI TickReader_Seek(TICK_READER* reader, uint64 fileSize, uint counter) {
+   uint64 lo = 0, hi = fileSize / sizeof(TICK);
+   TICK tick;
+
+   while (lo < hi) {
+      uint64 mid = lo + (hi-lo)/2;
+      if (!ReadTickAt(reader->hFile, mid, tick)) return(!error(ERR_WIN32_ERROR + GetLastError(), "cannot read tick %I64u of \"%s\"", mid, reader->filename.c_str()));
+      if (tick.counter <= counter) lo = mid + 1;
+      else                         hi = mid;
+   }
+   reader->readOffset  = lo * sizeof(TICK);
+   reader->lastCounter = counter;
+   return(TRUE);
+}
+
+
+/**
+ * Return the queue of a symbol. Called by the reader thread only, a missing queue is created and published.
+ *
+ * @param  TICK_READER* reader
+ * @param  char*        symbol
+ *
+ * @return TICK_QUEUE* - queue or NULL if the max. number of queues was reached
+ */
+static TICK_QUEUE* WINAPI TickReader_Queue(TICK_READER* reader, const char* symbol) {
+   uint count = reader->queuesCount;
+
+   if (reader->lastQueue < count && !strncmp(reader->queues[reader->lastQueue]->symbol, symbol, MAX_SYMBOL_LENGTH))
+      return(reader->queues[reader->lastQueue]);
+
+   for (uint i=0; i < count; i++) {
+      if (!strncmp(reader->queues[i]->symbol, symbol, MAX_SYMBOL_LENGTH)) {
+         reader->lastQueue = i;
+         return(reader->queues[i]);
+      }
+   }
+   if (count >= MAX_SYMBOLS) return(NULL);
+
+   TICK_QUEUE* queue = new TICK_QUEUE();
+   strncpy(queue->symbol, symbol, MAX_SYMBOL_LENGTH);
+   reader->queues[count] = queue;
+   InterlockedIncrement(&reader->queuesCount);                 // publish the queue (full barrier)
+   reader->lastQueue = count;
+   return(queue);
+}
+
+
+/**
+ * Find the queue of a symbol. Called by consumers.
+ *
+ * @param  TICK_READER* reader
+ * @param  char*        symbol
+ *
+ * @return TICK_QUEUE* - queue or NULL if no tick of the symbol was seen yet
+ */
+static TICK_QUEUE* WINAPI TickReader_FindQueue(const TICK_READER* reader, const char* symbol) {
+   uint count = reader->queuesCount;
+   for (uint i=0; i < count; i++) {
+      if (StrCompare(reader->queues[i]->symbol, symbol)) return(reader->queues[i]);
+   }
+   return(NULL);
+}
+
+
+/**
+ * Read all ticks appended to the file since the last call and distribute them to the symbol queues. If a queue is full the
+ * tick is dropped and counted as overflow.
+ *
+ * @param  TICK_READER* reader
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI TickReader_ReadNew(TICK_READER* reader) {
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(reader->hFile, &size)) return(!error(ERR_WIN32_ERROR + GetLastError(), "GetFileSizeEx(\"%s\")", reader->filename.c_str()));
+   uint64 fileSize = size.QuadPart;
+
+   if (fileSize < reader->readOffset) {                        // the file was truncated or replaced: start over
+      warn(ERR_ILLEGAL_STATE, "\"%s\" was truncated (size %I64u < offset %I64u), restarting at the first tick", reader->filename.c_str(), fileSize, reader->readOffset);
+      reader->readOffset  = 0;
+      reader->lastCounter = 0;
+   }
+   uint64 available = (fileSize - reader->readOffset) / sizeof(TICK);
+
+   while (available) {
+      uint count = (uint)min(available, (uint64)TICK_READ_BUFFER);
+      LARGE_INTEGER offset;
+      offset.QuadPart = reader->readOffset;
+      DWORD bytes = count * sizeof(TICK), read;
+      if (!SetFilePointerEx(reader->hFile, offset, NULL, FILE_BEGIN) || !ReadFile(reader->hFile, &reader->buffer[0], bytes, &read, NULL) || read != bytes)
+         return(!error(ERR_WIN32_ERROR + GetLastError(), "cannot read %d ticks at offset %I64u of \"%s\"", count, reader->readOffset, reader->filename.c_str()));
+
+      for (uint i=0; i < count; i++) {
+         const TICK& tick = reader->buffer[i];
+         if (reader->lastCounter && tick.counter <= (uint)reader->lastCounter) continue;   // already processed
+
+         TICK_QUEUE* queue = TickReader_Queue(reader, tick.symbol);
+         if (queue) {
+            uint head = queue->head;
+            if (head - (uint)queue->tail >= TICK_QUEUE_SIZE) {
+               InterlockedIncrement(&queue->overflows);
+            }
+            else {
+               queue->ticks[head & (TICK_QUEUE_SIZE-1)] = tick;
+               InterlockedExchange(&queue->head, head+1);      // publish the tick (full barrier)
+            }
+         }
+         InterlockedExchange(&reader->lastCounter, tick.counter);
+      }
+      reader->readOffset += bytes;
+      available -= count;
+   }
+   return(TRUE);
+}
+
+
+/**
+ * Thread procedure of a tick reader. Polls the file until the reader is closed.
+ *
+ * @param  LPVOID reader
+ */
+static DWORD WINAPI TickReaderThread(LPVOID param) {
+   TICK_READER* reader = (TICK_READER*)param;
+   BOOL failed = FALSE;
+
+   while (!reader->stop) {
+      BOOL success = TickReader_ReadNew(reader);
+      if (!success && !failed) warn(ERR_RUNTIME_ERROR, "tick reader for \"%s\" failed, retrying silently", reader->filename.c_str());
+      failed = !success;
+      Sleep(TICK_POLL_INTERVAL);
+   }
+   InterlockedExchange(&reader->stopped, TRUE);                // from here on the reader is not accessed anymore
+   return(0);
+}
+
+
+/**
+ * Open a reader following a tick file ("<data-directory>/history/<trade-server>/ticks.raw"). A background thread reads new
+ * ticks as they are appended by the terminal and distributes them to a queue per symbol. Consumers fetch the ticks of a
+ * symbol with TickReader_GetTicks(), the cost is proportional to the number of new ticks only.
+ *
+ * @param  char* filename               - full filename
+ * @param  uint  fromCounter [optional] - counter of the last tick already processed by the caller, reading starts with the
+ *                                        next tick (default: 0, read the whole file)
+ *
+ * @return uint - handle of the reader or NULL in case of errors
+ */
+uint WINAPI TickReader_Open(const char* filename, uint fromCounter/*=0*/) {
+   if ((uint)filename < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter filename: 0x%p (not a valid pointer)", filename));
+
+   HANDLE hFile = CreateFileA(filename,                              // file name
+                              GENERIC_READ,                          // desired access
+                              FILE_SHARE_READ|FILE_SHARE_WRITE,      // share mode: the terminal keeps writing to the file
+                              NULL,                                  // default security
+                              OPEN_EXISTING,                         // open only if existing
+                              FILE_ATTRIBUTE_NORMAL,                 // normal file
+                              NULL);                                 // no attribute template
+   if (hFile == INVALID_HANDLE_VALUE) return(!error(ERR_WIN32_ERROR + GetLastError(), "CreateFileA() cannot open \"%s\"", filename));
+
+   TICK_READER* reader = new TICK_READER();
+   reader->filename = filename;
+   reader->hFile    = hFile;
+   reader->refCount = 1;                                       // the registry's reference
+   reader->buffer.resize(TICK_READ_BUFFER);
+
+   if (fromCounter) {
+      LARGE_INTEGER size;
+      BOOL success = GetFileSizeEx(hFile, &size);
+      if (!success) error(ERR_WIN32_ERROR + GetLastError(), "GetFileSizeEx(\"%s\")", filename);
+      else success = TickReader_Seek(reader, size.QuadPart, fromCounter);
+      if (!success) {
+         delete reader;
+         return(!CloseHandle(hFile));
+      }
+   }
+
+   reader->hThread = CreateThread(NULL, 0, TickReaderThread, reader, 0, NULL);
+   if (!reader->hThread) {
+      error(ERR_WIN32_ERROR + GetLastError(), "CreateThread(\"TickReader\")");
+      delete reader;
+      return(!CloseHandle(hFile));
+   }
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   g_tickReaders.push_back(reader);                            // may re-allocate, thus needs to be synchronized
+   reader->id = g_tickReaders.size();
+   LeaveCriticalSection(&g_expanderMutex);
+
+   return(reader->id);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Resolve a tick reader handle and acquire a reference to the reader. The reference must be returned with
+ * DropTickReader(). A reader closed by another thread stays valid until all references are dropped.
+ *
+ * @param  uint hReader - tick reader handle
+ *
+ * @return TICK_READER* - the reader or NULL in case of errors
+ */
+static TICK_READER* WINAPI AcquireTickReader(uint hReader) {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   uint size = g_tickReaders.size();
+   TICK_READER* reader = ((int)hReader > 0 && hReader <= size) ? g_tickReaders[hReader-1] : NULL;
+   if (reader) InterlockedIncrement(&reader->refCount);
+   LeaveCriticalSection(&g_expanderMutex);
+
+   if ((int)hReader <= 0 || hReader > size) return((TICK_READER*)!error(ERR_INVALID_PARAMETER, "invalid parameter hReader: %d (unknown handle)", hReader));
+   if (!reader)                             return((TICK_READER*)!error(ERR_ILLEGAL_STATE, "tick reader already closed: hReader=%d", hReader));
+   return(reader);
+}
+
+
+/**
+ * Drop a reference to a tick reader. The last reference releases the queues and the reader itself.
+ *
+ * @param  TICK_READER* reader
+ */
+static void WINAPI DropTickReader(TICK_READER* reader) {
+   if (InterlockedDecrement(&reader->refCount) > 0) return;
+
+   for (int i=0; i < reader->queuesCount; i++) {
+      delete reader->queues[i];
+   }
+   delete reader;
+}
+
+
+/**
+ * Stop the thread of a tick reader, close its handles and drop the registry's reference. Must be called after the reader
+ * was removed from the registry.
+ *
+ * On DLL_PROCESS_DETACH the reader thread can't be joined: its exit needs the loader lock held by the detaching thread.
+ * Instead the thread's stop flag is polled for a limited time. If the thread neither stopped nor terminated (at process
+ * exit all other threads are already gone) the reader is leaked rather than freed under the running thread.
+ *
+ * @param  TICK_READER* reader
+ * @param  BOOL         join - whether to wait for the exit of the reader thread
+ *
+ * @return BOOL - success status
+ */
+static BOOL WINAPI TickReader_Release(TICK_READER* reader, BOOL join) {
+   InterlockedExchange(&reader->stop, TRUE);
+
+   BOOL stopped;
+   if (join) {
+      stopped = (WaitForSingleObject(reader->hThread, INFINITE) == WAIT_OBJECT_0);
+      if (!stopped) error(ERR_WIN32_ERROR + GetLastError(), "WaitForSingleObject(hThread of \"%s\")", reader->filename.c_str());
+   }
+   else {
+      for (uint waited=0; !reader->stopped && waited < 4*TICK_POLL_INTERVAL; waited += 10) Sleep(10);
+      stopped = reader->stopped || WaitForSingleObject(reader->hThread, 0)==WAIT_OBJECT_0;
+   }
+
+   BOOL success = stopped;
+   if (!CloseHandle(reader->hThread)) success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(hThread of \"%s\")", reader->filename.c_str());
+   if (!stopped) return(!warn(ERR_ILLEGAL_STATE, "reader thread of \"%s\" didn't stop, leaking the reader", reader->filename.c_str()));
+
+   if (!CloseHandle(reader->hFile)) success = !error(ERR_WIN32_ERROR + GetLastError(), "CloseHandle(hFile of \"%s\")", reader->filename.c_str());
+   DropTickReader(reader);
+   return(success);
+}
+
+
+/**
+ * Close a tick reader. Stops and joins the reader thread. Calls of other threads still using the reader complete normally,
+ * the queues are released when the last of them returns.
+ *
+ * @param  uint hReader - tick reader handle
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI TickReader_Close(uint hReader) {
+   TICK_READER* reader = AcquireTickReader(hReader);
+   if (!reader) return(FALSE);
+
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   BOOL closed = (g_tickReaders[hReader-1] == reader);
+   g_tickReaders[hReader-1] = NULL;                            // the vector itself is not modified
+   LeaveCriticalSection(&g_expanderMutex);
+
+   BOOL success = !closed ? !error(ERR_ILLEGAL_STATE, "tick reader already closed: hReader=%d", hReader) : TickReader_Release(reader, TRUE);
+   DropTickReader(reader);
+   return(success);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Fetch the new ticks of a symbol. The queue of a symbol must be consumed by a single thread only.
+ *
+ * @param  uint  hReader - tick reader handle
+ * @param  char* symbol  - symbol
+ * @param  TICK  ticks[] - buffer receiving the ticks (oldest first)
+ * @param  int   size    - size of the buffer
+ *
+ * @return int - number of returned ticks (0 if there are no new ticks) or EMPTY (-1) in case of errors
+ */
+int WINAPI TickReader_GetTicks(uint hReader, const char* symbol, TICK ticks[], int size) {
+   if ((uint)symbol < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter symbol: 0x%p (not a valid pointer)", symbol)));
+   if ((uint)ticks < MIN_VALID_POINTER)  return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ticks: 0x%p (not a valid pointer)", ticks)));
+   if (size < 0)                         return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size)));
+   TICK_READER* reader = AcquireTickReader(hReader);
+   if (!reader) return(EMPTY);
+
+   uint count = 0;
+   TICK_QUEUE* queue = TickReader_FindQueue(reader, symbol);
+   if (queue) {
+      uint tail = queue->tail;
+      count = min((uint)queue->head - tail, (uint)size);       // volatile read of head: acquire semantics
+
+      for (uint i=0; i < count; i++) {
+         ticks[i] = queue->ticks[(tail+i) & (TICK_QUEUE_SIZE-1)];
+      }
+      InterlockedExchange(&queue->tail, tail+count);           // release the slots
+   }
+   DropTickReader(reader);
+   return(count);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of ticks of a symbol dropped because its queue was full.
+ *
+ * @param  uint  hReader - tick reader handle
+ * @param  char* symbol  - symbol
+ *
+ * @return int - number of dropped ticks or EMPTY (-1) in case of errors
+ */
+int WINAPI TickReader_Overflows(uint hReader, const char* symbol) {
+   if ((uint)symbol < MIN_VALID_POINTER) return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter symbol: 0x%p (not a valid pointer)", symbol)));
+   TICK_READER* reader = AcquireTickReader(hReader);
+   if (!reader) return(EMPTY);
+
+   const TICK_QUEUE* queue = TickReader_FindQueue(reader, symbol);
+   int overflows = queue ? queue->overflows : 0;
+   DropTickReader(reader);
+   return(overflows);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the counter of the last tick processed by a tick reader. It can be passed to TickReader_Open() to resume reading
+ * after a restart.
+ *
+ * @param  uint hReader - tick reader handle
+ *
+ * @return uint - tick counter or NULL in case of errors
+ */
+uint WINAPI TickReader_LastCounter(uint hReader) {
+   TICK_READER* reader = AcquireTickReader(hReader);
+   if (!reader) return(NULL);
+   uint counter = reader->lastCounter;
+   DropTickReader(reader);
+   return(counter);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Close all tick readers still open. Called on DLL_PROCESS_DETACH.
+ */
+void WINAPI ReleaseTickReaders() {
+   if (!TryEnterCriticalSection(&g_expanderMutex)) {
+      debug("waiting for lock on g_expanderMutex...");
+      EnterCriticalSection(&g_expanderMutex);
+   }
+   std::vector<TICK_READER*> readers;
+   readers.swap(g_tickReaders);
+   LeaveCriticalSection(&g_expanderMutex);
+
+   uint size = readers.size();
+   for (uint i=0; i < size; i++) {
+      if (readers[i]) TickReader_Release(readers[i], FALSE);
+   }
+}
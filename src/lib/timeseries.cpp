@@ -0,0 +1,318 @@
+#include "expander.h"
+#include "lib/terminal.h"
+#include "lib/timeseries.h"
+
+#include <emmintrin.h>
+
+
+/**
+ * Return the bar format of the price series passed in EXECUTION_CONTEXT.rates. The format depends on the terminal build
+ * only and is resolved once per process.
+ *
+ * @return uint - bar format (400 | 401) or NULL in case of errors
+ */
+uint WINAPI GetBarFormat() {
+   static uint format;
+
+   if (!format) {
+      uint build = GetTerminalBuild();
+      if (!build) return(NULL);
+      format = (build <= 509) ? 400 : 401;
+   }
+   return(format);
+}
+
+
+/**
+ * Find the last bar with an open time not after the specified time, i.e. the bar containing the time. Uses interpolation
+ * search alternating with bisection. Interpolation hits the bar in 1-2 probes on regular series, bisection bounds the worst
+ * case of irregular series (e.g. weekends) to O(log n).
+ *
+ * @param  T*     rates - bars ordered ascending by time
+ * @param  int    from  - first bar to search
+ * @param  int    to    - last bar to search
+ * @param  time32 time  - time to look up
+ *
+ * @return int - memory index of the bar or EMPTY (-1) if the time is older than the bar at index 'from'
+ */
+template <typename T>
+static int WINAPI FindBar(const T* rates, int from, int to, time32 time) {
+   int lo = from, hi = to;
+   if (time <  rates[lo].time) return(EMPTY);
+   if (time >= rates[hi].time) return(hi);
+
+   // invariant: rates[lo].time <= time < rates[hi].time
+   for (BOOL interpolate=TRUE; hi-lo > 1; interpolate=!interpolate) {
+      int mid;
+      if (interpolate) {
+         mid = lo + (int)((double)(time - rates[lo].time) / (rates[hi].time - rates[lo].time) * (hi-lo));
+         if      (mid <= lo) mid = lo + 1;
+         else if (mid >= hi) mid = hi - 1;
+      }
+      else {
+         mid = lo + (hi-lo)/2;
+      }
+      if (rates[mid].time <= time) lo = mid;
+      else                         hi = mid;
+   }
+   return(lo);
+}
+
+
+/**
+ * Resolve the chart offset of the bar containing a time.
+ *
+ * @param  BarView<T> view  - bar timeseries
+ * @param  time32     time  - time to look up
+ * @param  BOOL       exact - whether the bar must start exactly at the specified time
+ *
+ * @return int - bar offset (0 = youngest bar) or EMPTY (-1) if no matching bar was found
+ */
+template <typename T>
+static int WINAPI BarShift(const BarView<T> &view, time32 time, BOOL exact) {
+   int i = FindBar(view.rates, 0, view.bars-1, time);
+   if (i == EMPTY || (exact && view.rates[i].time != time)) return(EMPTY);
+   return(view.bars-1-i);
+}
+
+
+/**
+ * Resolve the chart offsets of the bars containing multiple times. Times must be ordered ascending. The lookup is a single
+ * merged pass: each search starts at the previous result and gallops forward, so m lookups cost O(m * log(n/m)) instead
+ * of O(m * log(n)).
+ *
+ * @param  BarView<T> view      - bar timeseries
+ * @param  time32     times[]   - times to look up
+ * @param  int        size      - number of times
+ * @param  int        results[] - array receiving the bar offsets (0 = youngest bar) or EMPTY (-1) if no matching bar was
+ *                                found
+ * @param  BOOL       exact     - whether bars must start exactly at the specified times
+ */
+template <typename T>
+static void WINAPI BarShifts(const BarView<T> &view, const time32 times[], int size, int results[], BOOL exact) {
+   const T* rates = view.rates;
+   int last = view.bars-1, pos = 0;
+
+   for (int n=0; n < size; n++) {
+      time32 time = times[n];
+      int i = EMPTY;
+
+      if (time >= rates[pos].time) {
+         int lo = pos, step = 1;                         // gallop forward from the previous result
+         while (lo+step <= last && rates[lo+step].time <= time) {
+            lo += step;
+            step <<= 1;
+         }
+         i = FindBar(rates, lo, min(lo+step, last), time);
+         pos = i;
+      }
+      results[n] = (i==EMPTY || (exact && rates[i].time != time)) ? EMPTY : last-i;
+   }
+}
+
+
+/**
+ * Return the offset of the bar containing the specified time in the current chart of an MQL program. Replacement for
+ * MQL::iBarShift() using an interpolation/binary search over EXECUTION_CONTEXT.rates.
+ *
+ * @param  EXECUTION_CONTEXT* ec    - execution context of the program
+ * @param  time32             time  - time to look up
+ * @param  BOOL               exact - whether the bar must start exactly at the specified time (default: no)
+ *
+ * @return int - bar offset (0 = youngest bar) or EMPTY (-1) if no matching bar was found or in case of errors
+ */
+int WINAPI iBarShift(const EXECUTION_CONTEXT* ec, time32 time, BOOL exact/*=FALSE*/) {
+   if ((uint)ec < MIN_VALID_POINTER)        return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec)));
+   if ((uint)ec->rates < MIN_VALID_POINTER) return(_EMPTY(error(ERR_ILLEGAL_STATE, "invalid ec.rates: 0x%p (not a valid pointer)", ec->rates)));
+   if (ec->bars <= 0) return(EMPTY);
+
+   uint format = GetBarFormat();
+   if (!format) return(EMPTY);
+
+   if (format == 400) return(BarShift(BarView<HistoryBar400>(ec), time, exact));
+   else               return(BarShift(BarView<HistoryBar401>(ec), time, exact));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the offsets of the bars containing multiple times in the current chart of an MQL program. The times are resolved
+ * in a single merged pass over EXECUTION_CONTEXT.rates.
+ *
+ * @param  EXECUTION_CONTEXT* ec        - execution context of the program
+ * @param  time32             times[]   - times to look up, ordered ascending
+ * @param  int                size      - number of times
+ * @param  int                results[] - array receiving the bar offsets (0 = youngest bar) or EMPTY (-1) if no matching
+ *                                        bar was found
+ * @param  BOOL               exact     - whether bars must start exactly at the specified times (default: no)
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI iBarShifts(const EXECUTION_CONTEXT* ec, const time32 times[], int size, int results[], BOOL exact/*=FALSE*/) {
+   if ((uint)ec < MIN_VALID_POINTER)        return(!error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec));
+   if ((uint)ec->rates < MIN_VALID_POINTER) return(!error(ERR_ILLEGAL_STATE, "invalid ec.rates: 0x%p (not a valid pointer)", ec->rates));
+   if ((uint)times < MIN_VALID_POINTER)     return(!error(ERR_INVALID_PARAMETER, "invalid parameter times: 0x%p (not a valid pointer)", times));
+   if ((uint)results < MIN_VALID_POINTER)   return(!error(ERR_INVALID_PARAMETER, "invalid parameter results: 0x%p (not a valid pointer)", results));
+   if (size < 0)                            return(!error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= 0)", size));
+   for (int i=1; i < size; i++) {
+      if (times[i] < times[i-1])            return(!error(ERR_INVALID_PARAMETER, "invalid parameter times: not ordered ascending (times[%d] < times[%d])", i, i-1));
+   }
+
+   if (ec->bars <= 0) {
+      for (int i=0; i < size; i++) results[i] = EMPTY;
+      return(TRUE);
+   }
+
+   uint format = GetBarFormat();
+   if (!format) return(FALSE);
+
+   if (format == 400) BarShifts(BarView<HistoryBar400>(ec), times, size, results, exact);
+   else               BarShifts(BarView<HistoryBar401>(ec), times, size, results, exact);
+   return(TRUE);
+   #pragma EXPANDER_EXPORT
+}
+
+
+// a double field of a bar and its destination buffer
+struct RATES_COLUMN {
+   uint    offset;                                       // field offset in the bar struct
+   double* dest;                                         // destination buffer
+};
+
+
+/**
+ * Tick volume of a bar as a double.
+ */
+static inline double BarVolume(const HistoryBar400 &bar) { return(bar.ticks);                    }
+static inline double BarVolume(const HistoryBar401 &bar) { return((double)(int64)bar.tickVolume); }
+
+
+/**
+ * Copy bar fields into separate column buffers in a single pass over the bars. Double fields are copied 2 bars at a time
+ * using SSE2 strided loads (no gather needed), time and volume are converted per bar.
+ *
+ * @param  T*           rates     - bars ordered ascending by time
+ * @param  int          from      - first bar to copy
+ * @param  int          to        - last bar to copy + 1
+ * @param  RATES_COLUMN columns[] - double fields to copy
+ * @param  int          count     - number of double fields
+ * @param  time32*      times     - time buffer or NULL to skip
+ * @param  double*      volumes   - volume buffer or NULL to skip
+ */
+template <typename T>
+static void WINAPI CopyColumns(const T* rates, int from, int to, const RATES_COLUMN columns[], int count, time32* times, double* volumes) {
+   const BYTE* bar = (const BYTE*)(rates + from);
+   int i = from;
+
+   for (; i+1 < to; i += 2, bar += 2*sizeof(T)) {
+      for (int c=0; c < count; c++) {
+         const BYTE* src = bar + columns[c].offset;
+         __m128d v = _mm_load_sd((const double*)src);
+         v = _mm_loadh_pd(v, (const double*)(src + sizeof(T)));
+         _mm_storeu_pd(columns[c].dest + i, v);
+      }
+      if (times) {
+         times[i]   = rates[i].time;
+         times[i+1] = rates[i+1].time;
+      }
+      if (volumes) {
+         volumes[i]   = BarVolume(rates[i]);
+         volumes[i+1] = BarVolume(rates[i+1]);
+      }
+   }
+   if (i < to) {
+      for (int c=0; c < count; c++) {
+         columns[c].dest[i] = *(const double*)(bar + columns[c].offset);
+      }
+      if (times)   times[i]   = rates[i].time;
+      if (volumes) volumes[i] = BarVolume(rates[i]);
+   }
+}
+
+
+/**
+ * Copy the columns of a range of bars of EXECUTION_CONTEXT.rates into separate buffers. Buffers are indexed like the bars
+ * (index 0 = oldest bar). Pass NULL for columns not needed. The caller is responsible for valid parameters.
+ *
+ * @param  EXECUTION_CONTEXT* ec        - execution context of the program
+ * @param  int                from      - first bar to copy (index 0 = oldest bar), all bars up to the youngest one are copied
+ * @param  time32             times  [] - buffer receiving bar open times or NULL
+ * @param  double             open   [] - buffer receiving open prices or NULL
+ * @param  double             high   [] - buffer receiving high prices or NULL
+ * @param  double             low    [] - buffer receiving low prices or NULL
+ * @param  double             close  [] - buffer receiving close prices or NULL
+ * @param  double             volume [] - buffer receiving tick volumes or NULL
+ *
+ * @return BOOL - success status
+ */
+BOOL WINAPI CopyRatesColumns(const EXECUTION_CONTEXT* ec, int from, time32 times[], double open[], double high[], double low[], double close[], double volume[]) {
+   uint format = GetBarFormat();
+   if (!format) return(FALSE);
+
+   RATES_COLUMN columns[4];
+   int count = 0;
+   if (format == 400) {
+      if (open)  { columns[count].offset = offsetof(HistoryBar400, open);  columns[count++].dest = open;  }
+      if (high)  { columns[count].offset = offsetof(HistoryBar400, high);  columns[count++].dest = high;  }
+      if (low)   { columns[count].offset = offsetof(HistoryBar400, low);   columns[count++].dest = low;   }
+      if (close) { columns[count].offset = offsetof(HistoryBar400, close); columns[count++].dest = close; }
+      CopyColumns((const HistoryBar400*)ec->rates, from, ec->bars, columns, count, times, volume);
+   }
+   else {
+      if (open)  { columns[count].offset = offsetof(HistoryBar401, open);  columns[count++].dest = open;  }
+      if (high)  { columns[count].offset = offsetof(HistoryBar401, high);  columns[count++].dest = high;  }
+      if (low)   { columns[count].offset = offsetof(HistoryBar401, low);   columns[count++].dest = low;   }
+      if (close) { columns[count].offset = offsetof(HistoryBar401, close); columns[count++].dest = close; }
+      CopyColumns((const HistoryBar401*)ec->rates, from, ec->bars, columns, count, times, volume);
+   }
+   return(TRUE);
+}
+
+
+/**
+ * Extract the columns of the current price series of an MQL program (EXECUTION_CONTEXT.rates) into separate buffers. The
+ * buffers are filled in chronological order (index 0 = oldest bar), as the bars are stored in memory. With the youngest
+ * bar at the end, new bars don't shift existing values, so in incremental mode only the last 'changedBars' entries are
+ * refreshed. Pass NULL for columns not needed.
+ *
+ * If the terminal drops the oldest bar at the "max. bars in chart" limit, all bars shift by one although only the youngest
+ * bars changed. Incremental mode detects this by the bar open times stored in the times buffer by the previous call: if
+ * they don't match the current bars anymore, all bars are copied. Without a times buffer the shift can't be detected and
+ * all bars are always copied.
+ *
+ * @param  EXECUTION_CONTEXT* ec          - execution context of the program
+ * @param  int                size        - size of each of the passed buffers (must be at least ec.bars)
+ * @param  time32             times  []   - buffer receiving bar open times or NULL
+ * @param  double             open   []   - buffer receiving open prices or NULL
+ * @param  double             high   []   - buffer receiving high prices or NULL
+ * @param  double             low    []   - buffer receiving low prices or NULL
+ * @param  double             close  []   - buffer receiving close prices or NULL
+ * @param  double             volume []   - buffer receiving tick volumes or NULL
+ * @param  BOOL               incremental - whether to refresh only the bars changed since the last tick (ec.changedBars);
+ *                                          falls back to a full copy if all bars changed or the bars shifted
+ *
+ * @return int - index of the first refreshed bar or EMPTY (-1) in case of errors
+ */
+int WINAPI Rates_CopyColumns(const EXECUTION_CONTEXT* ec, int size, time32 times[], double open[], double high[], double low[], double close[], double volume[], BOOL incremental) {
+   if ((uint)ec < MIN_VALID_POINTER)        return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter ec: 0x%p (not a valid pointer)", ec)));
+   if ((uint)ec->rates < MIN_VALID_POINTER) return(_EMPTY(error(ERR_ILLEGAL_STATE, "invalid ec.rates: 0x%p (not a valid pointer)", ec->rates)));
+   if (size < ec->bars)                     return(_EMPTY(error(ERR_INVALID_PARAMETER, "invalid parameter size: %d (must be >= ec.bars=%d)", size, ec->bars)));
+
+   uint format = GetBarFormat();
+   if (!format) return(EMPTY);
+
+   int bars = ec->bars, from = 0;
+   if (incremental && times && ec->changedBars >= 0) {
+      from = max(0, bars - ec->changedBars);
+      if (from > 0) {
+         // the unchanged bars must still be at the positions of the previous copy
+         time32 first = (format==400) ? ((const HistoryBar400*)ec->rates)[0].time      : ((const HistoryBar401*)ec->rates)[0].time;
+         time32 last  = (format==400) ? ((const HistoryBar400*)ec->rates)[from-1].time : ((const HistoryBar401*)ec->rates)[from-1].time;
+         if (times[0] != first || times[from-1] != last) from = 0;
+      }
+   }
+
+   if (!CopyRatesColumns(ec, from, times, open, high, low, close, volume)) return(EMPTY);
+   return(from);
+   #pragma EXPANDER_EXPORT
+}
@@ -1,8 +1,11 @@
 #include "expander.h"
+#include "lib/binarylog.h"
 #include "lib/conversion.h"
 #include "lib/datetime.h"
 #include "lib/helper.h"
 #include "lib/log.h"
+#include "lib/logbuffer.h"
+#include "lib/logwriter.h"
 #include "lib/memory.h"
 #include "lib/string.h"
 #include "struct/ExecutionContext.h"
@@ -1508,7 +1511,10 @@ int WINAPI ec_SetLoglevel(EXECUTION_CONTEXT* ec, int level) {
          if (!level || level==LOG_OFF) {
             EXECUTION_CONTEXT* master = chain[0];
             if (master && master->logger && master->logger->is_open()) {
+               LogWriter_Lock();
                master->logger->close();               // close an open logfile if logging was disabled
+               BinaryLog_Close(master->logger);
+               LogWriter_Unlock();
             }
          }
          return(level);
@@ -1646,7 +1652,10 @@ int WINAPI ec_SetLoglevelFile(EXECUTION_CONTEXT* ec, int level) {
          if (!level || level==LOG_OFF) {
             EXECUTION_CONTEXT* master = chain[0];
             if (master && master->logger && master->logger->is_open()) {
+               LogWriter_Lock();
                master->logger->close();               // close an open logfile if the logfile appender was disabled
+               BinaryLog_Close(master->logger);
+               LogWriter_Unlock();
             }
          }
          return(level);
@@ -1851,7 +1860,7 @@ char* WINAPI EXECUTION_CONTEXT_toStr(const EXECUTION_CONTEXT* ec) {
          << ", loglevelMail="         << LoglevelDescriptionA(ec->loglevelMail)
          << ", loglevelTelegram="     << LoglevelDescriptionA(ec->loglevelTelegram)
          << ", logger="               <<                     (ec->logger    ? asformat("0x%p", ec->logger) : "0")
-         << ", logBufferSize="        <<                     (ec->logBuffer ? ec->logBuffer->size() : 0)
+         << ", logBufferSize="        <<                     LogBuffer_Size(ec->logBuffer)
          << ", logFilename="          <<       DoubleQuoteStr(ec->logFilename)
          << "}";
    }
@@ -0,0 +1,688 @@
+/**
+ * MT4 struct FXT_HEADER (header of the tick files in "<terminal-data-dir>/tester/history/")
+ */
+#include "expander.h"
+#include "struct/mt4/FxtHeader.h"
+
+
+/**
+ * Return the header version of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - header version
+ */
+uint WINAPI fxt_Version(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->version);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the description of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return char* - description
+ */
+const char* WINAPI fxt_Description(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return((char*)!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->description);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the account server name of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return char* - account server name
+ */
+const char* WINAPI fxt_ServerName(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return((char*)!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->serverName);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the symbol of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return char* - symbol
+ */
+const char* WINAPI fxt_Symbol(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return((char*)!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->symbol);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the timeframe in minutes of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - timeframe in minutes
+ */
+uint WINAPI fxt_Period(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->period);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Alias of fxt_Period().
+ */
+uint WINAPI fxt_Timeframe(const FXT_HEADER* fxt) {
+   return(fxt_Period(fxt));
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the bar model of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - bar model: MODE_EVERYTICK | MODE_CONTROLPOINTS | MODE_BAROPEN
+ */
+uint WINAPI fxt_ModelType(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->modelType);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of modeled bars of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - number of modeled bars (without prolog)
+ */
+uint WINAPI fxt_ModeledBars(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->modeledBars);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the open time of the first modeled bar of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return time32 - open time of the first modeled bar
+ */
+time32 WINAPI fxt_FirstBarTime(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->firstBarTime);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the open time of the last modeled bar of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return time32 - open time of the last modeled bar
+ */
+time32 WINAPI fxt_LastBarTime(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->lastBarTime);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the model quality in percent of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - model quality in percent
+ */
+double WINAPI fxt_ModelQuality(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->modelQuality);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the base currency of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return char* - base currency
+ */
+const char* WINAPI fxt_BaseCurrency(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return((char*)!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->baseCurrency);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the spread in points of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - spread in points (0: current spread)
+ */
+uint WINAPI fxt_Spread(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->spread);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the digits of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - digits
+ */
+uint WINAPI fxt_Digits(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->digits);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the point size of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - point size
+ */
+double WINAPI fxt_PointSize(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->pointSize);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the min. lotsize in hundredths of a lot of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - min. lotsize in hundredths of a lot
+ */
+uint WINAPI fxt_MinLotsize(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->minLotsize);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the max. lotsize in hundredths of a lot of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - max. lotsize in hundredths of a lot
+ */
+uint WINAPI fxt_MaxLotsize(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->maxLotsize);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the lot stepsize in hundredths of a lot of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - lot stepsize in hundredths of a lot
+ */
+uint WINAPI fxt_LotStepsize(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->lotStepsize);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the stop level in points of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - stop level in points
+ */
+uint WINAPI fxt_StopDistance(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->stopDistance);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the whether pending orders are good-till-cancelled of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return BOOL - whether pending orders are good-till-cancelled
+ */
+BOOL WINAPI fxt_PendingsGTC(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->pendingsGTC);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the contract size of a lot of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - contract size of a lot
+ */
+double WINAPI fxt_ContractSize(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->contractSize);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the tick value of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - tick value
+ */
+double WINAPI fxt_TickValue(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->tickValue);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the tick size of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - tick size
+ */
+double WINAPI fxt_TickSize(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->tickSize);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the profit calculation mode of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - profit calculation mode: 0=Forex|1=CFD|2=Futures
+ */
+uint WINAPI fxt_ProfitCalculationMode(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->profitCalculationMode);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the whether swaps are calculated of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return BOOL - whether swaps are calculated
+ */
+BOOL WINAPI fxt_SwapEnabled(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->swapEnabled);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the swap type of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - swap type: 0=Points|1=BaseCurrency|2=Interest|3=MarginCurrency
+ */
+uint WINAPI fxt_SwapType(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->swapType);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the long swap value of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - long swap value
+ */
+double WINAPI fxt_SwapLongValue(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->swapLongValue);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the short swap value of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - short swap value
+ */
+double WINAPI fxt_SwapShortValue(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->swapShortValue);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the weekday of triple swaps of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - weekday of triple swaps
+ */
+uint WINAPI fxt_SwapTripleRolloverDay(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->swapTripleRolloverDay);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the account leverage of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - account leverage
+ */
+uint WINAPI fxt_AccountLeverage(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->accountLeverage);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the free margin calculation type of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - free margin calculation type
+ */
+uint WINAPI fxt_FreeMarginCalculationType(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->freeMarginCalculationType);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the margin calculation mode of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - margin calculation mode
+ */
+uint WINAPI fxt_MarginCalculationMode(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginCalculationMode);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the margin stopout level of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - margin stopout level
+ */
+uint WINAPI fxt_MarginStopoutLevel(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginStopoutLevel);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the margin stopout type of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - margin stopout type
+ */
+uint WINAPI fxt_MarginStopoutType(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginStopoutType);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the initial margin requirement of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - initial margin requirement
+ */
+double WINAPI fxt_MarginInit(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginInit);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the maintenance margin requirement of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - maintenance margin requirement
+ */
+double WINAPI fxt_MarginMaintenance(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginMaintenance);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the hedged margin requirement of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - hedged margin requirement
+ */
+double WINAPI fxt_MarginHedged(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginHedged);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the margin divider of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - margin divider (leverage)
+ */
+double WINAPI fxt_MarginDivider(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginDivider);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the margin currency of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return char* - margin currency
+ */
+const char* WINAPI fxt_MarginCurrency(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return((char*)!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->marginCurrency);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the commission rate of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return double - commission rate
+ */
+double WINAPI fxt_CommissionValue(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->commissionValue);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the commission calculation mode of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - commission calculation mode: COMM_TYPE_*
+ */
+uint WINAPI fxt_CommissionCalculationMode(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->commissionCalculationMode);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the commission type of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - commission type: COMMISSION_PER_*
+ */
+uint WINAPI fxt_CommissionType(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->commissionType);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of the first modeled bar of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - number of the first modeled bar (number of prolog bars)
+ */
+uint WINAPI fxt_FirstBar(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->firstBar);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of the last modeled bar of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - number of the last modeled bar
+ */
+uint WINAPI fxt_LastBar(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->lastBar);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the start date of the tester settings of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return time32 - start date of the tester settings
+ */
+time32 WINAPI fxt_TesterSettingFrom(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->testerSettingFrom);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the end date of the tester settings of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return time32 - end date of the tester settings
+ */
+time32 WINAPI fxt_TesterSettingTo(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->testerSettingTo);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the freeze level in points of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - freeze level in points
+ */
+uint WINAPI fxt_FreezeDistance(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->freezeDistance);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return the number of errors during model generation of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ *
+ * @return uint - number of errors during model generation
+ */
+uint WINAPI fxt_ModelErrors(const FXT_HEADER* fxt) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   return(fxt->modelErrors);
+   #pragma EXPANDER_EXPORT
+}
+
+
+/**
+ * Return an element of the start period array of an FXT_HEADER.
+ *
+ * @param  FXT_HEADER* fxt
+ * @param  int         index - array index (0...5), element 0 holds the first modeled bar
+ *
+ * @return uint - bar number where modeling with the smaller period started
+ */
+uint WINAPI fxt_StartPeriod(const FXT_HEADER* fxt, int index) {
+   if ((uint)fxt < MIN_VALID_POINTER) return(!error(ERR_INVALID_PARAMETER, "invalid parameter fxt: 0x%p (not a valid pointer)", fxt));
+   if (index < 0 || index > 5)        return(!error(ERR_INVALID_PARAMETER, "invalid parameter index: %d (must be 0...5)", index));
+   return(fxt->startPeriod[index]);
+   #pragma EXPANDER_EXPORT
+}
@@ -6,7 +6,9 @@
 #include "expander.h"
 #include "struct/mt4/Symbol.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 
 /**
@@ -618,6 +620,19 @@ int __cdecl CompareSymbols(const void* a, const void* b) {
 }
 
 
+/**
+ * Comparator for sorting the indexes of a SYMBOL array by symbol name.
+ */
+struct SymbolIndexComparator {
+   const SYMBOL* symbols;
+   SymbolIndexComparator(const SYMBOL* symbols) : symbols(symbols) {}
+
+   bool operator() (int a, int b) const {
+      return(strcmp(symbols[a].name, symbols[b].name) < 0);
+   }
+};
+
+
 /**
  * Sort a SYMBOL array by name.
  *
@@ -632,7 +647,27 @@ BOOL WINAPI SortSymbols(SYMBOL symbols[], int size) {
    if (size == 1)                            // nothing to do
       return(TRUE);
 
-   qsort(symbols, size, sizeof(SYMBOL), CompareSymbols);
+   // Sort an index array instead of the 1936 byte records and move each record only once when applying the permutation.
+   std::vector<int> order(size);
+   for (int i=0; i < size; i++) {
+      order[i] = i;
+   }
+   std::stable_sort(order.begin(), order.end(), SymbolIndexComparator(symbols));
+
+   SYMBOL tmp;                               // apply the permutation by following its cycles
+   for (int i=0; i < size; i++) {
+      if (order[i] == i) continue;
+      tmp = symbols[i];
+      int dest = i;
+      while (order[dest] != i) {
+         int src = order[dest];
+         symbols[dest] = symbols[src];
+         order[dest] = dest;
+         dest = src;
+      }
+      symbols[dest] = tmp;
+      order[dest] = dest;
+   }
 
    for (int i=0; i < size; i++) {            // assign new array indexes
       symbols[i].index = i;
@@ -0,0 +1,201 @@
+/**
+ * Tests of the bar aggregator (src/lib/aggregator.cpp): bar boundaries of intraday, weekly, monthly and quarterly bars,
+ * session offsets and weekend handling.
+ */
+#include "expander.h"
+#include "lib/aggregator.h"
+#include "lib/history.h"
+#include "test.h"
+
+#include <vector>
+
+using std::vector;
+
+
+/**
+ * Return the Unix timestamp of a GMT date and time.
+ */
+static time32 T(int year, int month, int day, int hour = 0, int minute = 0) {
+   tm t = {};
+   t.tm_year = year - 1900;
+   t.tm_mon  = month - 1;
+   t.tm_mday = day;
+   t.tm_hour = hour;
+   t.tm_min  = minute;
+   return((time32)timegm(&t));
+}
+
+
+/**
+ * Release an aggregator and return the bars written to a history file.
+ */
+static vector<HistoryBar401> ReleaseAndRead(uint hAggregator, const string &filename) {
+   CHECK(Aggregator_Release(hAggregator));
+   vector<HistoryBar401> bars;
+   uint hFile = HistoryFile_Open(filename.c_str());
+   BarSpan<HistoryBar401> span;
+   if (hFile && GetHistoryBars(hFile, span)) bars.assign(span.bars, span.bars + span.size);
+   HistoryFile_Close(hFile);
+   DeleteFileA(filename.c_str());
+   return(bars);
+}
+
+
+static string HstFile(uint timeframe, const char* source) {
+   string name = "EURUSD" + TestValue(timeframe) + "-" + source + ".hst";
+   return(TempFilename(name.c_str()));
+}
+
+
+TEST(BarOpenTime_IntradayBarsStartAtTheSession) {
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 13,37), PERIOD_H1), T(2020,1,15, 13,0));
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 13,37), PERIOD_H4), T(2020,1,15, 12,0));
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 23,58), 7),         T(2020,1,15, 23,55));   // M7 restarts at each session start
+   CHECK_EQ(BarOpenTime(T(2020,1,16,  0, 3), 7),         T(2020,1,16,  0,0));
+
+   int session = -7*HOURS;                                     // sessions start at 17:00 of the previous day
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 18,30), PERIOD_D1, session), T(2020,1,15, 17,0));
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 16,59), PERIOD_D1, session), T(2020,1,14, 17,0));
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 22,00), PERIOD_H4, session), T(2020,1,15, 21,0));
+
+   uint hAggregator = Aggregator_Create("EURUSD", 5);         // a forming M7 bar is closed at the session end
+   CHECK(Aggregator_AddTimeframe(hAggregator, 7));
+   CHECK(Aggregator_AddTick(hAggregator, T(2020,1,15, 23,58), 1.1));
+   CHECK(Aggregator_AddTick(hAggregator, T(2020,1,16,  0, 1), 1.2));
+   const HistoryBar401* bar = Aggregator_CurrentBar(hAggregator, 7);
+   CHECK(bar && bar->time==T(2020,1,16) && bar->open==1.2);
+   CHECK(Aggregator_Release(hAggregator));
+}
+
+
+TEST(BarOpenTime_WeeksMonthsAndQuarters) {
+   CHECK_EQ(BarOpenTime(T(2020,1,15, 10,0), PERIOD_W1),  T(2020,1,12));            // Wednesday: the week starts on Sunday
+   CHECK_EQ(BarOpenTime(T(2020,1,12,  0,0), PERIOD_W1),  T(2020,1,12));
+   CHECK_EQ(BarOpenTime(T(2020,1,11, 23,59), PERIOD_W1), T(2020,1,5));
+   CHECK_EQ(BarOpenTime(T(2020,2,29, 12,0), PERIOD_MN1), T(2020,2,1));             // leap day
+   CHECK_EQ(BarOpenTime(T(2020,3, 1,  0,0), PERIOD_MN1), T(2020,3,1));
+   CHECK_EQ(BarOpenTime(T(2020,5,15, 12,0), PERIOD_Q1),  T(2020,4,1));
+   CHECK_EQ(BarOpenTime(T(2020,12,31, 23,59), PERIOD_Q1), T(2020,10,1));
+
+   int session = -7*HOURS;
+   CHECK_EQ(BarOpenTime(T(2020,3,31, 18,0), PERIOD_MN1, session), T(2020,3,31, 17,0));   // already in the April session
+   CHECK_EQ(BarOpenTime(T(2020,3,31, 16,0), PERIOD_Q1,  session), T(2019,12,31, 17,0));
+
+   CHECK_EQ(BarOpenTime(T(2020,1,12, 10,0), PERIOD_D1, 0, AGGREGATOR_MERGE_SUNDAY), T(2020,1,13));
+   CHECK_EQ(BarOpenTime(T(2020,1,11, 10,0), PERIOD_D1, 0, AGGREGATOR_MERGE_SUNDAY), T(2020,1,11));
+}
+
+
+TEST(Aggregator_SkipsOrMergesTheWeekend) {
+   time32 times[]  = { T(2020,1,10, 23,59), T(2020,1,11, 10,0), T(2020,1,12, 22,0), T(2020,1,13, 0,1) };   // Fri, Sat, Sun, Mon
+   double prices[] = { 1.1, 1.2, 1.3, 1.4 };
+
+   string filename = TempFilename("EURUSD1440-skip.hst");
+   uint hAggregator = Aggregator_Create("EURUSD", 5, AGGREGATOR_SKIP_WEEKEND);
+   CHECK(Aggregator_AddTimeframe(hAggregator, PERIOD_D1, filename.c_str()));
+   for (int i=0; i < 4; i++) CHECK(Aggregator_AddTick(hAggregator, times[i], prices[i]));
+   vector<HistoryBar401> bars = ReleaseAndRead(hAggregator, filename);
+   CHECK_EQ(bars.size(), 2u);
+   if (bars.size() == 2) {
+      CHECK_EQ(bars[0].time, T(2020,1,10));
+      CHECK_EQ(bars[1].time, T(2020,1,13));
+      CHECK_EQ(bars[1].open, 1.4);
+      CHECK_EQ(bars[1].tickVolume, 1u);
+   }
+
+   filename = TempFilename("EURUSD1440-merge.hst");
+   hAggregator = Aggregator_Create("EURUSD", 5, AGGREGATOR_MERGE_SUNDAY);
+   CHECK(Aggregator_AddTimeframe(hAggregator, PERIOD_D1, filename.c_str()));
+   for (int i=0; i < 4; i++) CHECK(Aggregator_AddTick(hAggregator, times[i], prices[i]));
+   bars = ReleaseAndRead(hAggregator, filename);
+   CHECK_EQ(bars.size(), 3u);
+   if (bars.size() == 3) {
+      CHECK_EQ(bars[1].time, T(2020,1,11));                    // Saturday stays, Sunday opens the Monday bar
+      CHECK_EQ(bars[2].time, T(2020,1,13));
+      CHECK_EQ(bars[2].open, 1.3);
+      CHECK_EQ(bars[2].close, 1.4);
+      CHECK_EQ(bars[2].tickVolume, 2u);
+   }
+}
+
+
+TEST(Aggregator_MonthAndQuarterBoundaries) {
+   string mn1File = TempFilename("EURUSD43200.hst"), q1File = TempFilename("EURUSD129600.hst");
+   uint hAggregator = Aggregator_Create("EURUSD", 5);
+   CHECK(Aggregator_AddTimeframe(hAggregator, PERIOD_MN1, mn1File.c_str()));
+   CHECK(Aggregator_AddTimeframe(hAggregator, PERIOD_Q1,  q1File.c_str()));
+
+   vector<HistoryBar401> m1(5);                                // 2020-03-31 23:58 .. 2020-04-01 00:02
+   for (int i=0; i < 5; i++) {
+      m1[i].time = T(2020,3,31, 23,58) + i*MINUTES;
+      m1[i].open = m1[i].high = m1[i].low = m1[i].close = 1 + i/10.;
+      m1[i].tickVolume = 10;
+   }
+   CHECK_EQ(Aggregator_AddBars(hAggregator, &m1[0], 5), 5);
+   CHECK(Aggregator_Release(hAggregator));
+
+   for (int n=0; n < 2; n++) {
+      string filename = n ? q1File : mn1File;
+      uint hFile = HistoryFile_Open(filename.c_str());
+      BarSpan<HistoryBar401> bars;
+      CHECK(GetHistoryBars(hFile, bars));
+      CHECK_EQ(bars.size, 2u);
+      if (bars.size == 2) {
+         CHECK_EQ(bars[0].time, n ? T(2020,1,1) : T(2020,3,1));
+         CHECK_EQ(bars[0].close, 1.1);
+         CHECK_EQ(bars[0].tickVolume, 20u);
+         CHECK_EQ(bars[1].time, T(2020,4,1));
+         CHECK_EQ(bars[1].open, 1.2);
+         CHECK_EQ(bars[1].high, 1.4);
+         CHECK_EQ(bars[1].tickVolume, 30u);
+      }
+      HistoryFile_Close(hFile);
+   }
+}
+
+
+TEST(Aggregator_M1BarsEqualTicks) {
+   vector<TICK> ticks(20000);
+   unsigned seed = 4711;
+   double price = 1.1;
+   time32 time = T(2020,3,27, 20,0);                           // a Friday evening, through the weekend to a new month
+   for (size_t i=0; i < ticks.size(); i++) {
+      seed = seed*1103515245 + 12345;
+      time  += 1 + (seed >> 16) % 40;
+      price += ((int)(seed >> 8 & 0xff) - 127) / 1e6;
+      memset(&ticks[i], 0, sizeof(TICK));
+      strcpy(ticks[i].symbol, "EURUSD");
+      ticks[i].time = time;
+      ticks[i].bid  = ticks[i].ask = price;
+   }
+   uint timeframes[] = { PERIOD_M5, PERIOD_H4, PERIOD_D1, PERIOD_W1, PERIOD_MN1 };
+
+   // ticks to M1 and all timeframes in one pass
+   uint hTicks = Aggregator_Create("EURUSD", 5, AGGREGATOR_MERGE_SUNDAY, -7*HOURS);
+   CHECK(Aggregator_AddTimeframe(hTicks, PERIOD_M1, TempFilename("EURUSD1.hst").c_str()));
+   for (int i=0; i < 5; i++) CHECK(Aggregator_AddTimeframe(hTicks, timeframes[i], HstFile(timeframes[i], "ticks").c_str()));
+   CHECK_EQ(Aggregator_AddTicks(hTicks, &ticks[0], ticks.size()), (int)ticks.size());
+   CHECK(Aggregator_Release(hTicks));
+
+   // the M1 bars to all timeframes
+   uint hFile = HistoryFile_Open(TempFilename("EURUSD1.hst").c_str());
+   BarSpan<HistoryBar401> m1;
+   CHECK(GetHistoryBars(hFile, m1));
+   uint hBars = Aggregator_Create("EURUSD", 5, AGGREGATOR_MERGE_SUNDAY, -7*HOURS);
+   for (int i=0; i < 5; i++) CHECK(Aggregator_AddTimeframe(hBars, timeframes[i], HstFile(timeframes[i], "bars").c_str()));
+   CHECK_EQ(Aggregator_AddBars(hBars, m1.bars, m1.size), (int)m1.size);
+   CHECK(Aggregator_Release(hBars));
+   HistoryFile_Close(hFile);
+
+   for (int i=0; i < 5; i++) {
+      uint hFromTicks = HistoryFile_Open(HstFile(timeframes[i], "ticks").c_str());
+      uint hFromBars  = HistoryFile_Open(HstFile(timeframes[i], "bars").c_str());
+      BarSpan<HistoryBar401> a, b;
+      CHECK(GetHistoryBars(hFromTicks, a) && GetHistoryBars(hFromBars, b));
+      CHECK_EQ(a.size, b.size);
+      CHECK(a.size > 1);
+      CHECK(a.size == b.size && !memcmp(a.bars, b.bars, a.size * sizeof(HistoryBar401)));
+      HistoryFile_Close(hFromTicks);
+      HistoryFile_Close(hFromBars);
+   }
+}
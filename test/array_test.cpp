@@ -0,0 +1,221 @@
+/**
+ * Tests of the array functions (src/lib/array.cpp).
+ */
+#include "expander.h"
+#include "lib/array.h"
+#include "test.h"
+
+#include <algorithm>
+#include <vector>
+
+
+// scalar baseline of SearchIntArray()
+static int ScalarSearch(const int array[], int size, int value) {
+   for (int i=0; i < size; i++) {
+      if (array[i] == value) return(i);
+   }
+   return(EMPTY);
+}
+
+
+TEST(FillArray_AllAlignmentsAndSizes) {
+   std::vector<double> values(300);
+   for (int offset=0; offset < 4; offset++) {
+      for (int count=0; count < 200; count += 7) {
+         values.assign(values.size(), 0.);
+         FillArray(&values[offset], count, 1.5);
+         for (int i=0; i < (int)values.size(); i++) {
+            bool inRange = (i >= offset && i < offset+count);
+            if (values[i] != (inRange ? 1.5 : 0.)) { CHECK_EQ(values[i], inRange ? 1.5 : 0.); return; }
+         }
+      }
+   }
+   std::vector<int> ints(1<<19, 0);                            // 2 MB: the non-temporal path
+   FillArray(&ints[1], (int)ints.size()-2, 7);
+   CHECK_EQ(ints[0], 0);
+   CHECK_EQ(ints[1], 7);
+   CHECK_EQ(ints[ints.size()-2], 7);
+   CHECK_EQ(ints[ints.size()-1], 0);
+}
+
+
+TEST(SearchIntArray_MatchesScalarSearch) {
+   std::vector<int> values(1003);
+   for (int i=0; i < (int)values.size(); i++) values[i] = (i*7919) % 500;  // every value occurs at least twice
+
+   for (int size=0; size <= 9; size++) {                       // all tail lengths of the SSE2 scan
+      for (int value=-1; value < 10; value++) {
+         int expected = ScalarSearch(&values[0], size, values[value < 0 ? 0 : value]);
+         CHECK_EQ(SearchIntArray(&values[0], size, values[value < 0 ? 0 : value]), expected);
+      }
+   }
+   int size = values.size();
+   for (int value=-1; value <= 500; value++) {
+      int first = ScalarSearch(&values[0], size, value);
+      CHECK_EQ(SearchIntArray(&values[0], size, value), first);
+
+      int last = EMPTY;                                        // the last match, reported as timeseries index
+      for (int i=size-1; i >= 0; i--) if (values[i] == value) { last = size-1-i; break; }
+      CHECK_EQ(SearchIntArray(&values[0], size, value, TRUE), last);
+   }
+   CHECK_EQ(SearchIntArray(NULL, 10, 1), -2);
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+}
+
+
+TEST(SearchSortedArrays_FindFirstAndLastMatch) {
+   int ints[] = { 1, 3, 3, 3, 7, 9 };
+   CHECK_EQ(SearchSortedIntArray(ints, 6, 3), 1);
+   CHECK_EQ(SearchSortedIntArray(ints, 6, 3, TRUE), 2);       // memory index 3 as timeseries index
+   CHECK_EQ(SearchSortedIntArray(ints, 6, 4), EMPTY);
+   CHECK_EQ(SearchSortedIntArray(ints, 6, 10), EMPTY);
+   CHECK_EQ(SearchSortedIntArray(ints, 0, 1), EMPTY);
+
+   double doubles[] = { -1.5, 0, 0.1, 0.1, 2 };
+   CHECK_EQ(SearchSortedDoubleArray(doubles, 5, 0.1), 2);
+   CHECK_EQ(SearchSortedDoubleArray(doubles, 5, 0.1, TRUE), 1);
+   CHECK_EQ(SearchDoubleArray(doubles, 5, 2.), 4);
+   CHECK_EQ(SearchDoubleArray(doubles, 5, 0.1, TRUE), 1);
+   CHECK_EQ(SearchDoubleArray(doubles, 4, 2.), EMPTY);
+}
+
+
+TEST(SearchStringArray_SkipsNullElements) {
+   char a[] = "a", b1[] = "b", b2[] = "b", c[] = "c";
+   MqlStringA sorted[] = { {0, NULL}, {0, a}, {0, b1}, {0, b2}, {0, c} };
+   CHECK_EQ(SearchStringArrayA(sorted, 5, "b", TRUE), 2);
+   CHECK_EQ(SearchStringArrayA(sorted, 5, "b", TRUE, TRUE), 1);
+   CHECK_EQ(SearchStringArrayA(sorted, 5, "", TRUE), EMPTY);
+   CHECK_EQ(SearchStringArrayA(sorted, 5, "d", TRUE), EMPTY);
+
+   MqlStringA trailing[] = { {0, a}, {0, b1}, {0, NULL} };    // NULL elements after a match (not sorted by SortMqlStringsA())
+   CHECK_EQ(SearchStringArrayA(trailing, 3, "b", TRUE, TRUE), 1);
+   CHECK_EQ(SearchStringArrayA(trailing, 3, "c", TRUE), EMPTY);
+
+   MqlStringA unsorted[] = { {0, c}, {0, NULL}, {0, a} };
+   CHECK_EQ(SearchStringArrayA(unsorted, 3, "a"), 2);
+   CHECK_EQ(SearchStringArrayA(unsorted, 3, "a", FALSE, TRUE), 0);
+
+   wchar wb[] = L"b";
+   MqlStringW wide[] = { {0, NULL, 0}, {0, wb, 0}, {0, NULL, 0} };
+   CHECK_EQ(SearchStringArrayW(wide, 3, L"b", TRUE, TRUE), 1);
+   CHECK_EQ(SearchStringArrayW(wide, 3, L"b"), 1);
+}
+
+
+TEST(SearchIntArrayKeys_MatchesSingleSearches) {
+   std::vector<int> tickets(1000);
+   for (int i=0; i < 1000; i++) tickets[i] = 100000 + (i*37) % 1000;
+   int keys[] = { 100005, 99999, 100999, 100005, 100000 };
+   int results[5];
+   CHECK_EQ(SearchIntArrayKeys(&tickets[0], 1000, keys, 5, results), 4);
+   for (int k=0; k < 5; k++) CHECK_EQ(results[k], SearchIntArray(&tickets[0], 1000, keys[k]));
+
+   CHECK_EQ(SearchIntArrayKeys(&tickets[0], 1000, keys, 5, results, TRUE), 4);
+   for (int k=0; k < 5; k++) CHECK_EQ(results[k], SearchIntArray(&tickets[0], 1000, keys[k], TRUE));
+}
+
+
+TEST(RingBuffer_MatchesShiftIndicatorBuffer) {
+   EXECUTION_CONTEXT ec = {};
+   ec.pid = 1;
+   const int size = 50;
+   uint hBuffer = RingBuffer_Create(&ec, size, EMPTY_VALUE);
+   CHECK(hBuffer != 0);
+
+   std::vector<double> expected(size, EMPTY_VALUE), actual(size);
+   int shifts[] = { 0, 1, 3, 49, 1, 50, 7, 120, 2 };
+   for (int n=0; n < 9; n++) {
+      CHECK(RingBuffer_Shift(hBuffer, shifts[n]));
+      CHECK(ShiftIndicatorBuffer(&expected[0], size, min(shifts[n], size), (double)EMPTY_VALUE));
+      for (int bar=0; bar < 5; bar++) {
+         double value = n*10 + bar;
+         CHECK(RingBuffer_Set(hBuffer, bar, value));
+         expected[size-1-bar] = value;                         // MQL buffers are reverse-indexed in memory
+      }
+      CHECK(RingBuffer_CopyTo(hBuffer, &actual[0], size));
+      CHECK(actual == expected);
+      CHECK_EQ(RingBuffer_Get(hBuffer, 3), expected[size-4]);
+   }
+   CHECK(RingBuffer_Release(hBuffer));
+}
+
+
+TEST(RingBuffer_ReleasedWithProgram) {
+   EXECUTION_CONTEXT ec1 = {}, ec2 = {};
+   ec1.pid = 11;
+   ec2.pid = 12;
+   uint h1 = RingBuffer_Create(&ec1, 10, 0);
+   uint h2 = RingBuffer_Create(&ec2, 10, 0);
+   uint h3 = RingBuffer_Create(&ec1, 10, 0);
+   CHECK(h1 && h2 && h3);
+
+   ReleaseRingBuffers(ec1.pid);                                // the program's final deinit
+   CHECK_EQ(RingBuffer_Get(h1, 0), EMPTY_VALUE);
+   CHECK_EQ(LastExpanderError(), ERR_ILLEGAL_STATE);
+   CHECK(!RingBuffer_Release(h3));
+   CHECK_EQ(RingBuffer_Get(h2, 0), 0.);                        // other programs keep their buffers
+   CHECK(RingBuffer_Release(h2));
+   CHECK(!RingBuffer_Release(h2));
+
+   CHECK(!RingBuffer_Create(&ec1, 0, 0));
+   ec1.pid = 0;
+   CHECK(!RingBuffer_Create(&ec1, 10, 0));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+}
+
+
+BENCHMARK(RingBuffer_ShiftVsShiftIndicatorBuffer) {
+   const int size = 100000, bars = 10000;
+   EXECUTION_CONTEXT ec = {};
+   ec.pid = 1;
+   uint hBuffer = RingBuffer_Create(&ec, size, EMPTY_VALUE);
+   std::vector<double> buffer(size, EMPTY_VALUE);
+
+   double start = MilliSeconds();
+   for (int i=0; i < bars; i++) {
+      ShiftIndicatorBuffer(&buffer[0], size, 1, (double)EMPTY_VALUE);
+      buffer[size-1] = i;
+   }
+   double shiftTime = MilliSeconds() - start;
+
+   start = MilliSeconds();
+   for (int i=0; i < bars; i++) {
+      RingBuffer_Shift(hBuffer, 1);
+      RingBuffer_Set(hBuffer, 0, i);
+   }
+   RingBuffer_CopyTo(hBuffer, &buffer[0], size);               // materialized once per tick
+   double ringTime = MilliSeconds() - start;
+   RingBuffer_Release(hBuffer);
+
+   printf("\n    %d shifts of %d elements: ShiftIndicatorBuffer %.1f ms, RingBuffer %.1f ms\n", bars, size, shiftTime, ringTime);
+}
+
+
+BENCHMARK(SearchIntArray_VsScalarSearch) {
+   const int size = 10000, searches = 20000;
+   std::vector<int> values(size);
+   for (int i=0; i < size; i++) values[i] = i*3;
+
+   int found = 0;
+   double start = MilliSeconds();
+   for (int n=0; n < searches; n++) found += ScalarSearch(&values[0], size, (n*7) % (size*3)) != EMPTY;
+   double scalarTime = MilliSeconds() - start;
+
+   start = MilliSeconds();
+   for (int n=0; n < searches; n++) found -= SearchIntArray(&values[0], size, (n*7) % (size*3)) != EMPTY;
+   double sse2Time = MilliSeconds() - start;
+
+   std::vector<int> keys(searches), results(searches);
+   for (int n=0; n < searches; n++) keys[n] = (n*7) % (size*3);
+   start = MilliSeconds();
+   SearchIntArrayKeys(&values[0], size, &keys[0], searches, &results[0]);
+   double keysTime = MilliSeconds() - start;
+
+   start = MilliSeconds();
+   for (int n=0; n < searches; n++) found += SearchSortedIntArray(&values[0], size, keys[n]) != EMPTY;
+   double sortedTime = MilliSeconds() - start;
+
+   CHECK(found >= 0);
+   printf("\n    %d searches in %d ints: scalar %.1f ms, SSE2 %.1f ms, keys %.1f ms, sorted %.1f ms\n", searches, size, scalarTime, sse2Time, keysTime, sortedTime);
+}
@@ -0,0 +1,81 @@
+/**
+ * Tests of the binary logfile format (src/lib/binarylog.cpp) and its decoder (tools/blogdump).
+ */
+#include "expander.h"
+#include "lib/binarylog.h"
+#include "test.h"
+
+#include <fstream>
+#include <sys/wait.h>
+
+
+/**
+ * Compose and encode a log message like AppendLogMessageA() and the log writer do.
+ */
+static void WriteMessage(std::ofstream* logger, int time, WORD milliseconds, const char* level, const char* path, const char* errorDescr, const char* message) {
+   BLOG_MESSAGE header = {};
+   header.time         = time;
+   header.milliseconds = milliseconds;
+   header.error        = *errorDescr ? ERR_INVALID_PARAMETER : NO_ERROR;
+
+   string composed, out;
+   BinaryLog_ComposeMessage(composed, header, level, "EURUSD", "H1", path, errorDescr, message);
+   BinaryLog_Encode(logger, composed.data(), composed.size(), out);
+   logger->write(out.data(), out.size());
+}
+
+
+/**
+ * Run blogdump and capture its output (stdout and stderr).
+ *
+ * @return int - exit status of blogdump
+ */
+static int RunBlogdump(const std::string &filename, std::string &output) {
+   std::string cmd = std::string(BLOGDUMP) + " \"" + filename + "\" 2>&1";
+   FILE* pipe = popen(cmd.c_str(), "r");
+   output.clear();
+   if (!pipe) return(-1);
+   char buffer[256];
+   size_t n;
+   while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) output.append(buffer, n);
+   int status = pclose(pipe);
+   return(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+}
+
+
+TEST(BinaryLog_RoundTrip) {
+   std::string filename = TempFilename("roundtrip.blog");
+   std::ofstream* logger = new std::ofstream(filename.c_str(), std::ios::binary);
+   BinaryLog_Open(logger);
+   WriteMessage(logger, 1577836800, 123, "INFO",  "MyExpert::",  "", "first message");
+   WriteMessage(logger, 1577836801,   7, "INFO",  "MyExpert::",  "", "multi\r\nline");
+   WriteMessage(logger, 1577836862, 999, "ERROR", "MyExpert::MyLib::", "ERR_INVALID_PARAMETER", "failed");
+   logger->close();
+   BinaryLog_Close(logger);
+
+   logger->open(filename.c_str(), std::ios::binary|std::ios::app);    // reopened: the next write starts a new section
+   WriteMessage(logger, 1577836800, 0, "DEBUG", "MyExpert::", "", "reopened");
+   logger->close();
+   BinaryLog_Close(logger);
+   delete logger;
+
+   std::string output;
+   CHECK_EQ(RunBlogdump(filename, output), 0);
+   CHECK(output == "2020-01-01 00:00:00.123  INFO    EURUSD,H1   MyExpert::first message\n"
+                   "2020-01-01 00:00:01.007  INFO    EURUSD,H1   MyExpert::multi line\n"
+                   "2020-01-01 00:01:02.999  ERROR   EURUSD,H1   MyExpert::MyLib::failed  [ERR_INVALID_PARAMETER]\n"
+                   "2020-01-01 00:00:00.000  DEBUG   EURUSD,H1   MyExpert::reopened\n");
+
+   // a truncated file is decoded up to the last complete record and reported with the offset of the broken one
+   std::ifstream in(filename.c_str(), std::ios::binary);
+   std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   std::string truncated = TempFilename("truncated.blog");
+   std::ofstream(truncated.c_str(), std::ios::binary).write(data.data(), data.size()-3);
+
+   CHECK_EQ(RunBlogdump(truncated, output), 1);
+   size_t lastRecord = data.size() - sizeof(BLOG_MESSAGE) - strlen("reopened");
+   char expected[128];
+   sprintf(expected, "unexpected end of file in record at offset %u", (uint)lastRecord);
+   CHECK(output.find(expected) != std::string::npos);
+   CHECK(output.find("MyExpert::MyLib::failed") != std::string::npos);
+}
@@ -0,0 +1,70 @@
+/**
+ * Tests of the date/time functions (src/lib/datetime.cpp).
+ */
+#include "expander.h"
+#include "lib/datetime.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+
+/**
+ * Switch the local timezone of the process.
+ */
+static void SetTimezone(const char* tz) {
+   if (tz) setenv("TZ", tz, 1);
+   else    unsetenv("TZ");
+   tzset();
+}
+
+
+/**
+ * Format a timestamp like cachedTimeFormat() but without a cache.
+ */
+static string UncachedTimeFormat(time32 time, BOOL toLocalTime, int milliseconds) {
+   string result = toLocalTime ? localTimeFormat(time, "%Y-%m-%d %H:%M:%S") : gmtTimeFormat(time, "%Y-%m-%d %H:%M:%S");
+   if (milliseconds >= 0) {
+      char ms[8];
+      sprintf(ms, ".%03d", milliseconds);
+      result.append(ms);
+   }
+   return(result);
+}
+
+
+TEST(cachedTimeFormat_MatchesUncachedFormat) {
+   const char* timezones[] = { "UTC0", "America/New_York", "Asia/Kolkata" };     // with DST and with a half-hour offset
+   const char* previousTz = getenv("TZ");
+   string savedTz = previousTz ? previousTz : "";
+
+   // 2019-03-10 06:59:00 GMT: DST starts in New York at 07:00 GMT, Kolkata is at 12:29 local time
+   time32 times[] = { 1552201140, 1552201199, 1552201200, 1552201201, 1552201259, 1552201260,   // minute rollovers and DST
+                      1552201199,                                                            // backwards into the cached minute
+                      1552202999, 1552203000, 1552203001,                                    // hour rollover (Kolkata: half hour)
+                      1552262399, 1552262400,                                                // day rollover GMT
+                      1577836799, 1577836800, 1577836800, 1577836861 };                      // year rollover, same time twice
+
+   for (uint z=0; z < sizeof(timezones)/sizeof(timezones[0]); z++) {
+      SetTimezone(timezones[z]);
+      TIME_FORMAT_CACHE cache = {};
+      for (uint i=0; i < sizeof(times)/sizeof(times[0]); i++) {
+         for (int mode=0; mode < 4; mode++) {                  // switch between local time and GMT with and without milliseconds
+            BOOL local = (mode + i) & 1;
+            int ms = (mode & 2) ? (int)(i*37 % 1000) : EMPTY;
+            CHECK_EQ(string(cachedTimeFormat(cache, times[i], local, ms)), UncachedTimeFormat(times[i], local, ms));
+         }
+      }
+
+      // every second of a day, as local time
+      TIME_FORMAT_CACHE day = {};
+      for (time32 t=1552176000; t < 1552176000 + 86400; t += 7) {
+         string expected = UncachedTimeFormat(t, TRUE, EMPTY);
+         if (expected != cachedTimeFormat(day, t, TRUE)) {
+            CHECK_EQ(string(cachedTimeFormat(day, t, TRUE)), expected);
+            break;
+         }
+      }
+   }
+   SetTimezone(previousTz ? savedTz.c_str() : NULL);
+}
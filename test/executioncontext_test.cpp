@@ -0,0 +1,287 @@
+/**
+ * Tests of the program registry (src/lib/executioncontext.cpp).
+ */
+#include "expander.h"
+#include "lib/executioncontext.h"
+#include "lib/helper.h"
+#include "lib/string.h"
+#include "struct/ExecutionContext.h"
+#include "test.h"
+
+#include <algorithm>
+
+
+extern MqlInstanceList g_mqlInstances;
+
+
+/**
+ * Register a loaded program with a master and a main context, like SyncMainContext_init() does for a new program.
+ */
+static EXECUTION_CONTEXT* NewProgram(ProgramType type, const char* name, BOOL testing) {
+   EXECUTION_CONTEXT* master = new EXECUTION_CONTEXT();
+   EXECUTION_CONTEXT* main   = new EXECUTION_CONTEXT();
+   ContextChain* chain = new ContextChain();
+   chain->push_back(master);
+   chain->push_back(main);
+
+   master->pid                 = PushProgram(chain);
+   master->programType         = type;
+   master->moduleType          = (ModuleType)type;
+   strcpy(master->programName, name);
+   strcpy(master->moduleName,  name);
+   master->programCoreFunction = CF_START;
+   master->testing             = testing;
+   master->threadId            = GetCurrentThreadId() + (testing ? 1 : 0);    // a test runs in a non-UI thread
+   *main = *master;
+   return(main);
+}
+
+
+/**
+ * Unload the main module of a program, like the terminal does after MainModule::deinit().
+ */
+static void UnloadProgram(EXECUTION_CONTEXT* ec, UninitializeReason reason) {
+   EXECUTION_CONTEXT* master = (*g_mqlInstances[ec->pid])[0];
+   master->programUninitReason = ec->programUninitReason = reason;
+   ec->moduleCoreFunction = CF_DEINIT;
+   CHECK_EQ(LeaveMqlModule(ec), NO_ERROR);
+}
+
+
+static int RetiredCount(uint pid) {
+   return(std::count(g_mqlInstances.retired.begin(), g_mqlInstances.retired.end(), pid));
+}
+
+
+TEST(RetireProgram_OnlyFinalUnloads) {
+   EXECUTION_CONTEXT* expert = NewProgram(PT_EXPERT, "Expert", FALSE);
+   UnloadProgram(expert, UR_REMOVE);
+   CHECK_EQ(RetiredCount(expert->pid), 1);
+
+   EXECUTION_CONTEXT* chartIndicator = NewProgram(PT_INDICATOR, "Indicator", FALSE);
+   UnloadProgram(chartIndicator, UR_CHARTCLOSE);
+   CHECK_EQ(RetiredCount(chartIndicator->pid), 1);
+
+   EXECUTION_CONTEXT* testIndicator = NewProgram(PT_INDICATOR, "Indicator", TRUE);
+   UnloadProgram(testIndicator, UR_CHARTCLOSE);                // reloaded after the test with IR_PROGRAM_AFTERTEST
+   CHECK_EQ(RetiredCount(testIndicator->pid), 0);
+
+   EXECUTION_CONTEXT* testIndicator2 = NewProgram(PT_INDICATOR, "Indicator", TRUE);
+   UnloadProgram(testIndicator2, UR_REMOVE);
+   CHECK_EQ(RetiredCount(testIndicator2->pid), 0);
+
+   EXECUTION_CONTEXT* testExpert = NewProgram(PT_EXPERT, "Expert", TRUE);
+   UnloadProgram(testExpert, UR_UNDEFINED);                    // a finished test
+   CHECK_EQ(RetiredCount(testExpert->pid), 1);
+}
+
+
+TEST(RetireProgram_RetiresOnceAndUnretiresOnReload) {
+   EXECUTION_CONTEXT* expert = NewProgram(PT_EXPERT, "Expert", FALSE);
+   uint pid = expert->pid;
+   UnloadProgram(expert, UR_REMOVE);
+   for (int i=0; i < MQL_INSTANCE_QUARANTINE+10; i++) {
+      RetireProgram(pid);                                      // repeated retirements must not fill the quarantine
+   }
+   CHECK_EQ(RetiredCount(pid), 1);
+
+   UnretireProgram(pid);                                       // reloaded: the pid must not be recycled anymore
+   CHECK_EQ(RetiredCount(pid), 0);
+   UnretireProgram(pid);
+   CHECK_EQ(RetiredCount(pid), 0);
+
+   for (int i=0; i < MQL_INSTANCE_QUARANTINE+10; i++) {        // programs retired later are recycled, the reloaded one isn't
+      EXECUTION_CONTEXT* ec = NewProgram(PT_SCRIPT, "Script", FALSE);
+      CHECK(ec->pid != pid);
+      UnloadProgram(ec, UR_REMOVE);
+   }
+   CHECK(g_mqlInstances.retired.size() <= MQL_INSTANCE_QUARANTINE+1);
+}
+
+
+TEST(FindModuleInLimbo_TestIndicatorReloadedAfterTest) {
+   EXECUTION_CONTEXT* indicator = NewProgram(PT_INDICATOR, "Limbo Indicator", TRUE);
+   uint pid = indicator->pid;
+   UnloadProgram(indicator, UR_CHARTCLOSE);                    // an iCustom() indicator at the end of a test
+   RetireProgram(pid);                                         // even a retired indicator stays findable until recycled
+
+   EXECUTION_CONTEXT ec = {}, sec = {};
+   uint prevPid = 0;
+   InitializeReason reason = GetInitReason_indicator(&ec, &sec, "Limbo Indicator", UR_CHARTCLOSE, "EURUSD", PERIOD_H1, TRUE, FALSE, NULL, -1, -1, -1, prevPid);
+   CHECK_EQ(reason, IR_PROGRAM_AFTERTEST);
+   CHECK_EQ(prevPid, pid);
+   UnretireProgram(pid);
+
+   for (int i=0; i < MQL_INSTANCE_QUARANTINE+10; i++) {        // other programs cycle through the quarantine
+      EXECUTION_CONTEXT* ec = NewProgram(PT_SCRIPT, "Script", FALSE);
+      UnloadProgram(ec, UR_REMOVE);
+   }
+   CHECK_EQ(FindModuleInLimbo(MT_INDICATOR, "Limbo Indicator", UR_CHARTCLOSE, TRUE, NULL), pid);
+}
+
+
+// a thread executing a program, as the terminal starts one per chart and per test
+struct ProgramThread {
+   uint          pid;
+   int           index;                                        // the thread's registry index as reported
+   HANDLE        hRelease;                                     // event the thread waits for before it terminates
+   volatile LONG* registered;                                  // number of threads registered so far
+};
+
+
+static DWORD WINAPI RunProgramThread(LPVOID arg) {
+   ProgramThread* thread = (ProgramThread*)arg;
+   thread->index = SetLastThreadProgram(thread->pid);
+   InterlockedIncrement(thread->registered);
+   WaitForSingleObject(thread->hRelease, INFINITE);
+   return(0);
+}
+
+
+/**
+ * Start the specified number of threads and wait until all of them are registered. The threads run until the event is set.
+ */
+static std::vector<HANDLE> StartProgramThreads(std::vector<ProgramThread> &threads, HANDLE hRelease, SIZE_T stackSize) {
+   volatile LONG registered = 0;
+   std::vector<HANDLE> handles;
+   for (uint i=0; i < threads.size(); i++) {
+      ProgramThread pt = { i+1, -1, hRelease, &registered };
+      threads[i] = pt;
+      handles.push_back(CreateThread(NULL, stackSize, RunProgramThread, &threads[i], 0, NULL));
+      CHECK(handles.back() != NULL);
+   }
+   while (registered < (LONG)threads.size()) Sleep(1);
+   return(handles);
+}
+
+
+static void JoinThreads(const std::vector<HANDLE> &handles) {
+   for (uint i=0; i < handles.size(); i++) {
+      CHECK_EQ(WaitForSingleObject(handles[i], INFINITE), WAIT_OBJECT_0);
+      CHECK(CloseHandle(handles[i]));
+   }
+}
+
+
+TEST(ThreadSlots_ReusedAfterThreadsTerminate) {
+   const uint concurrent = 16;
+   HANDLE hRelease = CreateEventA(NULL, TRUE, FALSE, NULL);
+   uint initialSlots = GetThreadSlotsCount();
+
+   for (int round=0; round < 20; round++) {
+      std::vector<ProgramThread> threads(concurrent);
+      ResetEvent(hRelease);
+      std::vector<HANDLE> handles = StartProgramThreads(threads, hRelease, 0);
+
+      std::vector<int> indexes;
+      for (uint i=0; i < threads.size(); i++) {
+         indexes.push_back(threads[i].index);
+         const THREAD_SLOT* slot = GetThreadSlot(threads[i].index);
+         CHECK(slot && slot->pid == threads[i].pid);
+      }
+      std::sort(indexes.begin(), indexes.end());
+      CHECK(indexes[0] >= 0);
+      CHECK(std::unique(indexes.begin(), indexes.end()) == indexes.end());    // live threads never share a slot
+
+      SetEvent(hRelease);
+      JoinThreads(handles);
+      CHECK(GetThreadSlotsCount() <= initialSlots + concurrent);              // bounded by the number of concurrent threads
+   }
+   CloseHandle(hRelease);
+}
+
+
+// measures the registration and the steady state of SetLastThreadProgram() in a new thread
+struct SetProgramBenchmark {
+   double registerTime;
+   double callsTime;
+   int    calls;
+};
+
+
+static DWORD WINAPI RunSetProgramBenchmark(LPVOID arg) {
+   SetProgramBenchmark* bench = (SetProgramBenchmark*)arg;
+   double start = MilliSeconds();
+   SetLastThreadProgram(1);                                    // registers the thread
+   bench->registerTime = MilliSeconds() - start;
+
+   start = MilliSeconds();
+   for (int i=0; i < bench->calls; i++) {
+      SetLastThreadProgram(i % 100 + 1);
+   }
+   bench->callsTime = MilliSeconds() - start;
+   return(0);
+}
+
+
+BENCHMARK(SetLastThreadProgram_RegisteredThreads) {
+   int counts[] = { 10, 1000, 4000 };
+   HANDLE hRelease = CreateEventA(NULL, TRUE, FALSE, NULL);
+   printf("\n");
+
+   for (uint n=0; n < sizeof(counts)/sizeof(counts[0]); n++) {
+      std::vector<ProgramThread> threads(counts[n]);
+      ResetEvent(hRelease);
+      std::vector<HANDLE> handles = StartProgramThreads(threads, hRelease, 64*1024);
+
+      SetProgramBenchmark bench = { 0, 0, 1000000 };
+      HANDLE hThread = CreateThread(NULL, 0, RunSetProgramBenchmark, &bench, 0, NULL);
+      WaitForSingleObject(hThread, INFINITE);
+      CloseHandle(hThread);
+      CHECK(GetThreadSlotsCount() > (uint)counts[n]);
+
+      SetEvent(hRelease);
+      JoinThreads(handles);
+      printf("    %4d registered threads: registration %.3f ms, %d calls %.1f ms\n", counts[n], bench.registerTime, bench.calls, bench.callsTime);
+   }
+   CloseHandle(hRelease);
+}
+
+
+/**
+ * Find an unloaded test indicator without libraries by scanning the whole program registry (FindModuleInLimbo() before the
+ * limbo index).
+ */
+static uint ScanRegistryForLimbo(const char* name, UninitializeReason uninitReason) {
+   uint size = g_mqlInstances.size();
+   for (uint pid=1; pid < size; pid++) {
+      ContextChain &chain = *g_mqlInstances[pid];
+      EXECUTION_CONTEXT* master = chain.size() ? chain[0] : NULL;
+      if (!master || master->programType!=PT_INDICATOR || master->programCoreFunction) continue;
+      if (master->programUninitReason != uninitReason || !StrCompare(master->programName, name)) continue;
+      if (chain.size() <= 2 && !IsUiThread(master->threadId)) return(pid);
+   }
+   return(NULL);
+}
+
+
+BENCHMARK(FindModuleInLimbo_50kPrograms) {
+   const int programs = 50000, names = 1000, lookups = 100000;
+   char name[MAX_FNAME];
+
+   double start = MilliSeconds();
+   for (int i=0; i < programs; i++) {
+      sprintf(name, "Indicator %d", i % names);
+      UnloadProgram(NewProgram(PT_INDICATOR, name, TRUE), UR_CHARTCLOSE);  // iCustom() indicators at the end of a test
+   }
+   double pushTime = MilliSeconds() - start;
+
+   std::vector<uint> found(lookups);
+   start = MilliSeconds();
+   for (int i=0; i < lookups; i++) {
+      sprintf(name, "Indicator %d", (i*7) % (names*2));                    // half of the names are not in limbo
+      found[i] = FindModuleInLimbo(MT_INDICATOR, name, UR_CHARTCLOSE, TRUE, NULL);
+   }
+   double indexTime = MilliSeconds() - start;
+
+   int scans = lookups/100;
+   start = MilliSeconds();
+   for (int i=0; i < scans; i++) {
+      sprintf(name, "Indicator %d", (i*7) % (names*2));
+      CHECK_EQ(ScanRegistryForLimbo(name, UR_CHARTCLOSE), found[i]);
+   }
+   double scanTime = MilliSeconds() - start;
+
+   printf("\n    %d programs pushed and unloaded: %.1f ms\n", programs, pushTime);
+   printf("    %d lookups: FindModuleInLimbo %.1f ms, registry scan %.1f ms (extrapolated from %d)\n", lookups, indexTime, scanTime * lookups/scans, scans);
+}
@@ -0,0 +1,220 @@
+/**
+ * Tests of the debug output (src/expander.cpp).
+ */
+#include "expander.h"
+#include "lib/conversion.h"
+#include "lib/executioncontext.h"
+#include "lib/string.h"
+#include "struct/ExecutionContext.h"
+#include "test.h"
+
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+
+// the real debug output functions, renamed in the test build (see Makefile)
+int __cdecl Expander_debug(const char* fileName, const char* funcName, uint line, const char* message, ...);
+int __cdecl Expander_debug(const char* fileName, const char* funcName, uint line, int error, const char* message, ...);
+int __cdecl Expander_warn (const char* fileName, const char* funcName, uint line, const char* message, ...);
+int __cdecl Expander_warn (const char* fileName, const char* funcName, uint line, int error, const char* message, ...);
+int __cdecl Expander_error(const char* fileName, const char* funcName, uint line, int error, const char* message, ...);
+
+
+/**
+ * Redirect the debugger output (stderr in the test build) to a file or to /dev/null.
+ */
+static int RedirectDebugOutput(const char* filename) {
+   fflush(stderr);
+   int saved = dup(STDERR_FILENO);
+   int fd = open(filename, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+   dup2(fd, STDERR_FILENO);
+   close(fd);
+   return(saved);
+}
+
+
+static void RestoreDebugOutput(int saved) {
+   fflush(stderr);
+   dup2(saved, STDERR_FILENO);
+   close(saved);
+}
+
+
+/**
+ * Stop capturing the debugger output and return it.
+ */
+static string CapturedOutput(int saved, const std::string &filename) {
+   RestoreDebugOutput(saved);
+   std::ifstream file(filename.c_str(), std::ios::binary);
+   return(string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+}
+
+
+/**
+ * Compose a debug message like the Expander did before OutputDebugMessage(): the message, the prefix and the error suffix
+ * were formatted one after another on the heap. The level is the padded prefix of the old functions.
+ */
+static char* BaselineMessage(const char* level, const char* fileName, const char* funcName, uint line, int error, const char* format, va_list args) {
+   const char* msg = format ? format : "(null)";
+   va_list copy;
+   va_copy(copy, args);
+   int size = _vscprintf(msg, copy) + 1;
+   va_end(copy);
+   char* formattedMsg = (char*)malloc(size);
+   vsnprintf(formattedMsg, size, msg, args);
+
+   char* fullMsg;
+   if (!funcName) {
+      fullMsg = asformat("MT4Expander %s%s", level, formattedMsg);
+   }
+   else {
+      const char* baseName = fileName ? fileName : "";
+      for (const char* c=baseName; *c; c++) {
+         if (*c=='\\' || *c=='/') baseName = c+1;
+      }
+      fullMsg = asformat("MT4Expander %s%s::%s(%u)  %s", level, baseName, funcName, line, formattedMsg);
+   }
+   if (error) {
+      char* newMsg = asformat("%s  [%s]", fullMsg, ErrorToStrA(error));
+      free(fullMsg);
+      fullMsg = newMsg;
+   }
+   free(formattedMsg);
+   return(fullMsg);
+}
+
+
+static string Baseline(const char* level, const char* fileName, const char* funcName, uint line, int error, const char* format, ...) {
+   va_list args;
+   va_start(args, format);
+   char* msg = BaselineMessage(level, fileName, funcName, line, error, format, args);
+   va_end(args);
+   string result(msg);
+   free(msg);
+   return(result);
+}
+
+
+TEST(OutputDebugMessage_MatchesBaseline) {
+   std::string filename = TempFilename("debug-output.txt");
+   const char* file = "C:\\projects\\mt4-expander\\src\\lib\\module.cpp";
+   int saved;
+
+   saved = RedirectDebugOutput(filename.c_str());
+   Expander_debug(file, "Function", 10, "value %d of %s", 7, "EURUSD");
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("       ", file, "Function", 10, NO_ERROR, "value %d of %s", 7, "EURUSD"));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   Expander_debug("src/lib/module.cpp", "Function", 11, ERR_INVALID_PARAMETER, "%s", "unix path");
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("       ", "src/lib/module.cpp", "Function", 11, ERR_INVALID_PARAMETER, "%s", "unix path"));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   _info(file, "Function", 12, "info %.2f", 1.5);
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("INFO   ", file, "Function", 12, NO_ERROR, "info %.2f", 1.5));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   _notice(file, "Function", 13, ERR_RUNTIME_ERROR, "notice");
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("NOTICE ", file, "Function", 13, ERR_RUNTIME_ERROR, "notice"));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   Expander_warn(file, "Function", 14, "warning %%d");
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("WARN   ", file, "Function", 14, NO_ERROR, "warning %%d"));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   Expander_warn(NULL, "Function", 15, ERR_INVALID_PARAMETER, NULL);
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("WARN   ", NULL, "Function", 15, ERR_INVALID_PARAMETER, NULL));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   Expander_error(file, "Function", 16, ERR_ILLEGAL_STATE, "error %d", -1);
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("ERROR  ", file, "Function", 16, ERR_ILLEGAL_STATE, "error %d", -1));
+
+   saved = RedirectDebugOutput(filename.c_str());
+   debug_raw("raw %s", "message");
+   CHECK_EQ(CapturedOutput(saved, filename), Baseline("       ", NULL, NULL, 0, NO_ERROR, "raw %s", "message"));
+
+   // messages around the size of the stack buffer (2048 bytes), the longer ones are composed on the heap
+   string text(2200, 'x');
+   for (uint length=1900; length < text.size(); length++) {
+      saved = RedirectDebugOutput(filename.c_str());
+      Expander_warn(file, "Function", 17, ERR_INVALID_PARAMETER, "%.*s|%d", length, text.c_str(), length);
+      string expected = Baseline("WARN   ", file, "Function", 17, ERR_INVALID_PARAMETER, "%.*s|%d", length, text.c_str(), length);
+      string output = CapturedOutput(saved, filename);
+      if (output != expected) {
+         CHECK_EQ(output.size(), expected.size());
+         CHECK_EQ(length, 0u);                                 // report the first length only
+         break;
+      }
+   }
+}
+
+
+// a thread executing a program which switched its debug output off
+static DWORD WINAPI RunSilentProgram(LPVOID arg) {
+   SetLastThreadProgram(*(uint*)arg);
+   Expander_debug("module.cpp", "Function", 20, "debug");
+   _info         ("module.cpp", "Function", 21, "info");
+   _notice       ("module.cpp", "Function", 22, "notice");
+   Expander_warn ("module.cpp", "Function", 23, ERR_INVALID_PARAMETER, "warning");
+   Expander_error("module.cpp", "Function", 24, ERR_ILLEGAL_STATE, "error");
+   return(0);
+}
+
+
+TEST(OutputDebugMessage_NeverFiltersWarningsAndErrors) {
+   EXECUTION_CONTEXT* master = new EXECUTION_CONTEXT();
+   EXECUTION_CONTEXT* main   = new EXECUTION_CONTEXT();
+   ContextChain* chain = new ContextChain();
+   chain->push_back(master);
+   chain->push_back(main);
+   master->pid = main->pid = PushProgram(chain);
+   master->loglevel = master->loglevelDebug = LOG_OFF;
+
+   std::string filename = TempFilename("debug-output.txt");
+   int saved = RedirectDebugOutput(filename.c_str());
+   HANDLE hThread = CreateThread(NULL, 0, RunSilentProgram, &master->pid, 0, NULL);
+   CHECK_EQ(WaitForSingleObject(hThread, INFINITE), WAIT_OBJECT_0);
+   CloseHandle(hThread);
+
+   string expected = Baseline("WARN   ",  "module.cpp", "Function", 23, ERR_INVALID_PARAMETER, "warning")
+                   + Baseline("ERROR  ",  "module.cpp", "Function", 24, ERR_ILLEGAL_STATE,     "error");
+   CHECK_EQ(CapturedOutput(saved, filename), expected);
+   CHECK_EQ(master->dllWarning, ERR_INVALID_PARAMETER);
+   CHECK_EQ(main->dllError, ERR_ILLEGAL_STATE);
+}
+
+
+/**
+ * A warning composed like before OutputDebugMessage().
+ */
+static int BaselineWarn(const char* fileName, const char* funcName, uint line, int error, const char* format, ...) {
+   va_list args;
+   va_start(args, format);
+   char* msg = BaselineMessage("WARN   ", fileName, funcName, line, error, format, args);
+   va_end(args);
+   OutputDebugStringA(msg);
+   free(msg);
+   return(error);
+}
+
+
+BENCHMARK(OutputDebugMessage_VsAsformat) {
+   const int count = 1000000;
+   const char* file = "C:\\projects\\mt4-expander\\src\\lib\\module.cpp";
+   int saved = RedirectDebugOutput("/dev/null");
+
+   double start = MilliSeconds();
+   for (int i=0; i < count; i++) {
+      BaselineWarn(file, "Function", 42, ERR_INVALID_PARAMETER, "invalid parameter hTable: %d (unknown handle)", i);
+   }
+   double asformatTime = MilliSeconds() - start;
+
+   start = MilliSeconds();
+   for (int i=0; i < count; i++) {
+      Expander_warn(file, "Function", 42, ERR_INVALID_PARAMETER, "invalid parameter hTable: %d (unknown handle)", i);
+   }
+   double bufferTime = MilliSeconds() - start;
+   RestoreDebugOutput(saved);
+
+   printf("\n    %d warnings: asformat() %.1f ms, OutputDebugMessage() %.1f ms\n", count, asformatTime, bufferTime);
+}
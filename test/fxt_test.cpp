@@ -0,0 +1,299 @@
+/**
+ * Tests of the FXT generator (src/lib/fxt.cpp). There is no terminal-generated reference file for the synthetic history
+ * used here, so the expected tick records are built independently from the documented price path of the generator and
+ * compared byte by byte against the generated file.
+ */
+#include "expander.h"
+#include "lib/fxt.h"
+#include "lib/history.h"
+#include "test.h"
+
+#include <vector>
+
+
+static const time32 T0 = 1577836800;                           // 2020.01.01 00:00
+
+
+// prices of the synthetic M1 bars in points (digits = 5)
+struct M1Points {
+   int open, high, low, close;
+   uint volume;
+};
+
+
+/**
+ * Synthetic M1 bar: bullish bars at even, bearish bars at odd offsets.
+ */
+static M1Points SyntheticBar(int i) {
+   M1Points bar;
+   bar.open   = 110000 + i*100;
+   bar.volume = 10 + i;
+   if (i % 2 == 0) { bar.low = bar.open - 30; bar.high = bar.open + 50; bar.close = bar.open + 20; }
+   else            { bar.high = bar.open + 40; bar.low = bar.open - 60; bar.close = bar.open - 10; }
+   return(bar);
+}
+
+
+static void WriteM1History(const string &filename, const std::vector<M1Points> &bars) {
+   HISTORY_HEADER hh = {};
+   hh.barFormat = 401;
+   strcpy(hh.symbol, "EURUSD");
+   hh.period = PERIOD_M1;
+   hh.digits = 5;
+
+   FILE* file = fopen(filename.c_str(), "wb");
+   fwrite(&hh, sizeof(hh), 1, file);
+   for (size_t i=0; i < bars.size(); i++) {
+      HistoryBar401 bar = {};
+      bar.time       = T0 + (time32)i*MINUTE;
+      bar.open       = bars[i].open  / 1e5;
+      bar.high       = bars[i].high  / 1e5;
+      bar.low        = bars[i].low   / 1e5;
+      bar.close      = bars[i].close / 1e5;
+      bar.tickVolume = bars[i].volume;
+      fwrite(&bar, sizeof(bar), 1, file);
+   }
+   fclose(file);
+}
+
+
+static void InitJob(FXT_GENERATOR_JOB &job, const string &hstFile, const string &fxtFile) {
+   memset(&job, 0, sizeof(job));
+   strcpy(job.hstFile, hstFile.c_str());
+   strcpy(job.fxtFile, fxtFile.c_str());
+   strcpy(job.symbol.name, "EURUSD");
+   strcpy(job.symbol.baseCurrency, "EUR");
+   strcpy(job.symbol.marginCurrency, "USD");
+   job.symbol.digits       = 5;
+   job.symbol.pointSize    = 0.00001;
+   job.symbol.contractSize = 100000;
+   strcpy(job.serverName, "Test-Server");
+   job.accountLeverage = 100;
+}
+
+
+static std::vector<BYTE> ReadFile(const string &filename) {
+   std::vector<BYTE> data;
+   FILE* file = fopen(filename.c_str(), "rb");
+   if (!file) return(data);
+   int c;
+   while ((c = fgetc(file)) != EOF) data.push_back((BYTE)c);
+   fclose(file);
+   return(data);
+}
+
+
+/**
+ * Append a tick record with the state of the bar after the tick.
+ */
+static void AddTick(std::vector<FXT_TICK_401> &ticks, FXT_TICK_401 &bar, time32 tickTime, int flags) {
+   bar.tickTime = tickTime;
+   bar.flags    = flags;
+   ticks.push_back(bar);
+}
+
+
+TEST(FxtFile_Generate_ControlPoints) {
+   std::vector<M1Points> m1(30);
+   for (int i=0; i < 30; i++) m1[i] = SyntheticBar(i);
+   m1[22].high = m1[22].open + 10;                             // inconsistent: high below close, repaired to the close
+
+   string hstFile = TempFilename("EURUSD1-cp.hst"), fxtFile = TempFilename("EURUSD5_1.fxt");
+   WriteM1History(hstFile, m1);
+
+   FXT_GENERATOR_JOB job;
+   InitJob(job, hstFile, fxtFile);
+   job.period     = PERIOD_M5;
+   job.barModel   = MODE_CONTROLPOINTS;
+   job.from       = T0 + 15*MINUTE;
+   job.to         = T0 + 25*MINUTE;
+   job.prologBars = 2;
+   CHECK(FxtFile_Generate(&job));
+   CHECK(job.success);
+
+   // expected records: the prolog has one record per M5 bar (M1 bars 5-14), then ticks of the M1 bars 15-24
+   std::vector<FXT_TICK_401> expected;
+   FXT_TICK_401 bar = {};
+   for (int m5=1; m5 < 3; m5++) {
+      int first = m5*5;
+      bar.barTime_ex = T0 + first*MINUTE;
+      bar.open = m1[first].open / 1e5;
+      int high = m1[first].open, low = m1[first].open;
+      bar.volume = 0;
+      for (int i=first; i < first+5; i++) {
+         high = max(high, m1[i].high);
+         low  = min(low,  m1[i].low);
+         bar.volume += m1[i].volume;
+      }
+      bar.high  = high / 1e5;
+      bar.low   = low  / 1e5;
+      bar.close = m1[first+4].close / 1e5;
+      AddTick(expected, bar, T0 + (first+4)*MINUTE + 59, 0);
+   }
+   for (int i=15; i < 25; i++) {
+      M1Points p = m1[i];
+      if (p.high < max(p.open, p.close)) p.high = max(p.open, p.close);
+      if (i % 5 == 0) {
+         bar.barTime_ex = T0 + i*MINUTE;
+         bar.open = bar.high = bar.low = bar.close = p.open / 1e5;
+         bar.volume = 0;
+      }
+      bool bullish = p.close >= p.open;
+      int path[4] = { p.open, bullish ? p.low : p.high, bullish ? p.high : p.low, p.close };
+      std::vector<int> prices;
+      for (int n=0; n < 4; n++) {
+         if (prices.empty() || prices.back() != path[n]) prices.push_back(path[n]);
+      }
+      for (size_t n=0; n < prices.size(); n++) {
+         double price = prices[n] / 1e5;
+         bar.high  = max(bar.high, price);
+         bar.low   = min(bar.low, price);
+         bar.close = price;
+         bar.volume++;
+         AddTick(expected, bar, T0 + i*MINUTE + n*MINUTE/prices.size(), 1);
+      }
+   }
+
+   std::vector<BYTE> data = ReadFile(fxtFile);
+   CHECK_EQ(data.size(), sizeof(FXT_HEADER) + expected.size()*sizeof(FXT_TICK_401));
+   CHECK_EQ(job.ticks, (uint)expected.size());
+   if (data.size() == sizeof(FXT_HEADER) + expected.size()*sizeof(FXT_TICK_401)) {
+      for (size_t i=0; i < expected.size(); i++) {
+         if (memcmp(&data[sizeof(FXT_HEADER) + i*sizeof(FXT_TICK_401)], &expected[i], sizeof(FXT_TICK_401))) {
+            CHECK_EQ(i, (size_t)-1);                           // report the first differing record
+            break;
+         }
+      }
+   }
+
+   const FXT_HEADER* header = (const FXT_HEADER*)&data[0];
+   CHECK_EQ(header->version, 405u);
+   CHECK_EQ(string(header->symbol), string("EURUSD"));
+   CHECK_EQ(header->period, (uint)PERIOD_M5);
+   CHECK_EQ(header->modelType, (uint)MODE_CONTROLPOINTS);
+   CHECK_EQ(header->digits, 5u);
+   CHECK_EQ(header->tickValue, 100000 * 0.00001);
+   CHECK_EQ(header->tickSize, 0.00001);
+   CHECK_EQ(header->firstBar, 2u);
+   CHECK_EQ(header->modeledBars, 2u);
+   CHECK_EQ(header->modelErrors, 1u);
+   CHECK_EQ(header->modelQuality, 0.);                         // only "every tick" has a model quality
+   CHECK_EQ(header->firstBarTime, T0 + 15*MINUTE);
+   CHECK_EQ(header->lastBarTime, T0 + 20*MINUTE);
+   CHECK_EQ(header->testerSettingFrom, job.from);
+   CHECK_EQ(header->testerSettingTo, job.to);
+
+   uint hFile = FxtFile_Open(fxtFile.c_str());                 // the reader agrees with the generator
+   CHECK(hFile != 0);
+   CHECK_EQ(FxtFile_TickFormat(hFile), 401u);
+   CHECK_EQ(FxtFile_PrologBars(hFile), 2);
+   CHECK_EQ(FxtFile_PrologTicks(hFile), 2);
+   CHECK_EQ(FxtFile_ModeledTicks(hFile), (int)expected.size()-2);
+   CHECK(FxtFile_Close(hFile));
+}
+
+
+TEST(FxtFile_Generate_EveryTickVisitsAllPoints) {
+   std::vector<M1Points> m1(3);
+   for (int i=0; i < 3; i++) {
+      m1[i] = SyntheticBar(i);
+      m1[i].volume = 1000;                                     // enough volume for a tick at every point of the path
+   }
+   string hstFile = TempFilename("EURUSD1-et.hst"), fxtFile = TempFilename("EURUSD1_0.fxt");
+   WriteM1History(hstFile, m1);
+
+   FXT_GENERATOR_JOB job;
+   InitJob(job, hstFile, fxtFile);
+   job.period    = PERIOD_M1;
+   job.barModel  = MODE_EVERYTICK;
+   job.from      = T0;
+   job.tickValue = 0.9;
+   CHECK(FxtFile_Generate(&job));
+
+   uint hFile = FxtFile_Open(fxtFile.c_str());
+   CHECK(hFile != 0);
+   std::vector<FxtTick> ticks(1000);
+   int count = FxtFile_ReadTicks(hFile, 0, &ticks[0], 1000);
+   CHECK_EQ(FxtFile_PrologTicks(hFile), 0);
+   CHECK_EQ(FxtFile_Header(hFile)->tickValue, 0.9);
+   CHECK_EQ(FxtFile_Header(hFile)->modelQuality, 90.);
+   CHECK(FxtFile_Close(hFile));
+
+   int n = 0;
+   for (int i=0; i < 3; i++) {
+      const M1Points &p = m1[i];
+      bool bullish = p.close >= p.open;
+      int path[4] = { p.open, bullish ? p.low : p.high, bullish ? p.high : p.low, p.close };
+      int expectedTicks = 1 + abs(path[1]-path[0]) + abs(path[2]-path[1]) + abs(path[3]-path[2]);
+
+      int price = path[0];
+      CHECK_EQ(ticks[n].close, price / 1e5);
+      for (int leg=0; leg < 3; leg++) {                        // one point per tick along each leg
+         int step = path[leg+1] > path[leg] ? 1 : -1;
+         while (price != path[leg+1]) {
+            price += step;
+            n++;
+            if (ticks[n].close != price / 1e5) { CHECK_EQ(ticks[n].close, price / 1e5); return; }
+         }
+      }
+      CHECK_EQ((int)ticks[n].volume, expectedTicks);
+      CHECK_EQ(ticks[n].tickTime, T0 + i*MINUTE + (expectedTicks-1)*MINUTE/expectedTicks);
+      n++;
+   }
+   CHECK_EQ(count, n);
+}
+
+
+TEST(FxtFile_GenerateAll_MatchesSingleGeneration) {
+   std::vector<M1Points> m1(2000);
+   for (int i=0; i < 2000; i++) m1[i] = SyntheticBar(i % 200);
+   string hstFile = TempFilename("EURUSD1-all.hst");
+   WriteM1History(hstFile, m1);
+
+   FXT_GENERATOR_JOB single, jobs[4];
+   InitJob(single, hstFile, TempFilename("single.fxt"));
+   single.period   = PERIOD_M15;
+   single.barModel = MODE_EVERYTICK;
+   single.from     = T0 + 500*MINUTE;
+   CHECK(FxtFile_Generate(&single));
+
+   for (int i=0; i < 4; i++) {                                 // the workers share the history file registry
+      char name[32];
+      sprintf(name, "parallel-%d.fxt", i);
+      jobs[i] = single;
+      strcpy(jobs[i].fxtFile, TempFilename(name).c_str());
+   }
+   CHECK(FxtFile_GenerateAll(jobs, 4));
+
+   std::vector<BYTE> expected = ReadFile(single.fxtFile);
+   CHECK(expected.size() > sizeof(FXT_HEADER));
+   for (int i=0; i < 4; i++) {
+      CHECK(jobs[i].success);
+      CHECK_EQ(jobs[i].ticks, single.ticks);
+      CHECK(ReadFile(jobs[i].fxtFile) == expected);
+   }
+}
+
+
+TEST(FxtFile_Generate_RejectsInvalidJobs) {
+   string hstFile = TempFilename("EURUSD1-invalid.hst");
+   std::vector<M1Points> m1(10);
+   for (int i=0; i < 10; i++) m1[i] = SyntheticBar(i);
+   WriteM1History(hstFile, m1);
+
+   FXT_GENERATOR_JOB job;
+   InitJob(job, hstFile, TempFilename("invalid.fxt"));
+   job.period = 0;
+   CHECK(!FxtFile_Generate(&job));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+
+   job.period = PERIOD_M1;
+   job.from   = T0 + 5*MINUTE;
+   job.to     = T0;
+   CHECK(!FxtFile_Generate(&job));
+   CHECK(!job.success);
+
+   InitJob(job, TempFilename("missing.hst"), TempFilename("invalid.fxt"));
+   job.period = PERIOD_M1;
+   CHECK(!FxtFile_Generate(&job));
+}
@@ -0,0 +1,257 @@
+/**
+ * Tests of the history file reader and writer (src/lib/history.cpp) against synthetic history files.
+ */
+#include "expander.h"
+#include "lib/history.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <vector>
+
+
+/**
+ * Write a synthetic history file.
+ *
+ * @param  string filename
+ * @param  uint   barFormat - 400 | 401
+ * @param  uint   bars      - number of bars, starting at 2020.01.01 00:00 in M1 steps
+ * @param  uint   extra     - number of trailing garbage bytes (a partial bar)
+ */
+static void WriteHistoryFile(const string &filename, uint barFormat, uint bars, uint extra = 0) {
+   HISTORY_HEADER hh = {};
+   hh.barFormat = barFormat;
+   strcpy(hh.symbol, "EURUSD");
+   hh.period = 1;
+   hh.digits = 5;
+
+   FILE* file = fopen(filename.c_str(), "wb");
+   fwrite(&hh, sizeof(hh), 1, file);
+   for (uint i=0; i < bars; i++) {
+      double price = 1.1 + i/100000.;
+      if (barFormat == 400) {
+         HistoryBar400 bar = { 1577836800 + (int)i*60, price, price-0.0001, price+0.0002, price+0.0001, i+1. };
+         fwrite(&bar, sizeof(bar), 1, file);
+      }
+      else {
+         HistoryBar401 bar = {};
+         bar.time = 1577836800 + i*60;
+         bar.open = price; bar.high = price+0.0002; bar.low = price-0.0001; bar.close = price+0.0001;
+         bar.tickVolume = i+1;
+         fwrite(&bar, sizeof(bar), 1, file);
+      }
+   }
+   for (uint i=0; i < extra; i++) fputc(0xAA, file);
+   fclose(file);
+}
+
+
+TEST(HistoryFile_ReadsBarFormat400) {
+   string filename = TempFilename("EURUSD1-400.hst");
+   WriteHistoryFile(filename, 400, 1000);
+
+   uint hFile = HistoryFile_Open(filename.c_str());
+   CHECK(hFile != 0);
+   CHECK_EQ(HistoryFile_BarFormat(hFile), 400u);
+   CHECK_EQ(HistoryFile_Bars(hFile), 1000);
+   CHECK_EQ(string(HistoryFile_Header(hFile)->symbol), string("EURUSD"));
+
+   BarSpan<HistoryBar400> span;
+   CHECK(GetHistoryBars(hFile, span));
+   CHECK_EQ(span.size, 1000u);
+   CHECK_EQ(span[999].time, 1577836800 + 999*60);
+   CHECK_EQ(span[999].ticks, 1000.);
+   CHECK((const void*)span.bars == HistoryFile_Rates(hFile));   // a view into the mapping, not a copy
+
+   BarSpan<HistoryBar401> wrongFormat;
+   CHECK(!GetHistoryBars(hFile, wrongFormat));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+
+   CHECK(HistoryFile_Close(hFile));
+}
+
+
+TEST(HistoryFile_IgnoresTrailingPartialBar) {
+   string filename = TempFilename("EURUSD1-partial.hst");
+   WriteHistoryFile(filename, 401, 10, sizeof(HistoryBar401)-1);
+
+   uint hFile = HistoryFile_Open(filename.c_str());
+   CHECK(hFile != 0);
+   CHECK_EQ(HistoryFile_Bars(hFile), 10);
+
+   BarSpan<HistoryBar401> span;
+   CHECK(GetHistoryBars(hFile, span));
+   CHECK_EQ(span[9].close, 1.1 + 9/100000. + 0.0001);
+   CHECK(HistoryFile_Close(hFile));
+}
+
+
+TEST(HistoryFile_RejectsInvalidFiles) {
+   string filename = TempFilename("invalid.hst");
+   WriteHistoryFile(filename, 402, 1);
+   CHECK_EQ(HistoryFile_Open(filename.c_str()), 0u);
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_FILE_FORMAT);
+
+   FILE* file = fopen(filename.c_str(), "wb");
+   fputs("too short", file);
+   fclose(file);
+   CHECK_EQ(HistoryFile_Open(filename.c_str()), 0u);
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_FILE_FORMAT);
+
+   CHECK_EQ(HistoryFile_Open(TempFilename("missing.hst").c_str()), 0u);
+   CHECK_EQ(LastExpanderError(), ERR_WIN32_ERROR + ERROR_FILE_NOT_FOUND);
+}
+
+
+TEST(HistoryFile_CloseInvalidatesHandle) {
+   string filename = TempFilename("EURUSD1-close.hst");
+   WriteHistoryFile(filename, 401, 1);
+
+   uint hFile = HistoryFile_Open(filename.c_str());
+   CHECK(HistoryFile_Close(hFile));
+   CHECK(!HistoryFile_Close(hFile));
+   CHECK_EQ(LastExpanderError(), ERR_ILLEGAL_STATE);
+   CHECK_EQ(HistoryFile_Bars(hFile), EMPTY);
+   CHECK(!HistoryFile_Close(hFile + 1000));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+}
+
+
+TEST(HistoryWriter_RoundTrip) {
+   string filename = TempFilename("GBPUSD5.hst");
+
+   uint hWriter = HistoryWriter_Open(filename.c_str(), "GBPUSD", 5, 5);
+   CHECK(hWriter != 0);
+   for (uint i=0; i < HISTORY_WRITE_BUFFER + 100; i++) {      // forces an intermediate flush
+      CHECK(HistoryWriter_AddBar(hWriter, 1577836800 + i*300, 1.3, 1.31, 1.29, 1.305, 10));
+   }
+   CHECK(HistoryWriter_UpdateBar(hWriter, 1577836800 + (HISTORY_WRITE_BUFFER+99)*300, 1.32, 5));
+   CHECK(HistoryWriter_Close(hWriter));
+
+   hWriter = HistoryWriter_Open(filename.c_str(), "GBPUSD", 5, 5);   // re-open and append
+   CHECK(HistoryWriter_AddBar(hWriter, 1577836800 + (HISTORY_WRITE_BUFFER+100)*300, 1.4, 1.4, 1.4, 1.4, 1));
+   CHECK(HistoryWriter_Close(hWriter));
+
+   uint hFile = HistoryFile_Open(filename.c_str());
+   BarSpan<HistoryBar401> span;
+   CHECK(GetHistoryBars(hFile, span));
+   CHECK_EQ(span.size, HISTORY_WRITE_BUFFER + 101u);
+   const HistoryBar401 &updated = span[HISTORY_WRITE_BUFFER+99];
+   CHECK_EQ(updated.high, 1.32);
+   CHECK_EQ(updated.close, 1.32);
+   CHECK_EQ(updated.tickVolume, (uint64)15);
+   CHECK_EQ(span[span.size-1].open, 1.4);
+   CHECK(HistoryFile_Close(hFile));
+}
+
+
+static DWORD WINAPI OpenCloseThread(LPVOID param) {
+   const string* filename = (const string*)param;
+   for (int i=0; i < 200; i++) {
+      uint hFile = HistoryFile_Open(filename->c_str());
+      if (!hFile || HistoryFile_Bars(hFile) != 100 || !HistoryFile_Close(hFile)) return(1);
+   }
+   return(0);
+}
+
+
+TEST(HistoryFile_ConcurrentOpenClose) {
+   string filename = TempFilename("EURUSD1-concurrent.hst");
+   WriteHistoryFile(filename, 401, 100);
+
+   HANDLE threads[4];
+   for (int i=0; i < 4; i++) threads[i] = CreateThread(NULL, 0, OpenCloseThread, &filename, 0, NULL);
+   CHECK_EQ(WaitForMultipleObjects(4, threads, TRUE, INFINITE), (DWORD)WAIT_OBJECT_0);
+
+   for (int i=0; i < 4; i++) {
+      DWORD exitCode;
+      CHECK(GetExitCodeThread(threads[i], &exitCode));
+      CHECK_EQ(exitCode, 0u);
+      CloseHandle(threads[i]);
+   }
+   CHECK_EQ(ExpanderErrorCount(), 0);
+}
+
+
+struct CloseRace {
+   uint          hWriter;
+   volatile LONG start;
+   volatile LONG closed;
+};
+
+static DWORD WINAPI CloseWriterThread(LPVOID param) {
+   CloseRace* race = (CloseRace*)param;
+   while (!race->start) {}
+   if (HistoryWriter_Close(race->hWriter)) InterlockedIncrement(&race->closed);
+   return(0);
+}
+
+
+TEST(HistoryWriter_ConcurrentCloseClosesOnce) {
+   string filename = TempFilename("GBPUSD5-close.hst");
+
+   for (int n=0; n < 200; n++) {
+      CloseRace race = { HistoryWriter_Open(filename.c_str(), "GBPUSD", 5, 5), 0, 0 };
+      CHECK(race.hWriter != 0);
+      if (!race.hWriter) return;
+      HistoryWriter_AddBar(race.hWriter, 1577836800 + n*300, 1.3, 1.31, 1.29, 1.305, 10);
+
+      HANDLE threads[4];
+      for (int i=0; i < 4; i++) threads[i] = CreateThread(NULL, 0, CloseWriterThread, &race, 0, NULL);
+      InterlockedExchange(&race.start, 1);
+      WaitForMultipleObjects(4, threads, TRUE, INFINITE);
+      for (int i=0; i < 4; i++) CloseHandle(threads[i]);
+      CHECK_EQ(race.closed, 1);
+   }
+
+   uint hFile = HistoryFile_Open(filename.c_str());            // every close flushed the writer exactly once
+   CHECK_EQ(HistoryFile_Bars(hFile), 200);
+   CHECK(HistoryFile_Close(hFile));
+}
+
+
+BENCHMARK(HistoryWriter_AddBarsVsWritePerBar) {
+   const uint bars = 10000000, batch = 1000;
+   string filename = TempFilename("EURUSD1-bench.hst");
+   std::vector<HistoryBar401> data(batch);
+
+   // baseline: one write per bar, as with MQL FileWriteArray()
+   HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+   CHECK(hFile != INVALID_HANDLE_VALUE);
+   HISTORY_HEADER hh = {};
+   DWORD written;
+   double start = MilliSeconds();
+   WriteFile(hFile, &hh, sizeof(hh), &written, NULL);
+   for (uint i=0; i < bars; i++) {
+      HistoryBar401 bar = {};
+      bar.time = 946684800 + i*60;
+      bar.open = bar.high = bar.low = bar.close = 1.1;
+      bar.tickVolume = 1;
+      WriteFile(hFile, &bar, sizeof(bar), &written, NULL);
+   }
+   CloseHandle(hFile);
+   double naiveTime = MilliSeconds() - start;
+   DeleteFileA(filename.c_str());
+
+   // the history writer, fed in batches
+   start = MilliSeconds();
+   uint hWriter = HistoryWriter_Open(filename.c_str(), "EURUSD", 1, 5);
+   CHECK(hWriter != 0);
+   for (uint i=0; i < bars; i += batch) {
+      for (uint n=0; n < batch; n++) {
+         HistoryBar401 &bar = data[n];
+         bar.time = 946684800 + (i+n)*60;
+         bar.open = bar.high = bar.low = bar.close = 1.1;
+         bar.tickVolume = 1;
+      }
+      HistoryWriter_AddBars(hWriter, &data[0], batch);
+   }
+   CHECK(HistoryWriter_Close(hWriter));
+   double writerTime = MilliSeconds() - start;
+
+   uint hFile2 = HistoryFile_Open(filename.c_str());
+   CHECK_EQ(HistoryFile_Bars(hFile2), (int)bars);
+   HistoryFile_Close(hFile2);
+   DeleteFileA(filename.c_str());
+
+   printf("\n    %u bars: one write per bar %.0f bars/sec, HistoryWriter_AddBars %.0f bars/sec\n", bars, bars/naiveTime*1000, bars/writerTime*1000);
+}
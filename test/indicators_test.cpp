@@ -0,0 +1,361 @@
+/**
+ * Tests of the indicator kernels (src/lib/indicators/) against scalar transcriptions of the MQL reference implementations
+ * "Moving Averages.mq4", "StdDev.mq4", "Bands.mq4", "ATR.mq4" and "RSI.mq4" (terminal build 600+). The references use the
+ * same operations in the same order as the MQL code, so a bit-identical kernel matches them exactly.
+ */
+#include "expander.h"
+#include "lib/indicators/incremental.h"
+#include "lib/indicators/ma.h"
+#include "lib/indicators/rsi.h"
+#include "lib/indicators/volatility.h"
+#include "struct/mt4/HistoryBar401.h"
+#include "test.h"
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+
+/**
+ * Generate a random walk of OHLC prices around 1.1 (a deterministic pseudo-random sequence).
+ */
+struct Prices {
+   vector<double> high, low, close;
+
+   Prices(int size) : high(size), low(size), close(size) {
+      unsigned seed = 12345;
+      double price = 1.1;
+      for (int i=0; i < size; i++) {
+         seed = seed*1103515245 + 12345;
+         price += ((int)(seed >> 16 & 0x7fff) - 16383) / 1e8;
+         seed = seed*1103515245 + 12345;
+         double range = (seed >> 16 & 0x7fff) / 1e7;
+         close[i] = price;
+         high[i]  = price + range;
+         low[i]   = price - range/2;
+      }
+   }
+};
+
+
+// "Moving Averages.mq4": CalculateSimpleMA()
+static vector<double> ReferenceSMA(const vector<double> &price, int period) {
+   int size = price.size(), limit = period, i;
+   vector<double> result(size, 0.);
+   double firstValue = 0;
+   for (i=0; i < limit; i++) firstValue += price[i];
+   firstValue /= period;
+   result[limit-1] = firstValue;
+   for (i=limit; i < size; i++) result[i] = result[i-1] + (price[i]-price[i-period])/period;
+   return(result);
+}
+
+
+// "Moving Averages.mq4": CalculateEMA()
+static vector<double> ReferenceEMA(const vector<double> &price, int period) {
+   int size = price.size();
+   vector<double> result(size);
+   double smoothFactor = 2.0/(1.0+period);
+   result[0] = price[0];
+   for (int i=1; i < size; i++) result[i] = price[i]*smoothFactor + result[i-1]*(1.0-smoothFactor);
+   return(result);
+}
+
+
+// "MovingAverages.mqh": SimpleMA() as used by "StdDev.mq4" and "Bands.mq4"
+static double SimpleMA(int position, int period, const vector<double> &price) {
+   double result = 0;
+   for (int i=0; i < period; i++) result += price[position-i];
+   return(result/period);
+}
+
+
+// "StdDev.mq4": StdDev_Func() with the moving average of SimpleMA()
+static vector<double> ReferenceStdDev(const vector<double> &price, int period, vector<double> &ma) {
+   int size = price.size();
+   vector<double> result(size, 0.);
+   ma.assign(size, 0.);
+   for (int i=period-1; i < size; i++) {
+      ma[i] = SimpleMA(i, period, price);
+      double tmp = 0;
+      for (int n=0; n < period; n++) tmp += pow(price[i-n] - ma[i], 2);
+      result[i] = sqrt(tmp/period);
+   }
+   return(result);
+}
+
+
+// "ATR.mq4"
+static vector<double> ReferenceATR(const Prices &p, int period) {
+   int size = p.close.size(), i;
+   vector<double> tr(size, 0.), atr(size, 0.);
+   for (i=1; i < size; i++) tr[i] = max(p.high[i], p.close[i-1]) - min(p.low[i], p.close[i-1]);
+   double firstValue = 0;
+   for (i=1; i <= period; i++) firstValue += tr[i];
+   atr[period] = firstValue/period;
+   for (i=period+1; i < size; i++) atr[i] = atr[i-1] + (tr[i]-tr[i-period])/period;
+   return(atr);
+}
+
+
+// "RSI.mq4"
+static vector<double> ReferenceRSI(const vector<double> &close, int period) {
+   int size = close.size(), i;
+   vector<double> rsi(size, 0.), pos(size, 0.), neg(size, 0.);
+   double sump = 0, sumn = 0, diff;
+   for (i=1; i <= period; i++) {
+      diff = close[i] - close[i-1];
+      if (diff > 0) sump += diff;
+      else          sumn -= diff;
+   }
+   pos[period] = sump/period;
+   neg[period] = sumn/period;
+   for (i=period; i < size; i++) {
+      if (i > period) {
+         diff = close[i] - close[i-1];
+         pos[i] = (pos[i-1]*(period-1) + (diff>0.0 ? diff:0.0))/period;
+         neg[i] = (neg[i-1]*(period-1) + (diff<0.0 ? -diff:0.0))/period;
+      }
+      if      (neg[i] != 0.0) rsi[i] = 100.0 - 100.0/(1+pos[i]/neg[i]);
+      else if (pos[i] != 0.0) rsi[i] = 100.0;
+      else                    rsi[i] = 50.0;
+   }
+   return(rsi);
+}
+
+
+/**
+ * Number of bars in [from, size) where two series differ in any bit.
+ */
+static int CountDifferences(const double* actual, const vector<double> &expected, int from) {
+   int count = 0;
+   for (int i=from; i < (int)expected.size(); i++) {
+      if (memcmp(&actual[i], &expected[i], sizeof(double))) count++;
+   }
+   return(count);
+}
+
+
+static const int BARS = 100000;
+
+
+TEST(Indicator_SMA_MatchesReference) {
+   Prices p(BARS);
+   int periods[] = { 1, 2, 14, 21, 200 };
+   for (int n=0; n < 5; n++) {
+      vector<double> results(BARS);
+      CHECK(Indicator_SMA(&p.close[0], BARS, periods[n], &results[0]));
+      CHECK_EQ(CountDifferences(&results[0], ReferenceSMA(p.close, periods[n]), periods[n]-1), 0);
+      if (periods[n] > 1) CHECK_EQ(results[periods[n]-2], EMPTY_VALUE);
+   }
+}
+
+
+TEST(Indicator_EMA_MatchesReference) {
+   Prices p(BARS);
+   vector<double> results(BARS);
+   CHECK(Indicator_EMA(&p.close[0], BARS, 21, &results[0]));
+   CHECK_EQ(CountDifferences(&results[0], ReferenceEMA(p.close, 21), 0), 0);
+}
+
+
+TEST(Indicator_ATR_MatchesReference) {
+   Prices p(BARS);
+   int periods[] = { 1, 14, 15, 100 };
+   for (int n=0; n < 4; n++) {
+      vector<double> results(BARS);
+      CHECK(Indicator_ATR(&p.high[0], &p.low[0], &p.close[0], BARS, periods[n], &results[0]));
+      CHECK_EQ(CountDifferences(&results[0], ReferenceATR(p, periods[n]), periods[n]), 0);
+      CHECK_EQ(results[periods[n]-1], EMPTY_VALUE);
+   }
+}
+
+
+TEST(Indicator_RSI_MatchesReference) {
+   Prices p(BARS);
+   vector<double> results(BARS);
+   CHECK(Indicator_RSI(&p.close[0], BARS, 14, &results[0]));
+   CHECK_EQ(CountDifferences(&results[0], ReferenceRSI(p.close, 14), 14), 0);
+   CHECK_EQ(results[13], EMPTY_VALUE);
+}
+
+
+TEST(Indicator_StdDev_WithinErrorBound) {
+   Prices p(BARS);
+   int periods[] = { 2, 20, 21, 200 };
+   for (int n=0; n < 4; n++) {
+      int period = periods[n];
+      vector<double> results(BARS), ma;
+      CHECK(Indicator_StdDev(&p.close[0], BARS, period, &results[0]));
+      vector<double> expected = ReferenceStdDev(p.close, period, ma);
+
+      double maxError = 0;
+      for (int i=period-1; i < BARS; i++) {
+         if (results[i] != expected[i]) maxError = max(maxError, fabs(results[i]-expected[i]) / expected[i]);
+      }
+      CHECK(maxError < period * 1e-16);
+      if (maxError >= period * 1e-16) fprintf(stderr, "    period %d: max. relative error %g\n", period, maxError);
+   }
+}
+
+
+TEST(Indicator_Bands_MatchesReference) {
+   Prices p(BARS);
+   vector<double> ma(BARS), upper(BARS), lower(BARS), refMa;
+   CHECK(Indicator_Bands(&p.close[0], BARS, 20, 2, &ma[0], &upper[0], &lower[0]));
+   vector<double> stdDev = ReferenceStdDev(p.close, 20, refMa);
+   CHECK_EQ(CountDifferences(&ma[0], refMa, 19), 0);      // the middle band is bit-identical
+
+   double maxError = 0;                                        // the bands differ by at most an ULP of the price
+   for (int i=19; i < BARS; i++) {
+      maxError = max(maxError, fabs(upper[i] - (refMa[i] + 2*stdDev[i])) / refMa[i]);
+      maxError = max(maxError, fabs(lower[i] - (refMa[i] - 2*stdDev[i])) / refMa[i]);
+   }
+   CHECK(maxError <= DBL_EPSILON);
+   CHECK_EQ(lower[18], EMPTY_VALUE);
+   CHECK_EQ(ma[18], EMPTY_VALUE);
+}
+
+
+TEST(Indicator_StdDev_FlatSeries) {
+   // the average of a flat window isn't exact either, the deviation follows the reference instead of being 0
+   vector<double> values(1000, 1.23456), results(1000), ma;
+   CHECK(Indicator_StdDev(&values[0], 1000, 20, &results[0]));
+   vector<double> expected = ReferenceStdDev(values, 20, ma);
+   for (int i=19; i < 1000; i++) CHECK_NEAR(results[i], expected[i], expected[i] * 20e-16);
+
+   vector<double> exact(1000, 1.25);                          // an average without rounding error
+   CHECK(Indicator_StdDev(&exact[0], 1000, 20, &results[0]));
+   for (int i=19; i < 1000; i++) CHECK_EQ(results[i], 0.);
+}
+
+
+TEST(Indicator_IncrementalEqualsFull) {
+   Prices p(1000);
+   int period = 14;
+   vector<double> full(1000), partial(1000), tr(1000), tr2(1000);
+   CalculateATR(&p.high[0], &p.low[0], &p.close[0], 0, 1000, period, &tr[0], &full[0]);
+   CalculateATR(&p.high[0], &p.low[0], &p.close[0], 0, 10, period, &tr2[0], &partial[0]);
+   CalculateATR(&p.high[0], &p.low[0], &p.close[0], 10, 501, period, &tr2[0], &partial[0]);
+   CalculateATR(&p.high[0], &p.low[0], &p.close[0], 501, 1000, period, &tr2[0], &partial[0]);
+   CHECK(!memcmp(&full[0], &partial[0], 1000*sizeof(double)));
+
+   vector<double> sma(1000), sma2(1000);
+   CalculateSMA(&p.close[0], 0, 1000, period, &sma[0]);
+   CalculateSMA(&p.close[0], 0, 7, period, &sma2[0]);
+   CalculateSMA(&p.close[0], 7, 998, period, &sma2[0]);
+   CalculateSMA(&p.close[0], 998, 1000, period, &sma2[0]);
+   CHECK(!memcmp(&sma[0], &sma2[0], 1000*sizeof(double)));
+}
+
+
+TEST(Indicator_RejectsInvalidParameters) {
+   double values[10] = {}, results[10];
+   CHECK(!Indicator_SMA(values, 10, 0, results));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+   CHECK(!Indicator_RSI(values, -1, 14, results));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+}
+
+
+/**
+ * Price series of a fake MQL program for the incremental engine: M1 bars with the closes of a random walk.
+ */
+struct Chart {
+   Prices                 prices;
+   vector<HistoryBar401>  rates;
+   EXECUTION_CONTEXT      ec;
+
+   Chart(int size) : prices(size+100), rates(size), ec() {
+      ec.pid = 1;
+      for (int i=0; i < size; i++) SetBar(i, 1577836800 + i*60, prices.close[i]);
+      Publish(-1);
+   }
+
+   void SetBar(int i, time32 time, double close) {
+      HistoryBar401 &bar = rates[i];
+      memset(&bar, 0, sizeof(bar));
+      bar.time = time;
+      bar.open = bar.high = bar.low = bar.close = close;
+      bar.tickVolume = 1;
+   }
+
+   void Publish(int changedBars) {
+      ec.rates       = &rates[0];
+      ec.bars        = rates.size();
+      ec.changedBars = changedBars;
+   }
+
+   // a full calculation over the current closes
+   vector<double> ExpectedEMA(int period) const {
+      vector<double> close(rates.size()), ema(rates.size());
+      for (size_t i=0; i < rates.size(); i++) close[i] = rates[i].close;
+      CalculateEMA(&close[0], 0, close.size(), period, &ema[0]);
+      return(ema);
+   }
+};
+
+
+TEST(Indicator_Update_RollsBackChangedBars) {
+   Chart chart(500);
+   uint hIndicator = Indicator_Create(&chart.ec, IND_EMA, 10, 0);
+   CHECK(hIndicator != 0);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+
+   chart.rates[499].close += 0.001;                             // the forming bar changes and a new bar opens
+   chart.rates.push_back(chart.rates[499]);
+   chart.SetBar(500, chart.rates[499].time + 60, 1.2);
+   chart.Publish(2);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 499);     // restarts at the checkpoint
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+
+   chart.rates[200].close = 1.3;                               // history rewritten in the middle
+   chart.Publish(-1);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+
+   chart.rates[501-1].close = 1.25;                            // a single tick
+   chart.Publish(1);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 500);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+   CHECK(Indicator_Release(hIndicator));
+}
+
+
+TEST(Indicator_Update_ResyncsShiftedRates) {
+   Chart chart(500);
+   uint hIndicator = Indicator_Create(&chart.ec, IND_EMA, 10, 0);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+
+   chart.SetBar(0, chart.rates[0].time - 3600, 1.0);           // the oldest bar was re-synchronized: firstBarTime changes
+   chart.Publish(1);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+
+   chart.rates.erase(chart.rates.begin());                     // the oldest bar dropped off the chart: all bars shift
+   chart.rates.push_back(chart.rates.back());
+   chart.SetBar(499, chart.rates[498].time + 60, chart.prices.close[500]);
+   chart.Publish(1);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+
+   chart.rates.push_back(chart.rates.back());                  // bars were inserted before the checkpoint: lastBarTime moves
+   for (int i=499; i > 300; i--) chart.rates[i] = chart.rates[i-1];
+   chart.SetBar(300, chart.rates[299].time + 30, 1.15);
+   chart.Publish(2);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+
+   chart.rates.resize(400);                                    // fewer bars than calculated
+   chart.Publish(1);
+   CHECK_EQ(Indicator_Update(&chart.ec, hIndicator), 0);
+   CHECK_EQ(CountDifferences(Indicator_Buffer(hIndicator, 0), chart.ExpectedEMA(10), 0), 0);
+   CHECK_EQ(Indicator_Value(hIndicator, 0, 0), chart.ExpectedEMA(10)[399]);
+
+   ReleaseIndicators(chart.ec.pid);                            // a released handle is rejected
+   CHECK(!Indicator_Release(hIndicator));
+   CHECK_EQ(LastExpanderError(), ERR_ILLEGAL_STATE);
+}
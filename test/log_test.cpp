@@ -0,0 +1,153 @@
+/**
+ * Tests of the loglevel filters of the logfile and debug output appenders (src/lib/log.cpp).
+ */
+#include "expander.h"
+#include "lib/executioncontext.h"
+#include "lib/log.h"
+#include "lib/logbuffer.h"
+#include "struct/ExecutionContext.h"
+#include "test.h"
+
+#include <fstream>
+
+
+extern MqlInstanceList g_mqlInstances;
+
+
+/**
+ * Register a loaded program with a master and a main context. A program with a host is loaded by iCustom(), its master
+ * context links the main context of the host like the terminal sets it up.
+ *
+ * @return EXECUTION_CONTEXT* - main context of the program
+ */
+static EXECUTION_CONTEXT* NewProgram(const char* name, int loglevel, int loglevelDebug, int loglevelFile, EXECUTION_CONTEXT* host = NULL) {
+   EXECUTION_CONTEXT* master = new EXECUTION_CONTEXT();
+   EXECUTION_CONTEXT* main   = new EXECUTION_CONTEXT();
+   ContextChain* chain = new ContextChain();
+   chain->push_back(master);
+   chain->push_back(main);
+
+   master->pid              = PushProgram(chain);
+   master->programType      = host ? PT_INDICATOR : PT_EXPERT;
+   master->moduleType       = host ? MT_INDICATOR : MT_EXPERT;
+   strcpy(master->programName, name);
+   strcpy(master->moduleName,  name);
+   strcpy(master->symbol, "EURUSD");
+   master->timeframe        = PERIOD_H1;
+   master->programInitFlags = INIT_BUFFERED_LOG;                   // no logfile, entries are collected in the logbuffer
+   master->superContext     = host;
+   master->loglevel         = loglevel;
+   master->loglevelDebug    = loglevelDebug;
+   master->loglevelFile     = loglevelFile;
+   *main = *master;
+   return(main);
+}
+
+
+static EXECUTION_CONTEXT* Master(const EXECUTION_CONTEXT* ec) {
+   return((*g_mqlInstances[ec->pid])[0]);
+}
+
+
+static uint BufferedEntries(const EXECUTION_CONTEXT* ec) {
+   LOG_BUFFER* buffer = Master(ec)->logBuffer;
+   return(buffer ? LogBuffer_Size(buffer) : 0);
+}
+
+
+/**
+ * Drain a program's logbuffer and return the entries.
+ */
+static string DrainBuffer(const EXECUTION_CONTEXT* ec) {
+   std::string filename = TempFilename("log.log");
+   std::ofstream logger(filename.c_str(), std::ios::binary);
+   CHECK(LogBuffer_Drain(Master(ec)->logBuffer, &logger, FALSE));
+   logger.close();
+
+   std::ifstream file(filename.c_str(), std::ios::binary);
+   return(string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+}
+
+
+TEST(GetLogContext_ResolvesHostOfICustomProgram) {
+   EXECUTION_CONTEXT* expert    = NewProgram("Expert",    LOG_INFO,  LOG_WARN,  LOG_NOTICE);
+   EXECUTION_CONTEXT* indicator = NewProgram("Indicator", LOG_DEBUG, LOG_DEBUG, LOG_DEBUG, expert);
+   CHECK(GetLogContext(expert->pid) == Master(expert));
+   CHECK(GetLogContext(indicator->pid) == Master(expert));
+   CHECK(!GetLogContext(0));
+   CHECK(!GetLogContext(g_mqlInstances.size()));
+
+   // the iCustom() program uses the configuration of its host
+   CHECK(!IsDebugLoglevelActive(indicator->pid, LOG_INFO));
+   CHECK( IsDebugLoglevelActive(indicator->pid, LOG_WARN));
+   CHECK(!IsLogfileLoglevelActive(indicator, LOG_INFO));
+   CHECK( IsLogfileLoglevelActive(indicator, LOG_NOTICE));
+
+   // its messages go to the logbuffer of the host under the name of the host
+   CHECK(!AppendLogMessageA(indicator, 0, "filtered", NO_ERROR, LOG_INFO));
+   CHECK(AppendLogMessageA(indicator, 0, "passed", NO_ERROR, LOG_NOTICE));
+   CHECK(!Master(indicator)->logBuffer);
+   CHECK_EQ(BufferedEntries(expert), 1u);
+   string entries = DrainBuffer(expert);
+   CHECK(entries.find("Expert::passed") != string::npos);
+   CHECK(entries.find("filtered") == string::npos);
+
+   // a super context without a known program falls back to the program's own master
+   EXECUTION_CONTEXT unknownHost = {};
+   unknownHost.pid = g_mqlInstances.size() + 10;
+   EXECUTION_CONTEXT* orphan = NewProgram("Orphan", LOG_DEBUG, LOG_DEBUG, LOG_DEBUG, &unknownHost);
+   CHECK(GetLogContext(orphan->pid) == Master(orphan));
+   CHECK(IsDebugLoglevelActive(orphan->pid, LOG_DEBUG));
+}
+
+
+TEST(Loglevel_OffIsNeverActive) {
+   EXECUTION_CONTEXT* expert = NewProgram("Expert", LOG_DEBUG, LOG_DEBUG, LOG_DEBUG);
+   CHECK(!IsDebugLoglevelActive(expert->pid, LOG_OFF));
+   CHECK(!IsLogfileLoglevelActive(expert, LOG_OFF));
+   CHECK(!AppendLogMessageA(expert, 0, "off", NO_ERROR, LOG_OFF));
+   CHECK_EQ(BufferedEntries(expert), 0u);
+
+   // switched off appenders discard all levels, also warnings and errors
+   EXECUTION_CONTEXT* silent = NewProgram("Silent", LOG_DEBUG, LOG_OFF, LOG_OFF);
+   int levels[] = { LOG_DEBUG, LOG_INFO, LOG_NOTICE, LOG_WARN, LOG_ERROR, LOG_FATAL };
+   for (uint i=0; i < countof(levels); i++) {
+      CHECK(!IsDebugLoglevelActive(silent->pid, levels[i]));
+      CHECK(!IsLogfileLoglevelActive(silent, levels[i]));
+      CHECK(!AppendLogMessageA(silent, 0, "message", NO_ERROR, levels[i]));
+   }
+   CHECK_EQ(BufferedEntries(silent), 0u);
+
+   // messages of threads not executing a program always pass the debug output filter
+   CHECK(IsDebugLoglevelActive(0, LOG_DEBUG));
+}
+
+
+TEST(Loglevel_MainLevelLimitsAppenderLevels) {
+   int levels[] = { LOG_DEBUG, LOG_INFO, LOG_NOTICE, LOG_WARN, LOG_ERROR, LOG_FATAL };
+   uint count = countof(levels);
+
+   for (uint m=0; m < count; m++) {
+      for (uint f=0; f < count; f++) {
+         int loglevel = levels[m], loglevelFile = levels[f], loglevelDebug = levels[count-1-f];
+         EXECUTION_CONTEXT* expert = NewProgram("Expert", loglevel, loglevelDebug, loglevelFile);
+
+         uint expected = 0;
+         for (uint i=0; i < count; i++) {
+            BOOL logfile = (levels[i] >= loglevel && levels[i] >= loglevelFile);
+            BOOL debug   = (levels[i] >= loglevel && levels[i] >= loglevelDebug);
+            CHECK_EQ(IsLogfileLoglevelActive(expert, levels[i]), logfile);
+            CHECK_EQ(IsDebugLoglevelActive(expert->pid, levels[i]), debug);
+            CHECK_EQ(AppendLogMessageA(expert, 0, "message", NO_ERROR, levels[i]), logfile);
+            expected += logfile;
+         }
+         CHECK_EQ(BufferedEntries(expert), expected);
+      }
+   }
+
+   // without a logfile and a logbuffer nothing is active
+   EXECUTION_CONTEXT* expert = NewProgram("Expert", LOG_DEBUG, LOG_DEBUG, LOG_DEBUG);
+   Master(expert)->programInitFlags = 0;
+   CHECK(!IsLogfileLoglevelActive(expert, LOG_ERROR));
+   CHECK(!AppendLogMessageA(expert, 0, "message", NO_ERROR, LOG_ERROR));
+}
@@ -0,0 +1,97 @@
+/**
+ * Tests of the log buffer (src/lib/logbuffer.cpp).
+ */
+#include "expander.h"
+#include "lib/logbuffer.h"
+#include "struct/BinaryLog.h"
+#include "test.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+
+/**
+ * Fill a log buffer with entries of varying length. Some entries span the boundaries of the memory chunks.
+ */
+static std::vector<string> FillBuffer(LOG_BUFFER* buffer, uint count) {
+   std::vector<string> entries;
+   for (uint i=0; i < count; i++) {
+      std::ostringstream ss;
+      ss << "entry " << i << " " << string(i % 300, 'x');
+      entries.push_back(ss.str());
+      CHECK(LogBuffer_Append(buffer, entries.back().data(), entries.back().size()));
+   }
+   CHECK_EQ(LogBuffer_Size(buffer), count);
+   return(entries);
+}
+
+
+/**
+ * Drain a log buffer to a new logfile and return the file content.
+ */
+static string DrainToFile(LOG_BUFFER* buffer, const char* name, BOOL binary) {
+   std::string filename = TempFilename(name);
+   std::ofstream logger(filename.c_str(), std::ios::binary);
+   CHECK(LogBuffer_Drain(buffer, &logger, binary));
+   CHECK_EQ(LogBuffer_Size(buffer), 0u);
+   logger.close();
+
+   std::ifstream file(filename.c_str(), std::ios::binary);
+   return(string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+}
+
+
+TEST(LogBuffer_DrainsTextEntries) {
+   for (int spill=0; spill < 2; spill++) {
+      CHECK(LogBuffer_Configure(spill ? 1000 : LOG_BUFFER_MAX_MEMORY));    // spill to the temp file after 1000 bytes
+      LOG_BUFFER* buffer = LogBuffer_Create();
+      std::vector<string> entries = FillBuffer(buffer, 1000);
+      CHECK_EQ(buffer->hTempFile != NULL, spill != 0);
+
+      string expected;
+      for (uint i=0; i < entries.size(); i++) expected.append(entries[i]).append(NL);
+      CHECK(DrainToFile(buffer, "logbuffer.log", FALSE) == expected);
+      LogBuffer_Release(buffer);
+   }
+   LogBuffer_Configure(LOG_BUFFER_MAX_MEMORY);
+}
+
+
+TEST(LogBuffer_DrainsOneBinaryRecordPerEntry) {
+   for (int spill=0; spill < 2; spill++) {
+      CHECK(LogBuffer_Configure(spill ? 100000 : LOG_BUFFER_MAX_MEMORY));  // entries span chunks and the temp file
+      LOG_BUFFER* buffer = LogBuffer_Create();
+      std::vector<string> entries = FillBuffer(buffer, 1000);
+      CHECK(buffer->chunks.size() > 1);
+
+      string data = DrainToFile(buffer, "logbuffer.blog", TRUE);
+      uint pos = 0, n = 0;
+      while (pos + sizeof(BLOG_TEXT) <= data.size()) {
+         BLOG_TEXT record = *(BLOG_TEXT*)&data[pos];
+         pos += sizeof(BLOG_TEXT);
+         if (record.type != BLOG_RECORD_TEXT || n >= entries.size() || data.compare(pos, record.length, entries[n])) break;
+         pos += record.length;
+         n++;
+      }
+      CHECK_EQ(n, entries.size());
+      CHECK_EQ(pos, data.size());
+      LogBuffer_Release(buffer);
+   }
+   LogBuffer_Configure(LOG_BUFFER_MAX_MEMORY);
+}
+
+
+TEST(LogBuffer_KeepsEntriesIfLogfileNotOpen) {
+   LOG_BUFFER* buffer = LogBuffer_Create();
+   FillBuffer(buffer, 10);
+
+   std::ofstream logger;                                       // not open
+   CHECK(!LogBuffer_Drain(buffer, &logger, FALSE));
+   CHECK_EQ(LastExpanderError(), ERR_ILLEGAL_STATE);
+   CHECK_EQ(LogBuffer_Size(buffer), 10u);
+   CHECK(!LogBuffer_Drain(buffer, NULL, FALSE));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+   CHECK_EQ(LogBuffer_Size(buffer), 10u);
+   LogBuffer_Release(buffer);
+}
@@ -0,0 +1,189 @@
+/**
+ * Tests of the asynchronous log writer (src/lib/logwriter.cpp).
+ */
+#include "expander.h"
+#include "lib/logwriter.h"
+#include "test.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+
+/**
+ * Read the lines of a logfile.
+ */
+static std::vector<std::string> ReadLines(const std::string &filename) {
+   std::ifstream file(filename.c_str());
+   std::vector<std::string> lines;
+   std::string line;
+   while (std::getline(file, line)) lines.push_back(line);
+   return(lines);
+}
+
+
+TEST(LogWriter_SynchronousModeWritesImmediately) {
+   std::string filename = TempFilename("logwriter-sync.log");
+   std::ofstream logger(filename.c_str());
+
+   CHECK(LogWriter_Configure(60000, LOG_RING_SIZE));
+   CHECK(LogWriter_Append(&logger, "queued 0", 8));
+   CHECK(LogWriter_Append(&logger, "queued 1", 8));
+   CHECK(LogWriter_Configure(0, 1));                           // writes the pending entries
+   CHECK_EQ(ReadLines(filename).size(), 2u);
+
+   char text[32];
+   for (int i=0; i < 20; i++) {
+      int length = sprintf(text, "entry %d", i);
+      CHECK(LogWriter_Append(&logger, text, length));
+      std::vector<std::string> lines = ReadLines(filename);    // no flush or lock: the entry must be in the file already
+      CHECK_EQ(lines.size(), (uint)i+3);
+      CHECK(!lines.empty() && lines.back() == text);
+   }
+   LogWriter_Flush();
+   logger.close();
+   CHECK(ReadLines(filename)[0] == "queued 0");
+   CHECK(ReadLines(filename)[1] == "queued 1");
+   CHECK(LogWriter_Configure(LOG_FLUSH_INTERVAL, LOG_FLUSH_SIZE));
+}
+
+
+// holds the log writer lock for a while, so the writer thread can't drain the queue
+struct LockHolder {
+   HANDLE hLocked;
+   DWORD  milliseconds;
+};
+
+
+static DWORD WINAPI HoldLogWriterLock(LPVOID arg) {
+   LockHolder* holder = (LockHolder*)arg;
+   LogWriter_Lock();
+   SetEvent(holder->hLocked);
+   Sleep(holder->milliseconds);
+   LogWriter_Unlock();
+   return(0);
+}
+
+
+TEST(LogWriter_QueueFullFallbackKeepsOrder) {
+   std::string filename = TempFilename("logwriter-full.log");
+   std::ofstream logger(filename.c_str());
+   CHECK(LogWriter_Configure(60000, LOG_RING_SIZE));
+
+   LockHolder holder = { CreateEventA(NULL, TRUE, FALSE, NULL), 200 };
+   HANDLE hThread = CreateThread(NULL, 0, HoldLogWriterLock, &holder, 0, NULL);
+   WaitForSingleObject(holder.hLocked, INFINITE);
+
+   // fill the queue, the next entry has to wait for the lock and is written synchronously after the queued ones
+   const int count = LOG_RING_SIZE + 100;
+   char text[LOG_ENTRY_SIZE + 100];
+   double start = MilliSeconds(), fallbackTime = 0;
+   for (int i=0; i < count; i++) {
+      int length = sprintf(text, "entry %d", i);
+      if (i % 1000 == 999) {                                   // too long to be queued
+         memset(text + length, 'x', LOG_ENTRY_SIZE);
+         length += LOG_ENTRY_SIZE;
+         text[length] = '\0';
+      }
+      CHECK(LogWriter_Append(&logger, text, length));
+      if (i == LOG_RING_SIZE) fallbackTime = MilliSeconds() - start;
+   }
+   CHECK(fallbackTime >= holder.milliseconds/2);               // the fallback waited for the lock
+   WaitForSingleObject(hThread, INFINITE);
+   CloseHandle(hThread);
+   CloseHandle(holder.hLocked);
+   LogWriter_Flush();
+   logger.close();
+
+   std::vector<std::string> lines = ReadLines(filename);
+   CHECK_EQ(lines.size(), (uint)count);
+   int n = 0;
+   for (; n < (int)lines.size(); n++) {
+      int length = sprintf(text, "entry %d", n);
+      if (lines[n].compare(0, length, text) || (lines[n].size() > (uint)length && n % 1000 != 999)) break;
+   }
+   CHECK_EQ(n, count);
+   CHECK(LogWriter_Configure(LOG_FLUSH_INTERVAL, LOG_FLUSH_SIZE));
+}
+
+
+TEST(LogWriter_ReleaseWritesPendingEntries) {
+   std::string filename = TempFilename("logwriter.log");
+   std::ofstream* logger = new std::ofstream(filename.c_str());
+
+   CHECK(LogWriter_Configure(60000, LOG_RING_SIZE));           // entries stay queued
+   char text[32];
+   for (int i=0; i < 50; i++) {
+      int length = sprintf(text, "entry %d", i);
+      CHECK(LogWriter_Append(logger, text, length));
+   }
+   CHECK(LogWriter_Configure(0, 1));                           // synchronous writing: the writer thread sleeps without timeout
+   for (int i=50; i < 100; i++) {
+      int length = sprintf(text, "entry %d", i);
+      CHECK(LogWriter_Append(logger, text, length));
+   }
+   CHECK(LogWriter_Configure(60000, LOG_RING_SIZE));
+   for (int i=100; i < 150; i++) {
+      int length = sprintf(text, "entry %d", i);
+      CHECK(LogWriter_Append(logger, text, length));
+   }
+
+   double start = MilliSeconds();
+   ReleaseLogWriter();                                         // wakes the writer thread instead of waiting for the interval
+   CHECK(MilliSeconds()-start < LOG_STOP_TIMEOUT);
+   logger->close();
+   delete logger;
+
+   std::ifstream file(filename.c_str());
+   std::string line;
+   int n = 0;
+   while (std::getline(file, line)) {
+      sprintf(text, "entry %d", n);
+      if (line != text) break;
+      n++;
+   }
+   CHECK_EQ(n, 150);
+}
+
+
+BENCHMARK(LogWriter_AppendVsWritePerMessage) {
+   const int count = 1000000;
+   char text[128];
+   std::vector<double> latencies(count);
+
+   std::string filename = TempFilename("bench-direct.log");
+   std::ofstream direct(filename.c_str());
+   double start = MilliSeconds();
+   for (int i=0; i < count; i++) {
+      double t = MilliSeconds();
+      int length = sprintf(text, "2020-01-01 00:00:00.000  INFO   EURUSD,H1  MyExpert::onTick()  message %d", i);
+      direct.write(text, length);
+      direct << std::endl;
+      latencies[i] = MilliSeconds() - t;
+   }
+   double directTime = MilliSeconds() - start;
+   direct.close();
+   std::sort(latencies.begin(), latencies.end());
+   double directP50 = latencies[count/2], directP99 = latencies[count*99/100], directMax = latencies[count-1];
+
+   filename = TempFilename("bench-writer.log");
+   std::ofstream logger(filename.c_str());
+   CHECK(LogWriter_Configure(LOG_FLUSH_INTERVAL, LOG_FLUSH_SIZE));
+   start = MilliSeconds();
+   for (int i=0; i < count; i++) {
+      double t = MilliSeconds();
+      int length = sprintf(text, "2020-01-01 00:00:00.000  INFO   EURUSD,H1  MyExpert::onTick()  message %d", i);
+      LogWriter_Append(&logger, text, length);
+      latencies[i] = MilliSeconds() - t;
+   }
+   double callerTime = MilliSeconds() - start;
+   LogWriter_Flush();
+   double writerTime = MilliSeconds() - start;
+   logger.close();
+   std::sort(latencies.begin(), latencies.end());
+
+   printf("\n    %d messages: write+endl %.1f ms (%.0f msg/s), LogWriter_Append %.1f ms in the caller, %.1f ms written (%.0f msg/s)\n",
+          count, directTime, count/directTime*1000, callerTime, writerTime, count/writerTime*1000);
+   printf("    caller latency p50/p99/max: write+endl %.2f/%.2f/%.1f us, LogWriter_Append %.2f/%.2f/%.1f us\n",
+          directP50*1000, directP99*1000, directMax*1000, latencies[count/2]*1000, latencies[count*99/100]*1000, latencies[count-1]*1000);
+}
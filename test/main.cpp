@@ -0,0 +1,103 @@
+/**
+ * Test runner.
+ *
+ *   test [--bench] [name ...]
+ */
+#include "test.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+
+struct TestCase {
+   const char*  name;
+   TestFunction function;
+   bool         benchmark;
+};
+
+static std::vector<TestCase>* g_tests;             // registered tests (allocated on first use, static initialization order)
+static std::string            g_tempDir;           // temporary directory of the current run
+static int                    g_failures;          // number of failed checks of the current test
+
+
+TestRegistrar::TestRegistrar(const char* name, TestFunction function, bool benchmark) {
+   if (!g_tests) g_tests = new std::vector<TestCase>();
+   TestCase test = { name, function, benchmark };
+   g_tests->push_back(test);
+}
+
+
+void TestFailed(const char* file, int line, const char* expression, const std::string &details) {
+   fprintf(stderr, "    %s:%d: CHECK(%s) failed", file, line, expression);
+   if (!details.empty()) fprintf(stderr, ": %s", details.c_str());
+   fputc('\n', stderr);
+   g_failures++;
+}
+
+
+std::string TempFilename(const char* name) {
+   return(g_tempDir + "/" + name);
+}
+
+
+double MilliSeconds() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return(ts.tv_sec*1000. + ts.tv_nsec/1000000.);
+}
+
+
+/**
+ * Whether a test is selected by the command line.
+ */
+static bool IsSelected(const TestCase &test, const std::vector<const char*> &filters, bool benchmarks) {
+   if (test.benchmark != benchmarks) return(false);
+   if (filters.empty()) return(true);
+   for (size_t i=0; i < filters.size(); i++) {
+      if (strstr(test.name, filters[i])) return(true);
+   }
+   return(false);
+}
+
+
+int main(int argc, char** argv) {
+   bool benchmarks = false;
+   std::vector<const char*> filters;
+   for (int i=1; i < argc; i++) {
+      if (!strcmp(argv[i], "--bench")) benchmarks = true;
+      else                             filters.push_back(argv[i]);
+   }
+
+   char tempDir[] = "/tmp/mt4expander-test-XXXXXX";
+   if (!mkdtemp(tempDir)) {
+      perror("mkdtemp");
+      return(2);
+   }
+   g_tempDir = tempDir;
+
+   int run = 0, failed = 0;
+   for (size_t i=0; g_tests && i < g_tests->size(); i++) {
+      const TestCase &test = (*g_tests)[i];
+      if (!IsSelected(test, filters, benchmarks)) continue;
+
+      g_failures = 0;
+      ResetExpanderErrors();
+      printf("%-50s", test.name);
+      fflush(stdout);
+      double start = MilliSeconds();
+      test.function();
+      printf("%s (%.0f ms)\n", g_failures ? "FAILED":"ok", MilliSeconds()-start);
+      run++;
+      if (g_failures) failed++;
+   }
+
+   std::string cleanup = "rm -rf '" + g_tempDir + "'";
+   if (system(cleanup.c_str())) {}
+
+   printf("\n%d %s run, %d failed\n", run, benchmarks ? "benchmarks":"tests", failed);
+   return(failed ? 1 : 0);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+/**
+ * Force-included into every translation unit of the Linux build (see "Makefile").
+ *
+ * The MT4 struct headers change the packing to 1 and restore it afterwards. Should one of them leave the packing changed,
+ * the MSVC headers protect their own classes with "#pragma pack(push, _CRT_PACKING)", libstdc++ doesn't. Included after
+ * such a header, library classes would get a different layout in different translation units. Including the library
+ * headers used by the Expander and the tests up front gives them the default packing everywhere.
+ */
+#ifdef __cplusplus
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#endif
@@ -0,0 +1,296 @@
+/**
+ * Replacements for the Expander functions used by the modules under test whose own modules depend on the terminal or the
+ * DLL environment (logging, execution context, terminal information). Errors are recorded for assertions instead of being
+ * logged. Set the environment variable TEST_VERBOSE to print them.
+ */
+#include "expander.h"
+#include "lib/conversion.h"
+#include "lib/datetime.h"
+#include "lib/helper.h"
+#include "lib/indicators/incremental.h"
+#include "lib/logbuffer.h"
+#include "lib/logwriter.h"
+#include "lib/string.h"
+#include "lib/terminal.h"
+#include "lib/tester.h"
+#include "lib/win32.h"
+#include "struct/ExecutionContext.h"
+#include "test.h"
+
+#include <sys/stat.h>
+
+
+extern CRITICAL_SECTION g_expanderMutex;           // mutex for Expander-wide locking (see executioncontext.cpp)
+extern DWORD            g_threadSlotTls;           // TLS index holding a thread's registry slot (see executioncontext.cpp)
+
+static int g_lastError;                            // last error passed to error() or warn()
+static int g_errorCount;                           // number of errors passed to error() or warn()
+
+
+/**
+ * Initialize the Expander-wide mutex and the thread registry before any test runs (onProcessAttach() in the DLL).
+ */
+static struct ProcessAttach {
+   ProcessAttach() {
+      InitializeCriticalSection(&g_expanderMutex);
+      g_threadSlotTls = TlsAlloc();
+   }
+} processAttach;
+
+
+static void Log(const char* level, const char* funcName, int error, const char* message, va_list args) {
+   if (!getenv("TEST_VERBOSE")) return;
+   fprintf(stderr, "      %s  %s()  ", level, funcName);
+   vfprintf(stderr, message, args);
+   if (error) fprintf(stderr, "  [%d]", error);
+   fputc('\n', stderr);
+}
+
+
+int LastExpanderError() {
+   return(g_lastError);
+}
+
+
+int ExpanderErrorCount() {
+   return(g_errorCount);
+}
+
+
+void ResetExpanderErrors() {
+   g_lastError = g_errorCount = 0;
+}
+
+
+int __cdecl _debug(const char* fileName, const char* funcName, uint line, const char* message, ...) {
+   va_list args; va_start(args, message); Log("DEBUG", funcName, NO_ERROR, message, args); va_end(args);
+   return(NO_ERROR);
+}
+
+
+int __cdecl _debug(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
+   va_list args; va_start(args, message); Log("DEBUG", funcName, error, message, args); va_end(args);
+   return(error);
+}
+
+
+int __cdecl _warn(const char* fileName, const char* funcName, uint line, const char* message, ...) {
+   va_list args; va_start(args, message); Log("WARN", funcName, NO_ERROR, message, args); va_end(args);
+   return(NO_ERROR);
+}
+
+
+int __cdecl _warn(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
+   va_list args; va_start(args, message); Log("WARN", funcName, error, message, args); va_end(args);
+   if (error) {
+      g_lastError = error;
+      g_errorCount++;
+   }
+   return(error);
+}
+
+
+int __cdecl _error(const char* fileName, const char* funcName, uint line, int error, const char* message, ...) {
+   if (!error) return(NO_ERROR);
+   va_list args; va_start(args, message); Log("ERROR", funcName, error, message, args); va_end(args);
+   g_lastError = error;
+   g_errorCount++;
+   return(error);
+}
+
+
+/**
+ * The tests emulate the latest terminal build.
+ */
+uint WINAPI GetTerminalBuild() {
+   return(1420);
+}
+
+
+/**
+ * The terminal's data directory is a directory in the test's temporary directory.
+ */
+const char* WINAPI GetTerminalDataPathA() {
+   static string path = TempFilename("terminal");
+   return(path.c_str());
+}
+
+
+
+
+/**
+ * String helpers. "lib/string.cpp" needs the MD5 and code page functions of the Win32 API.
+ */
+BOOL WINAPI StrCompare(const char* s1, const char* s2) {
+   if (s1 == s2)   return(TRUE);
+   if (!s1 || !s2) return(FALSE);
+   return(!strcmp(s1, s2));
+}
+
+
+BOOL WINAPI StrCompare(const wchar* s1, const wchar* s2) {
+   if (s1 == s2)   return(TRUE);
+   if (!s1 || !s2) return(FALSE);
+   return(!wcscmp(s1, s2));
+}
+
+
+BOOL WINAPI StrEndsWithI(const char* str, const char* suffix) {
+   size_t strLen = strlen(str), suffixLen = strlen(suffix);
+   return(suffixLen <= strLen && !strcasecmp(str + strLen - suffixLen, suffix));
+}
+
+
+BOOL WINAPI StrEndsWith(const wchar* str, const wchar* suffix) {
+   size_t strLen = wcslen(str), suffixLen = wcslen(suffix);
+   return(suffixLen <= strLen && !wcscmp(str + strLen - suffixLen, suffix));
+}
+
+
+string WINAPI strLeftTo(const string &subject, const string &limiter, int count) {
+   size_t pos = subject.find(limiter);
+   return(pos == string::npos ? subject : subject.substr(0, pos));
+}
+
+
+string& WINAPI strim(string &str) {
+   size_t start = str.find_first_not_of(" \t\r\n\v\f"), end = str.find_last_not_of(" \t\r\n\v\f");
+   if (start == string::npos) str.clear();
+   else                       str = str.substr(start, end-start+1);
+   return(str);
+}
+
+
+wchar* WINAPI wstrim(wchar* str) {
+   wchar* start = str;
+   while (iswspace(*start)) start++;
+   size_t len = wcslen(start);
+   while (len && iswspace(start[len-1])) len--;
+   memmove(str, start, len * sizeof(wchar));
+   str[len] = L'\0';
+   return(str);
+}
+
+
+wchar* WINAPI strToLower(wchar* str) {
+   for (wchar* c=str; c && *c; c++) *c = towlower(*c);
+   return(str);
+}
+
+
+wchar* WINAPI ansiToUtf16(const char* str) {
+   size_t len = strlen(str);
+   wchar* result = (wchar*)malloc((len+1) * sizeof(wchar));
+   for (size_t i=0; i <= len; i++) result[i] = (uchar)str[i];  // the tests use ASCII only
+   return(result);
+}
+
+
+string& WINAPI strReplace(string &subject, const string &search, const string &replace, size_t count/*= INT_MAX*/) {
+   if (search.empty() || search == replace) return(subject);
+   size_t replacements = 0, pos = 0;
+   while (replacements < count && (pos = subject.find(search, pos)) != string::npos) {
+      subject.replace(pos, search.length(), replace);
+      pos += replace.length();
+      replacements++;
+   }
+   return(subject);
+}
+
+
+BOOL WINAPI MemCompare(const void* a, const void* b, uint size) {
+   return(!memcmp(a, b, size));
+}
+
+
+char* __cdecl asformat(const char* format, ...) {
+   va_list args;
+   va_start(args, format);
+   int size = _vscprintf(format, args) + 1;
+   char* buffer = (char*)malloc(size);
+   va_end(args);
+   va_start(args, format);
+   vsnprintf(buffer, size, format, args);
+   va_end(args);
+   return(buffer);                                  // like the original the string is never released
+}
+
+
+char* WINAPI DoubleQuoteStr(const char* value) {
+   return(value ? asformat("\"%s\"", value) : strdup("(null)"));
+}
+
+
+/**
+ * File helpers used by the logfile appender. "lib/file.cpp" needs the reparse point functions of the Win32 API.
+ */
+BOOL WINAPI IsFileA(const char* path, DWORD mode) {
+   struct stat st;
+   return(path && !stat(path, &st) && S_ISREG(st.st_mode));
+}
+
+
+int WINAPI CreateDirectoryA(const char* path, DWORD flags) {
+   string dir(path);
+   for (size_t pos=1; pos <= dir.size(); pos++) {               // create the parent directories first (MODE_MKPARENT)
+      if (pos < dir.size() && dir[pos] != '/') continue;
+      string parent = dir.substr(0, pos);
+      if (mkdir(parent.c_str(), 0755) && errno != EEXIST) return(error(ERR_WIN32_ERROR, "cannot create directory \"%s\" (%s)", parent.c_str(), strerror(errno)));
+   }
+   return(NO_ERROR);
+}
+
+
+/**
+ * Descriptions of constants, used in log messages only. "lib/conversion.cpp" needs the MCI error codes.
+ */
+const char* WINAPI BarModelDescription(int id)                   { return(asformat("BarModel %d", id)); }
+const char* WINAPI BoolToStr(BOOL value)                         { return(value ? "TRUE" : "FALSE"); }
+const char* WINAPI CoreFunctionToStr(CoreFunction func)          { return("CoreFunction"); }
+      char* WINAPI DeinitFlagsToStr(DWORD flags)                 { return(asformat("%d", flags)); }
+const char* WINAPI ErrorToStrA(int error)                        { return("error"); }
+      char* WINAPI InitFlagsToStr(DWORD flags)                   { return(asformat("%d", flags)); }
+const char* WINAPI IndicatorListToStr(const IndicatorList &list) { return("IndicatorList"); }
+const char* WINAPI InitReasonToStr(InitializeReason reason)      { return(asformat("InitializeReason %d", reason)); }
+const char* WINAPI ModuleTypeToStr(ModuleType type)              { return(asformat("ModuleType %d", type)); }
+const char* WINAPI PeriodDescriptionA(int period)                { return(asformat("%d", period)); }
+const char* WINAPI ProgramTypeToStr(ProgramType type)            { return(asformat("ProgramType %d", type)); }
+const char* WINAPI UninitReasonToStr(UninitializeReason reason)  { return(asformat("UninitializeReason %d", reason)); }
+
+
+/**
+ * Loglevel descriptions are part of the debug output compared by the tests.
+ */
+const char* WINAPI LoglevelDescriptionA(int level, BOOL upper) {
+   switch (level) {
+      case LOG_DEBUG:  return(upper ? "DEBUG"  : "debug" );
+      case LOG_INFO:   return(upper ? "INFO"   : "info"  );
+      case LOG_NOTICE: return(upper ? "NOTICE" : "notice");
+      case LOG_WARN:   return(upper ? "WARN"   : "warn"  );
+      case LOG_ERROR:  return(upper ? "ERROR"  : "error" );
+      case LOG_FATAL:  return(upper ? "FATAL"  : "fatal" );
+      case LOG_OFF:    return(upper ? "OFF"    : "off"   );
+   }
+   return("(null)");
+}
+
+
+/**
+ * The test runner has no terminal windows. Its main thread acts as the UI thread, the tests don't log to files.
+ */
+static DWORD g_uiThreadId = GetCurrentThreadId();  // the runner's main thread (static initialization)
+
+BOOL   WINAPI IsUiThread(DWORD threadId)                                { return((threadId ? threadId : GetCurrentThreadId()) == g_uiThreadId); }
+HWND   WINAPI GetTerminalMainWindow()                                   { return(NULL); }
+HWND   WINAPI GetTerminalMdiWindow()                                    { return(NULL); }
+HWND   WINAPI FindInputDialogA(ProgramType programType, const char* name) { return(NULL); }
+DWORD  WINAPI GetDebugOptions()                                         { return(0); }
+int    WINAPI EnumChildWindowsToDebug(HWND hWnd, BOOL recursive)        { return(0); }
+string WINAPI getInternalWindowTextA(HWND hWnd)                         { return(string()); }
+wstring WINAPI getInternalWindowTextW(HWND hWnd)                        { return(wstring()); }
+wstring WINAPI getClassNameW(HWND hWnd)                                 { return(wstring()); }
+wchar* WINAPI GetWindowTextW(HWND hWnd)                                 { return(NULL); }
+string WINAPI MakeChartTitleA(const string &symbol, uint timeframe, bool custom) { return(symbol); }
+HANDLE WINAPI GetWindowPropertyA(HWND hWnd, const char* name)           { return(NULL); }
+BOOL   WINAPI SetWindowPropertyA(HWND hWnd, const char* name, HANDLE value) { return(FALSE); }
+
@@ -0,0 +1,222 @@
+/**
+ * Tests of the symbol files (src/lib/symbols.cpp).
+ */
+#include "expander.h"
+#include "lib/symbols.h"
+#include "test.h"
+
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+
+/**
+ * Create a symbol with the specified name and id.
+ */
+static SYMBOL NewSymbol(const char* name, uint id) {
+   SYMBOL symbol = {};
+   strcpy(symbol.name, name);
+   symbol.id     = id;
+   symbol.digits = 5;
+   return(symbol);
+}
+
+
+/**
+ * Write a "symbols.raw" file.
+ */
+static void WriteSymbols(const std::string &filename, const std::vector<SYMBOL> &symbols) {
+   FILE* file = fopen(filename.c_str(), "wb");
+   if (!symbols.empty()) fwrite(&symbols[0], sizeof(SYMBOL), symbols.size(), file);
+   fclose(file);
+}
+
+
+TEST(SymbolTable_IsASnapshot) {
+   std::string filename = TempFilename("symbols.raw");
+   std::vector<SYMBOL> symbols;
+   for (uint i=0; i < 100; i++) {
+      char name[12];
+      sprintf(name, "SYM%u", i);
+      symbols.push_back(NewSymbol(name, i+1));
+   }
+   WriteSymbols(filename, symbols);
+
+   uint hTable = SymbolTable_Open(filename.c_str());
+   CHECK(hTable != 0);
+   if (!hTable) return;
+   CHECK_EQ(SymbolTable_Count(hTable), 100);
+   const SYMBOL* symbol = SymbolTable_FindByName(hTable, "SYM42");
+   CHECK(symbol && symbol->id == 43);
+   CHECK(SymbolTable_FindById(hTable, 100) == SymbolTable_Symbols(hTable) + 99);
+   CHECK(!SymbolTable_FindByName(hTable, "SYM100"));
+
+   symbols[42].id = 1000;                                      // rewrite the file in place while the table is open
+   WriteSymbols(filename, symbols);
+   CHECK(symbol->id == 43);
+   CHECK(!SymbolTable_FindById(hTable, 1000));
+
+   std::string replacement = TempFilename("symbols.new");     // replace the file while the table is open
+   WriteSymbols(replacement, std::vector<SYMBOL>(1, NewSymbol("EURUSD", 1)));
+   CHECK(MoveFileExA(replacement.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING));
+   CHECK_EQ(SymbolTable_Count(hTable), 100);
+   CHECK(SymbolTable_Close(hTable));
+
+   hTable = SymbolTable_Open(filename.c_str());                // re-opening shows the changes
+   CHECK_EQ(SymbolTable_Count(hTable), 1);
+   CHECK(SymbolTable_FindByName(hTable, "EURUSD") != NULL);
+   CHECK(SymbolTable_Close(hTable));
+   CHECK(!SymbolTable_Close(hTable));
+   CHECK_EQ(LastExpanderError(), ERR_ILLEGAL_STATE);
+
+   CHECK(!SymbolTable_Open(TempFilename("missing.raw").c_str()));
+   CHECK_EQ(LastExpanderError(), ERR_FILE_NOT_FOUND);
+}
+
+
+/**
+ * Read a whole file.
+ */
+static std::string ReadFile(const std::string &filename) {
+   std::ifstream file(filename.c_str(), std::ios::binary);
+   std::ostringstream ss;
+   ss << file.rdbuf();
+   return(ss.str());
+}
+
+
+TEST(SymbolTransaction_RejectsInvalidBatchAsAWhole) {
+   std::string dir = TempFilename("batch/");
+   mkdir(dir.c_str(), 0755);
+
+   uint hTx = SymbolTransaction_Begin(dir.c_str());
+   CHECK(hTx != 0);
+   if (!hTx) return;
+   CHECK_EQ(SymbolTransaction_AddGroup(hTx, "Forex", "Forex pairs", 0), 0);
+
+   SYMBOL batch[] = { NewSymbol("EURUSD", 1), NewSymbol("GBPUSD", 2), NewSymbol("USDJPY", 3) };
+   batch[2].group = 5;                                         // an unused group
+   CHECK_EQ(SymbolTransaction_AddSymbols(hTx, batch, 3, TRUE), EMPTY);
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+   CHECK(SymbolTransaction_Commit(hTx));                       // adding the group is the only change
+   CHECK_EQ(GetFileAttributesA((dir + "symbols.raw").c_str()), FILE_ATTRIBUTE_NORMAL);
+   CHECK_EQ(ReadFile(dir + "symbols.raw").size(), 0u);
+
+   hTx = SymbolTransaction_Begin(dir.c_str());
+   batch[2].group = 0;
+   CHECK_EQ(SymbolTransaction_AddSymbols(hTx, batch, 3, TRUE), 3);
+   CHECK(SymbolTransaction_Commit(hTx));
+
+   uint hTable = SymbolTable_Open((dir + "symbols.raw").c_str());
+   CHECK_EQ(SymbolTable_Count(hTable), 3);
+   CHECK(SymbolTable_Close(hTable));
+}
+
+
+TEST(SymbolTransaction_FailedCommitRestoresAllFiles) {
+   std::string dir = TempFilename("commit/");
+   mkdir(dir.c_str(), 0755);
+
+   uint hTx = SymbolTransaction_Begin(dir.c_str());
+   SymbolTransaction_AddGroup(hTx, "Forex", "Forex pairs", 0);
+   SYMBOL eurusd = NewSymbol("EURUSD", 1);
+   CHECK_EQ(SymbolTransaction_AddSymbols(hTx, &eurusd, 1, TRUE), 1);
+   CHECK(SymbolTransaction_Commit(hTx));
+   std::string groups = ReadFile(dir + "symgroups.raw"), symbols = ReadFile(dir + "symbols.raw"), selected = ReadFile(dir + "symbols.sel");
+   CHECK(!symbols.empty() && !selected.empty());
+
+   hTx = SymbolTransaction_Begin(dir.c_str());
+   SymbolTransaction_AddGroup(hTx, "Metals", "Metals", 0);
+   SYMBOL gold = NewSymbol("XAUUSD", 2);
+   CHECK_EQ(SymbolTransaction_AddSymbols(hTx, &gold, 1, TRUE), 1);
+
+   std::string blocker = dir + "symbols.sel.bak";            // a non-empty directory: the backup of the last file fails
+   mkdir(blocker.c_str(), 0755);
+   mkdir((blocker + "/x").c_str(), 0755);
+   CHECK(!SymbolTransaction_Commit(hTx));
+   CHECK(ReadFile(dir + "symgroups.raw") == groups);         // the already replaced files were restored
+   CHECK(ReadFile(dir + "symbols.raw") == symbols);
+   CHECK(ReadFile(dir + "symbols.sel") == selected);
+   CHECK_EQ(GetFileAttributesA((dir + "symbols.raw.bak").c_str()), INVALID_FILE_ATTRIBUTES);
+   CHECK_EQ(GetFileAttributesA((dir + "symbols.raw.tmp").c_str()), INVALID_FILE_ATTRIBUTES);
+
+   rmdir((blocker + "/x").c_str());
+   rmdir(blocker.c_str());
+   CHECK(SymbolTransaction_Commit(hTx));                       // the transaction stayed open
+   uint hTable = SymbolTable_Open((dir + "symbols.raw").c_str());
+   CHECK_EQ(SymbolTable_Count(hTable), 2);
+   CHECK(SymbolTable_Close(hTable));
+   CHECK_EQ(GetFileAttributesA((dir + "symbols.raw.bak").c_str()), INVALID_FILE_ATTRIBUTES);
+}
+
+
+/**
+ * Create a file of 1024 symbols in random name order.
+ */
+static std::vector<SYMBOL> RandomSymbols(const std::string &filename) {
+   std::vector<SYMBOL> symbols;
+   srand(1);
+   for (uint i=0; i < 1024; i++) {
+      char name[12];
+      sprintf(name, "S%04X%04u", rand() & 0xffff, i);
+      symbols.push_back(NewSymbol(name, i+1));
+   }
+   WriteSymbols(filename, symbols);
+   return(symbols);
+}
+
+
+BENCHMARK(SymbolTable_FindByNameVsLinearScan) {
+   const int lookups = 1000000;
+   std::vector<SYMBOL> symbols = RandomSymbols(TempFilename("bench.raw"));
+   uint hTable = SymbolTable_Open(TempFilename("bench.raw").c_str());
+   uint size = symbols.size();
+
+   int found = 0;
+   double start = MilliSeconds();
+   for (int n=0; n < lookups; n++) {
+      const char* name = symbols[(n*7) % size].name;
+      for (uint i=0; i < size; i++) {
+         if (!strcmp(symbols[i].name, name)) { found++; break; }
+      }
+   }
+   double scanTime = MilliSeconds() - start;
+
+   start = MilliSeconds();
+   for (int n=0; n < lookups; n++) {
+      found -= SymbolTable_FindByName(hTable, symbols[(n*7) % size].name) != NULL;
+   }
+   double hashTime = MilliSeconds() - start;
+   CHECK(SymbolTable_Close(hTable));
+
+   CHECK_EQ(found, 0);
+   printf("\n    %d lookups in %u symbols: linear scan %.1f ms, SymbolTable_FindByName %.1f ms\n", lookups, size, scanTime, hashTime);
+}
+
+
+BENCHMARK(SortSymbols_IndexVsQsort) {
+   const int runs = 100;
+   std::vector<SYMBOL> symbols = RandomSymbols(TempFilename("bench.raw")), sorted;
+
+   double start = MilliSeconds();
+   for (int n=0; n < runs; n++) {
+      sorted = symbols;
+      qsort(&sorted[0], sorted.size(), sizeof(SYMBOL), CompareSymbols);
+   }
+   double qsortTime = MilliSeconds() - start;
+   std::vector<SYMBOL> expected = sorted;
+
+   start = MilliSeconds();
+   for (int n=0; n < runs; n++) {
+      sorted = symbols;
+      SortSymbols(&sorted[0], sorted.size());
+   }
+   double indexTime = MilliSeconds() - start;
+
+   for (uint i=0; i < sorted.size(); i++) {
+      CHECK(!strcmp(sorted[i].name, expected[i].name));
+   }
+   printf("\n    %d sorts of %u symbols (incl. copy): qsort %.1f ms, SortSymbols %.1f ms\n", runs, (uint)symbols.size(), qsortTime, indexTime);
+}
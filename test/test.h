@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * Minimal test framework for the Linux test runner. Tests are registered with TEST(), benchmarks with BENCHMARK(). The
+ * runner executes all tests, or only those whose names contain one of the command line arguments. Benchmarks run only
+ * with the option "--bench".
+ */
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+
+typedef void (*TestFunction)();
+
+struct TestRegistrar {
+   TestRegistrar(const char* name, TestFunction function, bool benchmark);
+};
+
+#define TEST(name)                                                                     \
+   static void Test_##name();                                                          \
+   static TestRegistrar testRegistrar_##name(#name, Test_##name, false);               \
+   static void Test_##name()
+
+#define BENCHMARK(name)                                                                \
+   static void Benchmark_##name();                                                     \
+   static TestRegistrar benchmarkRegistrar_##name(#name, Benchmark_##name, true);      \
+   static void Benchmark_##name()
+
+
+void TestFailed(const char* file, int line, const char* expression, const std::string &details = std::string());
+
+#define CHECK(expr)                                                                    \
+   do { if (!(expr)) TestFailed(__FILE__, __LINE__, #expr); } while (0)
+
+#define CHECK_EQ(actual, expected)                                                     \
+   do { if (!((actual) == (expected))) TestFailed(__FILE__, __LINE__, #actual " == " #expected, \
+        "actual=" + TestValue(actual) + " expected=" + TestValue(expected)); } while (0)
+
+#define CHECK_NEAR(actual, expected, epsilon)                                          \
+   do { double a_ = (actual), e_ = (expected);                                         \
+        if (!(std::fabs(a_ - e_) <= (epsilon))) TestFailed(__FILE__, __LINE__, #actual " ~ " #expected, \
+        "actual=" + TestValue(a_) + " expected=" + TestValue(e_)); } while (0)
+
+
+template <typename T>
+std::string TestValue(const T &value) {
+   std::ostringstream ss;
+   ss << std::setprecision(17) << value;
+   return(ss.str());
+}
+
+
+std::string TempFilename(const char* name);       // full name of a file in the test's temporary directory
+double      MilliSeconds();                       // monotonic clock for benchmarks
+
+int         LastExpanderError();                  // last error passed to error() or warn() (see "support.cpp")
+int         ExpanderErrorCount();                 // number of errors passed to error() or warn()
+void        ResetExpanderErrors();
@@ -0,0 +1,77 @@
+/**
+ * Tests of the test session metadata (src/lib/tester.cpp).
+ */
+#include "expander.h"
+#include "lib/terminal.h"
+#include "lib/tester.h"
+#include "test.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+
+/**
+ * Write the test history file of EURUSD,M15 (every tick) with the specified commission and modification time. The
+ * terminal data path of the tests has no directories, backslashes are part of the filename.
+ */
+static string WriteFxtFile(double commission, uint extra, time_t modified) {
+   string filename = string(GetTerminalDataPathA()).append("\\tester\\history\\EURUSD15_0.fxt");
+
+   FXT_HEADER fxt = {};
+   fxt.version = 405;
+   strcpy(fxt.symbol, "EURUSD");
+   fxt.period          = PERIOD_M15;
+   fxt.modelType       = 0;
+   fxt.spread          = 12;
+   fxt.commissionValue = commission;
+
+   FILE* file = fopen(filename.c_str(), "wb");
+   fwrite(&fxt, sizeof(fxt), 1, file);
+   for (uint i=0; i < extra; i++) fputc(0, file);              // tick data
+   fclose(file);
+
+   timespec times[2] = {{modified, 0}, {modified, 0}};
+   utimensat(AT_FDCWD, filename.c_str(), times, 0);
+   return(filename);
+}
+
+
+TEST(Tester_GetFxtHeader_InvalidatesOnFileChange) {
+   FXT_HEADER fxt;
+   string filename = WriteFxtFile(7, 100, 1577836800);
+   CHECK(Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(fxt.commissionValue, 7.);
+   CHECK_EQ(fxt.spread, 12u);
+
+   WriteFxtFile(8, 100, 1577836800);                           // same size and time: the cached header is returned
+   CHECK(Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(fxt.commissionValue, 7.);
+
+   WriteFxtFile(9, 100, 1577836801);                           // changed modification time
+   CHECK(Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(fxt.commissionValue, 9.);
+
+   WriteFxtFile(10, 200, 1577836801);                          // changed size
+   CHECK(Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(fxt.commissionValue, 10.);
+
+   DeleteFileA(filename.c_str());                              // a deleted file is reported
+   ResetExpanderErrors();
+   CHECK(!Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(ExpanderErrorCount(), 1);
+
+   WriteFxtFile(11, 200, 1577836801);                          // a re-created file is re-read, even with the former size and time
+   CHECK(Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(fxt.commissionValue, 11.);
+}
+
+
+TEST(Tester_GetFxtHeader_KeysBySymbolTimeframeAndModel) {
+   FXT_HEADER fxt;
+   WriteFxtFile(5, 0, 1577836800);
+   CHECK(Tester_GetFxtHeader("EURUSD", PERIOD_M15, 0, &fxt));
+   CHECK_EQ(fxt.commissionValue, 5.);
+   CHECK(!Tester_GetFxtHeader("EURUSD", PERIOD_M15, 1, &fxt));  // no file for another bar model
+   CHECK(!Tester_GetFxtHeader("EURUSD", PERIOD_H1, 0, &fxt));
+   CHECK(!Tester_GetFxtHeader("GBPUSD", PERIOD_M15, 0, &fxt));
+}
@@ -0,0 +1,111 @@
+/**
+ * Tests of the tick reader (src/lib/ticks.cpp).
+ */
+#include "expander.h"
+#include "lib/ticks.h"
+#include "test.h"
+
+#include <vector>
+
+
+/**
+ * Append ticks with consecutive counters to a tick file. The symbols alternate between "EURUSD" and "GBPUSD".
+ */
+static void AppendTicks(const std::string &filename, uint fromCounter, uint count) {
+   FILE* file = fopen(filename.c_str(), "ab");
+   for (uint i=0; i < count; i++) {
+      TICK tick = {};
+      uint counter = fromCounter + i;
+      strcpy(tick.symbol, counter % 2 ? "EURUSD" : "GBPUSD");
+      tick.time    = 1577836800 + counter;
+      tick.bid     = 1 + counter/1e5;
+      tick.ask     = tick.bid + 0.0001;
+      tick.counter = counter;
+      fwrite(&tick, sizeof(tick), 1, file);
+   }
+   fclose(file);
+}
+
+
+/**
+ * Fetch ticks of a symbol until the expected number arrived or a timeout occurred.
+ */
+static std::vector<TICK> WaitForTicks(uint hReader, const char* symbol, uint expected) {
+   std::vector<TICK> result;
+   TICK ticks[100];
+   for (double start=MilliSeconds(); result.size() < expected && MilliSeconds()-start < 5000; ) {
+      int count = TickReader_GetTicks(hReader, symbol, ticks, 100);
+      if (count < 0) break;
+      result.insert(result.end(), ticks, ticks+count);
+      if (!count) Sleep(5);
+   }
+   return(result);
+}
+
+
+TEST(TickReader_FollowsTheFile) {
+   std::string filename = TempFilename("ticks.raw");
+   AppendTicks(filename, 1, 10);
+
+   uint hReader = TickReader_Open(filename.c_str());
+   CHECK(hReader != 0);
+   if (!hReader) return;
+   std::vector<TICK> ticks = WaitForTicks(hReader, "EURUSD", 5);
+   CHECK_EQ(ticks.size(), 5u);
+   for (uint i=0; i < ticks.size(); i++) CHECK_EQ(ticks[i].counter, 2*i+1);
+
+   AppendTicks(filename, 11, 10);                              // ticks appended while the reader runs
+   ticks = WaitForTicks(hReader, "GBPUSD", 10);
+   CHECK_EQ(ticks.size(), 10u);
+   if (!ticks.empty()) CHECK_EQ(ticks.back().counter, 20u);
+   CHECK_EQ(TickReader_LastCounter(hReader), 20u);
+   CHECK_EQ(TickReader_Overflows(hReader, "GBPUSD"), 0);
+   CHECK(TickReader_Close(hReader));
+
+   hReader = TickReader_Open(filename.c_str(), 16);            // resume after a restart
+   ticks = WaitForTicks(hReader, "EURUSD", 2);
+   CHECK_EQ(ticks.size(), 2u);
+   if (ticks.size() == 2) CHECK_EQ(ticks[0].counter, 17u);
+   CHECK(TickReader_Close(hReader));
+}
+
+
+struct Consumer {
+   uint          hReader;
+   volatile LONG calls;
+   volatile LONG result;
+};
+
+static DWORD WINAPI ConsumerThread(LPVOID param) {
+   Consumer* consumer = (Consumer*)param;
+   TICK ticks[10];
+   int result;
+   while ((result = TickReader_GetTicks(consumer->hReader, "EURUSD", ticks, 10)) >= 0) {
+      InterlockedIncrement(&consumer->calls);
+   }
+   InterlockedExchange(&consumer->result, result);
+   return(0);
+}
+
+
+TEST(TickReader_CloseWhileConsuming) {
+   std::string filename = TempFilename("ticks-close.raw");
+   AppendTicks(filename, 1, 5000);                             // more than a queue holds: overflows
+
+   for (int n=0; n < 20; n++) {
+      Consumer consumer = { TickReader_Open(filename.c_str()), 0, 0 };
+      CHECK(consumer.hReader != 0);
+      if (!consumer.hReader) return;
+      HANDLE hThread = CreateThread(NULL, 0, ConsumerThread, &consumer, 0, NULL);
+      while (consumer.calls < 10) Sleep(0);
+
+      CHECK(TickReader_Close(consumer.hReader));               // joins the reader thread, the consumer keeps its reference
+      CHECK_EQ(WaitForSingleObject(hThread, 5000), (DWORD)WAIT_OBJECT_0);
+      CloseHandle(hThread);
+      CHECK_EQ(consumer.result, EMPTY);                        // the consumer's next call fails cleanly
+      CHECK(!TickReader_Close(consumer.hReader));
+      CHECK_EQ(LastExpanderError(), ERR_ILLEGAL_STATE);
+   }
+   CHECK(!TickReader_Close(0));
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+}
@@ -0,0 +1,158 @@
+/**
+ * Tests of the timeseries functions (src/lib/timeseries.cpp).
+ */
+#include "expander.h"
+#include "lib/terminal.h"
+#include "lib/timeseries.h"
+#include "test.h"
+
+#include <vector>
+
+
+/**
+ * Fill a price series with M1 bars starting at the specified time. Prices are derived from the bar time, so a value
+ * identifies its bar.
+ */
+static void FillRates(std::vector<HistoryBar401> &rates, time32 firstTime) {
+   for (size_t i=0; i < rates.size(); i++) {
+      HistoryBar401 &bar = rates[i];
+      memset(&bar, 0, sizeof(bar));
+      bar.time       = firstTime + (time32)i*60;
+      bar.open       = bar.time / 1e6;
+      bar.high       = bar.open + 0.001;
+      bar.low        = bar.open - 0.001;
+      bar.close      = bar.open + 0.0005;
+      bar.tickVolume = i + 1;
+   }
+}
+
+
+static bool ColumnsMatch(const std::vector<HistoryBar401> &rates, const std::vector<time32> &times, const std::vector<double> &close, const std::vector<double> &volume) {
+   for (size_t i=0; i < rates.size(); i++) {
+      if (times[i] != rates[i].time || close[i] != rates[i].close || volume[i] != (double)rates[i].tickVolume) return(false);
+   }
+   return(true);
+}
+
+
+TEST(Rates_CopyColumns_Incremental) {
+   std::vector<HistoryBar401> rates(1001);
+   FillRates(rates, 1577836800);
+
+   EXECUTION_CONTEXT ec = {};
+   ec.rates       = &rates[0];
+   ec.bars        = 1000;                          // the last bar is not yet visible
+   ec.changedBars = 1000;
+
+   std::vector<time32> times(1001);
+   std::vector<double> close(1001), volume(1001);
+   CHECK_EQ(Rates_CopyColumns(&ec, 1001, &times[0], NULL, NULL, NULL, &close[0], &volume[0], TRUE), 0);
+
+   rates[999].close = 9.99;                        // the youngest bar changed and a new bar arrived
+   ec.bars        = 1001;
+   ec.changedBars = 2;
+   CHECK_EQ(Rates_CopyColumns(&ec, 1001, &times[0], NULL, NULL, NULL, &close[0], &volume[0], TRUE), 999);
+   CHECK(ColumnsMatch(rates, times, close, volume));
+}
+
+
+TEST(Rates_CopyColumns_DetectsDroppedOldestBar) {
+   std::vector<HistoryBar401> rates(500);
+   FillRates(rates, 1577836800);
+
+   EXECUTION_CONTEXT ec = {};
+   ec.rates       = &rates[0];
+   ec.bars        = 500;
+   ec.changedBars = 500;
+
+   std::vector<time32> times(500);
+   std::vector<double> close(500), volume(500);
+   CHECK_EQ(Rates_CopyColumns(&ec, 500, &times[0], NULL, NULL, NULL, &close[0], &volume[0], TRUE), 0);
+
+   // at the max. bars limit the terminal drops the oldest bar: the number of bars stays the same, all bars shift by one
+   FillRates(rates, 1577836800 + 60);
+   ec.changedBars = 2;
+   CHECK_EQ(Rates_CopyColumns(&ec, 500, &times[0], NULL, NULL, NULL, &close[0], &volume[0], TRUE), 0);
+   CHECK(ColumnsMatch(rates, times, close, volume));
+}
+
+
+TEST(Rates_CopyColumns_WithoutTimesCopiesAll) {
+   std::vector<HistoryBar401> rates(100);
+   FillRates(rates, 1577836800);
+
+   EXECUTION_CONTEXT ec = {};
+   ec.rates       = &rates[0];
+   ec.bars        = 100;
+   ec.changedBars = 1;
+
+   std::vector<double> close(100);
+   CHECK_EQ(Rates_CopyColumns(&ec, 100, NULL, NULL, NULL, NULL, &close[0], NULL, TRUE), 0);
+   CHECK_EQ(close[0], rates[0].close);
+   CHECK_EQ(close[99], rates[99].close);
+
+   CHECK_EQ(Rates_CopyColumns(&ec, 99, NULL, NULL, NULL, NULL, &close[0], NULL, TRUE), EMPTY);
+   CHECK_EQ(LastExpanderError(), ERR_INVALID_PARAMETER);
+}
+
+
+TEST(iBarShift_FindsContainingBar) {
+   std::vector<HistoryBar401> rates(1000);
+   FillRates(rates, 1577836800);
+   rates[500].time += 30;                          // an irregular bar
+
+   EXECUTION_CONTEXT ec = {};
+   ec.rates = &rates[0];
+   ec.bars  = 1000;
+
+   CHECK_EQ(iBarShift(&ec, rates[999].time, TRUE), 0);
+   CHECK_EQ(iBarShift(&ec, rates[0].time, TRUE), 999);
+   CHECK_EQ(iBarShift(&ec, rates[0].time - 1, FALSE), EMPTY);
+   CHECK_EQ(iBarShift(&ec, rates[500].time - 10, FALSE), 500);
+   CHECK_EQ(iBarShift(&ec, rates[500].time - 10, TRUE), EMPTY);
+
+   time32 times[] = { rates[0].time - 1, rates[10].time, rates[10].time + 59, rates[998].time };
+   int results[4];
+   CHECK(iBarShifts(&ec, times, 4, results, FALSE));
+   CHECK_EQ(results[0], EMPTY);
+   CHECK_EQ(results[1], 989);
+   CHECK_EQ(results[2], 989);
+   CHECK_EQ(results[3], 1);
+}
+
+
+/**
+ * The former accessor with a per-call build check and format switch.
+ */
+static double OldClose(const void* rates, uint bars, uint bar) {
+   static uint build = GetTerminalBuild();
+   if (!build || bar >= bars) return NULL;
+
+   uint shift = bars-1-bar;
+   if (build <= 509) return ((HistoryBar400*) rates)[shift].close;
+   else              return ((HistoryBar401*) rates)[shift].close;
+}
+
+
+BENCHMARK(BarView_VsSwitchPerCall) {
+   const int bars = 1000000, passes = 20;
+   std::vector<HistoryBar401> rates(bars);
+   FillRates(rates, 946684800);
+
+   double sum1 = 0, start = MilliSeconds();
+   for (int n=0; n < passes; n++) {
+      for (int i=0; i < bars; i++) sum1 += OldClose(&rates[0], bars, i);
+   }
+   double switchTime = MilliSeconds() - start;
+
+   double sum2 = 0;
+   start = MilliSeconds();
+   BarView<HistoryBar401> view(&rates[0], bars);
+   for (int n=0; n < passes; n++) {
+      for (int i=0; i < bars; i++) sum2 += view.Close(i);
+   }
+   double viewTime = MilliSeconds() - start;
+
+   CHECK_EQ(sum1, sum2);
+   printf("\n    %d x %d bars: switch per call %.1f ms, BarView %.1f ms\n", passes, bars, switchTime, viewTime);
+}
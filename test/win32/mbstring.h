@@ -0,0 +1,5 @@
+#pragma once
+#include <stddef.h>
+
+size_t _mbslen(const unsigned char* str);
+size_t _mbstrlen(const char* str);
@@ -0,0 +1,775 @@
+/**
+ * POSIX implementation of the Win32 functions declared in "windows.h", as far as the tests need them.
+ */
+#include "windows.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+// kernel objects behind a HANDLE
+enum ObjectType { OBJECT_FILE, OBJECT_MAPPING, OBJECT_THREAD, OBJECT_EVENT };
+
+struct KernelObject {
+   ObjectType             type;
+   int                    fd;                      // file: descriptor; mapping: descriptor of the mapped file (not owned)
+   BOOL                   writable;                // mapping: whether the mapping is writable
+   pthread_t              thread;                  // thread
+   LPTHREAD_START_ROUTINE start;                   // thread: start routine
+   LPVOID                 param;                   // thread: start parameter
+   DWORD                  exitCode;                // thread: exit code
+   DWORD                  threadId;                // thread: id as returned by GetCurrentThreadId()
+   int                    references;              // thread: number of open handles (CreateThread() and OpenThread())
+   BOOL                   signaled;                // thread: finished; event: set
+   BOOL                   manualReset;             // event
+   pthread_mutex_t        mutex;
+   pthread_cond_t         cond;
+};
+
+static __thread DWORD                t_lastError;
+static pthread_mutex_t               g_viewsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<const void*, size_t> g_views;      // mapped views and their sizes
+static pthread_mutex_t               g_threadsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<DWORD, KernelObject*> g_threads;   // threads created by CreateThread() and not yet closed, key: thread id
+
+
+/**
+ * Map the current errno to a Win32 error code.
+ */
+static DWORD ErrnoToWin32(int error) {
+   switch (error) {
+      case ENOENT: return(ERROR_FILE_NOT_FOUND);
+      case ENOTDIR:return(ERROR_PATH_NOT_FOUND);
+      case EACCES:
+      case EPERM:  return(ERROR_ACCESS_DENIED);
+      case EBADF:  return(ERROR_INVALID_HANDLE);
+      case ENOMEM: return(ERROR_NOT_ENOUGH_MEMORY);
+      case EEXIST: return(ERROR_FILE_EXISTS);
+      case EINVAL: return(ERROR_INVALID_PARAMETER);
+   }
+   return(ERROR_GEN_FAILURE);
+}
+
+
+static BOOL Fail(DWORD error) {
+   t_lastError = error;
+   return(FALSE);
+}
+
+
+static KernelObject* NewObject(ObjectType type) {
+   KernelObject* object = new KernelObject();
+   object->type = type;
+   object->fd = -1;
+   pthread_mutex_init(&object->mutex, NULL);
+   pthread_cond_init(&object->cond, NULL);
+   return(object);
+}
+
+
+static KernelObject* GetObject(HANDLE handle, ObjectType type) {
+   KernelObject* object = (KernelObject*)handle;
+   if (!object || handle==INVALID_HANDLE_VALUE || object->type != type) return(NULL);
+   return(object);
+}
+
+
+DWORD GetLastError() {
+   return(t_lastError);
+}
+
+
+void SetLastError(DWORD error) {
+   t_lastError = error;
+}
+
+
+HANDLE CreateFileA(LPCSTR name, DWORD access, DWORD shareMode, LPSECURITY_ATTRIBUTES sa, DWORD disposition, DWORD flags, HANDLE hTemplate) {
+   int oflags = (access & GENERIC_WRITE) ? ((access & GENERIC_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+   switch (disposition) {
+      case CREATE_NEW:        oflags |= O_CREAT|O_EXCL;  break;
+      case CREATE_ALWAYS:     oflags |= O_CREAT|O_TRUNC; break;
+      case OPEN_EXISTING:                                break;
+      case OPEN_ALWAYS:       oflags |= O_CREAT;         break;
+      case TRUNCATE_EXISTING: oflags |= O_TRUNC;         break;
+      default: Fail(ERROR_INVALID_PARAMETER); return(INVALID_HANDLE_VALUE);
+   }
+   int fd = open(name, oflags|O_CLOEXEC, 0644);
+   if (fd == -1) {
+      Fail(ErrnoToWin32(errno));
+      return(INVALID_HANDLE_VALUE);
+   }
+   if (flags & FILE_FLAG_DELETE_ON_CLOSE) unlink(name);
+
+   KernelObject* file = NewObject(OBJECT_FILE);
+   file->fd = fd;
+   return(file);
+}
+
+
+BOOL ReadFile(HANDLE hFile, LPVOID buffer, DWORD size, LPDWORD bytesRead, LPOVERLAPPED overlapped) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+
+   DWORD done = 0;
+   while (done < size) {
+      ssize_t n = read(file->fd, (char*)buffer + done, size - done);
+      if (n < 0) {
+         if (errno == EINTR) continue;
+         return(Fail(ErrnoToWin32(errno)));
+      }
+      if (!n) break;                               // end of file
+      done += (DWORD)n;
+   }
+   if (bytesRead) *bytesRead = done;
+   return(TRUE);
+}
+
+
+BOOL WriteFile(HANDLE hFile, LPCVOID buffer, DWORD size, LPDWORD bytesWritten, LPOVERLAPPED overlapped) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+
+   DWORD done = 0;
+   while (done < size) {
+      ssize_t n = write(file->fd, (const char*)buffer + done, size - done);
+      if (n < 0) {
+         if (errno == EINTR) continue;
+         return(Fail(ErrnoToWin32(errno)));
+      }
+      done += (DWORD)n;
+   }
+   if (bytesWritten) *bytesWritten = done;
+   return(TRUE);
+}
+
+
+BOOL FlushFileBuffers(HANDLE hFile) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+   return(TRUE);                                   // data is flushed by the kernel, durability is not tested
+}
+
+
+BOOL SetFilePointerEx(HANDLE hFile, LARGE_INTEGER distance, LARGE_INTEGER* newPosition, DWORD method) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+
+   int whence = (method==FILE_BEGIN) ? SEEK_SET : (method==FILE_CURRENT) ? SEEK_CUR : SEEK_END;
+   off_t pos = lseek(file->fd, (off_t)distance.QuadPart, whence);
+   if (pos == (off_t)-1) return(Fail(ErrnoToWin32(errno)));
+   if (newPosition) newPosition->QuadPart = pos;
+   return(TRUE);
+}
+
+
+BOOL SetEndOfFile(HANDLE hFile) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+
+   off_t pos = lseek(file->fd, 0, SEEK_CUR);
+   if (pos == (off_t)-1 || ftruncate(file->fd, pos)) return(Fail(ErrnoToWin32(errno)));
+   return(TRUE);
+}
+
+
+BOOL GetFileSizeEx(HANDLE hFile, LARGE_INTEGER* size) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+
+   struct stat st;
+   if (fstat(file->fd, &st)) return(Fail(ErrnoToWin32(errno)));
+   size->QuadPart = st.st_size;
+   return(TRUE);
+}
+
+
+DWORD GetFileSize(HANDLE hFile, LPDWORD sizeHigh) {
+   LARGE_INTEGER size;
+   if (!GetFileSizeEx(hFile, &size)) return(INVALID_FILE_SIZE);
+   if (sizeHigh) *sizeHigh = size.HighPart;
+   return(size.LowPart);
+}
+
+
+/**
+ * Convert a POSIX timestamp to a FILETIME (100-nanosecond intervals since 1601-01-01).
+ */
+static FILETIME ToFileTime(const struct timespec &ts) {
+   ULARGE_INTEGER value;
+   value.QuadPart = ((ULONGLONG)ts.tv_sec + 11644473600ULL) * 10000000ULL + ts.tv_nsec/100;
+   FILETIME ft;
+   ft.dwLowDateTime  = value.LowPart;
+   ft.dwHighDateTime = value.HighPart;
+   return(ft);
+}
+
+
+BOOL GetFileTime(HANDLE hFile, FILETIME* creation, FILETIME* lastAccess, FILETIME* lastWrite) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) return(Fail(ERROR_INVALID_HANDLE));
+
+   struct stat st;
+   if (fstat(file->fd, &st)) return(Fail(ErrnoToWin32(errno)));
+   if (creation)   *creation   = ToFileTime(st.st_ctim);
+   if (lastAccess) *lastAccess = ToFileTime(st.st_atim);
+   if (lastWrite)  *lastWrite  = ToFileTime(st.st_mtim);
+   return(TRUE);
+}
+
+
+BOOL GetFileAttributesExA(LPCSTR name, int infoLevel, LPVOID info) {
+   struct stat st;
+   if (stat(name, &st)) return(Fail(ErrnoToWin32(errno)));
+
+   WIN32_FILE_ATTRIBUTE_DATA* data = (WIN32_FILE_ATTRIBUTE_DATA*)info;
+   data->dwFileAttributes = S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+   data->ftCreationTime   = ToFileTime(st.st_ctim);
+   data->ftLastAccessTime = ToFileTime(st.st_atim);
+   data->ftLastWriteTime  = ToFileTime(st.st_mtim);
+   data->nFileSizeHigh    = (DWORD)((ULONGLONG)st.st_size >> 32);
+   data->nFileSizeLow     = (DWORD)st.st_size;
+   return(TRUE);
+}
+
+
+DWORD GetFileAttributesA(LPCSTR name) {
+   struct stat st;
+   if (stat(name, &st)) {
+      Fail(ErrnoToWin32(errno));
+      return(INVALID_FILE_ATTRIBUTES);
+   }
+   return(S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL);
+}
+
+
+LONG CompareFileTime(const FILETIME* a, const FILETIME* b) {
+   ULONGLONG va = ((ULONGLONG)a->dwHighDateTime << 32) | a->dwLowDateTime;
+   ULONGLONG vb = ((ULONGLONG)b->dwHighDateTime << 32) | b->dwLowDateTime;
+   return((va > vb) - (va < vb));
+}
+
+
+BOOL DeleteFileA(LPCSTR name) {
+   if (unlink(name)) return(Fail(ErrnoToWin32(errno)));
+   return(TRUE);
+}
+
+
+BOOL MoveFileExA(LPCSTR existing, LPCSTR target, DWORD flags) {
+   if (!(flags & MOVEFILE_REPLACE_EXISTING) && !access(target, F_OK)) return(Fail(ERROR_ALREADY_EXISTS));
+   if (rename(existing, target)) return(Fail(ErrnoToWin32(errno)));
+   return(TRUE);
+}
+
+
+DWORD GetTempPathA(DWORD size, LPSTR buffer) {
+   const char* dir = getenv("TMPDIR");
+   if (!dir || !*dir) dir = "/tmp";
+   DWORD len = (DWORD)strlen(dir) + 1;             // including the trailing slash
+   if (len+1 > size) return(len+1);
+   sprintf(buffer, "%s/", dir);
+   return(len);
+}
+
+
+UINT GetTempFileNameA(LPCSTR path, LPCSTR prefix, UINT unique, LPSTR buffer) {
+   snprintf(buffer, MAX_PATH, "%s/%.3sXXXXXX", path, prefix);
+   int fd = mkstemp(buffer);
+   if (fd == -1) return(Fail(ErrnoToWin32(errno)));
+   close(fd);
+   return(1);
+}
+
+
+HANDLE CreateFileMappingA(HANDLE hFile, LPSECURITY_ATTRIBUTES sa, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCSTR name) {
+   KernelObject* file = GetObject(hFile, OBJECT_FILE);
+   if (!file) {
+      Fail(ERROR_INVALID_HANDLE);
+      return(NULL);
+   }
+   KernelObject* mapping = NewObject(OBJECT_MAPPING);
+   mapping->fd = file->fd;
+   mapping->writable = (protect == PAGE_READWRITE);
+   return(mapping);
+}
+
+
+LPVOID MapViewOfFile(HANDLE hMapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size) {
+   KernelObject* mapping = GetObject(hMapping, OBJECT_MAPPING);
+   if (!mapping) {
+      Fail(ERROR_INVALID_HANDLE);
+      return(NULL);
+   }
+   off_t offset = ((off_t)offsetHigh << 32) | offsetLow;
+   if (!size) {
+      struct stat st;
+      if (fstat(mapping->fd, &st)) {
+         Fail(ErrnoToWin32(errno));
+         return(NULL);
+      }
+      size = (SIZE_T)(st.st_size - offset);
+   }
+   int prot = (access & FILE_MAP_WRITE) && mapping->writable ? PROT_READ|PROT_WRITE : PROT_READ;
+   void* view = mmap(NULL, size, prot, MAP_SHARED, mapping->fd, offset);
+   if (view == MAP_FAILED) {
+      Fail(ErrnoToWin32(errno));
+      return(NULL);
+   }
+   pthread_mutex_lock(&g_viewsMutex);
+   g_views[view] = size;
+   pthread_mutex_unlock(&g_viewsMutex);
+   return(view);
+}
+
+
+BOOL UnmapViewOfFile(LPCVOID view) {
+   pthread_mutex_lock(&g_viewsMutex);
+   std::map<const void*, size_t>::iterator it = g_views.find(view);
+   size_t size = (it == g_views.end()) ? 0 : it->second;
+   if (size) g_views.erase(it);
+   pthread_mutex_unlock(&g_viewsMutex);
+
+   if (!size || munmap((void*)view, size)) return(Fail(ERROR_INVALID_PARAMETER));
+   return(TRUE);
+}
+
+
+BOOL CloseHandle(HANDLE handle) {
+   KernelObject* object = (KernelObject*)handle;
+   if (!object || handle==INVALID_HANDLE_VALUE) return(Fail(ERROR_INVALID_HANDLE));
+
+   if (object->type == OBJECT_FILE && close(object->fd)) return(Fail(ErrnoToWin32(errno)));
+   if (object->type == OBJECT_THREAD) {
+      pthread_mutex_lock(&g_threadsMutex);
+      if (object->references > 1) {                         // another handle is still open
+         object->references--;
+         pthread_mutex_unlock(&g_threadsMutex);
+         return(TRUE);
+      }
+      pthread_mutex_lock(&object->mutex);
+      BOOL finished = object->signaled;
+      pthread_mutex_unlock(&object->mutex);
+      if (!finished) {
+         pthread_mutex_unlock(&g_threadsMutex);
+         return(Fail(ERROR_INVALID_HANDLE));                // the tests always join their threads before closing them
+      }
+      std::map<DWORD, KernelObject*>::iterator it = g_threads.find(object->threadId);
+      if (it != g_threads.end() && it->second == object) g_threads.erase(it);
+      pthread_mutex_unlock(&g_threadsMutex);
+      pthread_join(object->thread, NULL);
+   }
+   pthread_mutex_destroy(&object->mutex);
+   pthread_cond_destroy(&object->cond);
+   delete object;
+   return(TRUE);
+}
+
+
+static void* ThreadMain(void* arg) {
+   KernelObject* thread = (KernelObject*)arg;
+   pthread_mutex_lock(&g_threadsMutex);
+   thread->threadId = GetCurrentThreadId();
+   g_threads[thread->threadId] = thread;
+   pthread_mutex_unlock(&g_threadsMutex);
+
+   DWORD exitCode = thread->start(thread->param);
+
+   pthread_mutex_lock(&thread->mutex);
+   thread->exitCode = exitCode;
+   thread->signaled = TRUE;
+   pthread_cond_broadcast(&thread->cond);
+   pthread_mutex_unlock(&thread->mutex);
+   return(NULL);
+}
+
+
+HANDLE CreateThread(LPSECURITY_ATTRIBUTES sa, SIZE_T stackSize, LPTHREAD_START_ROUTINE start, LPVOID param, DWORD flags, LPDWORD threadId) {
+   KernelObject* thread = NewObject(OBJECT_THREAD);
+   thread->start    = start;
+   thread->param    = param;
+   thread->exitCode   = STILL_ACTIVE;
+   thread->references = 1;
+
+   pthread_attr_t attr;
+   pthread_attr_init(&attr);
+   if (stackSize) pthread_attr_setstacksize(&attr, stackSize < PTHREAD_STACK_MIN ? PTHREAD_STACK_MIN : stackSize);
+   int failed = pthread_create(&thread->thread, &attr, ThreadMain, thread);
+   pthread_attr_destroy(&attr);
+
+   if (failed) {
+      Fail(ERROR_NOT_ENOUGH_MEMORY);
+      pthread_mutex_destroy(&thread->mutex);
+      pthread_cond_destroy(&thread->cond);
+      delete thread;
+      return(NULL);
+   }
+   if (threadId) *threadId = (DWORD)(uintptr_t)thread;
+   return(thread);
+}
+
+
+BOOL GetExitCodeThread(HANDLE hThread, LPDWORD exitCode) {
+   KernelObject* thread = GetObject(hThread, OBJECT_THREAD);
+   if (!thread) return(Fail(ERROR_INVALID_HANDLE));
+
+   pthread_mutex_lock(&thread->mutex);
+   *exitCode = thread->exitCode;
+   pthread_mutex_unlock(&thread->mutex);
+   return(TRUE);
+}
+
+
+DWORD GetCurrentThreadId() {
+   return((DWORD)syscall(SYS_gettid));
+}
+
+
+DWORD GetCurrentProcessId() {
+   return((DWORD)getpid());
+}
+
+
+HANDLE CreateEventA(LPSECURITY_ATTRIBUTES sa, BOOL manualReset, BOOL initialState, LPCSTR name) {
+   KernelObject* event = NewObject(OBJECT_EVENT);
+   event->manualReset = manualReset;
+   event->signaled    = initialState;
+   return(event);
+}
+
+
+static BOOL SignalEvent(HANDLE hEvent, BOOL signaled) {
+   KernelObject* event = GetObject(hEvent, OBJECT_EVENT);
+   if (!event) return(Fail(ERROR_INVALID_HANDLE));
+
+   pthread_mutex_lock(&event->mutex);
+   event->signaled = signaled;
+   if (signaled) pthread_cond_broadcast(&event->cond);
+   pthread_mutex_unlock(&event->mutex);
+   return(TRUE);
+}
+
+
+BOOL SetEvent(HANDLE hEvent) {
+   return(SignalEvent(hEvent, TRUE));
+}
+
+
+BOOL ResetEvent(HANDLE hEvent) {
+   return(SignalEvent(hEvent, FALSE));
+}
+
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD timeout) {
+   KernelObject* object = (KernelObject*)handle;
+   if (!object || (object->type != OBJECT_THREAD && object->type != OBJECT_EVENT)) {
+      Fail(ERROR_INVALID_HANDLE);
+      return(WAIT_FAILED);
+   }
+   struct timespec deadline;
+   clock_gettime(CLOCK_REALTIME, &deadline);
+   deadline.tv_sec  += timeout / 1000;
+   deadline.tv_nsec += (timeout % 1000) * 1000000L;
+   if (deadline.tv_nsec >= 1000000000L) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000L; }
+
+   DWORD result = WAIT_OBJECT_0;
+   pthread_mutex_lock(&object->mutex);
+   while (!object->signaled) {
+      if (timeout == INFINITE) pthread_cond_wait(&object->cond, &object->mutex);
+      else if (!timeout || pthread_cond_timedwait(&object->cond, &object->mutex, &deadline) == ETIMEDOUT) {
+         result = WAIT_TIMEOUT;
+         break;
+      }
+   }
+   if (result==WAIT_OBJECT_0 && object->type==OBJECT_EVENT && !object->manualReset) object->signaled = FALSE;
+   pthread_mutex_unlock(&object->mutex);
+   return(result);
+}
+
+
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD timeout) {
+   if (!waitAll || timeout != INFINITE) {          // only the variant used by the sources under test is supported
+      Fail(ERROR_INVALID_PARAMETER);
+      return(WAIT_FAILED);
+   }
+   for (DWORD i=0; i < count; i++) {
+      if (WaitForSingleObject(handles[i], INFINITE) != WAIT_OBJECT_0) return(WAIT_FAILED);
+   }
+   return(WAIT_OBJECT_0);
+}
+
+
+void Sleep(DWORD milliseconds) {
+   if (!milliseconds) sched_yield();
+   else               usleep(milliseconds * 1000);
+}
+
+
+void InitializeCriticalSection(CRITICAL_SECTION* cs) {
+   pthread_mutexattr_t attr;
+   pthread_mutexattr_init(&attr);
+   pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);   // critical sections are re-entrant
+   pthread_mutex_init(&cs->mutex, &attr);
+   pthread_mutexattr_destroy(&attr);
+}
+
+
+void DeleteCriticalSection(CRITICAL_SECTION* cs) {
+   pthread_mutex_destroy(&cs->mutex);
+}
+
+
+void EnterCriticalSection(CRITICAL_SECTION* cs) {
+   pthread_mutex_lock(&cs->mutex);
+}
+
+
+BOOL TryEnterCriticalSection(CRITICAL_SECTION* cs) {
+   return(!pthread_mutex_trylock(&cs->mutex));
+}
+
+
+void LeaveCriticalSection(CRITICAL_SECTION* cs) {
+   pthread_mutex_unlock(&cs->mutex);
+}
+
+
+DWORD TlsAlloc() {
+   pthread_key_t key;
+   if (pthread_key_create(&key, NULL)) {
+      Fail(ERROR_NOT_ENOUGH_MEMORY);
+      return(TLS_OUT_OF_INDEXES);
+   }
+   return((DWORD)key);
+}
+
+
+BOOL TlsFree(DWORD index) {
+   if (pthread_key_delete((pthread_key_t)index)) return(Fail(ERROR_INVALID_PARAMETER));
+   return(TRUE);
+}
+
+
+LPVOID TlsGetValue(DWORD index) {
+   SetLastError(ERROR_SUCCESS);
+   return(pthread_getspecific((pthread_key_t)index));
+}
+
+
+BOOL TlsSetValue(DWORD index, LPVOID value) {
+   if (pthread_setspecific((pthread_key_t)index, value)) return(Fail(ERROR_INVALID_PARAMETER));
+   return(TRUE);
+}
+
+
+HANDLE OpenThread(DWORD access, BOOL inherit, DWORD threadId) {
+   pthread_mutex_lock(&g_threadsMutex);
+   std::map<DWORD, KernelObject*>::iterator it = g_threads.find(threadId);
+   KernelObject* thread = (it == g_threads.end()) ? NULL : it->second;
+   if (thread) thread->references++;               // all handles of a thread share one object
+   pthread_mutex_unlock(&g_threadsMutex);
+
+   if (!thread) Fail(ERROR_INVALID_PARAMETER);     // only threads created by CreateThread() have handles
+   return(thread);
+}
+
+
+DWORD GetTickCount() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return((DWORD)(ts.tv_sec*1000 + ts.tv_nsec/1000000));
+}
+
+
+BOOL QueryPerformanceCounter(LARGE_INTEGER* counter) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   counter->QuadPart = (LONGLONG)ts.tv_sec*1000000000LL + ts.tv_nsec;
+   return(TRUE);
+}
+
+
+BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency) {
+   frequency->QuadPart = 1000000000LL;
+   return(TRUE);
+}
+
+
+/**
+ * Convert between Unix time and FILETIME/SYSTEMTIME. The local timezone is the one of the test process (variable TZ).
+ */
+static const LONGLONG UNIX_EPOCH_TICKS = 116444736000000000LL;  // FILETIME of 1970-01-01 00:00 GMT (100ns ticks)
+
+static FILETIME TicksToFileTime(LONGLONG ticks) {
+   FILETIME ft;
+   ft.dwLowDateTime  = (DWORD)ticks;
+   ft.dwHighDateTime = (DWORD)(ticks >> 32);
+   return(ft);
+}
+
+
+static LONGLONG FileTimeToTicks(const FILETIME* ft) {
+   return((LONGLONG)((ULONGLONG)ft->dwHighDateTime << 32 | ft->dwLowDateTime));
+}
+
+
+static void TmToSystemTime(const tm &t, WORD milliseconds, SYSTEMTIME* st) {
+   st->wYear         = (WORD)(t.tm_year + 1900);
+   st->wMonth        = (WORD)(t.tm_mon + 1);
+   st->wDayOfWeek    = (WORD)t.tm_wday;
+   st->wDay          = (WORD)t.tm_mday;
+   st->wHour         = (WORD)t.tm_hour;
+   st->wMinute       = (WORD)t.tm_min;
+   st->wSecond       = (WORD)t.tm_sec;
+   st->wMilliseconds = milliseconds;
+}
+
+
+static tm SystemTimeToTm(const SYSTEMTIME* st) {
+   tm t = {};
+   t.tm_year  = st->wYear - 1900;
+   t.tm_mon   = st->wMonth - 1;
+   t.tm_mday  = st->wDay;
+   t.tm_hour  = st->wHour;
+   t.tm_min   = st->wMinute;
+   t.tm_sec   = st->wSecond;
+   t.tm_isdst = -1;
+   return(t);
+}
+
+
+void GetSystemTime(SYSTEMTIME* st) {
+   timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   tm t;
+   gmtime_r(&ts.tv_sec, &t);
+   TmToSystemTime(t, (WORD)(ts.tv_nsec / 1000000), st);
+}
+
+
+void GetLocalTime(SYSTEMTIME* st) {
+   timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   tm t;
+   localtime_r(&ts.tv_sec, &t);
+   TmToSystemTime(t, (WORD)(ts.tv_nsec / 1000000), st);
+}
+
+
+void GetSystemTimeAsFileTime(FILETIME* ft) {
+   timespec ts;
+   clock_gettime(CLOCK_REALTIME, &ts);
+   *ft = ToFileTime(ts);
+}
+
+
+BOOL FileTimeToSystemTime(const FILETIME* ft, SYSTEMTIME* st) {
+   LONGLONG ticks = FileTimeToTicks(ft) - UNIX_EPOCH_TICKS;
+   time_t seconds = (time_t)(ticks / 10000000);
+   tm t;
+   if (!gmtime_r(&seconds, &t)) return(Fail(ERROR_INVALID_PARAMETER));
+   TmToSystemTime(t, (WORD)(ticks / 10000 % 1000), st);
+   return(TRUE);
+}
+
+
+BOOL SystemTimeToFileTime(const SYSTEMTIME* st, FILETIME* ft) {
+   tm t = SystemTimeToTm(st);
+   t.tm_isdst = 0;
+   *ft = TicksToFileTime((LONGLONG)timegm(&t) * 10000000 + st->wMilliseconds * 10000LL + UNIX_EPOCH_TICKS);
+   return(TRUE);
+}
+
+
+BOOL FileTimeToLocalFileTime(const FILETIME* ft, FILETIME* localFt) {
+   LONGLONG ticks = FileTimeToTicks(ft);
+   time_t seconds = (time_t)((ticks - UNIX_EPOCH_TICKS) / 10000000);
+   tm t;
+   localtime_r(&seconds, &t);
+   *localFt = TicksToFileTime(ticks + (LONGLONG)t.tm_gmtoff * 10000000);
+   return(TRUE);
+}
+
+
+BOOL SystemTimeToTzSpecificLocalTime(const TIME_ZONE_INFORMATION* tzi, const SYSTEMTIME* st, SYSTEMTIME* localTime) {
+   if (tzi) return(Fail(ERROR_INVALID_PARAMETER));           // only the current timezone is supported
+   tm t = SystemTimeToTm(st);
+   time_t seconds = timegm(&t);
+   localtime_r(&seconds, &t);
+   TmToSystemTime(t, st->wMilliseconds, localTime);
+   return(TRUE);
+}
+
+
+BOOL TzSpecificLocalTimeToSystemTime(const TIME_ZONE_INFORMATION* tzi, const SYSTEMTIME* localTime, SYSTEMTIME* st) {
+   if (tzi) return(Fail(ERROR_INVALID_PARAMETER));
+   tm t = SystemTimeToTm(localTime);
+   time_t seconds = mktime(&t);
+   gmtime_r(&seconds, &t);
+   TmToSystemTime(t, localTime->wMilliseconds, st);
+   return(TRUE);
+}
+
+
+LONG RegOpenKeyA(HKEY hKey, LPCSTR subKey, HKEY* result) {
+   *result = NULL;
+   return(ERROR_FILE_NOT_FOUND);
+}
+
+
+LONG RegGetValueW(HKEY hKey, LPCWSTR subKey, LPCWSTR value, DWORD flags, LPDWORD type, LPVOID data, LPDWORD size) {
+   return(ERROR_FILE_NOT_FOUND);
+}
+
+
+LONG RegCloseKey(HKEY hKey) {
+   return(ERROR_SUCCESS);
+}
+
+
+HWND GetParent(HWND hWnd)                  { return(NULL); }
+HWND GetWindow(HWND hWnd, UINT cmd)        { return(NULL); }
+HWND GetTopWindow(HWND hWnd)               { return(NULL); }
+HWND GetDlgItem(HWND hDlg, int id)         { return(NULL); }
+HANDLE GetPropA(HWND hWnd, LPCSTR name)    { return(NULL); }
+int GetWindowTextLengthA(HWND hWnd)        { return(0); }
+DWORD GetWindowThreadProcessId(HWND hWnd, LPDWORD processId) { if (processId) *processId = 0; return(0); }
+LRESULT SendMessageA(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) { return(0); }
+
+
+void OutputDebugStringA(LPCSTR message) {
+   fputs(message, stderr);
+}
+
+
+void _splitpath(const char* path, char* drive, char* dir, char* fname, char* ext) {
+   const char* start = path;
+   if (path[0] && path[1]==':') start += 2;
+   const char* name = start;
+   for (const char* c=start; *c; c++) {
+      if (*c=='/' || *c=='\\') name = c+1;
+   }
+   const char* dot = strrchr(name, '.');
+   if (!dot) dot = name + strlen(name);
+
+   if (drive) { memcpy(drive, path, start-path); drive[start-path] = '\0'; }
+   if (dir)   { memcpy(dir, start, name-start);  dir[name-start]   = '\0'; }
+   if (fname) { memcpy(fname, name, dot-name);   fname[dot-name]   = '\0'; }
+   if (ext)   strcpy(ext, dot);
+}
+
+
+int _snprintf(char* buffer, size_t size, const char* format, ...) {
+   va_list args;
+   va_start(args, format);
+   int n = vsnprintf(buffer, size, format, args);
+   va_end(args);
+   return((n < 0 || (size_t)n >= size) ? -1 : n);  // the MSVC variant returns -1 on truncation
+}
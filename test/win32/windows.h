@@ -0,0 +1,307 @@
+#pragma once
+
+/**
+ * Subset of the Win32 API used by the sources under test, for building them on Linux. Types and constants match the
+ * 32-bit Windows definitions. Functions are implemented in "win32.cpp" on top of POSIX, only as far as the tests need them.
+ * Functions which are declared but not implemented fail at link time.
+ */
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <wchar.h>
+
+
+// calling conventions and compiler extensions
+#define WINAPI
+#define APIENTRY
+#define CALLBACK
+#define __cdecl
+#define __stdcall
+#define __forceinline                  inline
+#define __declspec(x)
+#define __int64                        long long
+#define _countof(array)                (sizeof(array)/sizeof((array)[0]))
+
+
+// basic types
+typedef int                            BOOL;
+typedef unsigned char                  BYTE;
+typedef unsigned char                  BOOLEAN;
+typedef unsigned char                  UCHAR;
+typedef unsigned short                 WORD;
+typedef unsigned short                 USHORT;
+typedef uint32_t                       DWORD;
+typedef uint32_t                       ULONG;
+typedef int32_t                        LONG;
+typedef unsigned int                   UINT;
+typedef int64_t                        LONGLONG;
+typedef uint64_t                       ULONGLONG;
+typedef uintptr_t                      UINT_PTR, DWORD_PTR, ULONG_PTR, SIZE_T, WPARAM;
+typedef intptr_t                       LONG_PTR, LPARAM, LRESULT;
+typedef int32_t                        __time32_t;
+typedef int64_t                        __time64_t;
+typedef wchar_t                        WCHAR;
+typedef char                           TCHAR;
+
+typedef void*                          LPVOID;
+typedef const void*                    LPCVOID;
+typedef char*                          LPSTR;
+typedef const char*                    LPCSTR;
+typedef const char*                    LPCTSTR;
+typedef wchar_t*                       LPWSTR;
+typedef const wchar_t*                 LPCWSTR;
+typedef DWORD*                         LPDWORD;
+
+typedef void*                          HANDLE;
+typedef HANDLE                         HWND, HMODULE, HINSTANCE, HMENU, HHOOK, HKEY, HDC;
+
+typedef union { struct { DWORD LowPart; LONG  HighPart; }; LONGLONG  QuadPart; } LARGE_INTEGER;
+typedef union { struct { DWORD LowPart; DWORD HighPart; }; ULONGLONG QuadPart; } ULARGE_INTEGER;
+
+typedef struct { DWORD dwLowDateTime, dwHighDateTime; }                                               FILETIME;
+typedef struct { WORD wYear, wMonth, wDayOfWeek, wDay, wHour, wMinute, wSecond, wMilliseconds; }     SYSTEMTIME;
+typedef struct { LONG Bias; WCHAR StandardName[32]; SYSTEMTIME StandardDate; LONG StandardBias;
+                 WCHAR DaylightName[32]; SYSTEMTIME DaylightDate; LONG DaylightBias; }                TIME_ZONE_INFORMATION;
+typedef struct { DWORD dwFileAttributes; FILETIME ftCreationTime, ftLastAccessTime, ftLastWriteTime;
+                 DWORD nFileSizeHigh, nFileSizeLow; }                                                 WIN32_FILE_ATTRIBUTE_DATA;
+typedef struct { DWORD dwFileAttributes; FILETIME ftCreationTime, ftLastAccessTime, ftLastWriteTime;
+                 DWORD nFileSizeHigh, nFileSizeLow; char cFileName[260]; }                            WIN32_FIND_DATA, WIN32_FIND_DATAA;
+typedef struct { DWORD dwFileVersionLS, dwFileVersionMS; }                                           VS_FIXEDFILEINFO;
+typedef struct { int unused; }                                                                        SECURITY_ATTRIBUTES, *LPSECURITY_ATTRIBUTES;
+typedef struct { int unused; }                                                                        OVERLAPPED, *LPOVERLAPPED;
+typedef struct { pthread_mutex_t mutex; }                                                             CRITICAL_SECTION;
+
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID);
+
+
+// constants
+#define TRUE                           1
+#define FALSE                          0
+#define INFINITE                       0xFFFFFFFF
+#define INVALID_HANDLE_VALUE           ((HANDLE)(intptr_t)-1)
+#define INVALID_FILE_SIZE              ((DWORD)0xFFFFFFFF)
+#define INVALID_FILE_ATTRIBUTES        ((DWORD)0xFFFFFFFF)
+#define TLS_OUT_OF_INDEXES             ((DWORD)0xFFFFFFFF)
+
+#define MAX_PATH                       260
+#define _MAX_PATH                      260
+#define _MAX_DRIVE                     3
+#define _MAX_DIR                       256
+#define _MAX_FNAME                     256
+#define _MAX_EXT                       256
+
+#define GENERIC_READ                   0x80000000
+#define GENERIC_WRITE                  0x40000000
+#define FILE_SHARE_READ                0x00000001
+#define FILE_SHARE_WRITE               0x00000002
+#define FILE_SHARE_DELETE              0x00000004
+#define CREATE_NEW                     1
+#define CREATE_ALWAYS                  2
+#define OPEN_EXISTING                  3
+#define OPEN_ALWAYS                    4
+#define TRUNCATE_EXISTING              5
+#define FILE_ATTRIBUTE_DIRECTORY       0x00000010
+#define FILE_ATTRIBUTE_NORMAL          0x00000080
+#define FILE_ATTRIBUTE_TEMPORARY       0x00000100
+#define FILE_FLAG_DELETE_ON_CLOSE      0x04000000
+#define FILE_FLAG_SEQUENTIAL_SCAN      0x08000000
+#define FILE_FLAG_WRITE_THROUGH        0x80000000
+#define FILE_BEGIN                     0
+#define FILE_CURRENT                   1
+#define FILE_END                       2
+#define PAGE_READONLY                  0x02
+#define PAGE_READWRITE                 0x04
+#define FILE_MAP_WRITE                 0x0002
+#define FILE_MAP_READ                  0x0004
+#define MOVEFILE_REPLACE_EXISTING      0x00000001
+#define MOVEFILE_WRITE_THROUGH         0x00000008
+#define GetFileExInfoStandard          0
+
+#define HKEY_LOCAL_MACHINE             ((HKEY)(ULONG_PTR)0x80000002)
+#define RRF_RT_REG_SZ                  0x00000002
+#define RRF_RT_REG_BINARY              0x00000008
+
+#define ERROR_SUCCESS                  0
+#define ERROR_FILE_NOT_FOUND           2
+#define ERROR_PATH_NOT_FOUND           3
+#define ERROR_ACCESS_DENIED            5
+#define ERROR_INVALID_HANDLE           6
+#define ERROR_NOT_ENOUGH_MEMORY        8
+#define ERROR_GEN_FAILURE              31
+#define ERROR_HANDLE_EOF               38
+#define ERROR_FILE_EXISTS              80
+#define ERROR_INVALID_PARAMETER        87
+#define ERROR_ALREADY_EXISTS           183
+#define ERROR_IO_PENDING               997
+
+#define WAIT_OBJECT_0                  0
+#define WAIT_TIMEOUT                   258
+#define WAIT_FAILED                    0xFFFFFFFF
+#define MAXIMUM_WAIT_OBJECTS           64
+#define STILL_ACTIVE                   259
+#define SYNCHRONIZE                    0x00100000
+#define THREAD_QUERY_INFORMATION       0x0040
+#define DUPLICATE_SAME_ACCESS          0x00000002
+
+#define CP_ACP                         0
+#define CP_UTF8                        65001
+#define MB_ERR_INVALID_CHARS           0x00000008
+#define WC_ERR_INVALID_CHARS           0x00000080
+#define WC_NO_BEST_FIT_CHARS           0x00000400
+#define GW_HWNDNEXT                    2
+#define GW_HWNDLAST                    1
+#define GW_CHILD                       5
+#define WM_COMMAND                     0x0111
+
+#define MAKELONG(a, b)                 ((LONG)(((WORD)(a)) | ((DWORD)((WORD)(b))) << 16))
+#define LOWORD(l)                      ((WORD)(l))
+#define HIWORD(l)                      ((WORD)((l) >> 16))
+
+#define CopyMemory(dest, src, size)    memcpy((dest), (src), (size))
+#define MoveMemory(dest, src, size)    memmove((dest), (src), (size))
+#define ZeroMemory(dest, size)         memset((dest), 0, (size))
+
+
+extern "C" {
+// errors
+DWORD   GetLastError();
+void    SetLastError(DWORD error);
+
+// files
+HANDLE  CreateFileA(LPCSTR name, DWORD access, DWORD shareMode, LPSECURITY_ATTRIBUTES sa, DWORD disposition, DWORD flags, HANDLE hTemplate);
+BOOL    ReadFile(HANDLE hFile, LPVOID buffer, DWORD size, LPDWORD bytesRead, LPOVERLAPPED overlapped);
+BOOL    WriteFile(HANDLE hFile, LPCVOID buffer, DWORD size, LPDWORD bytesWritten, LPOVERLAPPED overlapped);
+BOOL    FlushFileBuffers(HANDLE hFile);
+BOOL    SetFilePointerEx(HANDLE hFile, LARGE_INTEGER distance, LARGE_INTEGER* newPosition, DWORD method);
+BOOL    SetEndOfFile(HANDLE hFile);
+BOOL    GetFileSizeEx(HANDLE hFile, LARGE_INTEGER* size);
+DWORD   GetFileSize(HANDLE hFile, LPDWORD sizeHigh);
+BOOL    GetFileTime(HANDLE hFile, FILETIME* creation, FILETIME* lastAccess, FILETIME* lastWrite);
+BOOL    GetFileAttributesExA(LPCSTR name, int infoLevel, LPVOID info);
+DWORD   GetFileAttributesA(LPCSTR name);
+BOOL    DeleteFileA(LPCSTR name);
+BOOL    MoveFileExA(LPCSTR existing, LPCSTR target, DWORD flags);
+DWORD   GetTempPathA(DWORD size, LPSTR buffer);
+UINT    GetTempFileNameA(LPCSTR path, LPCSTR prefix, UINT unique, LPSTR buffer);
+LONG    CompareFileTime(const FILETIME* a, const FILETIME* b);
+
+// file mappings
+HANDLE  CreateFileMappingA(HANDLE hFile, LPSECURITY_ATTRIBUTES sa, DWORD protect, DWORD sizeHigh, DWORD sizeLow, LPCSTR name);
+LPVOID  MapViewOfFile(HANDLE hMapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, SIZE_T size);
+BOOL    UnmapViewOfFile(LPCVOID view);
+
+// handles, threads and synchronization
+BOOL    CloseHandle(HANDLE handle);
+BOOL    DuplicateHandle(HANDLE hSourceProcess, HANDLE hSource, HANDLE hTargetProcess, HANDLE* hTarget, DWORD access, BOOL inherit, DWORD options);
+HANDLE  CreateThread(LPSECURITY_ATTRIBUTES sa, SIZE_T stackSize, LPTHREAD_START_ROUTINE start, LPVOID param, DWORD flags, LPDWORD threadId);
+HANDLE  OpenThread(DWORD access, BOOL inherit, DWORD threadId);
+BOOL    GetExitCodeThread(HANDLE hThread, LPDWORD exitCode);
+HANDLE  GetCurrentThread();
+HANDLE  GetCurrentProcess();
+DWORD   GetCurrentThreadId();
+DWORD   GetCurrentProcessId();
+HANDLE  CreateEventA(LPSECURITY_ATTRIBUTES sa, BOOL manualReset, BOOL initialState, LPCSTR name);
+BOOL    SetEvent(HANDLE hEvent);
+BOOL    ResetEvent(HANDLE hEvent);
+DWORD   WaitForSingleObject(HANDLE handle, DWORD timeout);
+DWORD   WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD timeout);
+void    Sleep(DWORD milliseconds);
+void    InitializeCriticalSection(CRITICAL_SECTION* cs);
+void    DeleteCriticalSection(CRITICAL_SECTION* cs);
+void    EnterCriticalSection(CRITICAL_SECTION* cs);
+BOOL    TryEnterCriticalSection(CRITICAL_SECTION* cs);
+void    LeaveCriticalSection(CRITICAL_SECTION* cs);
+DWORD   TlsAlloc();
+BOOL    TlsFree(DWORD index);
+LPVOID  TlsGetValue(DWORD index);
+BOOL    TlsSetValue(DWORD index, LPVOID value);
+
+// time
+DWORD   GetTickCount();
+BOOL    QueryPerformanceCounter(LARGE_INTEGER* counter);
+BOOL    QueryPerformanceFrequency(LARGE_INTEGER* frequency);
+void    GetSystemTime(SYSTEMTIME* st);
+void    GetLocalTime(SYSTEMTIME* st);
+void    GetSystemTimeAsFileTime(FILETIME* ft);
+DWORD   GetTimeZoneInformation(TIME_ZONE_INFORMATION* tzi);
+BOOL    FileTimeToSystemTime(const FILETIME* ft, SYSTEMTIME* st);
+BOOL    SystemTimeToFileTime(const SYSTEMTIME* st, FILETIME* ft);
+BOOL    FileTimeToLocalFileTime(const FILETIME* ft, FILETIME* localFt);
+BOOL    SystemTimeToTzSpecificLocalTime(const TIME_ZONE_INFORMATION* tzi, const SYSTEMTIME* st, SYSTEMTIME* localTime);
+BOOL    TzSpecificLocalTimeToSystemTime(const TIME_ZONE_INFORMATION* tzi, const SYSTEMTIME* localTime, SYSTEMTIME* st);
+
+// registry (the test process has no registry, keys are never found)
+LONG    RegOpenKeyA(HKEY hKey, LPCSTR subKey, HKEY* result);
+LONG    RegGetValueW(HKEY hKey, LPCWSTR subKey, LPCWSTR value, DWORD flags, LPDWORD type, LPVOID data, LPDWORD size);
+LONG    RegCloseKey(HKEY hKey);
+
+// miscellaneous
+void    OutputDebugStringA(LPCSTR message);
+DWORD   GetModuleFileNameA(HMODULE hModule, LPSTR buffer, DWORD size);
+int     MultiByteToWideChar(UINT codePage, DWORD flags, LPCSTR str, int length, LPWSTR buffer, int size);
+int     WideCharToMultiByte(UINT codePage, DWORD flags, LPCWSTR str, int length, LPSTR buffer, int size, LPCSTR defaultChar, BOOL* defaultUsed);
+
+// user interface (the test process has no windows)
+HWND    GetParent(HWND hWnd);
+HWND    GetWindow(HWND hWnd, UINT cmd);
+HWND    GetTopWindow(HWND hWnd);
+HWND    GetDlgItem(HWND hDlg, int id);
+HANDLE  GetPropA(HWND hWnd, LPCSTR name);
+BOOL    IsWindow(HWND hWnd);
+int     GetWindowTextA(HWND hWnd, LPSTR buffer, int size);
+int     GetWindowTextLengthA(HWND hWnd);
+int     GetClassNameA(HWND hWnd, LPSTR buffer, int size);
+DWORD   GetWindowThreadProcessId(HWND hWnd, LPDWORD processId);
+BOOL    PostMessageA(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+LRESULT SendMessageA(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+}
+
+#define GetWindowTextLength            GetWindowTextLengthA
+
+
+// interlocked operations
+inline LONG  InterlockedIncrement(LONG volatile* target)                              { return(__sync_add_and_fetch(target, 1));                       }
+inline LONG  InterlockedDecrement(LONG volatile* target)                              { return(__sync_sub_and_fetch(target, 1));                       }
+inline LONG  InterlockedExchange(LONG volatile* target, LONG value)                   { return(__sync_lock_test_and_set(target, value));               }
+inline LONG  InterlockedExchangeAdd(LONG volatile* target, LONG value)                { return(__sync_fetch_and_add(target, value));                   }
+inline LONG  InterlockedCompareExchange(LONG volatile* target, LONG value, LONG cmp)  { return(__sync_val_compare_and_swap(target, cmp, value));       }
+inline void* InterlockedExchangePointer(void* volatile* target, void* value)          { return(__sync_lock_test_and_set(target, value));               }
+inline void* InterlockedCompareExchangePointer(void* volatile* target, void* value, void* cmp) { return(__sync_val_compare_and_swap(target, cmp, value)); }
+inline void  MemoryBarrier()                                                          { __sync_synchronize();                                          }
+inline void  _ReadWriteBarrier()                                                      { __asm__ __volatile__("" ::: "memory");                         }
+
+
+// C runtime functions of the Microsoft CRT
+inline int   _stricmp(const char* a, const char* b)                                   { return(strcasecmp(a, b));                                      }
+inline int   stricmp(const char* a, const char* b)                                    { return(strcasecmp(a, b));                                      }
+inline int   _strnicmp(const char* a, const char* b, size_t n)                        { return(strncasecmp(a, b, n));                                  }
+inline int   wcsicmp(const wchar_t* a, const wchar_t* b)                              { return(wcscasecmp(a, b));                                      }
+inline int   _vscprintf(const char* format, va_list args)                             { va_list copy; va_copy(copy, args); int n = vsnprintf(NULL, 0, format, copy); va_end(copy); return(n); }
+inline int   _vsnprintf(char* buffer, size_t size, const char* format, va_list args)  { int n = vsnprintf(buffer, size, format, args); return((n < 0 || (size_t)n >= size) ? -1 : n); }
+inline int   vsprintf_s(char* buffer, size_t size, const char* format, va_list args)  { return(vsnprintf(buffer, size, format, args));                  }
+inline char* _strdup(const char* str)                                                 { return(strdup(str));                                           }
+inline wchar_t* _wcsdup(const wchar_t* str)                                           { return(wcsdup(str));                                           }
+inline int   _wtoi(const wchar_t* str)                                                { return((int)wcstol(str, NULL, 10));                            }
+inline __time32_t _time32(__time32_t* t)                                              { __time32_t now = (__time32_t)time(NULL); if (t) *t = now; return(now); }
+inline __time64_t _time64(__time64_t* t)                                              { __time64_t now = (__time64_t)time(NULL); if (t) *t = now; return(now); }
+inline tm*   _gmtime32(const __time32_t* t)                                           { static __thread tm result; time_t v = *t; return(gmtime_r(&v, &result));    }
+inline tm*   _gmtime64(const __time64_t* t)                                           { static __thread tm result; time_t v = *t; return(gmtime_r(&v, &result));    }
+inline tm*   _localtime32(const __time32_t* t)                                        { static __thread tm result; time_t v = *t; return(localtime_r(&v, &result)); }
+inline tm*   _localtime64(const __time64_t* t)                                        { static __thread tm result; time_t v = *t; return(localtime_r(&v, &result)); }
+inline __time32_t _mkgmtime32(tm* t)                                                  { return((__time32_t)timegm(t));                                 }
+inline __time64_t _mkgmtime64(tm* t)                                                  { return((__time64_t)timegm(t));                                 }
+inline __time32_t _mktime32(tm* t)                                                    { return((__time32_t)mktime(t));                                 }
+inline __time64_t _mktime64(tm* t)                                                    { return((__time64_t)mktime(t));                                 }
+int          _snprintf(char* buffer, size_t size, const char* format, ...);
+int          _vscwprintf(const wchar_t* format, va_list args);
+int          vswprintf_s(wchar_t* buffer, size_t size, const wchar_t* format, va_list args);
+void         _splitpath(const char* path, char* drive, char* dir, char* fname, char* ext);
+void         _splitpath_s(const char* path, char* drive, size_t driveSize, char* dir, size_t dirSize, char* fname, size_t fnameSize, char* ext, size_t extSize);
+#define      _alloca                   __builtin_alloca
@@ -0,0 +1,7 @@
+#pragma once
+#include "windows.h"
+
+#define CB_ERR                  (-1)
+#define CB_GETCURSEL            0x0147
+
+#define ComboBox_GetCurSel(hWnd) ((int)(DWORD)SendMessageA((hWnd), CB_GETCURSEL, 0, 0))
@@ -0,0 +1,2 @@
+#pragma once
+// no additional definitions needed, see "windows.h"
@@ -0,0 +1,196 @@
+/**
+ * blogdump - decoder for binary logfiles written by the MT4Expander (extension ".blog")
+ *
+ * Renders binary logfiles in the layout of the text logfiles written by AppendLogMessageA(). The tool is plain C++ and has
+ * no dependencies besides the shared file format definition.
+ *
+ *   Linux:   g++ -O2 -Wall -I../../header -o blogdump blogdump.cpp
+ *   Windows: cl /O2 /EHsc /I..\..\header blogdump.cpp
+ *
+ * Usage:     blogdump <file.blog> [...]      (the decoded log is written to stdout)
+ */
+#include "struct/BinaryLog.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using std::string;
+
+
+/**
+ * Format a Unix timestamp as "YYYY-MM-DD HH:MM:SS". The timestamp is not converted to another timezone.
+ *
+ * @param  int   time
+ * @param  char* buffer - buffer receiving the result (min. 20 chars)
+ */
+static void FormatTime(int time, char* buffer) {
+   long long t = time;
+   long long days = t / 86400, secs = t % 86400;
+   if (secs < 0) { secs += 86400; days--; }
+
+   // convert days since 1970-01-01 to a civil date
+   long long z   = days + 719468;
+   long long era = (z >= 0 ? z : z - 146096) / 146097;
+   long long doe = z - era * 146097;
+   long long yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+   long long doy = doe - (365*yoe + yoe/4 - yoe/100);
+   long long mp  = (5*doy + 2) / 153;
+   int day   = (int)(doy - (153*mp + 2)/5 + 1);
+   int month = (int)(mp < 10 ? mp+3 : mp-9);
+   int year  = (int)(yoe + era*400 + (month <= 2));
+
+   sprintf(buffer, "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, (int)(secs/3600), (int)(secs/60 % 60), (int)(secs % 60));
+}
+
+
+/**
+ * Append a string left-aligned and padded with spaces to a minimum width.
+ *
+ * @param  string &out
+ * @param  string &value
+ * @param  size_t width
+ */
+static void AppendPadded(string &out, const string &value, size_t width) {
+   out.append(value);
+   if (value.size() < width) out.append(width - value.size(), ' ');
+}
+
+
+/**
+ * Decode a binary logfile and write the log entries to stdout.
+ *
+ * @param  char* filename
+ *
+ * @return bool - success status
+ */
+static bool DecodeFile(const char* filename) {
+   FILE* file = fopen(filename, "rb");
+   if (!file) {
+      fprintf(stderr, "blogdump: cannot open \"%s\"\n", filename);
+      return(false);
+   }
+
+   std::vector<string> strings;                          // string table of the current section (index = string id)
+   bool sectionStarted = false, truncated = false, success = true;
+   string line, payload;
+   long offset = 0;                                      // offset of the current record
+   int type;
+
+   while ((type = fgetc(file)) != EOF) {
+      offset = ftell(file) - 1;
+
+      if (type == BLOG_RECORD_HEADER) {
+         BLOG_HEADER header;
+         header.type = (char)type;
+         if (fread((char*)&header + 1, sizeof(header) - 1, 1, file) != 1) { truncated = true; break; }
+         if (memcmp(header.magic, BLOG_MAGIC, sizeof(header.magic)) || header.version != BLOG_VERSION) {
+            fprintf(stderr, "blogdump: %s: unsupported file header (version %u)\n", filename, header.version);
+            success = false;
+            break;
+         }
+         strings.assign(1, string());
+         sectionStarted = true;
+         continue;
+      }
+      if (!sectionStarted) {
+         fprintf(stderr, "blogdump: %s: not a binary logfile\n", filename);
+         success = false;
+         break;
+      }
+
+      if (type == BLOG_RECORD_STRING) {
+         BLOG_STRING def;
+         def.type = (char)type;
+         if (fread((char*)&def + 1, sizeof(def) - 1, 1, file) != 1) { truncated = true; break; }
+         payload.resize(def.length);
+         if (def.length && fread(&payload[0], def.length, 1, file) != 1) { truncated = true; break; }
+         if (strings.size() <= def.id) strings.resize(def.id + 1);
+         strings[def.id] = payload;
+      }
+      else if (type == BLOG_RECORD_TEXT) {
+         BLOG_TEXT text;
+         text.type = (char)type;
+         if (fread((char*)&text + 1, sizeof(text) - 1, 1, file) != 1) { truncated = true; break; }
+         payload.resize(text.length);
+         if (text.length && fread(&payload[0], text.length, 1, file) != 1) { truncated = true; break; }
+         payload.append("\n");
+         fwrite(payload.data(), payload.size(), 1, stdout);
+      }
+      else if (type == BLOG_RECORD_MESSAGE) {
+         BLOG_MESSAGE msg;
+         msg.type = (char)type;
+         if (fread((char*)&msg + 1, sizeof(msg) - 1, 1, file) != 1) { truncated = true; break; }
+         payload.resize(msg.length);
+         if (msg.length && fread(&payload[0], msg.length, 1, file) != 1) { truncated = true; break; }
+
+         const size_t ids[] = { msg.levelId, msg.symbolId, msg.periodId, msg.pathId, msg.errorId };
+         for (size_t i=0; i < sizeof(ids)/sizeof(ids[0]); i++) {
+            if (ids[i] >= strings.size()) strings.resize(ids[i] + 1);   // tolerate a truncated string table
+         }
+
+         // replace linebreaks with spaces
+         string message;
+         message.reserve(payload.size());
+         for (size_t i=0; i < payload.size(); i++) {
+            if (payload[i] == '\r' && i+1 < payload.size() && payload[i+1] == '\n') i++;
+            message.append(1, payload[i]=='\n' ? ' ' : payload[i]);
+         }
+
+         // "{time}  {level}  {symbol},{period}  {path}{message}  [{error}]"
+         char time[32];
+         FormatTime(msg.time, time);
+         line.clear();
+         if (msg.flags & BLOG_FLAG_TESTER) {
+            line.append("T ").append(time);
+         }
+         else {
+            char ms[8];
+            sprintf(ms, ".%03u", (unsigned)msg.milliseconds % 1000);
+            line.append(time).append(ms);
+         }
+         line.append("  ");
+         AppendPadded(line, strings[msg.levelId], 6);
+         line.append("  ").append(strings[msg.symbolId]).append(",");
+         AppendPadded(line, strings[msg.periodId], 3);
+         line.append("  ").append(strings[msg.pathId]).append(message);
+         if (msg.error) line.append("  [").append(strings[msg.errorId]).append("]");
+         line.append("\n");
+         fwrite(line.data(), line.size(), 1, stdout);
+      }
+      else {
+         fprintf(stderr, "blogdump: %s: unknown record type 0x%02X at offset %ld\n", filename, type, offset);
+         success = false;
+         break;
+      }
+   }
+
+   if (truncated) {
+      fprintf(stderr, "blogdump: %s: %s in record at offset %ld\n", filename, ferror(file) ? "read error" : "unexpected end of file", offset);
+      success = false;
+   }
+   else if (success && ferror(file)) {
+      fprintf(stderr, "blogdump: %s: read error\n", filename);
+      success = false;
+   }
+   fclose(file);
+   return(success);
+}
+
+
+/**
+ * Main function.
+ */
+int main(int argc, char** argv) {
+   if (argc < 2) {
+      fprintf(stderr, "Usage: blogdump <file.blog> [...]\n");
+      return(2);
+   }
+
+   int result = 0;
+   for (int i=1; i < argc; i++) {
+      if (!DecodeFile(argv[i])) result = 1;
+   }
+   return(result);
+}